@@ -150,6 +150,28 @@ macro(libgav1_set_build_definitions)
 
   list(APPEND libgav1_defines "LIBGAV1_MAX_BITDEPTH=${LIBGAV1_MAX_BITDEPTH}")
 
+  if(DEFINED LIBGAV1_SPECIALIZE_420)
+    if(NOT LIBGAV1_SPECIALIZE_420 EQUAL 0 AND NOT LIBGAV1_SPECIALIZE_420 EQUAL 1)
+      libgav1_die("LIBGAV1_SPECIALIZE_420 must be 0 or 1.")
+    endif()
+
+    list(APPEND libgav1_defines
+         "LIBGAV1_SPECIALIZE_420=${LIBGAV1_SPECIALIZE_420}")
+  endif()
+
+  if(DEFINED LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK)
+    if(NOT LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK EQUAL 0
+       AND NOT LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK EQUAL 1)
+      libgav1_die("LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK must be 0 or 1.")
+    endif()
+
+    list(
+      APPEND
+      libgav1_defines
+      "LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK=${LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK}"
+      )
+  endif()
+
   if(DEFINED LIBGAV1_THREADPOOL_USE_STD_MUTEX)
     if(NOT LIBGAV1_THREADPOOL_USE_STD_MUTEX EQUAL 0
        AND NOT LIBGAV1_THREADPOOL_USE_STD_MUTEX EQUAL 1)
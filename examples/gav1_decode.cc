@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cerrno>
+#include <cinttypes>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -46,6 +47,9 @@ struct Options {
   uint8_t post_filter_mask = 0x1f;
   int threads = 1;
   bool frame_parallel = false;
+  int max_frames_in_flight = 0;
+  bool adaptive_threading = false;
+  bool perf_counters = false;
   bool output_all_layers = false;
   bool parse_only = false;
   int operating_point = 0;
@@ -62,8 +66,18 @@ struct Timing {
 struct FrameTiming {
   absl::Time enqueue;
   absl::Time dequeue;
+  // The performance counter values of the stages of the DequeueFrame() call
+  // that returned the frame.
+  libgav1::PerfCounters perf_counters;
 };
 
+constexpr const char* kPerfStageNames[libgav1::kNumPerfStages] = {
+    "parse", "predict",   "reconstruct",      "deblock",
+    "cdef",  "super_res", "loop_restoration", "film_grain"};
+
+constexpr const char* kPerfCounterNames[libgav1::kNumPerfCounters] = {
+    "cycles", "instructions", "llc misses", "branch misses"};
+
 void PrintHelp(FILE* const fout) {
   fprintf(fout,
           "Usage: gav1_decode [options] <input file>"
@@ -73,6 +87,12 @@ void PrintHelp(FILE* const fout) {
   fprintf(fout, "  -h, --help This help message.\n");
   fprintf(fout, "  --threads <positive integer> (Default 1).\n");
   fprintf(fout, "  --frame_parallel.\n");
+  fprintf(fout,
+          "  --max_frames_in_flight <non-negative integer> (Default 0 = no "
+          "limit).\n");
+  fprintf(fout,
+          "  --adaptive_threading Throttle the thread count with the frame "
+          "cost.\n");
   fprintf(fout,
           "  --limit <integer> Stop decoding after N frames (0 = all).\n");
   fprintf(fout, "  --skip <integer> Skip initial N frames (Default 0).\n");
@@ -90,6 +110,12 @@ void PrintHelp(FILE* const fout) {
           "  --frame_timing <file> Output per-frame timing to <file> in tsv"
           " format.\n   Yields meaningful results only when frame parallel is"
           " off.\n");
+  fprintf(fout,
+          "  --perf_counters Count the cycles, instructions, LLC misses and"
+          " branch misses\n   of each decoding stage and print them at the"
+          " end. The counts of each frame\n   are added to the --frame_timing"
+          " output. Requires a library built with\n"
+          "   LIBGAV1_ENABLE_PERF_COUNTERS=1 on Linux.\n");
   fprintf(fout, "\nAdvanced settings:\n");
   fprintf(fout, "  --post_filter_mask <integer> (Default 0x1f).\n");
   fprintf(fout,
@@ -144,6 +170,17 @@ void ParseOptions(int argc, char* argv[], Options* const options) {
       options->threads = value;
     } else if (strcmp(argv[i], "--frame_parallel") == 0) {
       options->frame_parallel = true;
+    } else if (strcmp(argv[i], "--max_frames_in_flight") == 0) {
+      if (++i >= argc || !absl::SimpleAtoi(argv[i], &value) || value < 0) {
+        fprintf(stderr, "Missing/Invalid value for --max_frames_in_flight.\n");
+        PrintHelp(stderr);
+        exit(EXIT_FAILURE);
+      }
+      options->max_frames_in_flight = value;
+    } else if (strcmp(argv[i], "--adaptive_threading") == 0) {
+      options->adaptive_threading = true;
+    } else if (strcmp(argv[i], "--perf_counters") == 0) {
+      options->perf_counters = true;
     } else if (strcmp(argv[i], "--parse_only") == 0) {
       options->parse_only = true;
     } else if (strcmp(argv[i], "--all_layers") == 0) {
@@ -253,6 +290,76 @@ void ReleaseInputBuffer(void* callback_private_data,
 
 int CloseFile(FILE* stream) { return (stream == nullptr) ? 0 : fclose(stream); }
 
+// Reads the performance counters of |decoder|, stores the counts since the
+// previous call in |*delta| and adds them to |*total|. |*last| holds the
+// counts read by the previous call.
+void UpdatePerfCounters(const libgav1::Decoder& decoder,
+                        libgav1::PerfCounters* const last,
+                        libgav1::PerfCounters* const delta,
+                        libgav1::PerfCounters* const total) {
+  libgav1::PerfCounters current;
+  if (decoder.GetPerfCounters(&current) != libgav1::kStatusOk) {
+    *delta = {};
+    return;
+  }
+  delta->available_counters = current.available_counters;
+  total->available_counters |= current.available_counters;
+  for (int stage = 0; stage < libgav1::kNumPerfStages; ++stage) {
+    for (int counter = 0; counter < libgav1::kNumPerfCounters; ++counter) {
+      delta->counts[stage][counter] =
+          current.counts[stage][counter] - last->counts[stage][counter];
+      total->counts[stage][counter] += delta->counts[stage][counter];
+    }
+  }
+  *last = current;
+}
+
+void PrintPerfCounters(const libgav1::PerfCounters& perf_counters) {
+  const auto print_count = [&perf_counters](int width, int64_t count,
+                                            libgav1::PerfCounter counter) {
+    if ((perf_counters.available_counters & (1 << counter)) == 0) {
+      fprintf(stderr, " %*s", width, "n/a");
+    } else {
+      fprintf(stderr, " %*" PRId64, width, count);
+    }
+  };
+  fprintf(stderr, "%-16s %15s %15s %6s %12s %14s\n", "stage", "cycles",
+          "instructions", "ipc", "llc misses", "branch misses");
+  for (int stage = 0; stage <= libgav1::kNumPerfStages; ++stage) {
+    // The last row is the sum of all the stages.
+    int64_t counts[libgav1::kNumPerfCounters] = {};
+    for (int counter = 0; counter < libgav1::kNumPerfCounters; ++counter) {
+      if (stage < libgav1::kNumPerfStages) {
+        counts[counter] = perf_counters.counts[stage][counter];
+      } else {
+        for (int i = 0; i < libgav1::kNumPerfStages; ++i) {
+          counts[counter] += perf_counters.counts[i][counter];
+        }
+      }
+    }
+    fprintf(stderr, "%-16s",
+            (stage < libgav1::kNumPerfStages) ? kPerfStageNames[stage]
+                                              : "total");
+    print_count(15, counts[libgav1::kPerfCounterCycles],
+                libgav1::kPerfCounterCycles);
+    print_count(15, counts[libgav1::kPerfCounterInstructions],
+                libgav1::kPerfCounterInstructions);
+    if (counts[libgav1::kPerfCounterCycles] > 0 &&
+        counts[libgav1::kPerfCounterInstructions] > 0) {
+      fprintf(stderr, " %6.2f",
+              static_cast<double>(counts[libgav1::kPerfCounterInstructions]) /
+                  counts[libgav1::kPerfCounterCycles]);
+    } else {
+      fprintf(stderr, " %6s", "n/a");
+    }
+    print_count(12, counts[libgav1::kPerfCounterLlcMisses],
+                libgav1::kPerfCounterLlcMisses);
+    print_count(14, counts[libgav1::kPerfCounterBranchMisses],
+                libgav1::kPerfCounterBranchMisses);
+    fprintf(stderr, "\n");
+  }
+}
+
 }  // namespace
 
 int main(int argc, char* argv[]) {
@@ -295,6 +402,9 @@ int main(int argc, char* argv[]) {
   settings.post_filter_mask = options.post_filter_mask;
   settings.threads = options.threads;
   settings.frame_parallel = options.frame_parallel;
+  settings.max_frames_in_flight = options.max_frames_in_flight;
+  settings.adaptive_threading = options.adaptive_threading;
+  settings.collect_perf_counters = options.perf_counters;
   settings.parse_only = options.parse_only;
   settings.output_all_layers = options.output_all_layers;
   settings.operating_point = options.operating_point;
@@ -318,6 +428,25 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
+  bool collect_perf_counters = false;
+  // The counts read after the last dequeued frame and the sum of the counts
+  // read since the decoder was created. The counts of the decoder are reset by
+  // SignalEOS().
+  libgav1::PerfCounters last_perf_counters = {};
+  libgav1::PerfCounters total_perf_counters = {};
+  if (options.perf_counters) {
+    status = decoder.GetPerfCounters(&last_perf_counters);
+    if (status == libgav1::kStatusOk) {
+      collect_perf_counters = true;
+    } else {
+      fprintf(stderr,
+              "Cannot collect performance counters: %s\nThey require "
+              "LIBGAV1_ENABLE_PERF_COUNTERS=1, Linux and permission to use "
+              "perf_event_open().\n",
+              libgav1::GetErrorString(status));
+    }
+  }
+
   fprintf(stderr, "decoding '%s'\n", options.input_file_name);
   if (options.verbose > 0 && options.skip > 0) {
     fprintf(stderr, "skipping %d frame(s).\n", options.skip);
@@ -370,7 +499,7 @@ int main(int argc, char* argv[]) {
           fprintf(stderr, "enqueue frame (length %zu)\n", input_buffer->size());
         }
         if (record_frame_timing) {
-          FrameTiming enqueue_time = {enqueue_start, absl::UnixEpoch()};
+          FrameTiming enqueue_time = {enqueue_start, absl::UnixEpoch(), {}};
           frame_timing.emplace_back(enqueue_time);
         }
 
@@ -427,6 +556,15 @@ int main(int argc, char* argv[]) {
       frame_timing[static_cast<int>(buffer->user_private_data)].dequeue =
           absl::Now();
     }
+    if (collect_perf_counters) {
+      libgav1::PerfCounters frame_perf_counters;
+      UpdatePerfCounters(decoder, &last_perf_counters, &frame_perf_counters,
+                         &total_perf_counters);
+      if (record_frame_timing) {
+        frame_timing[static_cast<int>(buffer->user_private_data)]
+            .perf_counters = frame_perf_counters;
+      }
+    }
 
     if (options.output_file_name != nullptr && file_writer == nullptr) {
       libgav1::FileWriter::Y4mParameters y4m_parameters;
@@ -458,25 +596,55 @@ int main(int argc, char* argv[]) {
       input_buffer = nullptr;
       // Clear any in progress frames to ensure the output frame limit is
       // respected.
+      if (collect_perf_counters) {
+        libgav1::PerfCounters unused;
+        UpdatePerfCounters(decoder, &last_perf_counters, &unused,
+                           &total_perf_counters);
+        last_perf_counters = {};
+      }
       decoder.SignalEOS();
     }
   } while (input_buffer != nullptr ||
            (!file_reader->IsEndOfFile() && !limit_reached) ||
            !dequeue_finished);
   timing.dequeue = absl::Now() - decode_loop_start - timing.input;
+  if (collect_perf_counters) {
+    libgav1::PerfCounters unused;
+    UpdatePerfCounters(decoder, &last_perf_counters, &unused,
+                       &total_perf_counters);
+  }
 
   if (record_frame_timing) {
     // Note timing for frame parallel will be skewed by the time spent queueing
     // additional frames and in the output queue waiting for previous frames,
     // the values reported won't be that meaningful.
-    fprintf(frame_timing_file.get(), "frame number\tdecode time us\n");
+    fprintf(frame_timing_file.get(), "frame number\tdecode time us");
+    if (collect_perf_counters) {
+      for (const char* const stage_name : kPerfStageNames) {
+        for (const char* const counter_name : kPerfCounterNames) {
+          fprintf(frame_timing_file.get(), "\t%s %s", stage_name,
+                  counter_name);
+        }
+      }
+    }
+    fprintf(frame_timing_file.get(), "\n");
     for (size_t i = 0; i < frame_timing.size(); ++i) {
       const int decode_time_us = static_cast<int>(absl::ToInt64Microseconds(
           frame_timing[i].dequeue - frame_timing[i].enqueue));
-      fprintf(frame_timing_file.get(), "%zu\t%d\n", i, decode_time_us);
+      fprintf(frame_timing_file.get(), "%zu\t%d", i, decode_time_us);
+      if (collect_perf_counters) {
+        for (const auto& stage_counts : frame_timing[i].perf_counters.counts) {
+          for (const int64_t count : stage_counts) {
+            fprintf(frame_timing_file.get(), "\t%" PRId64, count);
+          }
+        }
+      }
+      fprintf(frame_timing_file.get(), "\n");
     }
   }
 
+  if (collect_perf_counters) PrintPerfCounters(total_perf_counters);
+
   if (options.verbose > 0) {
     fprintf(stderr, "time to read input: %d us\n",
             static_cast<int>(absl::ToInt64Microseconds(timing.input)));
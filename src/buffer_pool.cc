@@ -15,7 +15,9 @@
 #include "src/buffer_pool.h"
 
 #include <cassert>
+#include <cstddef>
 #include <cstring>
+#include <memory>
 
 #include "src/utils/common.h"
 #include "src/utils/constants.h"
@@ -73,11 +75,16 @@ bool RefCountedBuffer::SetFrameDimensions(const ObuFrameHeader& frame_header) {
       !IsIntraFrame(frame_header.frame_type)) {
     const int rows4x4_half = DivideBy2(rows4x4_);
     const int columns4x4_half = DivideBy2(columns4x4_);
-    if (!reference_info_.Reset(rows4x4_half, columns4x4_half)) {
+    if (!reference_info_.Reserve(DivideBy2(pool_->max_rows4x4_),
+                                 DivideBy2(pool_->max_columns4x4_)) ||
+        !reference_info_.Reset(rows4x4_half, columns4x4_half)) {
       return false;
     }
   }
-  return segmentation_map_.Allocate(rows4x4_, columns4x4_);
+  return segmentation_map_.Reserve(
+             static_cast<size_t>(pool_->max_rows4x4_) *
+             pool_->max_columns4x4_) &&
+         segmentation_map_.Allocate(rows4x4_, columns4x4_);
 }
 
 void RefCountedBuffer::SetGlobalMotions(
@@ -109,8 +116,53 @@ void RefCountedBuffer::SetSegmentationParameters(
 
 void RefCountedBuffer::SetBufferPool(BufferPool* pool) { pool_ = pool; }
 
-void RefCountedBuffer::ReturnToBufferPool(RefCountedBuffer* ptr) {
-  ptr->pool_->ReturnUnusedBuffer(ptr);
+template <typename T>
+class RefCountedBuffer::ControlBlockAllocator {
+ public:
+  using value_type = T;
+
+  explicit ControlBlockAllocator(RefCountedBuffer* const buffer)
+      : buffer_(buffer) {}
+  template <typename U>
+  ControlBlockAllocator(const ControlBlockAllocator<U>& other)  // NOLINT
+      : buffer_(other.buffer_) {}
+
+  T* allocate(size_t n) {
+    static_assert(sizeof(T) <= kControlBlockSize,
+                  "kControlBlockSize is too small.");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "The control block is overaligned.");
+    assert(n == 1);
+    static_cast<void>(n);
+    return reinterpret_cast<T*>(buffer_->control_block_);
+  }
+
+  void deallocate(T* /*p*/, size_t /*n*/) {
+    buffer_->pool_->ReturnUnusedBuffer(buffer_);
+  }
+
+  template <typename U>
+  bool operator==(const ControlBlockAllocator<U>& other) const {
+    return buffer_ == other.buffer_;
+  }
+  template <typename U>
+  bool operator!=(const ControlBlockAllocator<U>& other) const {
+    return buffer_ != other.buffer_;
+  }
+
+ private:
+  template <typename U>
+  friend class ControlBlockAllocator;
+
+  RefCountedBuffer* const buffer_;
+};
+
+std::shared_ptr<RefCountedBuffer> RefCountedBuffer::MakeSharedPtr() {
+  // The deleter does nothing. ControlBlockAllocator::deallocate() returns the
+  // buffer to the pool.
+  return std::shared_ptr<RefCountedBuffer>(
+      this, [](RefCountedBuffer* /*buffer*/) {},
+      ControlBlockAllocator<RefCountedBuffer>(this));
 }
 
 BufferPool::BufferPool(
@@ -155,6 +207,12 @@ bool BufferPool::OnFrameBufferSizeChanged(int bitdepth,
                                        /*stride_alignment=*/16) == kStatusOk;
 }
 
+void BufferPool::SetMaxFrameSize(int width, int height) {
+  max_rows4x4_ = ((height + 7) >> 3) << 1;
+  max_columns4x4_ = ((width + 7) >> 3) << 1;
+  internal_frame_buffers_.SetMaxFrameSize(width, height);
+}
+
 RefCountedBufferPtr BufferPool::GetFreeBuffer() {
   std::unique_lock<std::mutex> lock(mutex_);
   for (auto buffer : buffers_) {
@@ -162,11 +220,12 @@ RefCountedBufferPtr BufferPool::GetFreeBuffer() {
       buffer->in_use_ = true;
       buffer->progress_row_ = -1;
       buffer->frame_state_ = kFrameStateUnknown;
+      buffer->abort_.store(false, std::memory_order_relaxed);
       buffer->hdr_cll_set_ = false;
       buffer->hdr_mdcv_set_ = false;
       buffer->itut_t35_set_ = false;
       lock.unlock();
-      return RefCountedBufferPtr(buffer, RefCountedBuffer::ReturnToBufferPool);
+      return buffer->MakeSharedPtr();
     }
   }
   lock.unlock();
@@ -189,7 +248,7 @@ RefCountedBufferPtr BufferPool::GetFreeBuffer() {
     delete buffer;
     return RefCountedBufferPtr();
   }
-  return RefCountedBufferPtr(buffer, RefCountedBuffer::ReturnToBufferPool);
+  return buffer->MakeSharedPtr();
 }
 
 void BufferPool::Abort() {
@@ -19,9 +19,11 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <condition_variable>  // NOLINT (unapproved c++11 header)
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>  // NOLINT (unapproved c++11 header)
@@ -116,8 +118,9 @@ class RefCountedBuffer : public MaxAlignedAllocable {
   // Sets upscaled_width_, frame_width_, frame_height_, render_width_,
   // render_height_, rows4x4_ and columns4x4_ from the corresponding fields
   // in frame_header. Allocates reference_info_.motion_field_reference_frame,
-  // reference_info_.motion_field_mv_, and segmentation_map_. Returns true on
-  // success, false on failure.
+  // reference_info_.motion_field_mv_, and segmentation_map_, for at least the
+  // maximum frame size of the buffer pool. Returns true on success, false on
+  // failure.
   bool SetFrameDimensions(const ObuFrameHeader& frame_header);
 
   int32_t upscaled_width() const { return upscaled_width_; }
@@ -221,7 +224,7 @@ class RefCountedBuffer : public MaxAlignedAllocable {
   void Abort() {
     {
       std::lock_guard<std::mutex> lock(mutex_);
-      abort_ = true;
+      abort_.store(true, std::memory_order_relaxed);
     }
     parsed_condvar_.notify_all();
     decoded_condvar_.notify_all();
@@ -252,6 +255,11 @@ class RefCountedBuffer : public MaxAlignedAllocable {
     progress_row_condvar_.notify_all();
   }
 
+  // Returns true if Abort() has been called. This does not acquire |mutex_|
+  // and is cheap enough to be polled by the decoding threads (once per
+  // superblock row) so that they can stop working on an aborted frame early.
+  bool aborted() const { return abort_.load(std::memory_order_relaxed); }
+
   void MarkFrameAsStarted() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (frame_state_ != kFrameStateUnknown) return;
@@ -310,13 +318,28 @@ class RefCountedBuffer : public MaxAlignedAllocable {
  private:
   friend class BufferPool;
 
+  // An allocator that places the control block of the std::shared_ptr that
+  // owns the buffer in |control_block_|. Defined in buffer_pool.cc.
+  template <typename T>
+  class ControlBlockAllocator;
+
+  // Large enough for the control block of a std::shared_ptr with an empty
+  // deleter and a ControlBlockAllocator in the common standard libraries.
+  // ControlBlockAllocator checks it at compile time.
+  static constexpr size_t kControlBlockSize = 64;
+
   // Methods for BufferPool:
   RefCountedBuffer();
   ~RefCountedBuffer();
   void SetBufferPool(BufferPool* pool);
-  static void ReturnToBufferPool(RefCountedBuffer* ptr);
+  // Returns a new std::shared_ptr that owns the buffer. The buffer is returned
+  // to the pool when its control block is freed, which is the last step of
+  // releasing the last reference. So a buffer is never handed out again while
+  // |control_block_| is still in use.
+  std::shared_ptr<RefCountedBuffer> MakeSharedPtr();
 
   BufferPool* pool_ = nullptr;
+  alignas(std::max_align_t) uint8_t control_block_[kControlBlockSize];
   bool buffer_private_data_valid_ = false;
   void* buffer_private_data_ = nullptr;
   YuvBuffer yuv_buffer_;
@@ -332,7 +355,10 @@ class RefCountedBuffer : public MaxAlignedAllocable {
   std::condition_variable parsed_condvar_;
   // Signaled when the frame state is set to kFrameStateDecoded.
   std::condition_variable decoded_condvar_;
-  bool abort_ = false LIBGAV1_GUARDED_BY(mutex_);
+  // Only written while holding |mutex_| so that the waiters in the
+  // WaitUntil*() functions do not miss the update. It is atomic so that
+  // aborted() can read it without holding |mutex_|.
+  std::atomic<bool> abort_{false};
 
   FrameType frame_type_ = kFrameKey;
   ChromaSamplePosition chroma_sample_position_ = kChromaSamplePositionUnknown;
@@ -379,10 +405,9 @@ class RefCountedBuffer : public MaxAlignedAllocable {
 // RefCountedBufferPtr contains a reference to a RefCountedBuffer.
 //
 // Note: For simplicity, RefCountedBufferPtr is implemented as a
-// std::shared_ptr<RefCountedBuffer>. This requires a heap allocation of the
-// control block for std::shared_ptr. To avoid that heap allocation, we can
-// add a |ref_count_| field to RefCountedBuffer and implement a custom
-// RefCountedBufferPtr class.
+// std::shared_ptr<RefCountedBuffer>. The control block of the std::shared_ptr
+// is stored in the RefCountedBuffer, so handing out a buffer does not
+// allocate memory.
 using RefCountedBufferPtr = std::shared_ptr<RefCountedBuffer>;
 
 // BufferPool maintains a pool of RefCountedBuffers.
@@ -403,6 +428,12 @@ class BufferPool {
       int bitdepth, Libgav1ImageFormat image_format, int width, int height,
       int left_border, int right_border, int top_border, int bottom_border);
 
+  // Sizes the per-frame buffers, and the frame buffers if they are allocated
+  // internally, for frames of up to |width| x |height|, so that changing the
+  // frame size within this limit does not reallocate them. Must be called
+  // before any buffer is used.
+  void SetMaxFrameSize(int width, int height);
+
   // Finds a free buffer in the buffer pool and returns a reference to the free
   // buffer. If there is no free buffer, returns a null pointer. This function
   // is thread safe.
@@ -427,6 +458,9 @@ class BufferPool {
   // pointers in the vector.
   Vector<RefCountedBuffer*> buffers_ LIBGAV1_GUARDED_BY(mutex_);
   InternalFrameBufferList internal_frame_buffers_;
+  // The frame size passed to SetMaxFrameSize() in units of 4x4 blocks.
+  int max_rows4x4_ = 0;
+  int max_columns4x4_ = 0;
 
   // Frame buffer callbacks.
   FrameBufferSizeChangedCallback on_frame_buffer_size_changed_;
@@ -42,6 +42,15 @@ Libgav1StatusCode Libgav1DecoderCreate(const Libgav1DecoderSettings* settings,
   cxx_settings.operating_point = settings->operating_point;
   cxx_settings.post_filter_mask = settings->post_filter_mask;
   cxx_settings.parse_only = settings->parse_only != 0;
+  cxx_settings.adaptive_threading = settings->adaptive_threading != 0;
+  cxx_settings.allocate_memory = settings->allocate_memory;
+  cxx_settings.allocate_aligned_memory = settings->allocate_aligned_memory;
+  cxx_settings.free_memory = settings->free_memory;
+  cxx_settings.allocator_private_data = settings->allocator_private_data;
+  cxx_settings.max_frame_width = settings->max_frame_width;
+  cxx_settings.max_frame_height = settings->max_frame_height;
+  cxx_settings.collect_perf_counters = settings->collect_perf_counters != 0;
+  cxx_settings.max_frames_in_flight = settings->max_frames_in_flight;
 
   const Libgav1StatusCode status = cxx_decoder->Init(&cxx_settings);
   if (status == kLibgav1StatusOk) {
@@ -70,11 +79,40 @@ Libgav1StatusCode Libgav1DecoderDequeueFrame(
   return cxx_decoder->DequeueFrame(out_ptr);
 }
 
+Libgav1StatusCode Libgav1DecoderFlush(Libgav1Decoder* decoder) {
+  auto* cxx_decoder = reinterpret_cast<libgav1::Decoder*>(decoder);
+  return cxx_decoder->Flush();
+}
+
+Libgav1StatusCode Libgav1DecoderSetThreads(Libgav1Decoder* decoder,
+                                           int threads) {
+  auto* cxx_decoder = reinterpret_cast<libgav1::Decoder*>(decoder);
+  return cxx_decoder->SetThreads(threads);
+}
+
+Libgav1StatusCode Libgav1DecoderHoldFrame(
+    Libgav1Decoder* decoder, const Libgav1DecoderBuffer** out_ptr) {
+  auto* cxx_decoder = reinterpret_cast<libgav1::Decoder*>(decoder);
+  return cxx_decoder->HoldFrame(out_ptr);
+}
+
+Libgav1StatusCode Libgav1DecoderReleaseFrame(
+    Libgav1Decoder* decoder, const Libgav1DecoderBuffer* buffer) {
+  auto* cxx_decoder = reinterpret_cast<libgav1::Decoder*>(decoder);
+  return cxx_decoder->ReleaseFrame(buffer);
+}
+
 Libgav1StatusCode Libgav1DecoderSignalEOS(Libgav1Decoder* decoder) {
   auto* cxx_decoder = reinterpret_cast<libgav1::Decoder*>(decoder);
   return cxx_decoder->SignalEOS();
 }
 
+Libgav1StatusCode Libgav1DecoderGetPerfCounters(
+    const Libgav1Decoder* decoder, Libgav1PerfCounters* perf_counters) {
+  const auto* cxx_decoder = reinterpret_cast<const libgav1::Decoder*>(decoder);
+  return cxx_decoder->GetPerfCounters(perf_counters);
+}
+
 int Libgav1DecoderGetMaxBitdepth() {
   return libgav1::Decoder::GetMaxBitdepth();
 }
@@ -105,20 +143,54 @@ StatusCode Decoder::DequeueFrame(const DecoderBuffer** out_ptr) {
   if (impl_ == nullptr) return kStatusNotInitialized;
   StatusCode status = impl_->DequeueFrame(out_ptr);
   if (settings_.parse_only) {
-    frame_mean_qps_ = impl_->GetFrameQps();
+    // assign() reuses the capacity of |frame_mean_qps_|.
+    const std::vector<int>& frame_qps = impl_->GetFrameQps();
+    frame_mean_qps_.assign(frame_qps.begin(), frame_qps.end());
   }
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+  if (status == kStatusOk && *out_ptr != nullptr) ReportTracedAllocations();
+#endif
   return status;
 }
 
+StatusCode Decoder::Flush() {
+  if (impl_ == nullptr) return kStatusNotInitialized;
+  return impl_->Flush();
+}
+
+StatusCode Decoder::SetThreads(int threads) {
+  if (impl_ == nullptr) return kStatusNotInitialized;
+  const StatusCode status = impl_->SetThreads(threads);
+  // Remember the value so that it is retained across SignalEOS().
+  if (status == kStatusOk) settings_.threads = threads;
+  return status;
+}
+
+StatusCode Decoder::HoldFrame(const DecoderBuffer** out_ptr) {
+  if (impl_ == nullptr) return kStatusNotInitialized;
+  return impl_->HoldFrame(out_ptr);
+}
+
+StatusCode Decoder::ReleaseFrame(const DecoderBuffer* buffer) {
+  if (impl_ == nullptr) return kStatusNotInitialized;
+  return impl_->ReleaseFrame(buffer);
+}
+
 StatusCode Decoder::SignalEOS() {
   if (impl_ == nullptr) return kStatusNotInitialized;
   // In non-frame-parallel mode, we have to release all the references. This
   // simply means replacing the |impl_| with a new instance so that all the
-  // existing references are released and the state is cleared.
+  // existing references are released and the state is cleared. This includes
+  // the stage costs measured for |settings_.adaptive_threading|.
   impl_ = nullptr;
   return DecoderImpl::Create(&settings_, &impl_);
 }
 
+StatusCode Decoder::GetPerfCounters(PerfCounters* perf_counters) const {
+  if (impl_ == nullptr) return kStatusNotInitialized;
+  return impl_->GetPerfCounters(perf_counters);
+}
+
 // static.
 int Decoder::GetMaxBitdepth() { return DecoderImpl::GetMaxBitdepth(); }
 
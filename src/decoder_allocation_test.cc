@@ -0,0 +1,150 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The tests in this file replace the global operator new and delete, which
+// affects every test linked into the same binary. They are kept out of
+// decoder_test.cc for that reason.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "src/decoder_test_data.h"
+#include "src/gav1/decoder.h"
+
+namespace libgav1 {
+namespace {
+
+constexpr uint8_t kFrame1[] = {OBU_TEMPORAL_DELIMITER, OBU_SEQUENCE_HEADER,
+                               OBU_FRAME_1};
+
+constexpr uint8_t kFrame2[] = {OBU_TEMPORAL_DELIMITER, OBU_FRAME_2};
+
+// Counts the calls of the memory allocation callbacks.
+struct AllocationCounts {
+  std::atomic<int> allocations{0};
+  std::atomic<int> frees{0};
+};
+
+extern "C" {
+
+static void* CountingAllocate(void* allocator_private_data, size_t size) {
+  ++static_cast<AllocationCounts*>(allocator_private_data)->allocations;
+  return malloc(size);
+}
+
+static void CountingFree(void* allocator_private_data, void* ptr) {
+  ++static_cast<AllocationCounts*>(allocator_private_data)->frees;
+  free(ptr);
+}
+
+}  // extern "C"
+
+// The global operator new below counts its calls while |count_operator_new| is
+// true. This catches the allocations that do not go through the allocator
+// callbacks, such as those of std::function, std::vector and std::shared_ptr.
+std::atomic<bool> count_operator_new{false};
+std::atomic<int> operator_new_calls{0};
+
+TEST(DecoderAllocationTest, SteadyStateAllocations) {
+  AllocationCounts counts;
+  std::unique_ptr<Decoder> decoder(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 1;
+  settings.allocate_memory = CountingAllocate;
+  settings.free_memory = CountingFree;
+  settings.allocator_private_data = &counts;
+  ASSERT_EQ(decoder->Init(&settings), kStatusOk);
+
+  // The first two passes allocate the buffers, including the frame buffers
+  // that are still referenced by the reference frames of the previous pass.
+  // The next passes decode the same frames and must reuse them.
+  for (int pass = 0; pass < 4; ++pass) {
+    SCOPED_TRACE(pass);
+    const int allocations = counts.allocations;
+    int frames = 0;
+    operator_new_calls = 0;
+    count_operator_new = true;
+    for (const auto& frame : {std::make_pair(kFrame1, sizeof(kFrame1)),
+                              std::make_pair(kFrame2, sizeof(kFrame2))}) {
+      const DecoderBuffer* buffer = nullptr;
+      if (decoder->EnqueueFrame(frame.first, frame.second, 0, nullptr) !=
+              kStatusOk ||
+          decoder->DequeueFrame(&buffer) != kStatusOk || buffer == nullptr) {
+        break;
+      }
+      ++frames;
+    }
+    count_operator_new = false;
+    EXPECT_EQ(frames, 2);
+    if (frames != 2) break;
+    if (pass < 2) continue;
+    EXPECT_EQ(counts.allocations, allocations);
+    EXPECT_EQ(operator_new_calls, 0);
+  }
+
+  // |counts| must outlive the decoder.
+  decoder = nullptr;
+  EXPECT_EQ(counts.frees, counts.allocations);
+}
+
+}  // namespace
+}  // namespace libgav1
+
+// Replacements of the global allocation functions. All of them use malloc()
+// and free() so that memory allocated by any form of operator new can be
+// released by any form of operator delete.
+void* operator new(size_t size) {
+  if (libgav1::count_operator_new) ++libgav1::operator_new_calls;
+  void* const ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  if (libgav1::count_operator_new) ++libgav1::operator_new_calls;
+  return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+
+void operator delete[](void* ptr) noexcept { free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  free(ptr);
+}
+
+// The sized forms are only declared by <new> when sized deallocation is
+// enabled (C++14 and later).
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, size_t /*size*/) noexcept { free(ptr); }
+
+void operator delete[](void* ptr, size_t /*size*/) noexcept { free(ptr); }
+#endif
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>  // NOLINT (unapproved c++11 header)
 #include <cmath>
 #include <iterator>
 #include <new>
@@ -38,6 +39,7 @@
 #include "src/utils/common.h"
 #include "src/utils/constants.h"
 #include "src/utils/logging.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/raw_bit_reader.h"
 #include "src/utils/segmentation.h"
 #include "src/utils/threadpool.h"
@@ -49,6 +51,14 @@ namespace {
 constexpr int kMaxBlockWidth4x4 = 32;
 constexpr int kMaxBlockHeight4x4 = 32;
 
+using Clock = std::chrono::steady_clock;
+
+int64_t MicrosecondsSince(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               start)
+      .count();
+}
+
 // Computes the bottom border size in pixels. If CDEF, loop restoration or
 // SuperRes is enabled, adds extra border pixels to facilitate those steps to
 // happen nearly in-place (a few extra rows instead of an entire frame buffer).
@@ -105,6 +115,17 @@ class FrameScratchBufferReleaser {
   std::unique_ptr<FrameScratchBuffer>* const frame_scratch_buffer_;
 };
 
+// Destroys the tiles in |tiles| when it goes out of scope. The capacity of
+// |tiles| and the memory of the tiles are kept for the next frame.
+class TilesReleaser {
+ public:
+  explicit TilesReleaser(Vector<TilePtr>* tiles) : tiles_(tiles) {}
+  ~TilesReleaser() { tiles_->clear(); }
+
+ private:
+  Vector<TilePtr>* const tiles_;
+};
+
 // Sets the |frame|'s segmentation map for two cases. The third case is handled
 // in Tile::DecodeBlock().
 void SetSegmentationMap(const ObuFrameHeader& frame_header,
@@ -125,10 +146,36 @@ void SetSegmentationMap(const ObuFrameHeader& frame_header,
   }
 }
 
+// Parses and decodes the tile at |tile_index| and records the time it took in
+// |tile_costs|.
+bool ParseAndDecodeTile(const Vector<TilePtr>& tiles,
+                        int tile_index, TileCost* const tile_costs) {
+  const Clock::time_point start = Clock::now();
+  if (!tiles[tile_index]->ParseAndDecode()) {
+    LIBGAV1_DLOG(ERROR, "Error decoding tile #%d", tile_index);
+    return false;
+  }
+  tile_costs[tile_index].microseconds = MicrosecondsSince(start);
+  return true;
+}
+
+// Parses the tile at |tile_index| and records the time it took in
+// |tile_costs|.
+bool ParseTile(const Vector<TilePtr>& tiles, int tile_index,
+               TileCost* const tile_costs) {
+  const Clock::time_point start = Clock::now();
+  if (!tiles[tile_index]->Parse()) {
+    LIBGAV1_DLOG(ERROR, "Error parsing tile #%d", tile_index);
+    return false;
+  }
+  tile_costs[tile_index].microseconds = MicrosecondsSince(start);
+  return true;
+}
+
 StatusCode DecodeTilesNonFrameParallel(
     const ObuSequenceHeader& sequence_header,
     const ObuFrameHeader& frame_header,
-    const Vector<std::unique_ptr<Tile>>& tiles,
+    const Vector<TilePtr>& tiles,
     FrameScratchBuffer* const frame_scratch_buffer,
     PostFilter* const post_filter) {
   // Decode in superblock row order.
@@ -154,9 +201,8 @@ StatusCode DecodeTilesNonFrameParallel(
 }
 
 StatusCode DecodeTilesThreadedNonFrameParallel(
-    const Vector<std::unique_ptr<Tile>>& tiles,
+    const Vector<TilePtr>& tiles,
     FrameScratchBuffer* const frame_scratch_buffer,
-    PostFilter* const post_filter,
     BlockingCounterWithStatus* const pending_tiles) {
   ThreadingStrategy& threading_strategy =
       frame_scratch_buffer->threading_strategy;
@@ -164,10 +210,14 @@ StatusCode DecodeTilesThreadedNonFrameParallel(
   BlockingCounterWithStatus pending_workers(num_workers);
   std::atomic<int> tile_counter(0);
   const int tile_count = static_cast<int>(tiles.size());
+  const int* const tile_order = frame_scratch_buffer->tile_order.get();
+  TileCost* const tile_costs = frame_scratch_buffer->tile_costs.get();
   bool tile_decoding_failed = false;
-  // Submit tile decoding jobs to the thread pool.
+  // Submit tile decoding jobs to the thread pool. The tiles are handed out in
+  // the order of decreasing estimated cost.
   for (int i = 0; i < num_workers; ++i) {
     threading_strategy.tile_thread_pool()->Schedule([&tiles, tile_count,
+                                                     tile_order, tile_costs,
                                                      &tile_counter,
                                                      &pending_workers,
                                                      &pending_tiles]() {
@@ -176,11 +226,7 @@ StatusCode DecodeTilesThreadedNonFrameParallel(
       while ((index = tile_counter.fetch_add(1, std::memory_order_relaxed)) <
              tile_count) {
         if (!failed) {
-          const auto& tile_ptr = tiles[index];
-          if (!tile_ptr->ParseAndDecode()) {
-            LIBGAV1_DLOG(ERROR, "Error decoding tile #%d", tile_ptr->number());
-            failed = true;
-          }
+          failed = !ParseAndDecodeTile(tiles, tile_order[index], tile_costs);
         } else {
           pending_tiles->Decrement(false);
         }
@@ -193,11 +239,8 @@ StatusCode DecodeTilesThreadedNonFrameParallel(
   while ((index = tile_counter.fetch_add(1, std::memory_order_relaxed)) <
          tile_count) {
     if (!tile_decoding_failed) {
-      const auto& tile_ptr = tiles[index];
-      if (!tile_ptr->ParseAndDecode()) {
-        LIBGAV1_DLOG(ERROR, "Error decoding tile #%d", tile_ptr->number());
-        tile_decoding_failed = true;
-      }
+      tile_decoding_failed =
+          !ParseAndDecodeTile(tiles, tile_order[index], tile_costs);
     } else {
       pending_tiles->Decrement(false);
     }
@@ -208,12 +251,10 @@ StatusCode DecodeTilesThreadedNonFrameParallel(
   // Wait until all the tiles have been decoded.
   tile_decoding_failed |= !pending_tiles->Wait();
   if (tile_decoding_failed) return kStatusUnknownError;
-  assert(threading_strategy.post_filter_thread_pool() != nullptr);
-  post_filter->ApplyFilteringThreaded();
   return kStatusOk;
 }
 
-StatusCode ParseTiles(const Vector<std::unique_ptr<Tile>>& tiles) {
+StatusCode ParseTiles(const Vector<TilePtr>& tiles) {
   for (const auto& tile : tiles) {
     if (!tile->Parse()) {
       LIBGAV1_DLOG(ERROR, "Failed to parse tile number: %d\n", tile->number());
@@ -226,7 +267,7 @@ StatusCode ParseTiles(const Vector<std::unique_ptr<Tile>>& tiles) {
 StatusCode DecodeTilesFrameParallel(
     const ObuSequenceHeader& sequence_header,
     const ObuFrameHeader& frame_header,
-    const Vector<std::unique_ptr<Tile>>& tiles,
+    const Vector<TilePtr>& tiles,
     const SymbolDecoderContext& saved_symbol_decoder_context,
     const SegmentationMap* const prev_segment_ids,
     FrameScratchBuffer* const frame_scratch_buffer,
@@ -277,7 +318,7 @@ StatusCode DecodeTilesFrameParallel(
 // Helper function used by DecodeTilesThreadedFrameParallel. Applies the
 // deblocking filter for tile boundaries for the superblock row at |row4x4|.
 void ApplyDeblockingFilterForTileBoundaries(
-    PostFilter* const post_filter, const std::unique_ptr<Tile>* tile_row_base,
+    PostFilter* const post_filter, const TilePtr* tile_row_base,
     const ObuFrameHeader& frame_header, int row4x4, int block_width4x4,
     int tile_columns, bool decode_entire_tiles_in_worker_threads) {
   // Apply vertical deblock filtering for the first 64 columns of each tile.
@@ -345,7 +386,7 @@ void ApplyDeblockingFilterForTileBoundaries(
 //   * If an entire superblock row of the frame has been decoded, it notifies
 //     the waiters (if there are any).
 void DecodeSuperBlockRowInTile(
-    const Vector<std::unique_ptr<Tile>>& tiles, size_t tile_index, int row4x4,
+    const Vector<TilePtr>& tiles, size_t tile_index, int row4x4,
     const int superblock_size4x4, const int tile_columns,
     const int superblock_rows, FrameScratchBuffer* const frame_scratch_buffer,
     PostFilter* const post_filter, BlockingCounter* const pending_jobs) {
@@ -421,7 +462,7 @@ void DecodeSuperBlockRowInTile(
 StatusCode DecodeTilesThreadedFrameParallel(
     const ObuSequenceHeader& sequence_header,
     const ObuFrameHeader& frame_header,
-    const Vector<std::unique_ptr<Tile>>& tiles,
+    const Vector<TilePtr>& tiles,
     const SymbolDecoderContext& saved_symbol_decoder_context,
     const SegmentationMap* const prev_segment_ids,
     FrameScratchBuffer* const frame_scratch_buffer,
@@ -432,20 +473,20 @@ StatusCode DecodeTilesThreadedFrameParallel(
   std::atomic<int> tile_counter(0);
   const int tile_count = static_cast<int>(tiles.size());
   const int num_workers = thread_pool.num_threads();
+  const int* const tile_order = frame_scratch_buffer->tile_order.get();
+  TileCost* const tile_costs = frame_scratch_buffer->tile_costs.get();
   BlockingCounterWithStatus parse_workers(num_workers);
-  // Submit tile parsing jobs to the thread pool.
+  // Submit tile parsing jobs to the thread pool. The tiles are handed out in
+  // the order of decreasing estimated cost.
   for (int i = 0; i < num_workers; ++i) {
-    thread_pool.Schedule([&tiles, tile_count, &tile_counter, &parse_workers]() {
+    thread_pool.Schedule([&tiles, tile_count, tile_order, tile_costs,
+                          &tile_counter, &parse_workers]() {
       bool failed = false;
       int index;
       while ((index = tile_counter.fetch_add(1, std::memory_order_relaxed)) <
              tile_count) {
         if (!failed) {
-          const auto& tile_ptr = tiles[index];
-          if (!tile_ptr->Parse()) {
-            LIBGAV1_DLOG(ERROR, "Error parsing tile #%d", tile_ptr->number());
-            failed = true;
-          }
+          failed = !ParseTile(tiles, tile_order[index], tile_costs);
         }
       }
       parse_workers.Decrement(!failed);
@@ -458,11 +499,7 @@ StatusCode DecodeTilesThreadedFrameParallel(
   while ((index = tile_counter.fetch_add(1, std::memory_order_relaxed)) <
          tile_count) {
     if (!failed) {
-      const auto& tile_ptr = tiles[index];
-      if (!tile_ptr->Parse()) {
-        LIBGAV1_DLOG(ERROR, "Error parsing tile #%d", tile_ptr->number());
-        failed = true;
-      }
+      failed = !ParseTile(tiles, tile_order[index], tile_costs);
     }
   }
 
@@ -500,7 +537,9 @@ StatusCode DecodeTilesThreadedFrameParallel(
   BlockingCounter pending_jobs(
       decode_entire_tiles_in_worker_threads ? num_workers : tile_columns);
   if (decode_entire_tiles_in_worker_threads) {
-    // Submit tile decoding jobs to the thread pool.
+    // Submit tile decoding jobs to the thread pool. Unlike parsing, the tiles
+    // are decoded in the bitstream order since the post filters (and hence
+    // the frames that refer to this frame) progress in superblock row order.
     tile_counter = 0;
     for (int i = 0; i < num_workers; ++i) {
       thread_pool.Schedule([&tiles, tile_count, &tile_counter, &pending_jobs,
@@ -541,9 +580,15 @@ StatusCode DecodeTilesThreadedFrameParallel(
   // Current thread will do the post filters.
   std::condition_variable* const superblock_row_progress_condvar =
       frame_scratch_buffer->superblock_row_progress_condvar.get();
-  const std::unique_ptr<Tile>* tile_row_base = &tiles[0];
+  const TilePtr* tile_row_base = &tiles[0];
   for (int row4x4 = 0, index = 0; row4x4 < frame_header.rows4x4;
        row4x4 += block_width4x4, ++index) {
+    if (current_frame->aborted()) {
+      // The tile workers will stop at their next superblock row. Do not wait
+      // for them to make any further progress.
+      SetFailureAndNotifyAll(frame_scratch_buffer, superblock_rows);
+      break;
+    }
     if (!tile_row_base[0]->IsRow4x4Inside(row4x4)) {
       tile_row_base += tile_columns;
     }
@@ -588,7 +633,7 @@ StatusCode DecodeTilesThreadedFrameParallel(
   return kStatusOk;
 }
 
-int CalcFrameMeanQp(const Vector<std::unique_ptr<Tile>>& tiles) {
+int CalcFrameMeanQp(const Vector<TilePtr>& tiles) {
   int cumulative_frame_qp = 0;
   for (const auto& tile : tiles) {
     cumulative_frame_qp += tile->GetTileMeanQP();
@@ -604,6 +649,67 @@ int CalcFrameMeanQp(const Vector<std::unique_ptr<Tile>>& tiles) {
   return frame_mean_qp;
 }
 
+// Returns a bitmask of the slots of the reference_frame array that may be
+// read while decoding the frame described by |frame_header|. Intra frames do
+// not read any reference frame; inter frames only read the ones listed in
+// reference_frame_index (the primary reference frame and the film grain
+// reference are always among them).
+int GetReferencedFrameMask(const ObuFrameHeader& frame_header) {
+  if (IsIntraFrame(frame_header.frame_type)) return 0;
+  int mask = 0;
+  for (const int index : frame_header.reference_frame_index) {
+    assert(index >= 0 && index < kNumReferenceFrameTypes);
+    mask |= 1 << index;
+  }
+  return mask;
+}
+
+// Allocates the buffers of |frame_scratch_buffer| whose size depends on the
+// frame size for frames of up to |width| x |height|. The arguments of the
+// Reserve() calls mirror the Reset() calls in DecoderImpl::DecodeTiles().
+bool ReserveFrameScratchBuffer(int width, int height, int8_t subsampling_x,
+                               int8_t subsampling_y, bool reserve_deblock,
+                               FrameScratchBuffer* const frame_scratch_buffer) {
+  const int rows4x4 = ((height + 7) >> 3) << 1;
+  const int columns4x4 = ((width + 7) >> 3) << 1;
+  const size_t padded_rows4x4 = rows4x4 + kMaxBlockHeight4x4;
+  const size_t padded_columns4x4 = columns4x4 + kMaxBlockWidth4x4;
+  if (!frame_scratch_buffer->cdef_index.Reserve(
+          DivideBy16(padded_rows4x4) * DivideBy16(padded_columns4x4)) ||
+      !frame_scratch_buffer->cdef_skip.Reserve(DivideBy2(padded_rows4x4) *
+                                               DivideBy16(padded_columns4x4)) ||
+      !frame_scratch_buffer->inter_transform_sizes.Reserve(padded_rows4x4 *
+                                                           padded_columns4x4) ||
+      !frame_scratch_buffer->motion_field.mv.Reserve(
+          static_cast<size_t>(DivideBy2(rows4x4)) * DivideBy2(columns4x4)) ||
+      !frame_scratch_buffer->motion_field.reference_offset.Reserve(
+          static_cast<size_t>(DivideBy2(rows4x4)) * DivideBy2(columns4x4)) ||
+      !frame_scratch_buffer->block_parameters_holder.Reserve(
+          rows4x4 + kMaxBlockHeight4x4, columns4x4 + kMaxBlockWidth4x4)) {
+    return false;
+  }
+  if (!reserve_deblock) return true;
+  for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+    const size_t size =
+        static_cast<size_t>(SubsampledValue(
+            rows4x4, (plane == kPlaneY) ? 0 : subsampling_y)) *
+        SubsampledValue(columns4x4, (plane == kPlaneY) ? 0 : subsampling_x);
+    for (auto& deblock_edges : frame_scratch_buffer->deblock_edges) {
+      if (!deblock_edges[plane].Reserve(size)) return false;
+    }
+  }
+  return true;
+}
+
+Allocator GetAllocator(const DecoderSettings& settings) {
+  Allocator allocator;
+  allocator.allocate = settings.allocate_memory;
+  allocator.allocate_aligned = settings.allocate_aligned_memory;
+  allocator.deallocate = settings.free_memory;
+  allocator.private_data = settings.allocator_private_data;
+  return allocator;
+}
+
 }  // namespace
 
 // static
@@ -613,6 +719,11 @@ StatusCode DecoderImpl::Create(const DecoderSettings* settings,
     LIBGAV1_DLOG(ERROR, "Invalid settings->threads: %d.", settings->threads);
     return kStatusInvalidArgument;
   }
+  if (settings->max_frames_in_flight < 0) {
+    LIBGAV1_DLOG(ERROR, "Invalid settings->max_frames_in_flight: %d.",
+                 settings->max_frames_in_flight);
+    return kStatusInvalidArgument;
+  }
   if (settings->frame_parallel) {
     if (settings->release_input_buffer == nullptr) {
       LIBGAV1_DLOG(ERROR,
@@ -629,6 +740,22 @@ StatusCode DecoderImpl::Create(const DecoderSettings* settings,
         "the frame_parallel option cannot be used in the parse_only mode.");
     return kStatusInvalidArgument;
   }
+  if (settings->allocate_memory == nullptr
+          ? (settings->allocate_aligned_memory != nullptr ||
+             settings->free_memory != nullptr)
+          : settings->free_memory == nullptr) {
+    LIBGAV1_DLOG(ERROR,
+                 "allocate_memory and free_memory must both be set or both be "
+                 "null, and allocate_aligned_memory requires allocate_memory.");
+    return kStatusInvalidArgument;
+  }
+  if (settings->max_frame_width < 0 || settings->max_frame_height < 0 ||
+      (settings->max_frame_width == 0) != (settings->max_frame_height == 0)) {
+    LIBGAV1_DLOG(ERROR, "Invalid settings->max_frame_width/height: %dx%d.",
+                 settings->max_frame_width, settings->max_frame_height);
+    return kStatusInvalidArgument;
+  }
+  const ScopedAllocator scoped_allocator(GetAllocator(*settings));
   std::unique_ptr<DecoderImpl> impl(new (std::nothrow) DecoderImpl(settings));
   if (impl == nullptr) {
     LIBGAV1_DLOG(ERROR, "Failed to allocate DecoderImpl.");
@@ -644,17 +771,23 @@ DecoderImpl::DecoderImpl(const DecoderSettings* settings)
     : buffer_pool_(settings->on_frame_buffer_size_changed,
                    settings->get_frame_buffer, settings->release_frame_buffer,
                    settings->callback_private_data),
-      settings_(*settings) {
+      settings_(*settings),
+      allocator_(GetAllocator(*settings)),
+      threads_(settings->threads) {
   dsp::DspInit();
+  buffer_pool_.SetMaxFrameSize(settings->max_frame_width,
+                               settings->max_frame_height);
 }
 
 DecoderImpl::~DecoderImpl() {
+  const ScopedAllocator scoped_allocator(allocator_);
   // Clean up and wait until all the threads have stopped. We just have to pass
   // in a dummy status that is not kStatusOk or kStatusTryAgain to trigger the
   // path that clears all the threads and structs.
   SignalFailure(kStatusUnknownError);
   // Release any other frame buffer references that we may be holding on to.
   ReleaseOutputFrame();
+  held_frames_.clear();
   output_frame_queue_.Clear();
   for (auto& reference_frame : state_.reference_frame) {
     reference_frame = nullptr;
@@ -666,6 +799,17 @@ StatusCode DecoderImpl::Init() {
     LIBGAV1_DLOG(ERROR, "output_frame_queue_.Init() failed.");
     return kStatusOutOfMemory;
   }
+  if (settings_.collect_perf_counters) {
+    if (PerfCountersAvailable()) {
+      perf_counter_totals_.reset(new (std::nothrow) PerfCounterTotals());
+      if (perf_counter_totals_ == nullptr) {
+        LIBGAV1_DLOG(ERROR, "Failed to allocate PerfCounterTotals.");
+        return kStatusOutOfMemory;
+      }
+    } else {
+      LIBGAV1_DLOG(WARNING, "Performance counters are not available.");
+    }
+  }
   return kStatusOk;
 }
 
@@ -690,10 +834,12 @@ StatusCode DecoderImpl::InitializeFrameThreadPoolAndTemporalUnitQueue(
     // We assume that the first frame that was parsed will contain the frame
     // header. This assumption is usually true in practice. So we will simply
     // not use frame parallel mode if this is not the case.
-    if (settings_.threads > 1 &&
+    frame_parallel_tile_count_ = obu->frame_header().tile_info.tile_count;
+    frame_parallel_tile_columns_ = obu->frame_header().tile_info.tile_columns;
+    if (threads_ > 1 &&
         !InitializeThreadPoolsForFrameParallel(
-            settings_.threads, obu->frame_header().tile_info.tile_count,
-            obu->frame_header().tile_info.tile_columns, &frame_thread_pool_,
+            threads_, frame_parallel_tile_count_, frame_parallel_tile_columns_,
+            settings_.max_frames_in_flight, &frame_thread_pool_,
             &frame_scratch_buffer_pool_)) {
       return kStatusOutOfMemory;
     }
@@ -712,6 +858,9 @@ StatusCode DecoderImpl::InitializeFrameThreadPoolAndTemporalUnitQueue(
 StatusCode DecoderImpl::EnqueueFrame(const uint8_t* data, size_t size,
                                      int64_t user_private_data,
                                      void* buffer_private_data) {
+  const ScopedAllocator scoped_allocator(allocator_);
+  const ScopedPerfCounterCollection perf_counter_collection(
+      perf_counter_totals_.get());
   if (data == nullptr || size == 0) return kStatusInvalidArgument;
   if (HasFailure()) return kStatusUnknownError;
   if (!seen_first_frame_) {
@@ -757,10 +906,116 @@ StatusCode DecoderImpl::SignalFailure(StatusCode status) {
   return status;
 }
 
+StatusCode DecoderImpl::Flush() {
+  const ScopedAllocator scoped_allocator(allocator_);
+  if (HasFailure()) return kStatusUnknownError;
+  if (is_frame_parallel_) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      flushing_ = true;
+    }
+    // Wake up all the threads that are waiting on frame progress. The frames
+    // that are being decoded notice the abort at the next superblock row and
+    // the frames that have not started yet are skipped altogether.
+    buffer_pool_.Abort();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_frames_ != 0) {
+      idle_condvar_.wait(lock);
+    }
+    flushing_ = false;
+  }
+  // None of the worker threads refer to |temporal_units_| any more, so it is
+  // safe to discard them.
+  while (!temporal_units_.Empty()) {
+    TemporalUnit& temporal_unit = temporal_units_.Front();
+    if (settings_.release_input_buffer != nullptr &&
+        !temporal_unit.released_input_buffer) {
+      settings_.release_input_buffer(settings_.callback_private_data,
+                                     temporal_unit.buffer_private_data);
+    }
+    temporal_units_.Pop();
+  }
+  ReleaseOutputFrame();
+  output_frame_queue_.Clear();
+  // Decoding resumes at the next random access point, so none of the
+  // reference frames will be used again. The sequence header is retained.
+  state_ = DecoderState();
+  stage_costs_.Reset();
+  return kStatusOk;
+}
+
+StatusCode DecoderImpl::SetThreads(int threads) {
+  const ScopedAllocator scoped_allocator(allocator_);
+  if (threads <= 0) {
+    LIBGAV1_DLOG(ERROR, "Invalid threads: %d.", threads);
+    return kStatusInvalidArgument;
+  }
+  if (settings_.parse_only && threads > 1) {
+    LIBGAV1_DLOG(ERROR,
+                 "The number of threads cannot be more than 1 in the "
+                 "parse_only mode.");
+    return kStatusInvalidArgument;
+  }
+  if (HasFailure()) return kStatusUnknownError;
+  if (threads == threads_) return kStatusOk;
+  // In non-frame-parallel mode, the thread pool is resized by
+  // ThreadingStrategy::Reset() when the next frame is decoded. Likewise, if
+  // frame parallel mode has not been set up yet, the new value will be used
+  // when the first frame is seen.
+  if (is_frame_parallel_) {
+    // In frame parallel mode, let the frames that are in flight finish with
+    // the threads that they started with. Then the frame threads and their
+    // worker threads are recreated for the new count.
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (pending_frames_ != 0) {
+        idle_condvar_.wait(lock);
+      }
+    }
+    // Every frame thread has one frame in flight, so the capacity of
+    // |temporal_units_| follows the number of frame threads. The temporal
+    // units that have been decoded but not dequeued yet are kept. Everything
+    // is allocated before the thread pools are replaced so that the decoder
+    // keeps decoding with the current threads if an allocation fails.
+    const int frame_threads = ComputeFrameThreadCountForResize(
+        threads, frame_parallel_tile_count_, frame_parallel_tile_columns_,
+        settings_.max_frames_in_flight);
+    const size_t capacity = std::max(static_cast<size_t>(frame_threads),
+                                     temporal_units_.Size());
+    Queue<TemporalUnit> temporal_units;
+    if (!temporal_units.Init(capacity)) {
+      LIBGAV1_DLOG(ERROR, "temporal_units.Init() failed.");
+      return kStatusOutOfMemory;
+    }
+    if (!ResizeThreadPoolsForFrameParallel(
+            threads, frame_parallel_tile_count_, frame_parallel_tile_columns_,
+            settings_.max_frames_in_flight, &frame_thread_pool_,
+            &frame_scratch_buffer_pool_)) {
+      return kStatusOutOfMemory;
+    }
+    assert(frame_thread_pool_->num_threads() == frame_threads);
+    while (!temporal_units_.Empty()) {
+      temporal_units.Push(std::move(temporal_units_.Front()));
+      temporal_units_.Pop();
+      for (EncodedFrame& encoded_frame : temporal_units.Back().frames) {
+        encoded_frame.temporal_unit = &temporal_units.Back();
+      }
+    }
+    temporal_units_ = std::move(temporal_units);
+  }
+  threads_ = threads;
+  // The stage costs were measured with the previous thread count.
+  stage_costs_.Reset();
+  return kStatusOk;
+}
+
 // DequeueFrame() follows the following policy to avoid holding unnecessary
 // frame buffer references in output_frame_: output_frame_ must be null when
 // DequeueFrame() returns false.
 StatusCode DecoderImpl::DequeueFrame(const DecoderBuffer** out_ptr) {
+  const ScopedAllocator scoped_allocator(allocator_);
+  const ScopedPerfCounterCollection perf_counter_collection(
+      perf_counter_totals_.get());
   if (out_ptr == nullptr) {
     LIBGAV1_DLOG(ERROR, "Invalid argument: out_ptr == nullptr.");
     return kStatusInvalidArgument;
@@ -856,28 +1111,76 @@ StatusCode DecoderImpl::DequeueFrame(const DecoderBuffer** out_ptr) {
   return kStatusOk;
 }
 
-std::vector<int> DecoderImpl::GetFrameQps() { return frame_mean_qps_; }
+StatusCode DecoderImpl::HoldFrame(const DecoderBuffer** out_ptr) {
+  const ScopedAllocator scoped_allocator(allocator_);
+  if (out_ptr == nullptr) {
+    LIBGAV1_DLOG(ERROR, "Invalid argument: out_ptr == nullptr.");
+    return kStatusInvalidArgument;
+  }
+  if (output_frame_ == nullptr) {
+    *out_ptr = nullptr;
+    return kStatusNothingToDequeue;
+  }
+  std::unique_ptr<HeldFrame> held_frame(new (std::nothrow) HeldFrame);
+  if (held_frame == nullptr) {
+    LIBGAV1_DLOG(ERROR, "Failed to allocate HeldFrame.");
+    return kStatusOutOfMemory;
+  }
+  held_frame->buffer = buffer_;
+  held_frame->frame = output_frame_;
+  const DecoderBuffer* const buffer = &held_frame->buffer;
+  if (!held_frames_.push_back(std::move(held_frame))) {
+    LIBGAV1_DLOG(ERROR, "held_frames_.push_back() failed.");
+    return kStatusOutOfMemory;
+  }
+  *out_ptr = buffer;
+  return kStatusOk;
+}
+
+StatusCode DecoderImpl::ReleaseFrame(const DecoderBuffer* buffer) {
+  const ScopedAllocator scoped_allocator(allocator_);
+  for (auto it = held_frames_.begin(); it != held_frames_.end(); ++it) {
+    if (&(*it)->buffer == buffer) {
+      // The order of |held_frames_| does not matter, so move the last entry
+      // into the released slot to avoid shifting the remaining entries.
+      if (it != &held_frames_.back()) *it = std::move(held_frames_.back());
+      held_frames_.pop_back();
+      return kStatusOk;
+    }
+  }
+  LIBGAV1_DLOG(ERROR, "ReleaseFrame() called with a buffer that is not held.");
+  return kStatusInvalidArgument;
+}
+
+StatusCode DecoderImpl::GetPerfCounters(PerfCounters* perf_counters) const {
+  if (perf_counter_totals_ == nullptr) return kStatusUnimplemented;
+  if (perf_counters == nullptr) return kStatusInvalidArgument;
+  perf_counter_totals_->Get(perf_counters);
+  return kStatusOk;
+}
+
+const std::vector<int>& DecoderImpl::GetFrameQps() const {
+  return frame_mean_qps_;
+}
 
 StatusCode DecoderImpl::ParseAndSchedule(const uint8_t* data, size_t size,
                                          int64_t user_private_data,
                                          void* buffer_private_data) {
   TemporalUnit temporal_unit(data, size, user_private_data,
                              buffer_private_data);
-  std::unique_ptr<ObuParser> obu(new (std::nothrow) ObuParser(
-      temporal_unit.data, temporal_unit.size, settings_.operating_point,
-      &buffer_pool_, &state_));
+  ObuParser* const obu = GetObuParser(temporal_unit.data, temporal_unit.size);
   if (obu == nullptr) {
     LIBGAV1_DLOG(ERROR, "Failed to allocate OBU parser.");
     return kStatusOutOfMemory;
   }
-  if (has_sequence_header_) {
-    obu->set_sequence_header(sequence_header_);
-  }
   StatusCode status;
   int position_in_temporal_unit = 0;
   while (obu->HasData()) {
     RefCountedBufferPtr current_frame;
-    status = obu->ParseOneFrame(&current_frame);
+    {
+      const ScopedPerfStage perf_stage(kPerfStageParse);
+      status = obu->ParseOneFrame(&current_frame);
+    }
     if (status != kStatusOk) {
       LIBGAV1_DLOG(ERROR, "Failed to parse OBU.");
       return status;
@@ -917,11 +1220,17 @@ StatusCode DecoderImpl::ParseAndSchedule(const uint8_t* data, size_t size,
     // Note that we cannot set EncodedFrame.temporal_unit here. It will be set
     // in the code below after |temporal_unit| is std::move'd into the
     // |temporal_units_| queue.
-    if (!temporal_unit.frames.emplace_back(obu.get(), state_, current_frame,
+    if (!temporal_unit.frames.emplace_back(obu, state_, current_frame,
                                            position_in_temporal_unit++)) {
       LIBGAV1_DLOG(ERROR, "temporal_unit.frames.emplace_back failed.");
       return kStatusOutOfMemory;
     }
+    // The copy of the decoder state only needs to keep alive the reference
+    // frames that the frame reads. Holding the others until the frame is
+    // decoded would delay their return to the buffer pool.
+    temporal_unit.frames.back().state.ReleaseReferenceFrames(
+        ~GetReferencedFrameMask(obu->frame_header()) &
+        ((1 << kNumReferenceFrameTypes) - 1));
     state_.UpdateReferenceFrames(current_frame,
                                  obu->frame_header().refresh_frame_flags);
   }
@@ -937,41 +1246,55 @@ StatusCode DecoderImpl::ParseAndSchedule(const uint8_t* data, size_t size,
   for (auto& frame : temporal_units_.Back().frames) {
     EncodedFrame* const encoded_frame = &frame;
     encoded_frame->temporal_unit = &temporal_units_.Back();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++pending_frames_;
+    }
     frame_thread_pool_->Schedule([this, encoded_frame]() {
-      if (HasFailure()) return;
-      const StatusCode status = DecodeFrame(encoded_frame);
-      encoded_frame->state = {};
-      encoded_frame->frame = nullptr;
-      TemporalUnit& temporal_unit = *encoded_frame->temporal_unit;
+      DecodeScheduledFrame(encoded_frame);
       std::lock_guard<std::mutex> lock(mutex_);
-      if (failure_status_ != kStatusOk) return;
-      // temporal_unit's status defaults to kStatusOk. So we need to set it only
-      // on error. If |failure_status_| is not kStatusOk at this point, it means
-      // that there has already been a failure. So we don't care about this
-      // subsequent failure.  We will simply return the error code of the first
-      // failure.
-      if (status != kStatusOk) {
-        temporal_unit.status = status;
-        if (failure_status_ == kStatusOk) {
-          failure_status_ = status;
-        }
-      }
-      temporal_unit.decoded =
-          ++temporal_unit.decoded_count == temporal_unit.frames.size();
-      if (temporal_unit.decoded && settings_.output_all_layers &&
-          temporal_unit.output_layer_count > 1) {
-        std::sort(
-            temporal_unit.output_layers,
-            temporal_unit.output_layers + temporal_unit.output_layer_count);
-      }
-      if (temporal_unit.decoded || failure_status_ != kStatusOk) {
-        decoded_condvar_.notify_one();
-      }
+      if (--pending_frames_ == 0) idle_condvar_.notify_one();
     });
   }
   return kStatusOk;
 }
 
+void DecoderImpl::DecodeScheduledFrame(EncodedFrame* const encoded_frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failure_status_ != kStatusOk || flushing_) return;
+  }
+  const StatusCode status = DecodeFrame(encoded_frame);
+  encoded_frame->state = {};
+  encoded_frame->frame = nullptr;
+  TemporalUnit& temporal_unit = *encoded_frame->temporal_unit;
+  std::lock_guard<std::mutex> lock(mutex_);
+  // If the decoder is being flushed, |status| is most likely the result of
+  // the frame being aborted and the temporal unit is going to be discarded.
+  if (failure_status_ != kStatusOk || flushing_) return;
+  // temporal_unit's status defaults to kStatusOk. So we need to set it only
+  // on error. If |failure_status_| is not kStatusOk at this point, it means
+  // that there has already been a failure. So we don't care about this
+  // subsequent failure.  We will simply return the error code of the first
+  // failure.
+  if (status != kStatusOk) {
+    temporal_unit.status = status;
+    if (failure_status_ == kStatusOk) {
+      failure_status_ = status;
+    }
+  }
+  temporal_unit.decoded =
+      ++temporal_unit.decoded_count == temporal_unit.frames.size();
+  if (temporal_unit.decoded && settings_.output_all_layers &&
+      temporal_unit.output_layer_count > 1) {
+    std::sort(temporal_unit.output_layers,
+              temporal_unit.output_layers + temporal_unit.output_layer_count);
+  }
+  if (temporal_unit.decoded || failure_status_ != kStatusOk) {
+    decoded_condvar_.notify_one();
+  }
+}
+
 StatusCode DecoderImpl::DecodeFrame(EncodedFrame* const encoded_frame) {
   const ObuSequenceHeader& sequence_header = encoded_frame->sequence_header;
   const ObuFrameHeader& frame_header = encoded_frame->frame_header;
@@ -1050,17 +1373,12 @@ StatusCode DecoderImpl::DecodeFrame(EncodedFrame* const encoded_frame) {
 
 StatusCode DecoderImpl::DecodeTemporalUnit(const TemporalUnit& temporal_unit,
                                            const DecoderBuffer** out_ptr) {
-  std::unique_ptr<ObuParser> obu(new (std::nothrow) ObuParser(
-      temporal_unit.data, temporal_unit.size, settings_.operating_point,
-      &buffer_pool_, &state_));
+  ObuParser* const obu = GetObuParser(temporal_unit.data, temporal_unit.size);
   if (obu == nullptr) {
     LIBGAV1_DLOG(ERROR, "Failed to allocate OBU parser.");
     return kStatusOutOfMemory;
   }
   frame_mean_qps_.clear();
-  if (has_sequence_header_) {
-    obu->set_sequence_header(sequence_header_);
-  }
   StatusCode status;
   std::unique_ptr<FrameScratchBuffer> frame_scratch_buffer =
       frame_scratch_buffer_pool_.Get();
@@ -1075,7 +1393,10 @@ StatusCode DecoderImpl::DecodeTemporalUnit(const TemporalUnit& temporal_unit,
 
   while (obu->HasData()) {
     RefCountedBufferPtr current_frame;
-    status = obu->ParseOneFrame(&current_frame);
+    {
+      const ScopedPerfStage perf_stage(kPerfStageParse);
+      status = obu->ParseOneFrame(&current_frame);
+    }
     if (status != kStatusOk) {
       LIBGAV1_DLOG(ERROR, "Failed to parse OBU.");
       return status;
@@ -1113,6 +1434,11 @@ StatusCode DecoderImpl::DecodeTemporalUnit(const TemporalUnit& temporal_unit,
         // not have a reason to handle those cases, so we simply continue.
         continue;
       }
+      // The reference frames that are refreshed by the current frame but not
+      // read by it can be released now instead of after the frame is decoded.
+      state_.ReleaseReferenceFrames(
+          obu->frame_header().refresh_frame_flags &
+          ~GetReferencedFrameMask(obu->frame_header()));
       status = DecodeTiles(obu->sequence_header(), obu->frame_header(),
                            obu->tile_buffers(), state_,
                            frame_scratch_buffer.get(), current_frame.get());
@@ -1137,14 +1463,27 @@ StatusCode DecoderImpl::DecodeTemporalUnit(const TemporalUnit& temporal_unit,
       }
       if (!settings_.parse_only) {
         RefCountedBufferPtr film_grain_frame;
+        const Clock::time_point film_grain_start = Clock::now();
         status = ApplyFilmGrain(
             obu->sequence_header(), obu->frame_header(), current_frame,
             &film_grain_frame,
             frame_scratch_buffer->threading_strategy.film_grain_thread_pool());
         if (status != kStatusOk) return status;
+        if (settings_.adaptive_threading &&
+            !obu->frame_header().show_existing_frame) {
+          stage_costs_.AddStageCost(DecodeStageCosts::kStageFilmGrain,
+                                    MicrosecondsSince(film_grain_start));
+        }
         output_frame_queue_.Push(std::move(film_grain_frame));
       }
     }
+    if (settings_.adaptive_threading && !settings_.parse_only &&
+        !obu->frame_header().show_existing_frame) {
+      const ThreadPool* const thread_pool =
+          frame_scratch_buffer->threading_strategy.thread_pool();
+      stage_costs_.EndFrame(
+          (thread_pool == nullptr) ? 1 : thread_pool->num_threads() + 1);
+    }
   }
   if (output_frame_queue_.Empty()) {
     // No displayable frame in the temporal unit. Not an error.
@@ -1245,6 +1584,15 @@ StatusCode DecoderImpl::DecodeTiles(
     const ObuFrameHeader& frame_header, const Vector<TileBuffer>& tile_buffers,
     const DecoderState& state, FrameScratchBuffer* const frame_scratch_buffer,
     RefCountedBuffer* const current_frame) {
+  if (settings_.max_frame_width > 0 &&
+      !ReserveFrameScratchBuffer(
+          settings_.max_frame_width, settings_.max_frame_height,
+          sequence_header.color_config.subsampling_x,
+          sequence_header.color_config.subsampling_y,
+          /*reserve_deblock=*/!settings_.parse_only, frame_scratch_buffer)) {
+    LIBGAV1_DLOG(ERROR, "Failed to reserve the frame scratch buffer.");
+    return kStatusOutOfMemory;
+  }
   frame_scratch_buffer->tile_scratch_buffer_pool.Reset(
       sequence_header.color_config.bitdepth);
   if (!frame_scratch_buffer->loop_restoration_info.Reset(
@@ -1259,7 +1607,10 @@ StatusCode DecoderImpl::DecodeTiles(
   ThreadingStrategy& threading_strategy =
       frame_scratch_buffer->threading_strategy;
   if (!is_frame_parallel_ &&
-      !threading_strategy.Reset(frame_header, settings_.threads)) {
+      !threading_strategy.Reset(
+          frame_header, settings_.adaptive_threading
+                            ? ComputeAdaptiveThreadCount(threads_, stage_costs_)
+                            : threads_)) {
     return kStatusOutOfMemory;
   }
   const bool do_cdef =
@@ -1315,6 +1666,29 @@ StatusCode DecoderImpl::DecodeTiles(
     LIBGAV1_DLOG(ERROR, "Failed to allocate memory for inter_transform_sizes.");
     return kStatusOutOfMemory;
   }
+  if (!settings_.parse_only &&
+      PostFilter::DoDeblock(frame_header, settings_.post_filter_mask)) {
+    const bool needs_chroma_deblock =
+        frame_header.loop_filter.level[kPlaneU + 1] != 0 ||
+        frame_header.loop_filter.level[kPlaneV + 1] != 0;
+    const int num_planes = needs_chroma_deblock ? kMaxPlanes : 1;
+    for (int plane = kPlaneY; plane < num_planes; ++plane) {
+      const int8_t subsampling_x =
+          (plane == kPlaneY) ? 0 : sequence_header.color_config.subsampling_x;
+      const int8_t subsampling_y =
+          (plane == kPlaneY) ? 0 : sequence_header.color_config.subsampling_y;
+      // The tiles only write the positions that have an edge.
+      for (auto& deblock_edges : frame_scratch_buffer->deblock_edges) {
+        if (!deblock_edges[plane].Reset(
+                SubsampledValue(frame_header.rows4x4, subsampling_y),
+                SubsampledValue(frame_header.columns4x4, subsampling_x))) {
+          LIBGAV1_DLOG(ERROR,
+                       "Failed to allocate memory for deblock edges.");
+          return kStatusOutOfMemory;
+        }
+      }
+    }
+  }
   if (frame_header.use_ref_frame_mvs) {
     if (!frame_scratch_buffer->motion_field.mv.Reset(
             DivideBy2(frame_header.rows4x4), DivideBy2(frame_header.columns4x4),
@@ -1361,11 +1735,19 @@ StatusCode DecoderImpl::DecodeTiles(
 
   const int tile_count = frame_header.tile_info.tile_count;
   assert(tile_count >= 1);
-  Vector<std::unique_ptr<Tile>> tiles;
+  Vector<TilePtr>& tiles = frame_scratch_buffer->tiles;
+  assert(tiles.empty());
   if (!tiles.reserve(tile_count)) {
     LIBGAV1_DLOG(ERROR, "tiles.reserve(%d) failed.\n", tile_count);
     return kStatusOutOfMemory;
   }
+  // The tiles refer to objects that are local to this function, so they are
+  // destroyed on every return path.
+  TilesReleaser tiles_releaser(&tiles);
+  if (!frame_scratch_buffer->tile_storage.Resize(tile_count)) {
+    LIBGAV1_DLOG(ERROR, "Failed to Resize tile_storage.");
+    return kStatusOutOfMemory;
+  }
 
   if (threading_strategy.row_thread_pool(0) != nullptr || is_frame_parallel_ ||
       settings_.parse_only) {
@@ -1523,11 +1905,11 @@ StatusCode DecoderImpl::DecodeTiles(
   // pixels for the intra prediction of the next superblock row. This is done
   // only when one of the following conditions are true:
   //   * is_frame_parallel_ is true.
-  //   * settings_.threads == 1.
+  //   * the frame is decoded without threads.
   // In the non-frame-parallel multi-threaded case, we do not run the post
   // filters in the decode loop. So this buffer need not be used.
   const bool use_intra_prediction_buffer =
-      is_frame_parallel_ || settings_.threads == 1;
+      is_frame_parallel_ || threading_strategy.thread_pool() == nullptr;
   if (use_intra_prediction_buffer) {
     if (!frame_scratch_buffer->intra_prediction_buffers.Resize(
             frame_header.tile_info.tile_rows)) {
@@ -1563,7 +1945,7 @@ StatusCode DecoderImpl::DecodeTiles(
   SymbolDecoderContext saved_symbol_decoder_context;
   BlockingCounterWithStatus pending_tiles(tile_count);
   for (int tile_number = 0; tile_number < tile_count; ++tile_number) {
-    std::unique_ptr<Tile> tile = Tile::Create(
+    TilePtr tile = Tile::Create(
         tile_number, tile_buffers[tile_number].data,
         tile_buffers[tile_number].size, sequence_header, frame_header,
         current_frame, state, frame_scratch_buffer, wedge_masks_,
@@ -1584,6 +1966,11 @@ StatusCode DecoderImpl::DecodeTiles(
     }
     frame_mean_qp_ = CalcFrameMeanQp(tiles);
   } else {  // Decode.
+    if (threading_strategy.thread_pool() != nullptr &&
+        !ComputeTileOrder(tile_buffers, frame_scratch_buffer)) {
+      LIBGAV1_DLOG(ERROR, "Failed to allocate memory for the tile order.");
+      return kStatusOutOfMemory;
+    }
     if (is_frame_parallel_) {
       if (frame_scratch_buffer->threading_strategy.thread_pool() == nullptr) {
         return DecodeTilesFrameParallel(sequence_header, frame_header, tiles,
@@ -1596,14 +1983,28 @@ StatusCode DecoderImpl::DecodeTiles(
           prev_segment_ids, frame_scratch_buffer, &post_filter, current_frame);
     }
     StatusCode status;
-    if (settings_.threads == 1) {
+    const Clock::time_point tiles_start = Clock::now();
+    if (threading_strategy.thread_pool() == nullptr) {
       status = DecodeTilesNonFrameParallel(sequence_header, frame_header, tiles,
                                            frame_scratch_buffer, &post_filter);
     } else {
-      status = DecodeTilesThreadedNonFrameParallel(
-          tiles, frame_scratch_buffer, &post_filter, &pending_tiles);
+      status = DecodeTilesThreadedNonFrameParallel(tiles, frame_scratch_buffer,
+                                                   &pending_tiles);
     }
     if (status != kStatusOk) return status;
+    if (settings_.adaptive_threading) {
+      stage_costs_.AddStageCost(DecodeStageCosts::kStageTiles,
+                                MicrosecondsSince(tiles_start));
+    }
+    if (threading_strategy.thread_pool() != nullptr) {
+      assert(threading_strategy.post_filter_thread_pool() != nullptr);
+      const Clock::time_point post_filter_start = Clock::now();
+      post_filter.ApplyFilteringThreaded();
+      if (settings_.adaptive_threading) {
+        stage_costs_.AddStageCost(DecodeStageCosts::kStagePostFilter,
+                                  MicrosecondsSince(post_filter_start));
+      }
+    }
   }
 
   if (frame_header.enable_frame_end_update_cdf) {
@@ -1625,6 +2026,7 @@ StatusCode DecoderImpl::ApplyFilmGrain(
     *film_grain_frame = displayable_frame;
     return kStatusOk;
   }
+  const ScopedPerfStage perf_stage(kPerfStageFilmGrain);
   if (!frame_header.show_existing_frame &&
       frame_header.refresh_frame_flags == 0) {
     // If show_existing_frame is true, then the current frame is a previously
@@ -1740,6 +2142,20 @@ StatusCode DecoderImpl::ApplyFilmGrain(
   return kStatusOk;
 }
 
+ObuParser* DecoderImpl::GetObuParser(const uint8_t* const data, size_t size) {
+  if (obu_parser_ == nullptr) {
+    obu_parser_.reset(new (std::nothrow) ObuParser(
+        data, size, settings_.operating_point, &buffer_pool_, &state_));
+    if (obu_parser_ == nullptr) return nullptr;
+  } else {
+    obu_parser_->Reset(data, size);
+  }
+  if (has_sequence_header_) {
+    obu_parser_->set_sequence_header(sequence_header_);
+  }
+  return obu_parser_.get();
+}
+
 bool DecoderImpl::IsNewSequenceHeader(const ObuParser& obu) {
   if (std::find_if(obu.obu_headers().begin(), obu.obu_headers().end(),
                    [](const ObuHeader& obu_header) {
@@ -31,17 +31,20 @@
 #include "src/frame_scratch_buffer.h"
 #include "src/gav1/decoder_buffer.h"
 #include "src/gav1/decoder_settings.h"
+#include "src/gav1/perf_counters.h"
 #include "src/gav1/status_code.h"
 #include "src/obu_parser.h"
 #include "src/quantizer.h"
 #include "src/residual_buffer_pool.h"
 #include "src/symbol_decoder_context.h"
+#include "src/threading_strategy.h"
 #include "src/tile.h"
 #include "src/utils/array_2d.h"
 #include "src/utils/block_parameters_holder.h"
 #include "src/utils/compiler_attributes.h"
 #include "src/utils/constants.h"
 #include "src/utils/memory.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/queue.h"
 #include "src/utils/segmentation_map.h"
 #include "src/utils/types.h"
@@ -129,6 +132,15 @@ struct TemporalUnit : public Allocable {
   bool released_input_buffer;
 };
 
+// An output frame that is held by the application (see
+// Decoder::HoldFrame()). |buffer| describes |frame| and the reference in
+// |frame| keeps the underlying frame buffer out of the BufferPool until the
+// application releases it.
+struct HeldFrame : public Allocable {
+  DecoderBuffer buffer;
+  RefCountedBufferPtr frame;
+};
+
 class DecoderImpl : public Allocable {
  public:
   // The constructor saves a const reference to |*settings|. Therefore
@@ -141,13 +153,18 @@ class DecoderImpl : public Allocable {
   StatusCode EnqueueFrame(const uint8_t* data, size_t size,
                           int64_t user_private_data, void* buffer_private_data);
   StatusCode DequeueFrame(const DecoderBuffer** out_ptr);
+  StatusCode Flush();
+  StatusCode SetThreads(int threads);
+  StatusCode HoldFrame(const DecoderBuffer** out_ptr);
+  StatusCode ReleaseFrame(const DecoderBuffer* buffer);
+  StatusCode GetPerfCounters(PerfCounters* perf_counters) const;
   static constexpr int GetMaxBitdepth() {
     static_assert(LIBGAV1_MAX_BITDEPTH == 8 || LIBGAV1_MAX_BITDEPTH == 10 ||
                       LIBGAV1_MAX_BITDEPTH == 12,
                   "LIBGAV1_MAX_BITDEPTH must be 8, 10 or 12.");
     return LIBGAV1_MAX_BITDEPTH;
   }
-  std::vector<int> GetFrameQps();
+  const std::vector<int>& GetFrameQps() const;
 
  private:
   explicit DecoderImpl(const DecoderSettings* settings);
@@ -189,6 +206,11 @@ class DecoderImpl : public Allocable {
   // |encoded_frame->temporal_unit|'s parameters if the decoded frame is a
   // displayable frame. Used only in frame parallel mode.
   StatusCode DecodeFrame(EncodedFrame* encoded_frame);
+  // Runs in |frame_thread_pool_|. Calls DecodeFrame() for |encoded_frame|
+  // (unless there has been a failure or the decoder is being flushed) and
+  // marks the temporal unit as decoded once all of its frames are done. Used
+  // only in frame parallel mode.
+  void DecodeScheduledFrame(EncodedFrame* encoded_frame);
 
   // Populates |buffer_| with values from |frame|. Adds a reference to |frame|
   // in |output_frame_|.
@@ -207,6 +229,11 @@ class DecoderImpl : public Allocable {
                             RefCountedBufferPtr* film_grain_frame,
                             ThreadPool* thread_pool);
 
+  // Resets |obu_parser_| to parse |data|, allocating it the first time, and
+  // gives it the last sequence header that was seen. Returns nullptr if the
+  // parser could not be allocated.
+  ObuParser* GetObuParser(const uint8_t* data, size_t size);
+
   bool IsNewSequenceHeader(const ObuParser& obu);
 
   bool HasFailure() {
@@ -232,6 +259,11 @@ class DecoderImpl : public Allocable {
   // |buffer_|.
   RefCountedBufferPtr output_frame_;
 
+  // Output frames held by the application. Each entry owns a reference to its
+  // frame. The entries are individually allocated so that the DecoderBuffer
+  // pointers handed out by HoldFrame() remain stable.
+  Vector<std::unique_ptr<HeldFrame>> held_frames_;
+
   // Queue of output frames that are to be returned in the DequeueFrame() calls.
   // If |settings_.output_all_layers| is false, this queue will never contain
   // more than 1 element. This queue is used only when |is_frame_parallel_| is
@@ -244,6 +276,9 @@ class DecoderImpl : public Allocable {
   QuantizerMatrix quantizer_matrix_;
   bool quantizer_matrix_initialized_ = false;
   FrameScratchBufferPool frame_scratch_buffer_pool_;
+  // Parses the temporal units of ParseAndSchedule() and DecodeTemporalUnit().
+  // It is kept across the temporal units so that its buffers are reused.
+  std::unique_ptr<ObuParser> obu_parser_;
 
   // Used to synchronize the accesses into |temporal_units_| in order to update
   // the "decoded" state of a temporal unit.
@@ -251,6 +286,10 @@ class DecoderImpl : public Allocable {
   std::condition_variable decoded_condvar_;
   bool is_frame_parallel_;
   std::unique_ptr<ThreadPool> frame_thread_pool_;
+  // The tile layout of the first frame, which the number of frame threads is
+  // computed from. Used only in frame parallel mode.
+  int frame_parallel_tile_count_ = 0;
+  int frame_parallel_tile_columns_ = 0;
 
   // In frame parallel mode, there are two primary points of failure:
   //  1) ParseAndSchedule()
@@ -260,13 +299,37 @@ class DecoderImpl : public Allocable {
   // If |failure_status_| is not kStatusOk, then the two functions will try to
   // abort as early as they can.
   StatusCode failure_status_ = kStatusOk LIBGAV1_GUARDED_BY(mutex_);
+  // Number of frames that have been scheduled in |frame_thread_pool_| and have
+  // not finished yet. Used only in frame parallel mode.
+  int pending_frames_ = 0 LIBGAV1_GUARDED_BY(mutex_);
+  // Set to true by Flush() while it waits for |pending_frames_| to drop to 0.
+  // The frames that have not been started yet are skipped and the results of
+  // the aborted frames are ignored while this is true.
+  bool flushing_ = false LIBGAV1_GUARDED_BY(mutex_);
+  // Signaled when |pending_frames_| drops to 0.
+  std::condition_variable idle_condvar_;
 
   ObuSequenceHeader sequence_header_ = {};
   // If true, sequence_header is valid.
   bool has_sequence_header_ = false;
 
   const DecoderSettings& settings_;
+  // The allocator from |settings_|. Installed on the calling thread by the
+  // public entry points and on the worker threads of the thread pools, so that
+  // all the internal allocations go through it.
+  const Allocator allocator_;
+  // The number of threads currently in use. Initialized from
+  // |settings_.threads| and updated by SetThreads().
+  int threads_;
   bool seen_first_frame_ = false;
+  // Measured cost of decoding the recent frames. Used only in non frame
+  // parallel mode when |settings_.adaptive_threading| is true.
+  DecodeStageCosts stage_costs_;
+  // The hardware performance counter totals. Only allocated if
+  // |settings_.collect_perf_counters| is true and the counters are available.
+  // Collected on the calling thread by EnqueueFrame() and DequeueFrame(), and
+  // on the threads that they schedule jobs on.
+  std::unique_ptr<PerfCounterTotals> perf_counter_totals_;
 
   std::vector<int> frame_mean_qps_;
   int frame_mean_qp_ = 0;
@@ -28,7 +28,16 @@ void Libgav1DecoderSettingsInitDefault(Libgav1DecoderSettings* settings) {
   settings->output_all_layers = 0;  // false
   settings->operating_point = 0;
   settings->post_filter_mask = 0x1f;
-  settings->parse_only = 0;  // false
+  settings->parse_only = 0;          // false
+  settings->adaptive_threading = 0;  // false
+  settings->allocate_memory = nullptr;
+  settings->allocate_aligned_memory = nullptr;
+  settings->free_memory = nullptr;
+  settings->allocator_private_data = nullptr;
+  settings->max_frame_width = 0;
+  settings->max_frame_height = 0;
+  settings->collect_perf_counters = 0;  // false
+  settings->max_frames_in_flight = 0;
 }
 
 }  // extern "C"
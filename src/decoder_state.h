@@ -40,6 +40,17 @@ struct DecoderState {
     }
   }
 
+  // Drops the frame buffers in the reference_frame array whose bit is set in
+  // |mask| so that they can be returned to the buffer pool. Unlike
+  // ClearReferenceFrames(), the frame ids and order hints are left unchanged.
+  // This must only be used for slots that will not be read before they are
+  // refreshed.
+  void ReleaseReferenceFrames(int mask) {
+    for (int ref_index = 0; mask != 0; ++ref_index, mask >>= 1) {
+      if ((mask & 1) != 0) reference_frame[ref_index] = nullptr;
+    }
+  }
+
   // Clears all the reference frames.
   void ClearReferenceFrames() {
     reference_frame_id = {};
@@ -14,14 +14,27 @@
 
 #include "src/gav1/decoder.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT (unapproved c++11 header)
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <new>
+#include <string>
+#include <utility>
 #include <vector>
 
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
 #include "gtest/gtest.h"
 #include "src/decoder_test_data.h"
+#include "tests/utils.h"
 
 namespace libgav1 {
 namespace {
@@ -40,10 +53,27 @@ constexpr uint8_t kFrame1WithHdrCllAndHdrMdcv[] = {
 constexpr uint8_t kFrame2WithItutT35[] = {OBU_TEMPORAL_DELIMITER,
                                           OBU_METADATA_ITUT_T35, OBU_FRAME_2};
 
+#if defined(__linux__)
+// Returns the number of threads in the process, or -1 on error.
+int GetThreadCount() {
+  DIR* const dir = opendir("/proc/self/task");
+  if (dir == nullptr) return -1;
+  int count = 0;
+  while (const dirent* const entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') ++count;
+  }
+  closedir(dir);
+  return count;
+}
+#endif
+
 class DecoderTest : public testing::Test {
  public:
   void SetUp() override;
-  void IncrementFramesInUse() { ++frames_in_use_; }
+  void IncrementFramesInUse() {
+    ++frames_in_use_;
+    max_frames_in_use_ = std::max(max_frames_in_use_, frames_in_use_);
+  }
   void DecrementFramesInUse() { --frames_in_use_; }
   void SetBufferPrivateData(void* buffer_private_data) {
     buffer_private_data_ = buffer_private_data;
@@ -55,6 +85,7 @@ class DecoderTest : public testing::Test {
  protected:
   std::unique_ptr<Decoder> decoder_;
   int frames_in_use_ = 0;
+  int max_frames_in_use_ = 0;
   void* buffer_private_data_ = nullptr;
   void* released_input_buffer_ = nullptr;
 };
@@ -381,6 +412,505 @@ TEST_F(DecoderTest, MetadataObu) {
   EXPECT_EQ(frames_in_use_, 0);
 }
 
+TEST_F(DecoderTest, NonFrameParallelModeFlush) {
+  StatusCode status;
+  const DecoderBuffer* buffer;
+
+  // Enqueue frame1 for decoding.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+
+  // Dequeue the output of frame1.
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(frames_in_use_, 1);
+
+  // Enqueue frame2 and flush before dequeuing it.
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->Flush();
+  ASSERT_EQ(status, kStatusOk);
+
+  // The input buffer of frame2 has been released without being decoded and
+  // all the reference frames have been released.
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+  EXPECT_EQ(frames_in_use_, 0);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusNothingToDequeue);
+  EXPECT_EQ(buffer, nullptr);
+
+  // Decoding can resume at a key frame.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame1);
+  EXPECT_EQ(frames_in_use_, 1);
+}
+
+TEST_F(DecoderTest, FrameParallelModeFlush) {
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 4;
+  settings.frame_parallel = true;
+  settings.blocking_dequeue = true;
+  settings.get_frame_buffer = GetFrameBuffer;
+  settings.release_frame_buffer = ReleaseFrameBuffer;
+  settings.callback_private_data = this;
+  settings.release_input_buffer = ReleaseInputBuffer;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  StatusCode status;
+  const DecoderBuffer* buffer;
+
+  // Enqueue frame1 and frame2 and flush without dequeuing them. Any frames that
+  // are still being decoded are aborted.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->Flush();
+  ASSERT_EQ(status, kStatusOk);
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+  EXPECT_EQ(frames_in_use_, 0);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusNothingToDequeue);
+
+  // Decoding can resume at a key frame.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame1);
+
+  decoder_ = nullptr;
+  EXPECT_EQ(frames_in_use_, 0);
+}
+
+TEST_F(DecoderTest, SetThreads) {
+  StatusCode status;
+  const DecoderBuffer* buffer;
+
+  EXPECT_EQ(decoder_->SetThreads(0), kStatusInvalidArgument);
+
+  // Decode frame1 with one thread and frame2 with four threads.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+
+  ASSERT_EQ(decoder_->SetThreads(4), kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+
+  // The thread count is retained across SignalEOS().
+  status = decoder_->SignalEOS();
+  EXPECT_EQ(status, kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame1);
+}
+
+TEST_F(DecoderTest, FrameParallelModeSetThreads) {
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 8;
+  settings.frame_parallel = true;
+  settings.blocking_dequeue = true;
+  settings.get_frame_buffer = GetFrameBuffer;
+  settings.release_frame_buffer = ReleaseFrameBuffer;
+  settings.callback_private_data = this;
+  settings.release_input_buffer = ReleaseInputBuffer;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  StatusCode status;
+  const DecoderBuffer* buffer;
+#if defined(__linux__)
+  const int initial_thread_count = GetThreadCount();
+#endif
+
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+#if defined(__linux__)
+  // The test frames have a single tile, so the 8 threads are split into 4
+  // frame threads with one worker thread each.
+  EXPECT_EQ(GetThreadCount(), initial_thread_count + 8);
+#endif
+  // Lower the thread count while frame1 may still be in flight. Two threads
+  // are too few for decoding frames in parallel, so one frame thread with one
+  // worker thread is left.
+  ASSERT_EQ(decoder_->SetThreads(2), kStatusOk);
+#if defined(__linux__)
+  EXPECT_EQ(GetThreadCount(), initial_thread_count + 2);
+#endif
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  // Only one frame can be in flight.
+  EXPECT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                   const_cast<uint8_t*>(kFrame1)),
+            kStatusTryAgain);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+
+  // Raise the thread count again.
+  ASSERT_EQ(decoder_->SetThreads(8), kStatusOk);
+#if defined(__linux__)
+  EXPECT_EQ(GetThreadCount(), initial_thread_count + 8);
+#endif
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+
+  decoder_ = nullptr;
+  EXPECT_EQ(frames_in_use_, 0);
+#if defined(__linux__)
+  EXPECT_EQ(GetThreadCount(), initial_thread_count);
+#endif
+}
+
+// Allocates with malloc() until |remaining| allocations have been made while
+// |limited| is true. The allocations after that fail.
+struct LimitedAllocations {
+  std::atomic<bool> limited{false};
+  std::atomic<int> remaining{0};
+};
+
+extern "C" {
+
+static void* LimitedAllocate(void* allocator_private_data, size_t size) {
+  auto* const allocations =
+      static_cast<LimitedAllocations*>(allocator_private_data);
+  if (allocations->limited && --allocations->remaining < 0) return nullptr;
+  return malloc(size);
+}
+
+static void LimitedFree(void* /*allocator_private_data*/, void* ptr) {
+  free(ptr);
+}
+
+}  // extern "C"
+
+TEST_F(DecoderTest, FrameParallelModeSetThreadsAllocationFailure) {
+  LimitedAllocations allocations;
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 8;
+  settings.frame_parallel = true;
+  settings.blocking_dequeue = true;
+  settings.callback_private_data = this;
+  settings.release_input_buffer = ReleaseInputBuffer;
+  settings.allocate_memory = LimitedAllocate;
+  settings.free_memory = LimitedFree;
+  settings.allocator_private_data = &allocations;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  const DecoderBuffer* buffer;
+#if defined(__linux__)
+  const int initial_thread_count = GetThreadCount();
+#endif
+  ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                   const_cast<uint8_t*>(kFrame1)),
+            kStatusOk);
+  ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+#if defined(__linux__)
+  EXPECT_EQ(GetThreadCount(), initial_thread_count + 8);
+#endif
+
+  // Make each of the allocations of SetThreads() fail in turn. After every
+  // failure the decoder must still have its previous threads and decode.
+  int failures = 0;
+  for (int allowed = 0; allowed < 1000; ++allowed) {
+    SCOPED_TRACE(allowed);
+    allocations.remaining = allowed;
+    allocations.limited = true;
+    const StatusCode status = decoder_->SetThreads(16);
+    allocations.limited = false;
+    if (status == kStatusOk) break;
+    ++failures;
+    EXPECT_EQ(status, kStatusOutOfMemory);
+#if defined(__linux__)
+    EXPECT_EQ(GetThreadCount(), initial_thread_count + 8);
+#endif
+    ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                   const_cast<uint8_t*>(kFrame1)),
+              kStatusOk);
+    ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+  }
+  EXPECT_GT(failures, 0);
+#if defined(__linux__)
+  // 8 frame threads with one worker thread each.
+  EXPECT_EQ(GetThreadCount(), initial_thread_count + 16);
+#endif
+  ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                   const_cast<uint8_t*>(kFrame1)),
+            kStatusOk);
+  ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+
+  decoder_ = nullptr;
+#if defined(__linux__)
+  EXPECT_EQ(GetThreadCount(), initial_thread_count);
+#endif
+}
+
+TEST_F(DecoderTest, AdaptiveThreading) {
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 4;
+  settings.adaptive_threading = true;
+  settings.get_frame_buffer = GetFrameBuffer;
+  settings.release_frame_buffer = ReleaseFrameBuffer;
+  settings.callback_private_data = this;
+  settings.release_input_buffer = ReleaseInputBuffer;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  // The test frames are tiny, so the decoder switches to single threaded
+  // decoding after a few frames. Make sure the output is produced throughout.
+  for (int i = 0; i < 8; ++i) {
+    SCOPED_TRACE(i);
+    const DecoderBuffer* buffer;
+    StatusCode status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                               const_cast<uint8_t*>(kFrame1));
+    ASSERT_EQ(status, kStatusOk);
+    status = decoder_->DequeueFrame(&buffer);
+    ASSERT_EQ(status, kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+    status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                    const_cast<uint8_t*>(kFrame2));
+    ASSERT_EQ(status, kStatusOk);
+    status = decoder_->DequeueFrame(&buffer);
+    ASSERT_EQ(status, kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(released_input_buffer_, &kFrame2);
+  }
+
+  decoder_ = nullptr;
+  EXPECT_EQ(frames_in_use_, 0);
+}
+
+// Compares the time it takes to decode the (tiny) test frames with and without
+// adaptive threading. See DecoderSpeedTest.DISABLED_AdaptiveThreadingSpeed for
+// the number of cores this needs.
+TEST_F(DecoderTest, DISABLED_AdaptiveThreadingSpeed) {
+  constexpr int kNumIterations = 2000;
+  for (const bool adaptive_threading : {false, true}) {
+    decoder_.reset(new (std::nothrow) Decoder());
+    ASSERT_NE(decoder_, nullptr);
+    DecoderSettings settings = {};
+    settings.threads = 4;
+    settings.adaptive_threading = adaptive_threading;
+    ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kNumIterations; ++i) {
+      const DecoderBuffer* buffer;
+      ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0, nullptr),
+                kStatusOk);
+      ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+      ASSERT_EQ(decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0, nullptr),
+                kStatusOk);
+      ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    printf("adaptive_threading=%d: %d us\n", adaptive_threading,
+           static_cast<int>(elapsed.count()));
+  }
+}
+
+TEST_F(DecoderTest, FrameParallelModeMaxFramesInFlight) {
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 8;
+  settings.frame_parallel = true;
+  settings.blocking_dequeue = true;
+  settings.max_frames_in_flight = 2;
+  settings.get_frame_buffer = GetFrameBuffer;
+  settings.release_frame_buffer = ReleaseFrameBuffer;
+  settings.callback_private_data = this;
+  settings.release_input_buffer = ReleaseInputBuffer;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  StatusCode status;
+  const DecoderBuffer* buffer;
+
+  // Only two frames can be in flight at a time.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusTryAgain);
+
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(released_input_buffer_, &kFrame2);
+
+  decoder_ = nullptr;
+  EXPECT_EQ(frames_in_use_, 0);
+}
+
+TEST_F(DecoderTest, HoldFrame) {
+  StatusCode status;
+  const DecoderBuffer* buffer;
+  const DecoderBuffer* held_buffer1;
+  const DecoderBuffer* held_buffer2;
+
+  // Nothing has been dequeued yet, so there is no frame to hold.
+  status = decoder_->HoldFrame(&held_buffer1);
+  ASSERT_EQ(status, kStatusNothingToDequeue);
+  EXPECT_EQ(held_buffer1, nullptr);
+
+  // Enqueue frame1 for decoding.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 1,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+
+  // Dequeue the output of frame1 and hold on to it.
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  void* const frame1_buffer_private_data = buffer->buffer_private_data;
+  status = decoder_->HoldFrame(&held_buffer1);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(held_buffer1, nullptr);
+  EXPECT_NE(held_buffer1, buffer);
+  EXPECT_EQ(held_buffer1->plane[0], buffer->plane[0]);
+
+  // Enqueue frame2 for decoding.
+  status = decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 2,
+                                  const_cast<uint8_t*>(kFrame2));
+  ASSERT_EQ(status, kStatusOk);
+
+  // Dequeue the output of frame2 and hold on to it.
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  status = decoder_->HoldFrame(&held_buffer2);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(held_buffer2, nullptr);
+
+  // The frame held after the first DequeueFrame() call is still valid.
+  EXPECT_EQ(held_buffer1->user_private_data, 1);
+  EXPECT_EQ(held_buffer1->buffer_private_data, frame1_buffer_private_data);
+  EXPECT_NE(held_buffer1->plane[0], nullptr);
+  EXPECT_EQ(held_buffer2->user_private_data, 2);
+  EXPECT_EQ(held_buffer2->buffer_private_data, buffer->buffer_private_data);
+  EXPECT_EQ(frames_in_use_, 2);
+
+  // Each held frame can be released exactly once.
+  EXPECT_EQ(decoder_->ReleaseFrame(held_buffer1), kStatusOk);
+  EXPECT_EQ(decoder_->ReleaseFrame(held_buffer1), kStatusInvalidArgument);
+  EXPECT_EQ(decoder_->ReleaseFrame(buffer), kStatusInvalidArgument);
+
+  // Signal end of stream. This releases the remaining held frame as well.
+  status = decoder_->SignalEOS();
+  EXPECT_EQ(status, kStatusOk);
+  EXPECT_EQ(frames_in_use_, 0);
+  EXPECT_EQ(decoder_->ReleaseFrame(held_buffer2), kStatusInvalidArgument);
+}
+
+TEST_F(DecoderTest, ReleaseUnreadReferenceFrames) {
+  // kFrame2 reads reference slots 0-6 and refreshes slots 2 and 3. Its
+  // refresh_frame_flags are bits 18 to 25 of the OBU payload, which starts at
+  // kFrame2[4]. Change them to 0x80 so that the frame only refreshes slot 7,
+  // which it does not read. Decoding does not depend on the refreshed slots.
+  uint8_t frame2[sizeof(kFrame2)];
+  memcpy(frame2, kFrame2, sizeof(frame2));
+  ASSERT_EQ(((frame2[6] & 0x3f) << 2) | (frame2[7] >> 6), 0x0c);
+  frame2[6] = (frame2[6] & 0xc0) | (0x80 >> 2);
+  frame2[7] &= 0x3f;
+
+  StatusCode status;
+  const DecoderBuffer* buffer;
+
+  // Frame1 is a key frame, which is stored in all the reference slots.
+  status = decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                  const_cast<uint8_t*>(kFrame1));
+  ASSERT_EQ(status, kStatusOk);
+  status = decoder_->DequeueFrame(&buffer);
+  ASSERT_EQ(status, kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(max_frames_in_use_, 1);
+
+  std::vector<uint8_t> first_output;
+  for (int i = 0; i < 4; ++i) {
+    status = decoder_->EnqueueFrame(frame2, sizeof(frame2), 0, frame2);
+    ASSERT_EQ(status, kStatusOk);
+    status = decoder_->DequeueFrame(&buffer);
+    ASSERT_EQ(status, kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+    // Slot 7 holds the previous copy of frame2 after the first iteration. It
+    // is released before the current copy is decoded, so only frame1 and the
+    // current copy are alive at any time.
+    EXPECT_EQ(max_frames_in_use_, 2) << "iteration: " << i;
+    // All the copies read the same reference frames and are identical.
+    std::vector<uint8_t> output;
+    for (int y = 0; y < buffer->displayed_height[0]; ++y) {
+      const uint8_t* const row = buffer->plane[0] + y * buffer->stride[0];
+      output.insert(output.end(), row, row + buffer->displayed_width[0]);
+    }
+    if (i == 0) {
+      first_output = output;
+    } else {
+      EXPECT_EQ(output, first_output) << "iteration: " << i;
+    }
+  }
+
+  decoder_ = nullptr;
+  EXPECT_EQ(frames_in_use_, 0);
+}
+
 class ParseOnlyTest : public testing::Test {
  public:
   void SetUp() override;
@@ -432,5 +962,198 @@ TEST_F(ParseOnlyTest, NonFrameParallelModeParseOnly) {
   EXPECT_EQ(frame2_qp[0], kFrame2MeanQp);
 }
 
+// Counts the calls of the memory allocation callbacks, which may be made from
+// several threads.
+struct AllocationCounts {
+  std::atomic<int> allocations{0};
+  std::atomic<int> frees{0};
+};
+
+extern "C" {
+
+static void* CountingAllocate(void* allocator_private_data, size_t size) {
+  ++static_cast<AllocationCounts*>(allocator_private_data)->allocations;
+  return malloc(size);
+}
+
+static void CountingFree(void* allocator_private_data, void* ptr) {
+  ++static_cast<AllocationCounts*>(allocator_private_data)->frees;
+  free(ptr);
+}
+
+}  // extern "C"
+
+TEST_F(DecoderTest, Allocator) {
+  for (const bool frame_parallel : {false, true}) {
+    SCOPED_TRACE(frame_parallel);
+    AllocationCounts counts;
+    decoder_.reset(new (std::nothrow) Decoder());
+    ASSERT_NE(decoder_, nullptr);
+    DecoderSettings settings = {};
+    settings.threads = 4;
+    settings.frame_parallel = frame_parallel;
+    settings.blocking_dequeue = true;
+    settings.release_input_buffer = ReleaseInputBuffer;
+    settings.callback_private_data = this;
+    settings.allocate_memory = CountingAllocate;
+    settings.allocator_private_data = &counts;
+    // free_memory is required with allocate_memory.
+    ASSERT_EQ(decoder_->Init(&settings), kStatusInvalidArgument);
+    settings.free_memory = CountingFree;
+    ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+    const int allocations_after_init = counts.allocations;
+    EXPECT_GT(allocations_after_init, 0);
+
+    const DecoderBuffer* buffer;
+    ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0,
+                                     const_cast<uint8_t*>(kFrame1)),
+              kStatusOk);
+    ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(decoder_->EnqueueFrame(kFrame2, sizeof(kFrame2), 0,
+                                     const_cast<uint8_t*>(kFrame2)),
+              kStatusOk);
+    ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+    // The frame buffers are allocated internally, so they come from the
+    // allocator too.
+    EXPECT_GT(counts.allocations, allocations_after_init);
+
+    decoder_ = nullptr;
+    EXPECT_EQ(counts.frees, counts.allocations);
+  }
+}
+
+TEST_F(DecoderTest, MaxFrameSize) {
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.max_frame_width = 1920;
+  // Both dimensions must be set.
+  ASSERT_EQ(decoder_->Init(&settings), kStatusInvalidArgument);
+  settings.max_frame_height = 1080;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+
+  const DecoderBuffer* buffer;
+  for (const auto& frame : {std::make_pair(kFrame1, sizeof(kFrame1)),
+                            std::make_pair(kFrame2, sizeof(kFrame2))}) {
+    ASSERT_EQ(decoder_->EnqueueFrame(frame.first, frame.second, 0, nullptr),
+              kStatusOk);
+    ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+    ASSERT_NE(buffer, nullptr);
+  }
+}
+
+TEST_F(DecoderTest, PerfCounters) {
+  PerfCounters perf_counters;
+  // Not requested in SetUp().
+  EXPECT_EQ(decoder_->GetPerfCounters(&perf_counters), kStatusUnimplemented);
+
+  decoder_.reset(new (std::nothrow) Decoder());
+  ASSERT_NE(decoder_, nullptr);
+  DecoderSettings settings = {};
+  settings.threads = 2;
+  settings.collect_perf_counters = true;
+  ASSERT_EQ(decoder_->Init(&settings), kStatusOk);
+  const StatusCode status = decoder_->GetPerfCounters(&perf_counters);
+  // The counters are not available if the library is built without them or
+  // if perf_event_open() is not permitted.
+  if (status == kStatusUnimplemented) return;
+  ASSERT_EQ(status, kStatusOk);
+
+  const DecoderBuffer* buffer;
+  ASSERT_EQ(decoder_->EnqueueFrame(kFrame1, sizeof(kFrame1), 0, nullptr),
+            kStatusOk);
+  ASSERT_EQ(decoder_->DequeueFrame(&buffer), kStatusOk);
+  ASSERT_NE(buffer, nullptr);
+  ASSERT_EQ(decoder_->GetPerfCounters(&perf_counters), kStatusOk);
+  EXPECT_NE(perf_counters.available_counters, 0);
+  if ((perf_counters.available_counters & (1 << kPerfCounterCycles)) != 0) {
+    EXPECT_GT(perf_counters.counts[kPerfStageParse][kPerfCounterCycles], 0);
+    EXPECT_GT(perf_counters.counts[kPerfStagePredict][kPerfCounterCycles], 0);
+  }
+
+  // SignalEOS() resets the counts.
+  ASSERT_EQ(decoder_->SignalEOS(), kStatusOk);
+  ASSERT_EQ(decoder_->GetPerfCounters(&perf_counters), kStatusOk);
+  EXPECT_EQ(perf_counters.counts[kPerfStageParse][kPerfCounterCycles], 0);
+}
+
+// Splits the contents of an IVF file into its frames.
+std::vector<std::string> GetIvfFrames(const std::string& ivf) {
+  std::vector<std::string> frames;
+  if (ivf.size() < 32) return frames;
+  size_t offset = static_cast<uint8_t>(ivf[6]) |
+                  (static_cast<uint8_t>(ivf[7]) << 8);
+  while (offset + 12 <= ivf.size()) {
+    const size_t size = static_cast<uint8_t>(ivf[offset]) |
+                        (static_cast<uint8_t>(ivf[offset + 1]) << 8) |
+                        (static_cast<uint8_t>(ivf[offset + 2]) << 16) |
+                        (static_cast<uint8_t>(ivf[offset + 3]) << 24);
+    offset += 12;
+    if (offset + size > ivf.size()) break;
+    frames.push_back(ivf.substr(offset, size));
+    offset += size;
+  }
+  return frames;
+}
+
+// Decodes a stream whose cost per frame changes every few frames: segments of
+// the tiny frames of decoder_test_data.h alternate with segments of the
+// 352x288 frames of five-frames.ivf. The time of each kind of segment is
+// reported with and without adaptive threading. Only meaningful on a machine
+// with at least as many cores as threads; with fewer cores the results
+// mostly show the cost of oversubscription.
+TEST(DecoderSpeedTest, DISABLED_AdaptiveThreadingSpeed) {
+  std::string ivf;
+  test_utils::GetTestData("five-frames.ivf", /*is_output_file=*/false, &ivf);
+  const std::vector<std::string> large_frames = GetIvfFrames(ivf);
+  ASSERT_EQ(large_frames.size(), 5u);
+  const int kNumRuns = 50;
+  const int kNumSmallFramePairs = 10;
+  const int thread_counts[] = {2, 4};
+  for (const int threads : thread_counts) {
+    for (const bool adaptive_threading : {false, true}) {
+      Decoder decoder;
+      DecoderSettings settings = {};
+      settings.threads = threads;
+      settings.adaptive_threading = adaptive_threading;
+      ASSERT_EQ(decoder.Init(&settings), kStatusOk);
+      std::chrono::microseconds small_time(0);
+      std::chrono::microseconds large_time(0);
+      const DecoderBuffer* buffer;
+      for (int run = 0; run < kNumRuns; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kNumSmallFramePairs; ++i) {
+          ASSERT_EQ(decoder.EnqueueFrame(kFrame1, sizeof(kFrame1), 0, nullptr),
+                    kStatusOk);
+          ASSERT_EQ(decoder.DequeueFrame(&buffer), kStatusOk);
+          ASSERT_EQ(decoder.EnqueueFrame(kFrame2, sizeof(kFrame2), 0, nullptr),
+                    kStatusOk);
+          ASSERT_EQ(decoder.DequeueFrame(&buffer), kStatusOk);
+        }
+        small_time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+        for (const std::string& frame : large_frames) {
+          ASSERT_EQ(decoder.EnqueueFrame(
+                        reinterpret_cast<const uint8_t*>(frame.data()),
+                        frame.size(), 0, nullptr),
+                    kStatusOk);
+          ASSERT_EQ(decoder.DequeueFrame(&buffer), kStatusOk);
+          ASSERT_NE(buffer, nullptr);
+        }
+        large_time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+      }
+      printf("threads: %d adaptive_threading: %d small frames: %6d us "
+             "352x288 frames: %6d us\n",
+             threads, adaptive_threading ? 1 : 0,
+             static_cast<int>(small_time.count()),
+             static_cast<int>(large_time.count()));
+    }
+  }
+}
+
 }  // namespace
 }  // namespace libgav1
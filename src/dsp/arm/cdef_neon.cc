@@ -416,6 +416,30 @@ void CdefDirection_NEON(const void* LIBGAV1_RESTRICT const source,
   *variance = (best_cost - cost[(*direction + 4) & 7]) >> 10;
 }
 
+template <int bitdepth>
+void CdefDirections_NEON(const void* LIBGAV1_RESTRICT const source,
+                         const ptrdiff_t stride, const int width8x8,
+                         const int height8x8,
+                         const uint8_t* LIBGAV1_RESTRICT const mask,
+                         uint8_t* LIBGAV1_RESTRICT direction,
+                         int* LIBGAV1_RESTRICT variance) {
+  assert(width8x8 > 0 && width8x8 <= 8);
+  assert(height8x8 > 0 && height8x8 <= 8);
+  constexpr int kPixelSize = (bitdepth == kBitdepth8) ? 1 : 2;
+  const auto* src = static_cast<const uint8_t*>(source);
+  for (int y = 0; y < height8x8; ++y) {
+    for (int x = 0; x < width8x8; ++x) {
+      if (((mask[y] >> x) & 1) != 0) {
+        CdefDirection_NEON<bitdepth>(src + x * 8 * kPixelSize, stride,
+                                     &direction[x], &variance[x]);
+      }
+    }
+    src += 8 * stride;
+    direction += width8x8;
+    variance += width8x8;
+  }
+}
+
 // -------------------------------------------------------------------------
 // CdefFilter
 
@@ -743,6 +767,7 @@ void Init8bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
   assert(dsp != nullptr);
   dsp->cdef_direction = CdefDirection_NEON<kBitdepth8>;
+  dsp->cdef_directions = CdefDirections_NEON<kBitdepth8>;
   dsp->cdef_filters[0][0] = CdefFilter_NEON<4, uint8_t>;
   dsp->cdef_filters[0][1] = CdefFilter_NEON<4, uint8_t, /*enable_primary=*/true,
                                             /*enable_secondary=*/false>;
@@ -766,6 +791,7 @@ void Init10bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
   assert(dsp != nullptr);
   dsp->cdef_direction = CdefDirection_NEON<kBitdepth10>;
+  dsp->cdef_directions = CdefDirections_NEON<kBitdepth10>;
   dsp->cdef_filters[0][0] = CdefFilter_NEON<4, uint16_t>;
   dsp->cdef_filters[0][1] =
       CdefFilter_NEON<4, uint16_t, /*enable_primary=*/true,
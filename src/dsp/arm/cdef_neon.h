@@ -23,8 +23,8 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::cdef_direction and Dsp::cdef_filters. This function is not
-// thread-safe.
+// Initializes Dsp::cdef_direction, Dsp::cdef_directions and Dsp::cdef_filters.
+// This function is not thread-safe.
 void CdefInit_NEON();
 
 }  // namespace dsp
@@ -32,9 +32,11 @@ void CdefInit_NEON();
 
 #if LIBGAV1_ENABLE_NEON
 #define LIBGAV1_Dsp8bpp_CdefDirection LIBGAV1_CPU_NEON
+#define LIBGAV1_Dsp8bpp_CdefDirections LIBGAV1_CPU_NEON
 #define LIBGAV1_Dsp8bpp_CdefFilters LIBGAV1_CPU_NEON
 
 #define LIBGAV1_Dsp10bpp_CdefDirection LIBGAV1_CPU_NEON
+#define LIBGAV1_Dsp10bpp_CdefDirections LIBGAV1_CPU_NEON
 #define LIBGAV1_Dsp10bpp_CdefFilters LIBGAV1_CPU_NEON
 #endif  // LIBGAV1_ENABLE_NEON
 
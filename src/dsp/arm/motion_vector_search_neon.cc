@@ -42,17 +42,6 @@ inline int16x4_t MvProjection(const int16x4_t mv, const int16x4_t denominator,
   return vqrshrn_n_s32(add_sign, 14);
 }
 
-inline int16x4_t MvProjectionCompound(const int16x4_t mv,
-                                      const int temporal_reference_offsets,
-                                      const int reference_offsets[2]) {
-  const int16x4_t denominator =
-      vdup_n_s16(kProjectionMvDivisionLookup[temporal_reference_offsets]);
-  const int32x2_t offset = vld1_s32(reference_offsets);
-  const int32x2x2_t offsets = vzip_s32(offset, offset);
-  const int32x4_t numerator = vcombine_s32(offsets.val[0], offsets.val[1]);
-  return MvProjection(mv, denominator, numerator);
-}
-
 inline int16x8_t ProjectionClip(const int16x4_t mv0, const int16x4_t mv1) {
   const int16x8_t projection_mv_clamp = vdupq_n_s16(kProjectionMvClamp);
   const int16x8_t mv = vcombine_s16(mv0, mv1);
@@ -60,21 +49,6 @@ inline int16x8_t ProjectionClip(const int16x4_t mv0, const int16x4_t mv1) {
   return vmaxq_s16(clamp, vnegq_s16(projection_mv_clamp));
 }
 
-inline int16x8_t MvProjectionCompoundClip(
-    const MotionVector* LIBGAV1_RESTRICT const temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT const temporal_reference_offsets,
-    const int reference_offsets[2]) {
-  const auto* const tmvs = reinterpret_cast<const int32_t*>(temporal_mvs);
-  const int32x2_t temporal_mv = vld1_s32(tmvs);
-  const int16x4_t tmv0 = vreinterpret_s16_s32(vdup_lane_s32(temporal_mv, 0));
-  const int16x4_t tmv1 = vreinterpret_s16_s32(vdup_lane_s32(temporal_mv, 1));
-  const int16x4_t mv0 = MvProjectionCompound(
-      tmv0, temporal_reference_offsets[0], reference_offsets);
-  const int16x4_t mv1 = MvProjectionCompound(
-      tmv1, temporal_reference_offsets[1], reference_offsets);
-  return ProjectionClip(mv0, mv1);
-}
-
 inline int16x8_t MvProjectionSingleClip(
     const MotionVector* LIBGAV1_RESTRICT const temporal_mvs,
     const int8_t* LIBGAV1_RESTRICT const temporal_reference_offsets,
@@ -115,66 +89,6 @@ inline void ForceInteger(const int16x8_t mv, void* const candidate_mvs) {
   vst1q_s16(static_cast<int16_t*>(candidate_mvs), mv2);
 }
 
-void MvProjectionCompoundLowPrecision_NEON(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int loop_count = (count + 1) >> 1;
-  do {
-    const int16x8_t mv = MvProjectionCompoundClip(
-        temporal_mvs, temporal_reference_offsets, offsets);
-    LowPrecision(mv, candidate_mvs);
-    temporal_mvs += 2;
-    temporal_reference_offsets += 2;
-    candidate_mvs += 2;
-  } while (--loop_count != 0);
-}
-
-void MvProjectionCompoundForceInteger_NEON(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int loop_count = (count + 1) >> 1;
-  do {
-    const int16x8_t mv = MvProjectionCompoundClip(
-        temporal_mvs, temporal_reference_offsets, offsets);
-    ForceInteger(mv, candidate_mvs);
-    temporal_mvs += 2;
-    temporal_reference_offsets += 2;
-    candidate_mvs += 2;
-  } while (--loop_count != 0);
-}
-
-void MvProjectionCompoundHighPrecision_NEON(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int loop_count = (count + 1) >> 1;
-  do {
-    const int16x8_t mv = MvProjectionCompoundClip(
-        temporal_mvs, temporal_reference_offsets, offsets);
-    vst1q_s16(reinterpret_cast<int16_t*>(candidate_mvs), mv);
-    temporal_mvs += 2;
-    temporal_reference_offsets += 2;
-    candidate_mvs += 2;
-  } while (--loop_count != 0);
-}
-
 void MvProjectionSingleLowPrecision_NEON(
     const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
     const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
@@ -234,9 +148,6 @@ void MvProjectionSingleHighPrecision_NEON(
 void MotionVectorSearchInit_NEON() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
   assert(dsp != nullptr);
-  dsp->mv_projection_compound[0] = MvProjectionCompoundLowPrecision_NEON;
-  dsp->mv_projection_compound[1] = MvProjectionCompoundForceInteger_NEON;
-  dsp->mv_projection_compound[2] = MvProjectionCompoundHighPrecision_NEON;
   dsp->mv_projection_single[0] = MvProjectionSingleLowPrecision_NEON;
   dsp->mv_projection_single[1] = MvProjectionSingleForceInteger_NEON;
   dsp->mv_projection_single[2] = MvProjectionSingleHighPrecision_NEON;
@@ -23,8 +23,7 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::mv_projection_compound and Dsp::mv_projection_single. This
-// function is not thread-safe.
+// Initializes Dsp::mv_projection_single. This function is not thread-safe.
 void MotionVectorSearchInit_NEON();
 
 }  // namespace dsp
@@ -32,11 +32,15 @@ namespace {
 #include "src/dsp/cdef.inc"
 
 // Silence unused function warnings when CdefDirection_C is obviated.
-#if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS ||           \
-    !defined(LIBGAV1_Dsp8bpp_CdefDirection) ||    \
-    (LIBGAV1_MAX_BITDEPTH >= 10 &&                \
-     !defined(LIBGAV1_Dsp10bpp_CdefDirection)) || \
-    (LIBGAV1_MAX_BITDEPTH == 12 && !defined(LIBGAV1_Dsp12bpp_CdefDirection))
+#if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS ||              \
+    !defined(LIBGAV1_Dsp8bpp_CdefDirection) ||       \
+    !defined(LIBGAV1_Dsp8bpp_CdefDirections) ||      \
+    (LIBGAV1_MAX_BITDEPTH >= 10 &&                   \
+     (!defined(LIBGAV1_Dsp10bpp_CdefDirection) ||    \
+      !defined(LIBGAV1_Dsp10bpp_CdefDirections))) || \
+    (LIBGAV1_MAX_BITDEPTH == 12 &&                   \
+     (!defined(LIBGAV1_Dsp12bpp_CdefDirection) ||    \
+      !defined(LIBGAV1_Dsp12bpp_CdefDirections)))
 constexpr int16_t kDivisionTable[] = {840, 420, 280, 210, 168, 140, 120, 105};
 
 int32_t Square(int32_t x) { return x * x; }
@@ -102,12 +106,38 @@ void CdefDirection_C(const void* LIBGAV1_RESTRICT const source,
   }
   *variance = (best_cost - cost[(*direction + 4) & 7]) >> 10;
 }
+
+template <int bitdepth, typename Pixel>
+void CdefDirections_C(const void* LIBGAV1_RESTRICT const source,
+                      const ptrdiff_t stride, const int width8x8,
+                      const int height8x8,
+                      const uint8_t* LIBGAV1_RESTRICT const mask,
+                      uint8_t* LIBGAV1_RESTRICT direction,
+                      int* LIBGAV1_RESTRICT variance) {
+  assert(width8x8 > 0 && width8x8 <= 8);
+  assert(height8x8 > 0 && height8x8 <= 8);
+  const auto* src = static_cast<const uint8_t*>(source);
+  for (int y = 0; y < height8x8; ++y) {
+    for (int x = 0; x < width8x8; ++x) {
+      if (((mask[y] >> x) & 1) != 0) {
+        CdefDirection_C<bitdepth, Pixel>(src + x * 8 * sizeof(Pixel), stride,
+                                         &direction[x], &variance[x]);
+      }
+    }
+    src += 8 * stride;
+    direction += width8x8;
+    variance += width8x8;
+  }
+}
 #endif  // LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS ||
         // !defined(LIBGAV1_Dsp8bpp_CdefDirection) ||
+        // !defined(LIBGAV1_Dsp8bpp_CdefDirections) ||
         // (LIBGAV1_MAX_BITDEPTH >= 10 &&
-        //  !defined(LIBGAV1_Dsp10bpp_CdefDirection))
+        //  (!defined(LIBGAV1_Dsp10bpp_CdefDirection) ||
+        //   !defined(LIBGAV1_Dsp10bpp_CdefDirections)))
         // (LIBGAV1_MAX_BITDEPTH == 12 &&
-        //  !defined(LIBGAV1_Dsp12bpp_CdefDirection))
+        //  (!defined(LIBGAV1_Dsp12bpp_CdefDirection) ||
+        //   !defined(LIBGAV1_Dsp12bpp_CdefDirections)))
 
 // Silence unused function warnings when CdefFilter_C is obviated.
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS ||                                       \
@@ -125,15 +155,18 @@ int Constrain(int diff, int threshold, int damping) {
 
 // Filters the source block. It doesn't check whether the candidate pixel is
 // inside the frame. However it requires the source input to be padded with a
-// constant large value (kCdefLargeValue) if at the boundary.
-template <int block_width, int bitdepth, typename Pixel,
-          bool enable_primary = true, bool enable_secondary = true>
-void CdefFilter_C(const uint16_t* LIBGAV1_RESTRICT src,
-                  const ptrdiff_t src_stride, const int block_height,
-                  const int primary_strength, const int secondary_strength,
-                  const int damping, const int direction,
-                  void* LIBGAV1_RESTRICT const dest,
-                  const ptrdiff_t dest_stride) {
+// constant large value (kCdefLargeValue) if at the boundary. |SourcePixel| is
+// uint16_t for the padded copy of the block and uint8_t when the 8-bit frame
+// is read directly, in which case no pixel equals kCdefLargeValue.
+// |src_stride| is given in units of SourcePixel.
+template <int block_width, int bitdepth, typename Pixel, typename SourcePixel,
+          bool enable_primary, bool enable_secondary>
+void CdefFilterBlock_C(const SourcePixel* LIBGAV1_RESTRICT src,
+                       const ptrdiff_t src_stride, const int block_height,
+                       const int primary_strength,
+                       const int secondary_strength, const int damping,
+                       const int direction, void* LIBGAV1_RESTRICT const dest,
+                       const ptrdiff_t dest_stride) {
   static_assert(block_width == 4 || block_width == 8, "Invalid CDEF width.");
   static_assert(enable_primary || enable_secondary, "");
   assert(block_height == 4 || block_height == 8);
@@ -220,6 +253,36 @@ void CdefFilter_C(const uint16_t* LIBGAV1_RESTRICT src,
     dst += dst_stride;
   } while (--y != 0);
 }
+
+template <int block_width, int bitdepth, typename Pixel,
+          bool enable_primary = true, bool enable_secondary = true>
+void CdefFilter_C(const uint16_t* LIBGAV1_RESTRICT const src,
+                  const ptrdiff_t src_stride, const int block_height,
+                  const int primary_strength, const int secondary_strength,
+                  const int damping, const int direction,
+                  void* LIBGAV1_RESTRICT const dest,
+                  const ptrdiff_t dest_stride) {
+  CdefFilterBlock_C<block_width, bitdepth, Pixel, uint16_t, enable_primary,
+                    enable_secondary>(src, src_stride, block_height,
+                                      primary_strength, secondary_strength,
+                                      damping, direction, dest, dest_stride);
+}
+
+template <int block_width, bool enable_primary = true,
+          bool enable_secondary = true>
+void CdefFilterUnpadded_C(const void* LIBGAV1_RESTRICT const source,
+                          const ptrdiff_t source_stride,
+                          const int block_height, const int primary_strength,
+                          const int secondary_strength, const int damping,
+                          const int direction,
+                          void* LIBGAV1_RESTRICT const dest,
+                          const ptrdiff_t dest_stride) {
+  CdefFilterBlock_C<block_width, 8, uint8_t, uint8_t, enable_primary,
+                    enable_secondary>(
+      static_cast<const uint8_t*>(source), source_stride, block_height,
+      primary_strength, secondary_strength, damping, direction, dest,
+      dest_stride);
+}
 #endif  // LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS ||
         // !defined(LIBGAV1_Dsp8bpp_CdefFilters) ||
         // (LIBGAV1_MAX_BITDEPTH >= 10 &&
@@ -230,8 +293,10 @@ void CdefFilter_C(const uint16_t* LIBGAV1_RESTRICT src,
 void Init8bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(8);
   assert(dsp != nullptr);
+  memset(dsp->cdef_filters_unpadded, 0, sizeof(dsp->cdef_filters_unpadded));
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->cdef_direction = CdefDirection_C<8, uint8_t>;
+  dsp->cdef_directions = CdefDirections_C<8, uint8_t>;
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 8, uint8_t>;
   dsp->cdef_filters[0][1] = CdefFilter_C<4, 8, uint8_t, /*enable_primary=*/true,
                                          /*enable_secondary=*/false>;
@@ -242,11 +307,26 @@ void Init8bpp() {
                                          /*enable_secondary=*/false>;
   dsp->cdef_filters[1][2] =
       CdefFilter_C<8, 8, uint8_t, /*enable_primary=*/false>;
+  dsp->cdef_filters_unpadded[0][0] = CdefFilterUnpadded_C<4>;
+  dsp->cdef_filters_unpadded[0][1] =
+      CdefFilterUnpadded_C<4, /*enable_primary=*/true,
+                           /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[0][2] =
+      CdefFilterUnpadded_C<4, /*enable_primary=*/false>;
+  dsp->cdef_filters_unpadded[1][0] = CdefFilterUnpadded_C<8>;
+  dsp->cdef_filters_unpadded[1][1] =
+      CdefFilterUnpadded_C<8, /*enable_primary=*/true,
+                           /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[1][2] =
+      CdefFilterUnpadded_C<8, /*enable_primary=*/false>;
 #else  // !LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   static_cast<void>(dsp);
 #ifndef LIBGAV1_Dsp8bpp_CdefDirection
   dsp->cdef_direction = CdefDirection_C<8, uint8_t>;
 #endif
+#ifndef LIBGAV1_Dsp8bpp_CdefDirections
+  dsp->cdef_directions = CdefDirections_C<8, uint8_t>;
+#endif
 #ifndef LIBGAV1_Dsp8bpp_CdefFilters
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 8, uint8_t>;
   dsp->cdef_filters[0][1] = CdefFilter_C<4, 8, uint8_t, /*enable_primary=*/true,
@@ -259,6 +339,23 @@ void Init8bpp() {
   dsp->cdef_filters[1][2] =
       CdefFilter_C<8, 8, uint8_t, /*enable_primary=*/false>;
 #endif
+// The unpadded C functions are only paired with the C cdef_filters. An
+// optimized cdef_filters without an unpadded version keeps the padded path.
+#if !defined(LIBGAV1_Dsp8bpp_CdefFilters) && \
+    !defined(LIBGAV1_Dsp8bpp_CdefFiltersUnpadded)
+  dsp->cdef_filters_unpadded[0][0] = CdefFilterUnpadded_C<4>;
+  dsp->cdef_filters_unpadded[0][1] =
+      CdefFilterUnpadded_C<4, /*enable_primary=*/true,
+                           /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[0][2] =
+      CdefFilterUnpadded_C<4, /*enable_primary=*/false>;
+  dsp->cdef_filters_unpadded[1][0] = CdefFilterUnpadded_C<8>;
+  dsp->cdef_filters_unpadded[1][1] =
+      CdefFilterUnpadded_C<8, /*enable_primary=*/true,
+                           /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[1][2] =
+      CdefFilterUnpadded_C<8, /*enable_primary=*/false>;
+#endif
 #endif  // LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
 }
 
@@ -268,6 +365,7 @@ void Init10bpp() {
   assert(dsp != nullptr);
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->cdef_direction = CdefDirection_C<10, uint16_t>;
+  dsp->cdef_directions = CdefDirections_C<10, uint16_t>;
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 10, uint16_t>;
   dsp->cdef_filters[0][1] =
       CdefFilter_C<4, 10, uint16_t, /*enable_primary=*/true,
@@ -285,6 +383,9 @@ void Init10bpp() {
 #ifndef LIBGAV1_Dsp10bpp_CdefDirection
   dsp->cdef_direction = CdefDirection_C<10, uint16_t>;
 #endif
+#ifndef LIBGAV1_Dsp10bpp_CdefDirections
+  dsp->cdef_directions = CdefDirections_C<10, uint16_t>;
+#endif
 #ifndef LIBGAV1_Dsp10bpp_CdefFilters
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 10, uint16_t>;
   dsp->cdef_filters[0][1] =
@@ -309,6 +410,7 @@ void Init12bpp() {
   assert(dsp != nullptr);
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->cdef_direction = CdefDirection_C<12, uint16_t>;
+  dsp->cdef_directions = CdefDirections_C<12, uint16_t>;
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 12, uint16_t>;
   dsp->cdef_filters[0][1] =
       CdefFilter_C<4, 12, uint16_t, /*enable_primary=*/true,
@@ -326,6 +428,9 @@ void Init12bpp() {
 #ifndef LIBGAV1_Dsp12bpp_CdefDirection
   dsp->cdef_direction = CdefDirection_C<12, uint16_t>;
 #endif
+#ifndef LIBGAV1_Dsp12bpp_CdefDirections
+  dsp->cdef_directions = CdefDirections_C<12, uint16_t>;
+#endif
 #ifndef LIBGAV1_Dsp12bpp_CdefFilters
   dsp->cdef_filters[0][0] = CdefFilter_C<4, 12, uint16_t>;
   dsp->cdef_filters[0][1] =
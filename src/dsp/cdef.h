@@ -43,8 +43,9 @@ enum {
   kCdefSecondaryTap1 = 1,
 };
 
-// Initializes Dsp::cdef_direction and Dsp::cdef_filters. This function is not
-// thread-safe.
+// Initializes Dsp::cdef_direction, Dsp::cdef_directions, Dsp::cdef_filters
+// and Dsp::cdef_filters_unpadded.
+// This function is not thread-safe.
 void CdefInit_C();
 
 }  // namespace dsp
@@ -14,6 +14,7 @@
 
 #include "src/dsp/cdef.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <ostream>
@@ -181,6 +182,134 @@ TEST_P(CdefDirectionTest12bpp, DISABLED_Speed) {
 INSTANTIATE_TEST_SUITE_P(C, CdefDirectionTest12bpp, testing::Values(0));
 #endif  // LIBGAV1_MAX_BITDEPTH == 12
 
+// Verifies that Dsp::cdef_directions produces the same output as calling
+// Dsp::cdef_direction for each of the selected 8x8 blocks.
+// The 'int' parameter is unused but required to allow for instantiations of C,
+// NEON, etc.
+template <int bitdepth, typename Pixel>
+class CdefDirectionsTest : public testing::TestWithParam<int> {
+ public:
+  static_assert(bitdepth >= kBitdepth8 && bitdepth <= LIBGAV1_MAX_BITDEPTH, "");
+  CdefDirectionsTest() = default;
+  CdefDirectionsTest(const CdefDirectionsTest&) = delete;
+  CdefDirectionsTest& operator=(const CdefDirectionsTest&) = delete;
+  ~CdefDirectionsTest() override = default;
+
+ protected:
+  void SetUp() override {
+    test_utils::ResetDspTable(bitdepth);
+    CdefInit_C();
+
+    const Dsp* const dsp = GetDspTable(bitdepth);
+    ASSERT_NE(dsp, nullptr);
+    const testing::TestInfo* const test_info =
+        testing::UnitTest::GetInstance()->current_test_info();
+    const char* const test_case = test_info->test_suite_name();
+    if (absl::StartsWith(test_case, "C/")) {
+    } else if (absl::StartsWith(test_case, "SSE41/")) {
+      if ((GetCpuInfo() & kSSE4_1) == 0) GTEST_SKIP() << "No SSE4.1 support!";
+      CdefInit_SSE4_1();
+    } else if (absl::StartsWith(test_case, "AVX2/")) {
+      if ((GetCpuInfo() & kAVX2) == 0) GTEST_SKIP() << "No AVX2 support!";
+      CdefInit_AVX2();
+    } else if (absl::StartsWith(test_case, "NEON/")) {
+      CdefInit_NEON();
+    } else {
+      FAIL() << "Unrecognized architecture prefix in test case name: "
+             << test_case;
+    }
+    cur_cdef_direction_ = dsp->cdef_direction;
+    cur_cdef_directions_ = dsp->cdef_directions;
+  }
+
+  void TestRandomValues(int num_runs);
+
+  static constexpr int kStride = kMaxSuperBlockSizeInPixels;
+
+  Pixel buffer_[kMaxSuperBlockSizeInPixels * kStride];
+
+  CdefDirectionFunc cur_cdef_direction_;
+  CdefDirectionsFunc cur_cdef_directions_;
+};
+
+template <int bitdepth, typename Pixel>
+void CdefDirectionsTest<bitdepth, Pixel>::TestRandomValues(int num_runs) {
+  ASSERT_NE(cur_cdef_direction_, nullptr);
+  ASSERT_NE(cur_cdef_directions_, nullptr);
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  for (int num_tests = 0; num_tests < num_runs; ++num_tests) {
+    for (auto& pixel : buffer_) {
+      pixel = rnd.Rand16() & ((1 << bitdepth) - 1);
+    }
+    const int width8x8 = 1 + (rnd.Rand8() & 7);
+    const int height8x8 = 1 + (rnd.Rand8() & 7);
+    SCOPED_TRACE(testing::Message() << "width8x8: " << width8x8
+                                    << " height8x8: " << height8x8);
+    uint8_t mask[8];
+    for (auto& row_mask : mask) row_mask = rnd.Rand8();
+    // Blocks which are not selected must be left unchanged.
+    uint8_t expected_direction[8 * 8];
+    int expected_variance[8 * 8];
+    uint8_t direction[8 * 8];
+    int variance[8 * 8];
+    memset(expected_direction, 0xff, sizeof(expected_direction));
+    memset(expected_variance, 0xff, sizeof(expected_variance));
+    memset(direction, 0xff, sizeof(direction));
+    memset(variance, 0xff, sizeof(variance));
+    for (int y = 0; y < height8x8; ++y) {
+      for (int x = 0; x < width8x8; ++x) {
+        if (((mask[y] >> x) & 1) == 0) continue;
+        const int index = y * width8x8 + x;
+        cur_cdef_direction_(&buffer_[y * 8 * kStride + x * 8],
+                            kStride * sizeof(Pixel), &expected_direction[index],
+                            &expected_variance[index]);
+      }
+    }
+    cur_cdef_directions_(buffer_, kStride * sizeof(Pixel), width8x8,
+                         height8x8, mask, direction, variance);
+    ASSERT_EQ(memcmp(direction, expected_direction, sizeof(direction)), 0);
+    ASSERT_EQ(memcmp(variance, expected_variance, sizeof(variance)), 0);
+  }
+}
+
+using CdefDirectionsTest8bpp = CdefDirectionsTest<8, uint8_t>;
+
+TEST_P(CdefDirectionsTest8bpp, Correctness) { TestRandomValues(100); }
+
+INSTANTIATE_TEST_SUITE_P(C, CdefDirectionsTest8bpp, testing::Values(0));
+
+#if LIBGAV1_ENABLE_NEON
+INSTANTIATE_TEST_SUITE_P(NEON, CdefDirectionsTest8bpp, testing::Values(0));
+#endif
+
+#if LIBGAV1_ENABLE_SSE4_1
+INSTANTIATE_TEST_SUITE_P(SSE41, CdefDirectionsTest8bpp, testing::Values(0));
+#endif
+
+#if LIBGAV1_ENABLE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, CdefDirectionsTest8bpp, testing::Values(0));
+#endif  // LIBGAV1_ENABLE_AVX2
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+using CdefDirectionsTest10bpp = CdefDirectionsTest<10, uint16_t>;
+
+TEST_P(CdefDirectionsTest10bpp, Correctness) { TestRandomValues(100); }
+
+INSTANTIATE_TEST_SUITE_P(C, CdefDirectionsTest10bpp, testing::Values(0));
+
+#if LIBGAV1_ENABLE_NEON
+INSTANTIATE_TEST_SUITE_P(NEON, CdefDirectionsTest10bpp, testing::Values(0));
+#endif
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+#if LIBGAV1_MAX_BITDEPTH == 12
+using CdefDirectionsTest12bpp = CdefDirectionsTest<12, uint16_t>;
+
+TEST_P(CdefDirectionsTest12bpp, Correctness) { TestRandomValues(100); }
+
+INSTANTIATE_TEST_SUITE_P(C, CdefDirectionsTest12bpp, testing::Values(0));
+#endif  // LIBGAV1_MAX_BITDEPTH == 12
+
 const char* GetDigest8bpp(int id) {
   static const char* const kDigest[] = {
       "b6fe1a1f5bbb23e35197160ce57d90bd", "8aed39871b19184f1d381b145779bc33",
@@ -448,6 +577,265 @@ INSTANTIATE_TEST_SUITE_P(C, CdefFilteringTest12bpp,
                          testing::ValuesIn(cdef_test_param));
 #endif  // LIBGAV1_MAX_BITDEPTH == 12
 
+// Verifies that Dsp::cdef_filters_uv produces the same output as filtering the
+// U and V blocks separately with Dsp::cdef_filters. The functions are only
+// provided by the SIMD implementations.
+// The 'int' parameter is unused but required to allow for instantiations of
+// SSE41, AVX2, etc.
+template <int bitdepth, typename Pixel>
+class CdefFilteringUVTest : public testing::TestWithParam<int> {
+ public:
+  static_assert(bitdepth >= kBitdepth8 && bitdepth <= LIBGAV1_MAX_BITDEPTH, "");
+  CdefFilteringUVTest() = default;
+  CdefFilteringUVTest(const CdefFilteringUVTest&) = delete;
+  CdefFilteringUVTest& operator=(const CdefFilteringUVTest&) = delete;
+  ~CdefFilteringUVTest() override = default;
+
+ protected:
+  void SetUp() override {
+    test_utils::ResetDspTable(bitdepth);
+    CdefInit_C();
+
+    const Dsp* const dsp = GetDspTable(bitdepth);
+    ASSERT_NE(dsp, nullptr);
+    const testing::TestInfo* const test_info =
+        testing::UnitTest::GetInstance()->current_test_info();
+    const char* const test_case = test_info->test_suite_name();
+    if (absl::StartsWith(test_case, "SSE41/")) {
+      if ((GetCpuInfo() & kSSE4_1) == 0) GTEST_SKIP() << "No SSE4.1 support!";
+      CdefInit_SSE4_1();
+    } else if (absl::StartsWith(test_case, "AVX2/")) {
+      if ((GetCpuInfo() & kAVX2) == 0) GTEST_SKIP() << "No AVX2 support!";
+      CdefInit_AVX2();
+    } else {
+      FAIL() << "Unrecognized architecture prefix in test case name: "
+             << test_case;
+    }
+    memcpy(cur_cdef_filter_, dsp->cdef_filters, sizeof(cur_cdef_filter_));
+    memcpy(cur_cdef_filter_uv_, dsp->cdef_filters_uv,
+           sizeof(cur_cdef_filter_uv_));
+  }
+
+  void TestRandomValues(int num_runs);
+
+  uint16_t source_[2][kSourceBufferSize];
+  Pixel dest_[2][kTestBufferSize];
+  Pixel dest_uv_[2][kTestBufferSize];
+
+  CdefFilteringFuncs cur_cdef_filter_;
+  CdefFilteringUVFuncs cur_cdef_filter_uv_;
+};
+
+template <int bitdepth, typename Pixel>
+void CdefFilteringUVTest<bitdepth, Pixel>::TestRandomValues(int num_runs) {
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  const int offset = 2 * kSourceStride + 2;
+  const ptrdiff_t dest_stride = kTestBufferStride * sizeof(Pixel);
+  for (int num_tests = 0; num_tests < num_runs; ++num_tests) {
+    for (int width_index = 0; width_index < 2; ++width_index) {
+      for (int block_height = 4; block_height <= 8; block_height += 4) {
+        for (int strength_index = 0; strength_index < 3; ++strength_index) {
+          SCOPED_TRACE(testing::Message()
+                       << "width: " << (4 << width_index)
+                       << " height: " << block_height
+                       << " strength_index: " << strength_index);
+          ASSERT_NE(cur_cdef_filter_uv_[width_index][strength_index], nullptr);
+          for (auto& source : source_) {
+            for (auto& value : source) {
+              // Use kCdefLargeValue for some of the entries to emulate the
+              // frame borders.
+              value = ((rnd.Rand8() & 15) == 0)
+                          ? kCdefLargeValue
+                          : rnd.Rand16() & ((1 << bitdepth) - 1);
+            }
+          }
+          int primary_strength = 0;
+          if (strength_index != 2) {
+            do {
+              int strength = rnd.Rand16() & 15;
+              if (strength == 3) ++strength;
+              primary_strength = strength << (bitdepth - 8);
+            } while (primary_strength == 0);
+          }
+          int secondary_strength = 0;
+          if (strength_index != 1) {
+            do {
+              int strength = rnd.Rand16() & 3;
+              if (strength == 3) ++strength;
+              secondary_strength = strength << (bitdepth - 8);
+            } while (secondary_strength == 0);
+          }
+          // Chroma damping.
+          const int damping = (rnd.Rand16() & 3) + 2;
+          const int direction = rnd.Rand16() & 7;
+
+          memset(dest_, 0, sizeof(dest_));
+          memset(dest_uv_, 0, sizeof(dest_uv_));
+          for (int plane = 0; plane < 2; ++plane) {
+            cur_cdef_filter_[width_index][strength_index](
+                source_[plane] + offset, kSourceStride, block_height,
+                primary_strength, secondary_strength, damping, direction,
+                dest_[plane], dest_stride);
+          }
+          cur_cdef_filter_uv_[width_index][strength_index](
+              source_[0] + offset, source_[1] + offset, kSourceStride,
+              block_height, primary_strength, secondary_strength, damping,
+              direction, dest_uv_[0], dest_stride, dest_uv_[1], dest_stride);
+          ASSERT_EQ(memcmp(dest_, dest_uv_, sizeof(dest_)), 0);
+        }
+      }
+    }
+  }
+}
+
+using CdefFilteringUVTest8bpp = CdefFilteringUVTest<8, uint8_t>;
+
+TEST_P(CdefFilteringUVTest8bpp, Correctness) { TestRandomValues(10); }
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(CdefFilteringUVTest8bpp);
+
+#if LIBGAV1_ENABLE_SSE4_1
+INSTANTIATE_TEST_SUITE_P(SSE41, CdefFilteringUVTest8bpp, testing::Values(0));
+#endif
+
+#if LIBGAV1_ENABLE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, CdefFilteringUVTest8bpp, testing::Values(0));
+#endif  // LIBGAV1_ENABLE_AVX2
+
+// Verifies that Dsp::cdef_filters_unpadded, which reads 8-bit pixels directly
+// from the frame, matches Dsp::cdef_filters run on the same pixels widened to
+// 16 bits, and that the SIMD versions match the C version.
+// The 'int' parameter is unused but required to allow for instantiations of
+// C, SSE41, AVX2, etc.
+class CdefFilteringUnpaddedTest8bpp : public testing::TestWithParam<int> {
+ public:
+  CdefFilteringUnpaddedTest8bpp() = default;
+  CdefFilteringUnpaddedTest8bpp(const CdefFilteringUnpaddedTest8bpp&) =
+      delete;
+  CdefFilteringUnpaddedTest8bpp& operator=(
+      const CdefFilteringUnpaddedTest8bpp&) = delete;
+  ~CdefFilteringUnpaddedTest8bpp() override = default;
+
+ protected:
+  void SetUp() override {
+    test_utils::ResetDspTable(kBitdepth8);
+    CdefInit_C();
+
+    const Dsp* const dsp = GetDspTable(kBitdepth8);
+    ASSERT_NE(dsp, nullptr);
+    const testing::TestInfo* const test_info =
+        testing::UnitTest::GetInstance()->current_test_info();
+    const char* const test_case = test_info->test_suite_name();
+    memcpy(base_cdef_filter_unpadded_, dsp->cdef_filters_unpadded,
+           sizeof(base_cdef_filter_unpadded_));
+    if (absl::StartsWith(test_case, "C/")) {
+    } else if (absl::StartsWith(test_case, "SSE41/")) {
+      if ((GetCpuInfo() & kSSE4_1) == 0) GTEST_SKIP() << "No SSE4.1 support!";
+      CdefInit_SSE4_1();
+    } else if (absl::StartsWith(test_case, "AVX2/")) {
+      if ((GetCpuInfo() & kAVX2) == 0) GTEST_SKIP() << "No AVX2 support!";
+      CdefInit_AVX2();
+    } else {
+      FAIL() << "Unrecognized architecture prefix in test case name: "
+             << test_case;
+    }
+    memcpy(cur_cdef_filter_, dsp->cdef_filters, sizeof(cur_cdef_filter_));
+    memcpy(cur_cdef_filter_unpadded_, dsp->cdef_filters_unpadded,
+           sizeof(cur_cdef_filter_unpadded_));
+  }
+
+  void TestRandomValues(int num_runs);
+
+  uint8_t frame_[kSourceBufferSize];
+  uint16_t source_[kSourceBufferSize];
+  uint8_t dest_[kTestBufferSize];
+  uint8_t dest_unpadded_[kTestBufferSize];
+  uint8_t dest_base_[kTestBufferSize];
+
+  CdefFilteringFuncs cur_cdef_filter_;
+  CdefFilteringUnpaddedFuncs cur_cdef_filter_unpadded_;
+  CdefFilteringUnpaddedFuncs base_cdef_filter_unpadded_;
+};
+
+void CdefFilteringUnpaddedTest8bpp::TestRandomValues(int num_runs) {
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  const int offset = 2 * kSourceStride + 2;
+  for (int num_tests = 0; num_tests < num_runs; ++num_tests) {
+    for (int width_index = 0; width_index < 2; ++width_index) {
+      for (int block_height = 4; block_height <= 8; block_height += 4) {
+        for (int strength_index = 0; strength_index < 3; ++strength_index) {
+          SCOPED_TRACE(testing::Message()
+                       << "width: " << (4 << width_index)
+                       << " height: " << block_height
+                       << " strength_index: " << strength_index);
+          ASSERT_NE(cur_cdef_filter_unpadded_[width_index][strength_index],
+                    nullptr);
+          ASSERT_NE(base_cdef_filter_unpadded_[width_index][strength_index],
+                    nullptr);
+          for (int i = 0; i < kSourceBufferSize; ++i) {
+            frame_[i] = rnd.Rand8();
+            source_[i] = frame_[i];
+          }
+          int primary_strength = 0;
+          if (strength_index != 2) {
+            do {
+              primary_strength = rnd.Rand16() & 15;
+              if (primary_strength == 3) ++primary_strength;
+            } while (primary_strength == 0);
+          }
+          int secondary_strength = 0;
+          if (strength_index != 1) {
+            do {
+              secondary_strength = rnd.Rand16() & 3;
+              if (secondary_strength == 3) ++secondary_strength;
+            } while (secondary_strength == 0);
+          }
+          const int damping = (rnd.Rand16() & 3) + 3;
+          const int direction = rnd.Rand16() & 7;
+
+          memset(dest_, 0, sizeof(dest_));
+          memset(dest_unpadded_, 0, sizeof(dest_unpadded_));
+          cur_cdef_filter_[width_index][strength_index](
+              source_ + offset, kSourceStride, block_height, primary_strength,
+              secondary_strength, damping, direction, dest_,
+              kTestBufferStride);
+          cur_cdef_filter_unpadded_[width_index][strength_index](
+              frame_ + offset, kSourceStride, block_height, primary_strength,
+              secondary_strength, damping, direction, dest_unpadded_,
+              kTestBufferStride);
+          ASSERT_EQ(memcmp(dest_, dest_unpadded_, sizeof(dest_)), 0);
+
+          memset(dest_base_, 0, sizeof(dest_base_));
+          base_cdef_filter_unpadded_[width_index][strength_index](
+              frame_ + offset, kSourceStride, block_height, primary_strength,
+              secondary_strength, damping, direction, dest_base_,
+              kTestBufferStride);
+          ASSERT_EQ(memcmp(dest_base_, dest_unpadded_, sizeof(dest_base_)), 0);
+        }
+      }
+    }
+  }
+}
+
+TEST_P(CdefFilteringUnpaddedTest8bpp, Correctness) { TestRandomValues(10); }
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(CdefFilteringUnpaddedTest8bpp);
+
+// The C functions are not installed alongside the NEON cdef_filters.
+#if !LIBGAV1_ENABLE_NEON || LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
+INSTANTIATE_TEST_SUITE_P(C, CdefFilteringUnpaddedTest8bpp, testing::Values(0));
+#endif
+
+#if LIBGAV1_ENABLE_SSE4_1
+INSTANTIATE_TEST_SUITE_P(SSE41, CdefFilteringUnpaddedTest8bpp,
+                         testing::Values(0));
+#endif
+
+#if LIBGAV1_ENABLE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, CdefFilteringUnpaddedTest8bpp,
+                         testing::Values(0));
+#endif  // LIBGAV1_ENABLE_AVX2
+
 }  // namespace
 }  // namespace dsp
 }  // namespace libgav1
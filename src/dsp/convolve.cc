@@ -699,6 +699,7 @@ void ConvolveIntraBlockCopy1D_C(
 void Init8bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(8);
   assert(dsp != nullptr);
+  dsp->convolve_2d_average_blend = nullptr;
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->convolve[0][0][0][0] = ConvolveCopy_C<8, uint8_t>;
   dsp->convolve[0][0][0][1] = ConvolveHorizontal_C<8, uint8_t>;
@@ -784,6 +785,7 @@ void Init8bpp() {
 void Init10bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(10);
   assert(dsp != nullptr);
+  dsp->convolve_2d_average_blend = nullptr;
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->convolve[0][0][0][0] = ConvolveCopy_C<10, uint16_t>;
   dsp->convolve[0][0][0][1] = ConvolveHorizontal_C<10, uint16_t>;
@@ -870,6 +872,7 @@ void Init10bpp() {
 void Init12bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(12);
   assert(dsp != nullptr);
+  dsp->convolve_2d_average_blend = nullptr;
 #if LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS
   dsp->convolve[0][0][0][0] = ConvolveCopy_C<12, uint16_t>;
   dsp->convolve[0][0][0][1] = ConvolveHorizontal_C<12, uint16_t>;
@@ -30,6 +30,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "gtest/gtest.h"
+#include "src/dsp/average_blend.h"
 #include "src/dsp/constants.h"
 #include "src/dsp/dsp.h"
 #include "src/utils/common.h"
@@ -1372,6 +1373,108 @@ TEST_P(ConvolveScaleTest8bpp, DISABLED_Speed) {
   Test(false, 0, num_runs);
 }
 
+//------------------------------------------------------------------------------
+// Compares Dsp::convolve_2d_average_blend against convolve[0][1][1][1]
+// followed by average_blend.
+class ConvolveAverageBlendTest8bpp
+    : public testing::TestWithParam<ConvolveTestParam> {
+ public:
+  ConvolveAverageBlendTest8bpp() = default;
+  ~ConvolveAverageBlendTest8bpp() override = default;
+
+  void SetUp() override {
+    ConvolveInit_C();
+    AverageBlendInit_C();
+
+    const testing::TestInfo* const test_info =
+        testing::UnitTest::GetInstance()->current_test_info();
+    const absl::string_view test_case = test_info->test_suite_name();
+    if (absl::StartsWith(test_case, "SSE41/")) {
+      if ((GetCpuInfo() & kSSE4_1) == 0) GTEST_SKIP() << "No SSE4.1 support!";
+      ConvolveInit_SSE4_1();
+      AverageBlendInit_SSE4_1();
+    } else if (absl::StartsWith(test_case, "AVX2/")) {
+      if ((GetCpuInfo() & kAVX2) == 0) GTEST_SKIP() << "No AVX2 support!";
+      ConvolveInit_SSE4_1();
+      AverageBlendInit_SSE4_1();
+      ConvolveInit_AVX2();
+    } else {
+      FAIL() << "Unrecognized architecture prefix in test case name: "
+             << test_case;
+    }
+
+    const Dsp* const dsp = GetDspTable(8);
+    ASSERT_NE(dsp, nullptr);
+    convolve_func_ = dsp->convolve[0][1][1][1];
+    average_blend_func_ = dsp->average_blend;
+    convolve_average_blend_func_ = dsp->convolve_2d_average_blend;
+    ASSERT_NE(convolve_func_, nullptr);
+    ASSERT_NE(average_blend_func_, nullptr);
+    ASSERT_NE(convolve_average_blend_func_, nullptr);
+  }
+
+ protected:
+  void SetInputData();
+  void Test();
+
+  const ConvolveTestParam param_ = GetParam();
+
+ private:
+  ConvolveFunc convolve_func_;
+  AverageBlendFunc average_blend_func_;
+  ConvolveAverageBlendFunc convolve_average_blend_func_;
+  uint8_t source_[2][kMaxBlockHeight * kMaxBlockWidth] = {};
+  int16_t prediction_[2][kMaxSuperBlockSizeSquareInPixels] = {};
+  uint8_t dest_[kMaxSuperBlockSizeSquareInPixels] = {};
+  uint8_t dest_average_blend_[kMaxSuperBlockSizeSquareInPixels] = {};
+};
+
+void ConvolveAverageBlendTest8bpp::SetInputData() {
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  for (auto& source : source_) {
+    for (auto& pixel : source) pixel = rnd.Rand8();
+  }
+}
+
+void ConvolveAverageBlendTest8bpp::Test() {
+  // Compound blocks are at least 4x4.
+  if (param_.width < 4 || param_.height < 4) GTEST_SKIP();
+
+  SetInputData();
+  const int width = param_.width;
+  const int height = param_.height;
+  const int offset =
+      kConvolveBorderLeftTop * kMaxBlockWidth + kConvolveBorderLeftTop;
+  for (int vertical_index = 0; vertical_index < 4; ++vertical_index) {
+    for (int horizontal_index = 0; horizontal_index < 4; ++horizontal_index) {
+      for (int filter_id = 1; filter_id < (1 << kSubPixelBits); ++filter_id) {
+        const int horizontal_filter_id = filter_id;
+        const int vertical_filter_id = (1 << kSubPixelBits) - filter_id;
+        for (int i = 0; i < 2; ++i) {
+          convolve_func_(source_[i] + offset, kMaxBlockWidth,
+                         horizontal_index, vertical_index,
+                         horizontal_filter_id, vertical_filter_id, width,
+                         height, prediction_[i], width);
+        }
+        average_blend_func_(prediction_[0], prediction_[1], width, height,
+                            dest_, width);
+        convolve_average_blend_func_(
+            source_[1] + offset, kMaxBlockWidth, horizontal_index,
+            vertical_index, horizontal_filter_id, vertical_filter_id, width,
+            height, prediction_[0], dest_average_blend_, width);
+        ASSERT_TRUE(test_utils::CompareBlocks(dest_, dest_average_blend_,
+                                              width, height, width, width,
+                                              false))
+            << "filter index (h/v): " << horizontal_index << "/"
+            << vertical_index << ", filter id (h/v): " << horizontal_filter_id
+            << "/" << vertical_filter_id;
+      }
+    }
+  }
+}
+
+TEST_P(ConvolveAverageBlendTest8bpp, RandomValues) { Test(); }
+
 //------------------------------------------------------------------------------
 const ConvolveTestParam kConvolveParam[] = {
     ConvolveTestParam(ConvolveTestParam::kBlockSize2x2),
@@ -1437,6 +1540,8 @@ INSTANTIATE_TEST_SUITE_P(SSE41, ConvolveTest8bpp,
 INSTANTIATE_TEST_SUITE_P(SSE41, ConvolveScaleTest8bpp,
                          testing::Combine(testing::Bool(),
                                           testing::ValuesIn(kConvolveParam)));
+INSTANTIATE_TEST_SUITE_P(SSE41, ConvolveAverageBlendTest8bpp,
+                         testing::ValuesIn(kConvolveParam));
 #endif  // LIBGAV1_ENABLE_SSE4_1
 
 #if LIBGAV1_ENABLE_AVX2
@@ -1446,6 +1551,8 @@ INSTANTIATE_TEST_SUITE_P(AVX2, ConvolveTest8bpp,
 INSTANTIATE_TEST_SUITE_P(AVX2, ConvolveScaleTest8bpp,
                          testing::Combine(testing::Bool(),
                                           testing::ValuesIn(kConvolveParam)));
+INSTANTIATE_TEST_SUITE_P(AVX2, ConvolveAverageBlendTest8bpp,
+                         testing::ValuesIn(kConvolveParam));
 #endif  // LIBGAV1_ENABLE_AVX2
 
 #if LIBGAV1_MAX_BITDEPTH >= 10
@@ -129,9 +129,16 @@ void DspInit() {
 #endif  // LIBGAV1_ENABLE_SSE4_1
 #if LIBGAV1_ENABLE_AVX2
     if ((cpu_features & kAVX2) != 0) {
+      AverageBlendInit_AVX2();
       CdefInit_AVX2();
       ConvolveInit_AVX2();
+      DistanceWeightedBlendInit_AVX2();
       LoopRestorationInit_AVX2();
+      MaskBlendInit_AVX2();
+      MotionFieldProjectionInit_AVX2();
+      MotionVectorSearchInit_AVX2();
+      ObmcInit_AVX2();
+      WeightMaskInit_AVX2();
 #if LIBGAV1_MAX_BITDEPTH >= 10
       LoopRestorationInit10bpp_AVX2();
 #endif  // LIBGAV1_MAX_BITDEPTH >= 10
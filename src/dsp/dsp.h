@@ -352,6 +352,22 @@ using LoopFilterFuncs =
 using CdefDirectionFunc = void (*)(const void* src, ptrdiff_t stride,
                                    uint8_t* direction, int* variance);
 
+// Cdef direction function signature for all the 8x8 blocks of a Cdef unit.
+// Section 7.15.2.
+// |src| is a pointer to the top left 8x8 block of the unit. Pixel size is
+// determined by bitdepth with |stride| given in bytes. |width8x8| and
+// |height8x8| are the dimensions of the unit in 8x8 blocks (at most 8 each).
+// |mask| holds |height8x8| entries. Bit i of |mask[row]| is set if the
+// direction of the i-th block of that row has to be computed.
+// |direction| and |variance| are output arrays with |width8x8| * |height8x8|
+// entries in raster order. Entries of blocks whose bit is not set in |mask|
+// are left unchanged.
+// The pointer arguments do not alias one another.
+using CdefDirectionsFunc = void (*)(const void* src, ptrdiff_t stride,
+                                    int width8x8, int height8x8,
+                                    const uint8_t* mask, uint8_t* direction,
+                                    int* variance);
+
 // Cdef filtering function signature. Section 7.15.3.
 // |source| is a pointer to the input block padded with kCdefLargeValue if at a
 // frame border. |source_stride| is given in units of uint16_t.
@@ -372,6 +388,45 @@ using CdefFilteringFunc = void (*)(const uint16_t* source,
 // |primary_strength| only, [2]: |secondary_strength| only.
 using CdefFilteringFuncs = CdefFilteringFunc[2][3];
 
+// Cdef filtering function signature for a pair of co-located U and V blocks.
+// Section 7.15.3. The chroma planes share the filtering parameters and
+// |direction|, so both blocks are filtered in a single call.
+// This is an auxiliary function for SIMD optimizations and has no corresponding
+// C function. When it is not set the planes are filtered separately with
+// Dsp::cdef_filters.
+// |source_u| and |source_v| are the padded input blocks (see
+// CdefFilteringFunc), both with |source_stride| given in units of uint16_t.
+// |dest_u| and |dest_v| are the output buffers with |dest_stride_u| and
+// |dest_stride_v| given in bytes. The other parameters are the same as in
+// CdefFilteringFunc.
+// The pointer arguments do not alias one another.
+using CdefFilteringUVFunc = void (*)(
+    const uint16_t* source_u, const uint16_t* source_v, ptrdiff_t source_stride,
+    int block_height, int primary_strength, int secondary_strength, int damping,
+    int direction, void* dest_u, ptrdiff_t dest_stride_u, void* dest_v,
+    ptrdiff_t dest_stride_v);
+
+// The indices are the same as in CdefFilteringFuncs.
+using CdefFilteringUVFuncs = CdefFilteringUVFunc[2][3];
+
+// Cdef filtering function signature for blocks where all the pixels read by
+// the filter are inside the frame. Section 7.15.3.
+// Since no pixel needs to be replaced by kCdefLargeValue, the source pixels are
+// read directly from the frame instead of from a padded 16-bit copy of the
+// block. The output matches CdefFilteringFunc run on the widened pixels. The C
+// function is only installed when Dsp::cdef_filters is also the C version.
+// |source| is a pointer to the source block with |source_stride| given in
+// bytes. The other parameters are the same as in CdefFilteringFunc.
+// The pointer arguments do not alias one another.
+// Note: Only the entry from the 8-bit Dsp table is used.
+using CdefFilteringUnpaddedFunc = void (*)(
+    const void* source, ptrdiff_t source_stride, int block_height,
+    int primary_strength, int secondary_strength, int damping, int direction,
+    void* dest, ptrdiff_t dest_stride);
+
+// The indices are the same as in CdefFilteringFuncs.
+using CdefFilteringUnpaddedFuncs = CdefFilteringUnpaddedFunc[2][3];
+
 // Upscaling coefficients function signature. Section 7.16.
 // This is an auxiliary function for SIMD optimizations and has no corresponding
 // C function. Different SIMD versions may have different outputs. So it must
@@ -495,6 +550,21 @@ using ConvolveScaleFunc = void (*)(const void* reference,
 // 0: single predictor. 1: compound predictor.
 using ConvolveScaleFuncs = ConvolveScaleFunc[2];
 
+// Compound 2D convolve and average blend function signature.
+// This is an auxiliary function for SIMD optimizations and has no corresponding
+// C function. It produces the same output as running convolve[0][1][1][1] for
+// the second prediction of a compound block and blending it with the first one
+// using average_blend, without writing the second prediction to memory.
+// |reference| to |height| are the same as for ConvolveFunc.
+// |prediction_0| is the first prediction with a stride equal to |width|.
+// |dest| is the output buffer. |dest_stride| is given in bytes.
+// The pointer arguments do not alias one another.
+using ConvolveAverageBlendFunc = void (*)(
+    const void* reference, ptrdiff_t reference_stride,
+    int horizontal_filter_index, int vertical_filter_index,
+    int horizontal_filter_id, int vertical_filter_id, int width, int height,
+    const void* prediction_0, void* dest, ptrdiff_t dest_stride);
+
 // Weight mask function signature. Section 7.11.3.12.
 // |prediction_0| is the first input block.
 // |prediction_1| is the second input block. Both blocks are int16_t* when
@@ -834,23 +904,6 @@ using MotionFieldProjectionKernelFunc = void (*)(
     int dst_sign, int y8_start, int y8_end, int x8_start, int x8_end,
     TemporalMotionField* motion_field);
 
-// Compound temporal motion vector projection function signature.
-// Section 7.9.3 and 7.10.2.10.
-// |temporal_mvs| is the aligned set of temporal reference motion vectors.
-// |temporal_reference_offsets| specifies the number of frames covered by the
-// original motion vector.
-// |reference_offsets| specifies the number of frames to be covered by the
-// projected motion vector.
-// |count| is the number of the temporal motion vectors.
-// |candidate_mvs| is the aligned set of projected motion vectors.
-// The pointer arguments do not alias one another.
-// Note: Only the entry from the 8-bit Dsp table is used as this function is
-// bitdepth agnostic.
-using MvProjectionCompoundFunc = void (*)(
-    const MotionVector* temporal_mvs, const int8_t* temporal_reference_offsets,
-    const int reference_offsets[2], int count,
-    CompoundMotionVector* candidate_mvs);
-
 // Single temporal motion vector projection function signature.
 // Section 7.9.3 and 7.10.2.10.
 // |temporal_mvs| is the aligned set of temporal reference motion vectors.
@@ -870,10 +923,14 @@ using MvProjectionSingleFunc = void (*)(
 struct Dsp {
   AverageBlendFunc average_blend;
   CdefDirectionFunc cdef_direction;
+  CdefDirectionsFunc cdef_directions;
   CdefFilteringFuncs cdef_filters;
+  CdefFilteringUVFuncs cdef_filters_uv;
+  CdefFilteringUnpaddedFuncs cdef_filters_unpadded;
   CflIntraPredictorFuncs cfl_intra_predictors;
   CflSubsamplerFuncs cfl_subsamplers;
   ConvolveFuncs convolve;
+  ConvolveAverageBlendFunc convolve_2d_average_blend;
   ConvolveScaleFuncs convolve_scale;
   DirectionalIntraPredictorZone1Func directional_intra_predictor_zone1;
   DirectionalIntraPredictorZone2Func directional_intra_predictor_zone2;
@@ -890,7 +947,6 @@ struct Dsp {
   LoopRestorationFuncs loop_restorations;
   MaskBlendFuncs mask_blend;
   MotionFieldProjectionKernelFunc motion_field_projection_kernel;
-  MvProjectionCompoundFunc mv_projection_compound[3];
   MvProjectionSingleFunc mv_projection_single[3];
   ObmcBlendFuncs obmc_blend;
   SuperResCoefficientsFunc super_res_coefficients;
@@ -121,12 +121,51 @@ void CheckTables(bool c_only) {
 
     EXPECT_NE(dsp->super_res, nullptr);
     EXPECT_NE(dsp->cdef_direction, nullptr);
+    EXPECT_NE(dsp->cdef_directions, nullptr);
     for (int i = 0; i < 2; ++i) {
       for (int j = 0; j < 3; ++j) {
         EXPECT_NE(dsp->cdef_filters[i][j], nullptr)
             << "index [" << i << "][" << j << "]";
       }
     }
+
+    bool cdef_filters_uv_is_nonnull = false;
+#if LIBGAV1_ENABLE_SSE4_1
+    cdef_filters_uv_is_nonnull = (cpu_features & kSSE4_1) != 0;
+#endif
+    if (c_only || bitdepth != kBitdepth8) {
+      cdef_filters_uv_is_nonnull = false;
+    }
+    for (int i = 0; i < 2; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        if (cdef_filters_uv_is_nonnull) {
+          EXPECT_NE(dsp->cdef_filters_uv[i][j], nullptr)
+              << "index [" << i << "][" << j << "]";
+        } else {
+          EXPECT_EQ(dsp->cdef_filters_uv[i][j], nullptr)
+              << "index [" << i << "][" << j << "]";
+        }
+      }
+    }
+
+    // The C cdef_filters_unpadded functions are not installed alongside the
+    // NEON cdef_filters, which have no unpadded version.
+    bool cdef_filters_unpadded_is_nonnull =
+        c_only || LIBGAV1_ENABLE_ALL_DSP_FUNCTIONS || !LIBGAV1_ENABLE_NEON;
+    if (bitdepth != kBitdepth8) {
+      cdef_filters_unpadded_is_nonnull = false;
+    }
+    for (int i = 0; i < 2; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        if (cdef_filters_unpadded_is_nonnull) {
+          EXPECT_NE(dsp->cdef_filters_unpadded[i][j], nullptr)
+              << "index [" << i << "][" << j << "]";
+        } else {
+          EXPECT_EQ(dsp->cdef_filters_unpadded[i][j], nullptr)
+              << "index [" << i << "][" << j << "]";
+        }
+      }
+    }
     for (auto convolve_func : dsp->convolve_scale) {
       EXPECT_NE(convolve_func, nullptr);
     }
@@ -143,6 +182,19 @@ void CheckTables(bool c_only) {
         }
       }
     }
+
+    bool convolve_2d_average_blend_is_nonnull = false;
+#if LIBGAV1_ENABLE_SSE4_1
+    convolve_2d_average_blend_is_nonnull = (cpu_features & kSSE4_1) != 0;
+#endif
+    if (c_only || bitdepth != kBitdepth8) {
+      convolve_2d_average_blend_is_nonnull = false;
+    }
+    if (convolve_2d_average_blend_is_nonnull) {
+      EXPECT_NE(dsp->convolve_2d_average_blend, nullptr);
+    } else {
+      EXPECT_EQ(dsp->convolve_2d_average_blend, nullptr);
+    }
     for (const auto& m : dsp->mask_blend) {
       for (int i = 0; i < 2; ++i) {
         if (i == 0 || bitdepth >= 10) {
@@ -209,17 +261,11 @@ void CheckTables(bool c_only) {
 
     if (bitdepth == 8) {
       EXPECT_NE(dsp->motion_field_projection_kernel, nullptr);
-      EXPECT_NE(dsp->mv_projection_compound[0], nullptr);
-      EXPECT_NE(dsp->mv_projection_compound[1], nullptr);
-      EXPECT_NE(dsp->mv_projection_compound[2], nullptr);
       EXPECT_NE(dsp->mv_projection_single[0], nullptr);
       EXPECT_NE(dsp->mv_projection_single[1], nullptr);
       EXPECT_NE(dsp->mv_projection_single[2], nullptr);
     } else {
       EXPECT_EQ(dsp->motion_field_projection_kernel, nullptr);
-      EXPECT_EQ(dsp->mv_projection_compound[0], nullptr);
-      EXPECT_EQ(dsp->mv_projection_compound[1], nullptr);
-      EXPECT_EQ(dsp->mv_projection_compound[2], nullptr);
       EXPECT_EQ(dsp->mv_projection_single[0], nullptr);
       EXPECT_EQ(dsp->mv_projection_single[1], nullptr);
       EXPECT_EQ(dsp->mv_projection_single[2], nullptr);
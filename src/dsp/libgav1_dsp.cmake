@@ -76,13 +76,27 @@ list(APPEND libgav1_dsp_sources
 
 list(APPEND libgav1_dsp_sources_avx2
             ${libgav1_dsp_sources_avx2}
+            "${libgav1_source}/dsp/x86/average_blend_avx2.cc"
+            "${libgav1_source}/dsp/x86/average_blend_avx2.h"
             "${libgav1_source}/dsp/x86/cdef_avx2.cc"
             "${libgav1_source}/dsp/x86/cdef_avx2.h"
             "${libgav1_source}/dsp/x86/convolve_avx2.cc"
             "${libgav1_source}/dsp/x86/convolve_avx2.h"
+            "${libgav1_source}/dsp/x86/distance_weighted_blend_avx2.cc"
+            "${libgav1_source}/dsp/x86/distance_weighted_blend_avx2.h"
             "${libgav1_source}/dsp/x86/loop_restoration_10bit_avx2.cc"
             "${libgav1_source}/dsp/x86/loop_restoration_avx2.cc"
-            "${libgav1_source}/dsp/x86/loop_restoration_avx2.h")
+            "${libgav1_source}/dsp/x86/loop_restoration_avx2.h"
+            "${libgav1_source}/dsp/x86/mask_blend_avx2.cc"
+            "${libgav1_source}/dsp/x86/mask_blend_avx2.h"
+            "${libgav1_source}/dsp/x86/motion_field_projection_avx2.cc"
+            "${libgav1_source}/dsp/x86/motion_field_projection_avx2.h"
+            "${libgav1_source}/dsp/x86/motion_vector_search_avx2.cc"
+            "${libgav1_source}/dsp/x86/motion_vector_search_avx2.h"
+            "${libgav1_source}/dsp/x86/obmc_avx2.cc"
+            "${libgav1_source}/dsp/x86/obmc_avx2.h"
+            "${libgav1_source}/dsp/x86/weight_mask_avx2.cc"
+            "${libgav1_source}/dsp/x86/weight_mask_avx2.h")
 
 list(APPEND libgav1_dsp_sources_neon
             ${libgav1_dsp_sources_neon}
@@ -175,6 +189,7 @@ list(APPEND libgav1_dsp_sources_sse4
             "${libgav1_source}/dsp/x86/motion_vector_search_sse4.h"
             "${libgav1_source}/dsp/x86/obmc_sse4.cc"
             "${libgav1_source}/dsp/x86/obmc_sse4.h"
+            "${libgav1_source}/dsp/x86/obmc_sse4.inc"
             "${libgav1_source}/dsp/x86/super_res_sse4.cc"
             "${libgav1_source}/dsp/x86/super_res_sse4.h"
             "${libgav1_source}/dsp/x86/transpose_sse4.h"
@@ -31,6 +31,7 @@
 // before setting the base.
 // clang-format off
 // SSE4_1
+#include "src/dsp/x86/mask_blend_avx2.h"
 #include "src/dsp/x86/mask_blend_sse4.h"
 // clang-format on
 
@@ -272,6 +272,9 @@ class MaskBlendTest : public testing::TestWithParam<MaskBlendTestParam>,
     } else if (absl::StartsWith(test_case, "SSE41/")) {
       if ((GetCpuInfo() & kSSE4_1) == 0) GTEST_SKIP() << "No SSE4.1 support!";
       MaskBlendInit_SSE4_1();
+    } else if (absl::StartsWith(test_case, "AVX2/")) {
+      if ((GetCpuInfo() & kAVX2) == 0) GTEST_SKIP() << "No AVX2 support!";
+      MaskBlendInit_AVX2();
     } else {
       FAIL() << "Unrecognized architecture prefix in test case name: "
              << test_case;
@@ -561,6 +564,10 @@ INSTANTIATE_TEST_SUITE_P(NEON, MaskBlendTest8bpp,
 INSTANTIATE_TEST_SUITE_P(SSE41, MaskBlendTest8bpp,
                          testing::ValuesIn(kMaskBlendTestParam));
 #endif
+#if LIBGAV1_ENABLE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, MaskBlendTest8bpp,
+                         testing::ValuesIn(kMaskBlendTestParam));
+#endif
 
 #if LIBGAV1_MAX_BITDEPTH >= 10
 using MaskBlendTest10bpp = MaskBlendTest<10, uint16_t>;
@@ -578,6 +585,10 @@ INSTANTIATE_TEST_SUITE_P(C, MaskBlendTest10bpp,
 INSTANTIATE_TEST_SUITE_P(SSE41, MaskBlendTest10bpp,
                          testing::ValuesIn(kMaskBlendTestParam));
 #endif
+#if LIBGAV1_ENABLE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, MaskBlendTest10bpp,
+                         testing::ValuesIn(kMaskBlendTestParam));
+#endif
 #if LIBGAV1_ENABLE_NEON
 INSTANTIATE_TEST_SUITE_P(NEON, MaskBlendTest10bpp,
                          testing::ValuesIn(kMaskBlendTestParam));
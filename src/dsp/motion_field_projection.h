@@ -29,7 +29,7 @@
 // The order of includes is important as each tests for a superior version
 // before setting the base.
 // clang-format off
-// SSE4_1
+#include "src/dsp/x86/motion_field_projection_avx2.h"
 #include "src/dsp/x86/motion_field_projection_sse4.h"
 // clang-format on
 
@@ -30,7 +30,7 @@
 // The order of includes is important as each tests for a superior version
 // before setting the base.
 // clang-format off
-// SSE4_1
+#include "src/dsp/x86/motion_vector_search_avx2.h"
 #include "src/dsp/x86/motion_vector_search_sse4.h"
 // clang-format on
 
@@ -39,8 +39,7 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::mv_projection_compound and Dsp::mv_projection_single. This
-// function is not thread-safe.
+// Initializes Dsp::mv_projection_single. This function is not thread-safe.
 void MotionVectorSearchInit_C();
 
 }  // namespace dsp
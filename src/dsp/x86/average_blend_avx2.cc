@@ -0,0 +1,285 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/average_blend.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace low_bitdepth {
+namespace {
+
+constexpr int kInterPostRoundBit = 4;
+
+inline __m256i AverageBlend16(const int16_t* LIBGAV1_RESTRICT prediction_0,
+                              const int16_t* LIBGAV1_RESTRICT prediction_1) {
+  const __m256i pred_0 = LoadUnaligned32(prediction_0);
+  const __m256i pred_1 = LoadUnaligned32(prediction_1);
+  const __m256i res = _mm256_add_epi16(pred_0, pred_1);
+  return RightShiftWithRounding_S16(res, kInterPostRoundBit + 1);
+}
+
+// Blends 32 consecutive prediction values and returns the pixels in order.
+inline __m256i AverageBlend32(const int16_t* LIBGAV1_RESTRICT prediction_0,
+                              const int16_t* LIBGAV1_RESTRICT prediction_1) {
+  const __m256i res_0 = AverageBlend16(prediction_0, prediction_1);
+  const __m256i res_1 = AverageBlend16(prediction_0 + 16, prediction_1 + 16);
+  // _mm256_packus_epi16() works within 128-bit lanes, restore the order.
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(res_0, res_1), 0xd8);
+}
+
+inline void AverageBlend4x4Row(const int16_t* LIBGAV1_RESTRICT prediction_0,
+                               const int16_t* LIBGAV1_RESTRICT prediction_1,
+                               uint8_t* LIBGAV1_RESTRICT dest,
+                               const ptrdiff_t dest_stride) {
+  const __m256i res = AverageBlend16(prediction_0, prediction_1);
+  const __m128i result_pixels = _mm_packus_epi16(
+      _mm256_castsi256_si128(res), _mm256_extracti128_si256(res, 1));
+  Store4(dest, result_pixels);
+  dest += dest_stride;
+  const int result_1 = _mm_extract_epi32(result_pixels, 1);
+  memcpy(dest, &result_1, sizeof(result_1));
+  dest += dest_stride;
+  const int result_2 = _mm_extract_epi32(result_pixels, 2);
+  memcpy(dest, &result_2, sizeof(result_2));
+  dest += dest_stride;
+  const int result_3 = _mm_extract_epi32(result_pixels, 3);
+  memcpy(dest, &result_3, sizeof(result_3));
+}
+
+void AverageBlend_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                       const void* LIBGAV1_RESTRICT prediction_1,
+                       const int width, const int height,
+                       void* LIBGAV1_RESTRICT const dest,
+                       const ptrdiff_t dest_stride) {
+  auto* dst = static_cast<uint8_t*>(dest);
+  const auto* pred_0 = static_cast<const int16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const int16_t*>(prediction_1);
+  int y = height;
+
+  if (width == 4) {
+    const ptrdiff_t dest_stride4 = dest_stride << 2;
+    constexpr ptrdiff_t width4 = 4 << 2;
+    do {
+      AverageBlend4x4Row(pred_0, pred_1, dst, dest_stride);
+      dst += dest_stride4;
+      pred_0 += width4;
+      pred_1 += width4;
+
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    const ptrdiff_t dest_stride4 = dest_stride << 2;
+    constexpr ptrdiff_t width4 = 8 << 2;
+    do {
+      const __m256i result = AverageBlend32(pred_0, pred_1);
+      const __m128i result_01 = _mm256_castsi256_si128(result);
+      const __m128i result_23 = _mm256_extracti128_si256(result, 1);
+      StoreLo8(dst, result_01);
+      StoreHi8(dst + dest_stride, result_01);
+      StoreLo8(dst + 2 * dest_stride, result_23);
+      StoreHi8(dst + 3 * dest_stride, result_23);
+      dst += dest_stride4;
+      pred_0 += width4;
+      pred_1 += width4;
+
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 16) {
+    const ptrdiff_t dest_stride2 = dest_stride << 1;
+    constexpr ptrdiff_t width2 = 16 << 1;
+    do {
+      const __m256i result = AverageBlend32(pred_0, pred_1);
+      StoreUnaligned16(dst, _mm256_castsi256_si128(result));
+      StoreUnaligned16(dst + dest_stride, _mm256_extracti128_si256(result, 1));
+      dst += dest_stride2;
+      pred_0 += width2;
+      pred_1 += width2;
+
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      StoreUnaligned32(dst + x, AverageBlend32(pred_0 + x, pred_1 + x));
+      x += 32;
+    } while (x < width);
+    dst += dest_stride;
+    pred_0 += width;
+    pred_1 += width;
+  } while (--y != 0);
+}
+
+void Init8bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_8BPP_AVX2(AverageBlend)
+  dsp->average_blend = AverageBlend_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace low_bitdepth
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+namespace high_bitdepth {
+namespace {
+
+constexpr int kInterPostRoundBitPlusOne = 5;
+
+// Blends 16 consecutive prediction values and returns the pixels in order.
+inline __m256i AverageBlend16(const uint16_t* LIBGAV1_RESTRICT prediction_0,
+                              const uint16_t* LIBGAV1_RESTRICT prediction_1,
+                              const __m256i& offset, const __m256i& max) {
+  const __m256i zero = _mm256_setzero_si256();
+  // pred_0/1 max range is 16b.
+  const __m256i pred_0 = LoadUnaligned32(prediction_0);
+  const __m256i pred_1 = LoadUnaligned32(prediction_1);
+  const __m256i pred_00 = _mm256_unpacklo_epi16(pred_0, zero);
+  const __m256i pred_01 = _mm256_unpackhi_epi16(pred_0, zero);
+  const __m256i pred_10 = _mm256_unpacklo_epi16(pred_1, zero);
+  const __m256i pred_11 = _mm256_unpackhi_epi16(pred_1, zero);
+
+  // Remove the compound offset, then RightShiftWithRounding and Clip3.
+  const __m256i pred_add_0 =
+      _mm256_sub_epi32(_mm256_add_epi32(pred_00, pred_10), offset);
+  const __m256i pred_add_1 =
+      _mm256_sub_epi32(_mm256_add_epi32(pred_01, pred_11), offset);
+  const __m256i res_0 =
+      _mm256_srai_epi32(pred_add_0, kInterPostRoundBitPlusOne);
+  const __m256i res_1 =
+      _mm256_srai_epi32(pred_add_1, kInterPostRoundBitPlusOne);
+  // The unpacks and the pack both work within 128-bit lanes, so the order is
+  // preserved.
+  return _mm256_min_epi16(_mm256_packus_epi32(res_0, res_1), max);
+}
+
+void AverageBlend10bpp_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                            const void* LIBGAV1_RESTRICT prediction_1,
+                            const int width, const int height,
+                            void* LIBGAV1_RESTRICT const dest,
+                            const ptrdiff_t dst_stride) {
+  auto* dst = static_cast<uint16_t*>(dest);
+  const ptrdiff_t dest_stride = dst_stride / sizeof(dst[0]);
+  const auto* pred_0 = static_cast<const uint16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const uint16_t*>(prediction_1);
+  // The compound offset of both predictions less the rounding offset.
+  const __m256i offset =
+      _mm256_set1_epi32(kCompoundOffset + kCompoundOffset -
+                        ((1 << kInterPostRoundBitPlusOne) >> 1));
+  const __m256i max = _mm256_set1_epi16((1 << kBitdepth10) - 1);
+  int y = height;
+
+  if (width == 4) {
+    const ptrdiff_t dest_stride4 = dest_stride << 2;
+    constexpr ptrdiff_t width4 = 4 << 2;
+    do {
+      const __m256i result = AverageBlend16(pred_0, pred_1, offset, max);
+      const __m128i result_01 = _mm256_castsi256_si128(result);
+      const __m128i result_23 = _mm256_extracti128_si256(result, 1);
+      StoreLo8(dst, result_01);
+      StoreHi8(dst + dest_stride, result_01);
+      StoreLo8(dst + 2 * dest_stride, result_23);
+      StoreHi8(dst + 3 * dest_stride, result_23);
+      dst += dest_stride4;
+      pred_0 += width4;
+      pred_1 += width4;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    const ptrdiff_t dest_stride2 = dest_stride << 1;
+    constexpr ptrdiff_t width2 = 8 << 1;
+    do {
+      const __m256i result = AverageBlend16(pred_0, pred_1, offset, max);
+      StoreUnaligned16(dst, _mm256_castsi256_si128(result));
+      StoreUnaligned16(dst + dest_stride, _mm256_extracti128_si256(result, 1));
+      dst += dest_stride2;
+      pred_0 += width2;
+      pred_1 += width2;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      StoreUnaligned32(dst + x,
+                       AverageBlend16(pred_0 + x, pred_1 + x, offset, max));
+      x += 16;
+    } while (x < width);
+    dst += dest_stride;
+    pred_0 += width;
+    pred_1 += width;
+  } while (--y != 0);
+}
+
+void Init10bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_10BPP_AVX2(AverageBlend)
+  dsp->average_blend = AverageBlend10bpp_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace high_bitdepth
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+void AverageBlendInit_AVX2() {
+  low_bitdepth::Init8bpp();
+#if LIBGAV1_MAX_BITDEPTH >= 10
+  high_bitdepth::Init10bpp();
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+
+namespace libgav1 {
+namespace dsp {
+
+void AverageBlendInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
@@ -269,8 +269,9 @@ LIBGAV1_ALWAYS_INLINE void AddPartial_D7_D5(__m256i* v_src, __m256i* partial_lo,
       _mm256_add_epi16(*partial_hi, _mm256_srli_si256(v_pair_add[3], 10));
 }
 
-LIBGAV1_ALWAYS_INLINE void AddPartial(const uint8_t* LIBGAV1_RESTRICT src,
-                                      ptrdiff_t stride, __m256i* partial) {
+// |rows| holds the 8 rows of the block in their low 8 bytes.
+LIBGAV1_ALWAYS_INLINE void AddPartial(const __m128i* LIBGAV1_RESTRICT rows,
+                                      __m256i* partial) {
   // 8x8 input
   // 00 01 02 03 04 05 06 07
   // 10 11 12 13 14 15 16 17
@@ -281,11 +282,10 @@ LIBGAV1_ALWAYS_INLINE void AddPartial(const uint8_t* LIBGAV1_RESTRICT src,
   // 60 61 62 63 64 65 66 67
   // 70 71 72 73 74 75 76 77
   __m256i v_src[8];
-  for (auto& i : v_src) {
-    i = _mm256_castsi128_si256(LoadLo8(src));
+  for (int i = 0; i < 8; ++i) {
+    v_src[i] = _mm256_castsi128_si256(rows[i]);
     // Dup lower lane.
-    i = _mm256_permute2x128_si256(i, i, 0x0);
-    src += stride;
+    v_src[i] = _mm256_permute2x128_si256(v_src[i], v_src[i], 0x0);
   }
 
   const __m256i v_zero = _mm256_setzero_si256();
@@ -451,13 +451,26 @@ inline void Cost2And6_Pair(uint32_t* cost, const __m256i partial_a,
   cost[6] = _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
 }
 
-void CdefDirection_AVX2(const void* LIBGAV1_RESTRICT const source,
-                        ptrdiff_t stride,
-                        uint8_t* LIBGAV1_RESTRICT const direction,
-                        int* LIBGAV1_RESTRICT const variance) {
-  assert(direction != nullptr);
-  assert(variance != nullptr);
-  const auto* src = static_cast<const uint8_t*>(source);
+// The division tables used by CdefDirection8x8(). They are loaded once per
+// call of CdefDirection_AVX2() and CdefDirections_AVX2().
+struct DivisionTables {
+  DivisionTables()
+      : all(LoadUnaligned32(kCdefDivisionTable)),
+        seventh(_mm256_broadcastd_epi32(
+            _mm_cvtsi32_si128(kCdefDivisionTable[7]))),
+        odd{LoadUnaligned32(kCdefDivisionTableOddPairsPadded),
+            LoadUnaligned32(kCdefDivisionTableOddPairsPadded + 8)} {}
+
+  const __m256i all;
+  const __m256i seventh;
+  const __m256i odd[2];
+};
+
+// |rows| holds the 8 rows of the block in their low 8 bytes.
+LIBGAV1_ALWAYS_INLINE void CdefDirection8x8(
+    const __m128i* LIBGAV1_RESTRICT const rows, const DivisionTables& tables,
+    uint8_t* LIBGAV1_RESTRICT const direction,
+    int* LIBGAV1_RESTRICT const variance) {
   uint32_t cost[8];
 
   // partial[0] = add partial 0,4 low
@@ -470,22 +483,14 @@ void CdefDirection_AVX2(const void* LIBGAV1_RESTRICT const source,
   // partial[7] = add partial 7,5 low
   __m256i partial[8];
 
-  AddPartial(src, stride, partial);
-
-  const __m256i division_table = LoadUnaligned32(kCdefDivisionTable);
-  const __m256i division_table_7 =
-      _mm256_broadcastd_epi32(_mm_cvtsi32_si128(kCdefDivisionTable[7]));
-
-  Cost2And6_Pair(cost, partial[2], partial[6], division_table_7);
+  AddPartial(rows, partial);
 
-  Cost0Or4_Pair(cost, partial[0], partial[4], division_table);
+  Cost2And6_Pair(cost, partial[2], partial[6], tables.seventh);
 
-  const __m256i division_table_odd[2] = {
-      LoadUnaligned32(kCdefDivisionTableOddPairsPadded),
-      LoadUnaligned32(kCdefDivisionTableOddPairsPadded + 8)};
+  Cost0Or4_Pair(cost, partial[0], partial[4], tables.all);
 
-  CostOdd_Pair<1, 3>(cost, partial[1], partial[3], division_table_odd);
-  CostOdd_Pair<7, 5>(cost, partial[7], partial[5], division_table_odd);
+  CostOdd_Pair<1, 3>(cost, partial[1], partial[3], tables.odd);
+  CostOdd_Pair<7, 5>(cost, partial[7], partial[5], tables.odd);
 
   uint32_t best_cost = 0;
   *direction = 0;
@@ -498,11 +503,93 @@ void CdefDirection_AVX2(const void* LIBGAV1_RESTRICT const source,
   *variance = (best_cost - cost[(*direction + 4) & 7]) >> 10;
 }
 
+void CdefDirection_AVX2(const void* LIBGAV1_RESTRICT const source,
+                        ptrdiff_t stride,
+                        uint8_t* LIBGAV1_RESTRICT const direction,
+                        int* LIBGAV1_RESTRICT const variance) {
+  assert(direction != nullptr);
+  assert(variance != nullptr);
+  const auto* src = static_cast<const uint8_t*>(source);
+  __m128i rows[8];
+  for (auto& row : rows) {
+    row = LoadLo8(src);
+    src += stride;
+  }
+  CdefDirection8x8(rows, DivisionTables(), direction, variance);
+}
+
+// Horizontally adjacent blocks are processed in pairs so that each row of the
+// pair is fetched with a single 16 byte load.
+void CdefDirections_AVX2(const void* LIBGAV1_RESTRICT const source,
+                         const ptrdiff_t stride, const int width8x8,
+                         const int height8x8,
+                         const uint8_t* LIBGAV1_RESTRICT const mask,
+                         uint8_t* LIBGAV1_RESTRICT direction,
+                         int* LIBGAV1_RESTRICT variance) {
+  assert(width8x8 > 0 && width8x8 <= 8);
+  assert(height8x8 > 0 && height8x8 <= 8);
+  const auto* src = static_cast<const uint8_t*>(source);
+  const DivisionTables tables;
+  for (int y = 0; y < height8x8; ++y) {
+    const int row_mask = mask[y] & ((1 << width8x8) - 1);
+    for (int x = 0; x < width8x8; x += 2) {
+      const int pair_mask = (row_mask >> x) & 3;
+      if (pair_mask == 0) continue;
+      const uint8_t* src_x = src + x * 8;
+      __m128i rows[8];
+      if (x + 1 < width8x8) {
+        __m128i rows_right[8];
+        for (int i = 0; i < 8; ++i) {
+          rows[i] = LoadUnaligned16(src_x);
+          rows_right[i] = _mm_srli_si128(rows[i], 8);
+          src_x += stride;
+        }
+        if ((pair_mask & 2) != 0) {
+          CdefDirection8x8(rows_right, tables, &direction[x + 1],
+                           &variance[x + 1]);
+        }
+        if ((pair_mask & 1) == 0) continue;
+      } else {
+        for (auto& row : rows) {
+          row = LoadLo8(src_x);
+          src_x += stride;
+        }
+      }
+      CdefDirection8x8(rows, tables, &direction[x], &variance[x]);
+    }
+    src += 8 * stride;
+    direction += width8x8;
+    variance += width8x8;
+  }
+}
+
 // -------------------------------------------------------------------------
 // CdefFilter
 
+// Load 8 pixels as 16-bit values.
+inline __m128i LoadPixels8(const uint16_t* const src) {
+  return LoadUnaligned16(src);
+}
+
+inline __m128i LoadPixels8(const uint8_t* const src) {
+  return _mm_cvtepu8_epi16(LoadLo8(src));
+}
+
+// Load 4 pixels from |src| into the low half and 4 pixels from |src_hi| into
+// the high half as 16-bit values.
+inline __m128i LoadPixels4x2(const uint16_t* const src,
+                             const uint16_t* const src_hi) {
+  return LoadHi8(LoadLo8(src), src_hi);
+}
+
+inline __m128i LoadPixels4x2(const uint8_t* const src,
+                             const uint8_t* const src_hi) {
+  return _mm_cvtepu8_epi16(_mm_unpacklo_epi32(Load4(src), Load4(src_hi)));
+}
+
 // Load 4 vectors based on the given |direction|.
-inline void LoadDirection(const uint16_t* LIBGAV1_RESTRICT const src,
+template <typename T>
+inline void LoadDirection(const T* LIBGAV1_RESTRICT const src,
                           const ptrdiff_t stride, __m128i* output,
                           const int direction) {
   // Each |direction| describes a different set of source values. Expand this
@@ -520,29 +607,32 @@ inline void LoadDirection(const uint16_t* LIBGAV1_RESTRICT const src,
   const int x_0 = kCdefDirections[direction][0][1];
   const int y_1 = kCdefDirections[direction][1][0];
   const int x_1 = kCdefDirections[direction][1][1];
-  output[0] = LoadUnaligned16(src - y_0 * stride - x_0);
-  output[1] = LoadUnaligned16(src + y_0 * stride + x_0);
-  output[2] = LoadUnaligned16(src - y_1 * stride - x_1);
-  output[3] = LoadUnaligned16(src + y_1 * stride + x_1);
+  output[0] = LoadPixels8(src - y_0 * stride - x_0);
+  output[1] = LoadPixels8(src + y_0 * stride + x_0);
+  output[2] = LoadPixels8(src - y_1 * stride - x_1);
+  output[3] = LoadPixels8(src + y_1 * stride + x_1);
 }
 
 // Load 4 vectors based on the given |direction|. Use when |block_width| == 4 to
-// do 2 rows at a time.
-void LoadDirection4(const uint16_t* LIBGAV1_RESTRICT const src,
+// do 2 rows at a time. The low half of each vector is loaded relative to |src|
+// and the high half relative to |src_hi|.
+template <typename T>
+void LoadDirection4(const T* LIBGAV1_RESTRICT const src,
+                    const T* LIBGAV1_RESTRICT const src_hi,
                     const ptrdiff_t stride, __m128i* output,
                     const int direction) {
   const int y_0 = kCdefDirections[direction][0][0];
   const int x_0 = kCdefDirections[direction][0][1];
   const int y_1 = kCdefDirections[direction][1][0];
   const int x_1 = kCdefDirections[direction][1][1];
-  output[0] = LoadHi8(LoadLo8(src - y_0 * stride - x_0),
-                      src - y_0 * stride + stride - x_0);
-  output[1] = LoadHi8(LoadLo8(src + y_0 * stride + x_0),
-                      src + y_0 * stride + stride + x_0);
-  output[2] = LoadHi8(LoadLo8(src - y_1 * stride - x_1),
-                      src - y_1 * stride + stride - x_1);
-  output[3] = LoadHi8(LoadLo8(src + y_1 * stride + x_1),
-                      src + y_1 * stride + stride + x_1);
+  output[0] = LoadPixels4x2(src - y_0 * stride - x_0,
+                            src_hi - y_0 * stride - x_0);
+  output[1] = LoadPixels4x2(src + y_0 * stride + x_0,
+                            src_hi + y_0 * stride + x_0);
+  output[2] = LoadPixels4x2(src - y_1 * stride - x_1,
+                            src_hi - y_1 * stride - x_1);
+  output[3] = LoadPixels4x2(src + y_1 * stride + x_1,
+                            src_hi + y_1 * stride + x_1);
 }
 
 inline __m256i Constrain(const __m256i& pixel, const __m256i& reference,
@@ -572,16 +662,25 @@ inline __m256i ApplyConstrainAndTap(const __m256i& pixel, const __m256i& val,
   return _mm256_mullo_epi16(constrained, tap);
 }
 
-template <int width, bool enable_primary = true, bool enable_secondary = true>
-void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
-                     const ptrdiff_t src_stride, const int height,
-                     const int primary_strength, const int secondary_strength,
-                     const int damping, const int direction,
-                     void* LIBGAV1_RESTRICT dest, const ptrdiff_t dst_stride) {
+// Filters |num_rows| vectors of 8 pixels. When |width| is 8, each vector is a
+// row starting at |src|. When |width| is 4, the low half of the vector is a row
+// starting at |src| and the high half is a row starting at |src_hi|. After each
+// vector, the source pointers advance by |src_step| and the destination
+// pointers by |dst_step| and |dst_hi_step| respectively. The strides and steps
+// of the source are given in units of T. T is uint16_t for the blocks padded
+// with kCdefLargeValue and uint8_t for the unpadded pixels of the frame.
+template <int width, bool enable_primary, bool enable_secondary, typename T>
+void CdefFilterRows(const T* LIBGAV1_RESTRICT src,
+                    const T* LIBGAV1_RESTRICT src_hi,
+                    const ptrdiff_t src_stride, const ptrdiff_t src_step,
+                    const int num_rows, const int primary_strength,
+                    const int secondary_strength, const int damping,
+                    const int direction, uint8_t* LIBGAV1_RESTRICT dst,
+                    uint8_t* LIBGAV1_RESTRICT dst_hi, const ptrdiff_t dst_step,
+                    const ptrdiff_t dst_hi_step) {
   static_assert(width == 8 || width == 4, "Invalid CDEF width.");
   static_assert(enable_primary || enable_secondary, "");
   constexpr bool clipping_required = enable_primary && enable_secondary;
-  auto* dst = static_cast<uint8_t*>(dest);
   __m128i primary_damping_shift, secondary_damping_shift;
 
   // FloorLog2() requires input to be > 0.
@@ -614,13 +713,13 @@ void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
   const __m256i secondary_threshold =
       _mm256_broadcastw_epi16(_mm_cvtsi32_si128(secondary_strength));
 
-  int y = height;
+  int y = num_rows;
   do {
     __m128i pixel_128;
     if (width == 8) {
-      pixel_128 = LoadUnaligned16(src);
+      pixel_128 = LoadPixels8(src);
     } else {
-      pixel_128 = LoadHi8(LoadLo8(src), src + src_stride);
+      pixel_128 = LoadPixels4x2(src, src_hi);
     }
 
     __m256i pixel = SetrM128i(pixel_128, pixel_128);
@@ -635,7 +734,7 @@ void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
       if (width == 8) {
         LoadDirection(src, src_stride, primary_val_128, direction);
       } else {
-        LoadDirection4(src, src_stride, primary_val_128, direction);
+        LoadDirection4(src, src_hi, src_stride, primary_val_128, direction);
       }
 
       __m256i primary_val[2];
@@ -672,8 +771,10 @@ void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
         LoadDirection(src, src_stride, secondary_val_128, direction + 2);
         LoadDirection(src, src_stride, secondary_val_128 + 4, direction - 2);
       } else {
-        LoadDirection4(src, src_stride, secondary_val_128, direction + 2);
-        LoadDirection4(src, src_stride, secondary_val_128 + 4, direction - 2);
+        LoadDirection4(src, src_hi, src_stride, secondary_val_128,
+                       direction + 2);
+        LoadDirection4(src, src_hi, src_stride, secondary_val_128 + 4,
+                       direction - 2);
       }
 
       __m256i secondary_val[4];
@@ -739,26 +840,100 @@ void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
     }
 
     const __m128i result = _mm_packus_epi16(sum, sum);
+    src += src_step;
     if (width == 8) {
-      src += src_stride;
       StoreLo8(dst, result);
-      dst += dst_stride;
-      --y;
     } else {
-      src += src_stride << 1;
+      src_hi += src_step;
       Store4(dst, result);
-      dst += dst_stride;
-      Store4(dst, _mm_srli_si128(result, 4));
-      dst += dst_stride;
-      y -= 2;
+      Store4(dst_hi, _mm_srli_si128(result, 4));
+      dst_hi += dst_hi_step;
     }
-  } while (y != 0);
+    dst += dst_step;
+  } while (--y != 0);
+}
+
+// Filters a |width|x|height| block. See CdefFilterRows() for the units of
+// |src_stride|.
+template <int width, bool enable_primary, bool enable_secondary, typename T>
+void CdefFilterBlock(const T* LIBGAV1_RESTRICT src, const ptrdiff_t src_stride,
+                     const int height, const int primary_strength,
+                     const int secondary_strength, const int damping,
+                     const int direction, uint8_t* LIBGAV1_RESTRICT dst,
+                     const ptrdiff_t dst_stride) {
+  if (width == 8) {
+    CdefFilterRows<width, enable_primary, enable_secondary, T>(
+        src, nullptr, src_stride, src_stride, height, primary_strength,
+        secondary_strength, damping, direction, dst, nullptr, dst_stride, 0);
+    return;
+  }
+  // Do 2 rows at a time.
+  CdefFilterRows<width, enable_primary, enable_secondary, T>(
+      src, src + src_stride, src_stride, src_stride << 1, height >> 1,
+      primary_strength, secondary_strength, damping, direction, dst,
+      dst + dst_stride, dst_stride << 1, dst_stride << 1);
+}
+
+template <int width, bool enable_primary = true, bool enable_secondary = true>
+void CdefFilter_AVX2(const uint16_t* LIBGAV1_RESTRICT src,
+                     const ptrdiff_t src_stride, const int height,
+                     const int primary_strength, const int secondary_strength,
+                     const int damping, const int direction,
+                     void* LIBGAV1_RESTRICT dest, const ptrdiff_t dst_stride) {
+  CdefFilterBlock<width, enable_primary, enable_secondary>(
+      src, src_stride, height, primary_strength, secondary_strength, damping,
+      direction, static_cast<uint8_t*>(dest), dst_stride);
+}
+
+template <int width, bool enable_primary = true, bool enable_secondary = true>
+void CdefFilterUV_AVX2(const uint16_t* LIBGAV1_RESTRICT src_u,
+                       const uint16_t* LIBGAV1_RESTRICT src_v,
+                       const ptrdiff_t src_stride, const int height,
+                       const int primary_strength, const int secondary_strength,
+                       const int damping, const int direction,
+                       void* LIBGAV1_RESTRICT dest_u,
+                       const ptrdiff_t dst_stride_u,
+                       void* LIBGAV1_RESTRICT dest_v,
+                       const ptrdiff_t dst_stride_v) {
+  auto* const dst_u = static_cast<uint8_t*>(dest_u);
+  auto* const dst_v = static_cast<uint8_t*>(dest_v);
+  if (width == 8) {
+    // A row of 8 pixels already fills the vector.
+    CdefFilterRows<width, enable_primary, enable_secondary, uint16_t>(
+        src_u, nullptr, src_stride, src_stride, height, primary_strength,
+        secondary_strength, damping, direction, dst_u, nullptr, dst_stride_u,
+        0);
+    CdefFilterRows<width, enable_primary, enable_secondary, uint16_t>(
+        src_v, nullptr, src_stride, src_stride, height, primary_strength,
+        secondary_strength, damping, direction, dst_v, nullptr, dst_stride_v,
+        0);
+    return;
+  }
+  // Filter a row of U and the co-located row of V together.
+  CdefFilterRows<width, enable_primary, enable_secondary, uint16_t>(
+      src_u, src_v, src_stride, src_stride, height, primary_strength,
+      secondary_strength, damping, direction, dst_u, dst_v, dst_stride_u,
+      dst_stride_v);
+}
+
+template <int width, bool enable_primary = true, bool enable_secondary = true>
+void CdefFilterUnpadded_AVX2(const void* LIBGAV1_RESTRICT const source,
+                             const ptrdiff_t src_stride, const int height,
+                             const int primary_strength,
+                             const int secondary_strength, const int damping,
+                             const int direction, void* LIBGAV1_RESTRICT dest,
+                             const ptrdiff_t dst_stride) {
+  CdefFilterBlock<width, enable_primary, enable_secondary>(
+      static_cast<const uint8_t*>(source), src_stride, height,
+      primary_strength, secondary_strength, damping, direction,
+      static_cast<uint8_t*>(dest), dst_stride);
 }
 
 void Init8bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(8);
   assert(dsp != nullptr);
   dsp->cdef_direction = CdefDirection_AVX2;
+  dsp->cdef_directions = CdefDirections_AVX2;
 
   dsp->cdef_filters[0][0] = CdefFilter_AVX2<4>;
   dsp->cdef_filters[0][1] =
@@ -768,6 +943,27 @@ void Init8bpp() {
   dsp->cdef_filters[1][1] =
       CdefFilter_AVX2<8, /*enable_primary=*/true, /*enable_secondary=*/false>;
   dsp->cdef_filters[1][2] = CdefFilter_AVX2<8, /*enable_primary=*/false>;
+
+  dsp->cdef_filters_uv[0][0] = CdefFilterUV_AVX2<4>;
+  dsp->cdef_filters_uv[0][1] =
+      CdefFilterUV_AVX2<4, /*enable_primary=*/true, /*enable_secondary=*/false>;
+  dsp->cdef_filters_uv[0][2] = CdefFilterUV_AVX2<4, /*enable_primary=*/false>;
+  dsp->cdef_filters_uv[1][0] = CdefFilterUV_AVX2<8>;
+  dsp->cdef_filters_uv[1][1] =
+      CdefFilterUV_AVX2<8, /*enable_primary=*/true, /*enable_secondary=*/false>;
+  dsp->cdef_filters_uv[1][2] = CdefFilterUV_AVX2<8, /*enable_primary=*/false>;
+  dsp->cdef_filters_unpadded[0][0] = CdefFilterUnpadded_AVX2<4>;
+  dsp->cdef_filters_unpadded[0][1] =
+      CdefFilterUnpadded_AVX2<4, /*enable_primary=*/true,
+                              /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[0][2] =
+      CdefFilterUnpadded_AVX2<4, /*enable_primary=*/false>;
+  dsp->cdef_filters_unpadded[1][0] = CdefFilterUnpadded_AVX2<8>;
+  dsp->cdef_filters_unpadded[1][1] =
+      CdefFilterUnpadded_AVX2<8, /*enable_primary=*/true,
+                              /*enable_secondary=*/false>;
+  dsp->cdef_filters_unpadded[1][2] =
+      CdefFilterUnpadded_AVX2<8, /*enable_primary=*/false>;
 }
 
 }  // namespace
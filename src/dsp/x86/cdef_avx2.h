@@ -23,8 +23,9 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::cdef_direction and Dsp::cdef_filters. This function is not
-// thread-safe.
+// Initializes Dsp::cdef_direction, Dsp::cdef_directions, Dsp::cdef_filters,
+// Dsp::cdef_filters_uv and Dsp::cdef_filters_unpadded.
+// This function is not thread-safe.
 void CdefInit_AVX2();
 
 }  // namespace dsp
@@ -36,10 +37,22 @@ void CdefInit_AVX2();
 #define LIBGAV1_Dsp8bpp_CdefDirection LIBGAV1_CPU_AVX2
 #endif
 
+#ifndef LIBGAV1_Dsp8bpp_CdefDirections
+#define LIBGAV1_Dsp8bpp_CdefDirections LIBGAV1_CPU_AVX2
+#endif
+
 #ifndef LIBGAV1_Dsp8bpp_CdefFilters
 #define LIBGAV1_Dsp8bpp_CdefFilters LIBGAV1_CPU_AVX2
 #endif
 
+#ifndef LIBGAV1_Dsp8bpp_CdefFiltersUV
+#define LIBGAV1_Dsp8bpp_CdefFiltersUV LIBGAV1_CPU_AVX2
+#endif
+
+#ifndef LIBGAV1_Dsp8bpp_CdefFiltersUnpadded
+#define LIBGAV1_Dsp8bpp_CdefFiltersUnpadded LIBGAV1_CPU_AVX2
+#endif
+
 #endif  // LIBGAV1_TARGETING_AVX2
 
 #endif  // LIBGAV1_SRC_DSP_X86_CDEF_AVX2_H_
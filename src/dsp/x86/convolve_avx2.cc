@@ -458,11 +458,15 @@ __m256i SimpleSum2DVerticalTaps(const __m256i* const src,
       RightShiftWithRounding_S32(sum_hi, kInterRoundBitsVertical - 1));
 }
 
-template <int num_taps, bool is_compound = false>
+// When |is_average_blend| is true, the compound result is averaged with
+// |prediction_0|, whose stride is |width|, and written to |dst| as pixels.
+template <int num_taps, bool is_compound = false, bool is_average_blend = false>
 void Filter2DVertical16xH(const uint16_t* LIBGAV1_RESTRICT src,
                           void* LIBGAV1_RESTRICT const dst,
                           const ptrdiff_t dst_stride, const int width,
-                          const int height, const __m256i* const taps) {
+                          const int height, const __m256i* const taps,
+                          const int16_t* const prediction_0 = nullptr) {
+  static_assert(is_compound || !is_average_blend, "");
   assert(width >= 8);
   constexpr int next_row = num_taps - 1;
   // The Horizontal pass uses |width| as |stride| for the intermediate buffer.
@@ -498,6 +502,8 @@ void Filter2DVertical16xH(const uint16_t* LIBGAV1_RESTRICT src,
 
     auto* dst8_x = dst8 + x;
     auto* dst16_x = dst16 + x;
+    const int16_t* prediction_0_x =
+        is_average_blend ? prediction_0 + x : nullptr;
     int y = height;
     do {
       srcs[next_row] = LoadAligned32(src_x);
@@ -505,7 +511,16 @@ void Filter2DVertical16xH(const uint16_t* LIBGAV1_RESTRICT src,
 
       const __m256i sum =
           SimpleSum2DVerticalTaps<num_taps, is_compound>(srcs, taps);
-      if (is_compound) {
+      if (is_average_blend) {
+        const __m256i res = RightShiftWithRounding_S16(
+            _mm256_add_epi16(LoadUnaligned32(prediction_0_x), sum),
+            kAverageBlendRoundBits);
+        StoreUnaligned16(dst8_x,
+                         _mm_packus_epi16(_mm256_castsi256_si128(res),
+                                          _mm256_extracti128_si256(res, 1)));
+        dst8_x += dst_stride;
+        prediction_0_x += width;
+      } else if (is_compound) {
         StoreUnaligned32(dst16_x, sum);
         dst16_x += dst_stride;
       } else {
@@ -1364,12 +1379,20 @@ void ConvolveCompoundHorizontal_AVX2(
       filter_index);
 }
 
-void ConvolveCompound2D_AVX2(
-    const void* LIBGAV1_RESTRICT const reference,
-    const ptrdiff_t reference_stride, const int horizontal_filter_index,
-    const int vertical_filter_index, const int horizontal_filter_id,
-    const int vertical_filter_id, const int width, const int height,
-    void* LIBGAV1_RESTRICT prediction, const ptrdiff_t pred_stride) {
+// When |is_average_blend| is true, the compound prediction is averaged with
+// |prediction_0| and |prediction| receives pixels. Otherwise |prediction|
+// receives the compound prediction and |pred_stride| is |width|.
+template <bool is_average_blend>
+void ConvolveCompound2D(const void* LIBGAV1_RESTRICT const reference,
+                        const ptrdiff_t reference_stride,
+                        const int horizontal_filter_index,
+                        const int vertical_filter_index,
+                        const int horizontal_filter_id,
+                        const int vertical_filter_id, const int width,
+                        const int height,
+                        const int16_t* LIBGAV1_RESTRICT const prediction_0,
+                        void* LIBGAV1_RESTRICT prediction,
+                        const ptrdiff_t pred_stride) {
   const int horiz_filter_index = GetFilterIndex(horizontal_filter_index, width);
   const int vert_filter_index = GetFilterIndex(vertical_filter_index, height);
   const int vertical_taps =
@@ -1407,20 +1430,24 @@ void ConvolveCompound2D_AVX2(
 
     if (vertical_taps == 8) {
       SetupTaps<8, /*is_2d_vertical=*/true>(&v_filter_ext, taps_256);
-      Filter2DVertical16xH<8, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps_256);
+      Filter2DVertical16xH<8, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps_256,
+          prediction_0);
     } else if (vertical_taps == 6) {
       SetupTaps<6, /*is_2d_vertical=*/true>(&v_filter_ext, taps_256);
-      Filter2DVertical16xH<6, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps_256);
+      Filter2DVertical16xH<6, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps_256,
+          prediction_0);
     } else if (vertical_taps == 4) {
       SetupTaps<4, /*is_2d_vertical=*/true>(&v_filter_ext, taps_256);
-      Filter2DVertical16xH<4, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps_256);
+      Filter2DVertical16xH<4, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps_256,
+          prediction_0);
     } else {  // |vertical_taps| == 2
       SetupTaps<2, /*is_2d_vertical=*/true>(&v_filter_ext, taps_256);
-      Filter2DVertical16xH<2, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps_256);
+      Filter2DVertical16xH<2, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps_256,
+          prediction_0);
     }
   } else {  // width <= 8
     __m128i taps[4];
@@ -1428,43 +1455,72 @@ void ConvolveCompound2D_AVX2(
     if (vertical_taps == 8) {
       SetupTaps<8, /*is_2d_vertical=*/true>(&v_filter, taps);
       if (width == 4) {
-        Filter2DVertical4xH<8, /*is_compound=*/true>(intermediate_result, dest,
-                                                     dest_stride, height, taps);
+        Filter2DVertical4xH<8, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, height, taps, prediction_0);
       } else {
-        Filter2DVertical<8, /*is_compound=*/true>(
-            intermediate_result, dest, dest_stride, width, height, taps);
+        Filter2DVertical<8, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, width, height, taps,
+            prediction_0);
       }
     } else if (vertical_taps == 6) {
       SetupTaps<6, /*is_2d_vertical=*/true>(&v_filter, taps);
       if (width == 4) {
-        Filter2DVertical4xH<6, /*is_compound=*/true>(intermediate_result, dest,
-                                                     dest_stride, height, taps);
+        Filter2DVertical4xH<6, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, height, taps, prediction_0);
       } else {
-        Filter2DVertical<6, /*is_compound=*/true>(
-            intermediate_result, dest, dest_stride, width, height, taps);
+        Filter2DVertical<6, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, width, height, taps,
+            prediction_0);
       }
     } else if (vertical_taps == 4) {
       SetupTaps<4, /*is_2d_vertical=*/true>(&v_filter, taps);
       if (width == 4) {
-        Filter2DVertical4xH<4, /*is_compound=*/true>(intermediate_result, dest,
-                                                     dest_stride, height, taps);
+        Filter2DVertical4xH<4, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, height, taps, prediction_0);
       } else {
-        Filter2DVertical<4, /*is_compound=*/true>(
-            intermediate_result, dest, dest_stride, width, height, taps);
+        Filter2DVertical<4, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, width, height, taps,
+            prediction_0);
       }
     } else {  // |vertical_taps| == 2
       SetupTaps<2, /*is_2d_vertical=*/true>(&v_filter, taps);
       if (width == 4) {
-        Filter2DVertical4xH<2, /*is_compound=*/true>(intermediate_result, dest,
-                                                     dest_stride, height, taps);
+        Filter2DVertical4xH<2, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, height, taps, prediction_0);
       } else {
-        Filter2DVertical<2, /*is_compound=*/true>(
-            intermediate_result, dest, dest_stride, width, height, taps);
+        Filter2DVertical<2, /*is_compound=*/true, is_average_blend>(
+            intermediate_result, dest, dest_stride, width, height, taps,
+            prediction_0);
       }
     }
   }
 }
 
+void ConvolveCompound2D_AVX2(
+    const void* LIBGAV1_RESTRICT const reference,
+    const ptrdiff_t reference_stride, const int horizontal_filter_index,
+    const int vertical_filter_index, const int horizontal_filter_id,
+    const int vertical_filter_id, const int width, const int height,
+    void* LIBGAV1_RESTRICT prediction, const ptrdiff_t pred_stride) {
+  ConvolveCompound2D</*is_average_blend=*/false>(
+      reference, reference_stride, horizontal_filter_index,
+      vertical_filter_index, horizontal_filter_id, vertical_filter_id, width,
+      height, /*prediction_0=*/nullptr, prediction, pred_stride);
+}
+
+void ConvolveCompound2DAverageBlend_AVX2(
+    const void* LIBGAV1_RESTRICT const reference,
+    const ptrdiff_t reference_stride, const int horizontal_filter_index,
+    const int vertical_filter_index, const int horizontal_filter_id,
+    const int vertical_filter_id, const int width, const int height,
+    const void* LIBGAV1_RESTRICT const prediction_0,
+    void* LIBGAV1_RESTRICT const dest, const ptrdiff_t dest_stride) {
+  ConvolveCompound2D</*is_average_blend=*/true>(
+      reference, reference_stride, horizontal_filter_index,
+      vertical_filter_index, horizontal_filter_id, vertical_filter_id, width,
+      height, static_cast<const int16_t*>(prediction_0), dest, dest_stride);
+}
+
 void Init8bpp() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
   assert(dsp != nullptr);
@@ -1475,6 +1531,7 @@ void Init8bpp() {
   dsp->convolve[0][1][0][1] = ConvolveCompoundHorizontal_AVX2;
   dsp->convolve[0][1][1][0] = ConvolveCompoundVertical_AVX2;
   dsp->convolve[0][1][1][1] = ConvolveCompound2D_AVX2;
+  dsp->convolve_2d_average_blend = ConvolveCompound2DAverageBlend_AVX2;
 }
 
 }  // namespace
@@ -23,8 +23,8 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::convolve, see the defines below for specifics. This
-// function is not thread-safe.
+// Initializes Dsp::convolve and Dsp::convolve_2d_average_blend, see the defines
+// below for specifics. This function is not thread-safe.
 void ConvolveInit_AVX2();
 
 }  // namespace dsp
@@ -54,6 +54,10 @@ void ConvolveInit_AVX2();
 #define LIBGAV1_Dsp8bpp_ConvolveCompoundVertical LIBGAV1_CPU_AVX2
 #endif
 
+#ifndef LIBGAV1_Dsp8bpp_Convolve2DAverageBlend
+#define LIBGAV1_Dsp8bpp_Convolve2DAverageBlend LIBGAV1_CPU_AVX2
+#endif
+
 #endif  // LIBGAV1_TARGETING_AVX2
 
 #endif  // LIBGAV1_SRC_DSP_X86_CONVOLVE_AVX2_H_
@@ -611,12 +611,20 @@ void ConvolveCompoundHorizontal_SSE4_1(
       filter_index);
 }
 
-void ConvolveCompound2D_SSE4_1(
-    const void* LIBGAV1_RESTRICT const reference,
-    const ptrdiff_t reference_stride, const int horizontal_filter_index,
-    const int vertical_filter_index, const int horizontal_filter_id,
-    const int vertical_filter_id, const int width, const int height,
-    void* LIBGAV1_RESTRICT prediction, const ptrdiff_t /*pred_stride*/) {
+// When |is_average_blend| is true, the compound prediction is averaged with
+// |prediction_0| and |dest| receives pixels. Otherwise |dest| receives the
+// compound prediction and |dest_stride| is |width|.
+template <bool is_average_blend>
+void ConvolveCompound2D(const void* LIBGAV1_RESTRICT const reference,
+                        const ptrdiff_t reference_stride,
+                        const int horizontal_filter_index,
+                        const int vertical_filter_index,
+                        const int horizontal_filter_id,
+                        const int vertical_filter_id, const int width,
+                        const int height,
+                        const int16_t* LIBGAV1_RESTRICT const prediction_0,
+                        void* LIBGAV1_RESTRICT const dest,
+                        const ptrdiff_t dest_stride) {
   // The output of the horizontal filter, i.e. the intermediate_result, is
   // guaranteed to fit in int16_t.
   alignas(16) uint16_t
@@ -647,10 +655,8 @@ void ConvolveCompound2D_SSE4_1(
       horizontal_filter_id, horiz_filter_index);
 
   // Vertical filter.
-  auto* dest = static_cast<uint16_t*>(prediction);
   assert(vertical_filter_id != 0);
 
-  const ptrdiff_t dest_stride = width;
   __m128i taps[4];
   const __m128i v_filter =
       LoadLo8(kHalfSubPixelFilters[vert_filter_index][vertical_filter_id]);
@@ -658,42 +664,71 @@ void ConvolveCompound2D_SSE4_1(
   if (vertical_taps == 8) {
     SetupTaps<8, /*is_2d_vertical=*/true>(&v_filter, taps);
     if (width == 4) {
-      Filter2DVertical4xH<8, /*is_compound=*/true>(intermediate_result, dest,
-                                                   dest_stride, height, taps);
+      Filter2DVertical4xH<8, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, height, taps, prediction_0);
     } else {
-      Filter2DVertical<8, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps);
+      Filter2DVertical<8, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps,
+          prediction_0);
     }
   } else if (vertical_taps == 6) {
     SetupTaps<6, /*is_2d_vertical=*/true>(&v_filter, taps);
     if (width == 4) {
-      Filter2DVertical4xH<6, /*is_compound=*/true>(intermediate_result, dest,
-                                                   dest_stride, height, taps);
+      Filter2DVertical4xH<6, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, height, taps, prediction_0);
     } else {
-      Filter2DVertical<6, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps);
+      Filter2DVertical<6, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps,
+          prediction_0);
     }
   } else if (vertical_taps == 4) {
     SetupTaps<4, /*is_2d_vertical=*/true>(&v_filter, taps);
     if (width == 4) {
-      Filter2DVertical4xH<4, /*is_compound=*/true>(intermediate_result, dest,
-                                                   dest_stride, height, taps);
+      Filter2DVertical4xH<4, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, height, taps, prediction_0);
     } else {
-      Filter2DVertical<4, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps);
+      Filter2DVertical<4, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps,
+          prediction_0);
     }
   } else {  // |vertical_taps| == 2
     SetupTaps<2, /*is_2d_vertical=*/true>(&v_filter, taps);
     if (width == 4) {
-      Filter2DVertical4xH<2, /*is_compound=*/true>(intermediate_result, dest,
-                                                   dest_stride, height, taps);
+      Filter2DVertical4xH<2, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, height, taps, prediction_0);
     } else {
-      Filter2DVertical<2, /*is_compound=*/true>(
-          intermediate_result, dest, dest_stride, width, height, taps);
+      Filter2DVertical<2, /*is_compound=*/true, is_average_blend>(
+          intermediate_result, dest, dest_stride, width, height, taps,
+          prediction_0);
     }
   }
 }
 
+void ConvolveCompound2D_SSE4_1(
+    const void* LIBGAV1_RESTRICT const reference,
+    const ptrdiff_t reference_stride, const int horizontal_filter_index,
+    const int vertical_filter_index, const int horizontal_filter_id,
+    const int vertical_filter_id, const int width, const int height,
+    void* LIBGAV1_RESTRICT prediction, const ptrdiff_t /*pred_stride*/) {
+  ConvolveCompound2D</*is_average_blend=*/false>(
+      reference, reference_stride, horizontal_filter_index,
+      vertical_filter_index, horizontal_filter_id, vertical_filter_id, width,
+      height, /*prediction_0=*/nullptr, prediction, /*dest_stride=*/width);
+}
+
+void ConvolveCompound2DAverageBlend_SSE4_1(
+    const void* LIBGAV1_RESTRICT const reference,
+    const ptrdiff_t reference_stride, const int horizontal_filter_index,
+    const int vertical_filter_index, const int horizontal_filter_id,
+    const int vertical_filter_id, const int width, const int height,
+    const void* LIBGAV1_RESTRICT const prediction_0,
+    void* LIBGAV1_RESTRICT const dest, const ptrdiff_t dest_stride) {
+  ConvolveCompound2D</*is_average_blend=*/true>(
+      reference, reference_stride, horizontal_filter_index,
+      vertical_filter_index, horizontal_filter_id, vertical_filter_id, width,
+      height, static_cast<const int16_t*>(prediction_0), dest, dest_stride);
+}
+
 // Pre-transposed filters.
 template <int filter_index>
 inline void GetHalfSubPixelFilter(__m128i* output) {
@@ -1877,6 +1912,7 @@ void Init8bpp() {
   dsp->convolve[0][1][0][1] = ConvolveCompoundHorizontal_SSE4_1;
   dsp->convolve[0][1][1][0] = ConvolveCompoundVertical_SSE4_1;
   dsp->convolve[0][1][1][1] = ConvolveCompound2D_SSE4_1;
+  dsp->convolve_2d_average_blend = ConvolveCompound2DAverageBlend_SSE4_1;
 
   dsp->convolve[1][0][0][1] = ConvolveIntraBlockCopyHorizontal_SSE4_1;
   dsp->convolve[1][0][1][0] = ConvolveIntraBlockCopyVertical_SSE4_1;
@@ -23,8 +23,8 @@
 namespace libgav1 {
 namespace dsp {
 
-// Initializes Dsp::convolve, see the defines below for specifics. This
-// function is not thread-safe.
+// Initializes Dsp::convolve and Dsp::convolve_2d_average_blend, see the defines
+// below for specifics. This function is not thread-safe.
 void ConvolveInit_SSE4_1();
 
 }  // namespace dsp
@@ -62,6 +62,10 @@ void ConvolveInit_SSE4_1();
 #define LIBGAV1_Dsp8bpp_ConvolveCompound2D LIBGAV1_CPU_SSE4_1
 #endif
 
+#ifndef LIBGAV1_Dsp8bpp_Convolve2DAverageBlend
+#define LIBGAV1_Dsp8bpp_Convolve2DAverageBlend LIBGAV1_CPU_SSE4_1
+#endif
+
 #ifndef LIBGAV1_Dsp8bpp_ConvolveScale2D
 #define LIBGAV1_Dsp8bpp_ConvolveScale2D LIBGAV1_CPU_SSE4_1
 #endif
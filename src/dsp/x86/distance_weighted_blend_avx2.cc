@@ -0,0 +1,302 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/distance_weighted_blend.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace low_bitdepth {
+namespace {
+
+constexpr int kInterPostRoundBit = 4;
+constexpr int kInterPostRhsAdjust = 1 << (16 - kInterPostRoundBit - 1);
+
+// See the SSE4.1 version for the derivation of the formula.
+inline __m256i ComputeWeightedAverage16(const int16_t* LIBGAV1_RESTRICT pred_0,
+                                        const int16_t* LIBGAV1_RESTRICT pred_1,
+                                        const __m256i& weight) {
+  const __m256i pred0 = LoadUnaligned32(pred_0);
+  const __m256i pred1 = LoadUnaligned32(pred_1);
+  const __m256i diff = _mm256_slli_epi16(_mm256_sub_epi16(pred0, pred1), 1);
+  // (((p0 - p1) * (w0 << 12) >> 16) + ((16 * p1) >> 4)
+  const __m256i weighted_diff = _mm256_mulhi_epi16(diff, weight);
+  // ((p0 - p1) * w0 >> 4) + p1
+  const __m256i upscaled_average = _mm256_add_epi16(weighted_diff, pred1);
+  // (x << 11) >> 15 == x >> 4
+  const __m256i right_shift_prep = _mm256_set1_epi16(kInterPostRhsAdjust);
+  // (((p0 - p1) * w0 >> 4) + p1 + (128 >> 4)) >> 4
+  return _mm256_mulhrs_epi16(upscaled_average, right_shift_prep);
+}
+
+// Blends 32 consecutive prediction values and returns the pixels in order.
+inline __m256i ComputeWeightedAverage32(const int16_t* LIBGAV1_RESTRICT pred_0,
+                                        const int16_t* LIBGAV1_RESTRICT pred_1,
+                                        const __m256i& weight) {
+  const __m256i res_0 = ComputeWeightedAverage16(pred_0, pred_1, weight);
+  const __m256i res_1 =
+      ComputeWeightedAverage16(pred_0 + 16, pred_1 + 16, weight);
+  // _mm256_packus_epi16() works within 128-bit lanes, restore the order.
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(res_0, res_1), 0xd8);
+}
+
+void DistanceWeightedBlend_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                                const void* LIBGAV1_RESTRICT prediction_1,
+                                const uint8_t weight_0,
+                                const uint8_t /*weight_1*/, const int width,
+                                const int height,
+                                void* LIBGAV1_RESTRICT const dest,
+                                const ptrdiff_t dest_stride) {
+  const auto* pred_0 = static_cast<const int16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const int16_t*>(prediction_1);
+  auto* dst = static_cast<uint8_t*>(dest);
+  // Upscale the weight for mulhi.
+  const __m256i weight = _mm256_set1_epi16(weight_0 << 11);
+  int y = height;
+
+  if (width == 4) {
+    do {
+      const __m256i res = ComputeWeightedAverage16(pred_0, pred_1, weight);
+      const __m128i result_pixels = _mm_packus_epi16(
+          _mm256_castsi256_si128(res), _mm256_extracti128_si256(res, 1));
+      Store4(dst, result_pixels);
+      dst += dest_stride;
+      const int result_1 = _mm_extract_epi32(result_pixels, 1);
+      memcpy(dst, &result_1, sizeof(result_1));
+      dst += dest_stride;
+      const int result_2 = _mm_extract_epi32(result_pixels, 2);
+      memcpy(dst, &result_2, sizeof(result_2));
+      dst += dest_stride;
+      const int result_3 = _mm_extract_epi32(result_pixels, 3);
+      memcpy(dst, &result_3, sizeof(result_3));
+      dst += dest_stride;
+      pred_0 += 4 << 2;
+      pred_1 += 4 << 2;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    do {
+      const __m256i result = ComputeWeightedAverage32(pred_0, pred_1, weight);
+      const __m128i result_01 = _mm256_castsi256_si128(result);
+      const __m128i result_23 = _mm256_extracti128_si256(result, 1);
+      StoreLo8(dst, result_01);
+      dst += dest_stride;
+      StoreHi8(dst, result_01);
+      dst += dest_stride;
+      StoreLo8(dst, result_23);
+      dst += dest_stride;
+      StoreHi8(dst, result_23);
+      dst += dest_stride;
+      pred_0 += 8 << 2;
+      pred_1 += 8 << 2;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 16) {
+    do {
+      const __m256i result = ComputeWeightedAverage32(pred_0, pred_1, weight);
+      StoreUnaligned16(dst, _mm256_castsi256_si128(result));
+      dst += dest_stride;
+      StoreUnaligned16(dst, _mm256_extracti128_si256(result, 1));
+      dst += dest_stride;
+      pred_0 += 16 << 1;
+      pred_1 += 16 << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      StoreUnaligned32(
+          dst + x, ComputeWeightedAverage32(pred_0 + x, pred_1 + x, weight));
+      x += 32;
+    } while (x < width);
+    dst += dest_stride;
+    pred_0 += width;
+    pred_1 += width;
+  } while (--y != 0);
+}
+
+void Init8bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_8BPP_AVX2(DistanceWeightedBlend)
+  dsp->distance_weighted_blend = DistanceWeightedBlend_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace low_bitdepth
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+namespace high_bitdepth {
+namespace {
+
+constexpr int kMax10bppSample = (1 << 10) - 1;
+constexpr int kInterPostRoundBit = 4;
+
+// Blends 16 consecutive prediction values and returns the pixels in order.
+inline __m256i ComputeWeightedAverage16(
+    const uint16_t* LIBGAV1_RESTRICT pred_0,
+    const uint16_t* LIBGAV1_RESTRICT pred_1, const __m256i& weight0,
+    const __m256i& weight1) {
+  // This offset is a combination of round_factor and round_offset
+  // which are to be added and subtracted respectively.
+  // Here kInterPostRoundBit + 4 is considering bitdepth=10.
+  constexpr int offset =
+      (1 << ((kInterPostRoundBit + 4) - 1)) - (kCompoundOffset << 4);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi32(offset);
+  const __m256i clip_high = _mm256_set1_epi16(kMax10bppSample);
+  const __m256i pred0 = LoadUnaligned32(pred_0);
+  const __m256i pred1 = LoadUnaligned32(pred_1);
+
+  __m256i prediction0 = _mm256_unpacklo_epi16(pred0, zero);
+  __m256i mult0 = _mm256_mullo_epi32(prediction0, weight0);
+  __m256i prediction1 = _mm256_unpacklo_epi16(pred1, zero);
+  __m256i mult1 = _mm256_mullo_epi32(prediction1, weight1);
+  __m256i sum = _mm256_add_epi32(mult0, mult1);
+  sum = _mm256_add_epi32(sum, bias);
+  const __m256i result0 = _mm256_srai_epi32(sum, kInterPostRoundBit + 4);
+
+  prediction0 = _mm256_unpackhi_epi16(pred0, zero);
+  mult0 = _mm256_mullo_epi32(prediction0, weight0);
+  prediction1 = _mm256_unpackhi_epi16(pred1, zero);
+  mult1 = _mm256_mullo_epi32(prediction1, weight1);
+  sum = _mm256_add_epi32(mult0, mult1);
+  sum = _mm256_add_epi32(sum, bias);
+  const __m256i result1 = _mm256_srai_epi32(sum, kInterPostRoundBit + 4);
+  // The unpacks and the pack both work within 128-bit lanes, so the order is
+  // preserved.
+  const __m256i pack = _mm256_packus_epi32(result0, result1);
+
+  return _mm256_min_epi16(pack, clip_high);
+}
+
+void DistanceWeightedBlend_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                                const void* LIBGAV1_RESTRICT prediction_1,
+                                const uint8_t weight_0, const uint8_t weight_1,
+                                const int width, const int height,
+                                void* LIBGAV1_RESTRICT const dest,
+                                const ptrdiff_t dest_stride) {
+  const auto* pred_0 = static_cast<const uint16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const uint16_t*>(prediction_1);
+  auto* dst = static_cast<uint16_t*>(dest);
+  const ptrdiff_t dst_stride = dest_stride / sizeof(*pred_0);
+  const __m256i weight0 = _mm256_set1_epi32(weight_0);
+  const __m256i weight1 = _mm256_set1_epi32(weight_1);
+  int y = height;
+
+  if (width == 4) {
+    do {
+      const __m256i result =
+          ComputeWeightedAverage16(pred_0, pred_1, weight0, weight1);
+      const __m128i result_01 = _mm256_castsi256_si128(result);
+      const __m128i result_23 = _mm256_extracti128_si256(result, 1);
+      StoreLo8(dst, result_01);
+      dst += dst_stride;
+      StoreHi8(dst, result_01);
+      dst += dst_stride;
+      StoreLo8(dst, result_23);
+      dst += dst_stride;
+      StoreHi8(dst, result_23);
+      dst += dst_stride;
+      pred_0 += 4 << 2;
+      pred_1 += 4 << 2;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    do {
+      const __m256i result =
+          ComputeWeightedAverage16(pred_0, pred_1, weight0, weight1);
+      StoreUnaligned16(dst, _mm256_castsi256_si128(result));
+      dst += dst_stride;
+      StoreUnaligned16(dst, _mm256_extracti128_si256(result, 1));
+      dst += dst_stride;
+      pred_0 += 8 << 1;
+      pred_1 += 8 << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      StoreUnaligned32(dst + x, ComputeWeightedAverage16(pred_0 + x, pred_1 + x,
+                                                         weight0, weight1));
+      x += 16;
+    } while (x < width);
+    dst += dst_stride;
+    pred_0 += width;
+    pred_1 += width;
+  } while (--y != 0);
+}
+
+void Init10bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_10BPP_AVX2(DistanceWeightedBlend)
+  dsp->distance_weighted_blend = DistanceWeightedBlend_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace high_bitdepth
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+void DistanceWeightedBlendInit_AVX2() {
+  low_bitdepth::Init8bpp();
+#if LIBGAV1_MAX_BITDEPTH >= 10
+  high_bitdepth::Init10bpp();
+#endif
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+
+namespace libgav1 {
+namespace dsp {
+
+void DistanceWeightedBlendInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
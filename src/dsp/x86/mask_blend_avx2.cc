@@ -0,0 +1,525 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/mask_blend.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace {
+
+constexpr int kMaskInverse = 64;
+
+// Returns 16 mask values widened to 16 bits. The mask values are at most 64,
+// so the sum of two rows still fits in 8 bits.
+template <int subsampling_x, int subsampling_y>
+inline __m256i GetMask16(const uint8_t* mask, const ptrdiff_t stride) {
+  if (subsampling_x == 1) {
+    __m256i mask_val = LoadUnaligned32(mask);
+    if (subsampling_y == 1) {
+      mask_val = _mm256_add_epi8(mask_val, LoadUnaligned32(mask + stride));
+    }
+    const __m256i subsampled_mask =
+        _mm256_maddubs_epi16(mask_val, _mm256_set1_epi8(1));
+    return RightShiftWithRounding_S16(subsampled_mask, 1 + subsampling_y);
+  }
+  assert(subsampling_y == 0 && subsampling_x == 0);
+  return _mm256_cvtepu8_epi16(LoadUnaligned16(mask));
+}
+
+template <int subsampling_x, int subsampling_y>
+inline __m128i GetMask8(const uint8_t* mask, const ptrdiff_t stride) {
+  if (subsampling_x == 1) {
+    __m128i mask_val = LoadUnaligned16(mask);
+    if (subsampling_y == 1) {
+      mask_val = _mm_add_epi8(mask_val, LoadUnaligned16(mask + stride));
+    }
+    const __m128i subsampled_mask =
+        _mm_maddubs_epi16(mask_val, _mm_set1_epi8(1));
+    return RightShiftWithRounding_S16(subsampled_mask, 1 + subsampling_y);
+  }
+  assert(subsampling_y == 0 && subsampling_x == 0);
+  return _mm_cvtepu8_epi16(LoadLo8(mask));
+}
+
+// Returns the masks of two rows of 8 values.
+template <int subsampling_x, int subsampling_y>
+inline __m256i GetMask8x2(const uint8_t* mask, const ptrdiff_t mask_stride) {
+  return SetrM128i(GetMask8<subsampling_x, subsampling_y>(mask, mask_stride),
+                   GetMask8<subsampling_x, subsampling_y>(
+                       mask + (mask_stride << subsampling_y), mask_stride));
+}
+
+// Width can only be 4 when it is subsampled from a block of width 8, hence
+// the mask rows are contiguous with a stride of 8 when subsampling_x is 1.
+template <int subsampling_x, int subsampling_y>
+inline __m128i GetMask4x2(const uint8_t* mask) {
+  if (subsampling_y == 1) {
+    const __m128i mask_val_01 = LoadUnaligned16(mask);
+    const __m128i mask_val_23 = LoadUnaligned16(mask + 16);
+    // Transpose rows to add row 0 to row 1, and row 2 to row 3.
+    const __m128i mask_val_02 = _mm_unpacklo_epi64(mask_val_01, mask_val_23);
+    const __m128i mask_val_13 = _mm_unpackhi_epi64(mask_val_01, mask_val_23);
+    const __m128i mask_val = _mm_add_epi8(mask_val_02, mask_val_13);
+    const __m128i subsampled_mask =
+        _mm_maddubs_epi16(mask_val, _mm_set1_epi8(1));
+    return RightShiftWithRounding_S16(subsampled_mask, 2);
+  }
+  return GetMask8<subsampling_x, 0>(mask, 0);
+}
+
+// Returns the masks of four rows of 4 values.
+template <int subsampling_x, int subsampling_y>
+inline __m256i GetMask4x4(const uint8_t* mask, const ptrdiff_t mask_stride) {
+  if (subsampling_x == 1) {
+    return SetrM128i(GetMask4x2<subsampling_x, subsampling_y>(mask),
+                     GetMask4x2<subsampling_x, subsampling_y>(
+                         mask + (mask_stride << (1 + subsampling_y))));
+  }
+  // When using intra or difference weighted masks, the function doesn't use
+  // subsampling, so |mask_stride| may be 4 or 8.
+  assert(subsampling_y == 0 && subsampling_x == 0);
+  const __m128i mask_val_01 =
+      _mm_unpacklo_epi32(Load4(mask), Load4(mask + mask_stride));
+  const __m128i mask_val_23 = _mm_unpacklo_epi32(
+      Load4(mask + 2 * mask_stride), Load4(mask + 3 * mask_stride));
+  return _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(mask_val_01, mask_val_23));
+}
+
+}  // namespace
+
+namespace low_bitdepth {
+namespace {
+
+// Returns the 16-bit results of blending 16 values.
+inline __m256i MaskBlend16(const __m256i& pred_val_0,
+                           const __m256i& pred_val_1,
+                           const __m256i& pred_mask_0) {
+  // 64 - mask
+  const __m256i pred_mask_1 =
+      _mm256_sub_epi16(_mm256_set1_epi16(kMaskInverse), pred_mask_0);
+  const __m256i mask_lo = _mm256_unpacklo_epi16(pred_mask_0, pred_mask_1);
+  const __m256i mask_hi = _mm256_unpackhi_epi16(pred_mask_0, pred_mask_1);
+  const __m256i pred_lo = _mm256_unpacklo_epi16(pred_val_0, pred_val_1);
+  const __m256i pred_hi = _mm256_unpackhi_epi16(pred_val_0, pred_val_1);
+  // int res = (mask_value * prediction_0[x] +
+  //      (64 - mask_value) * prediction_1[x]) >> 6;
+  const __m256i compound_pred_lo = _mm256_madd_epi16(pred_lo, mask_lo);
+  const __m256i compound_pred_hi = _mm256_madd_epi16(pred_hi, mask_hi);
+  // The unpacks and the pack both work within 128-bit lanes, so the order is
+  // preserved.
+  const __m256i res =
+      _mm256_packus_epi32(_mm256_srli_epi32(compound_pred_lo, 6),
+                          _mm256_srli_epi32(compound_pred_hi, 6));
+  // dst[x] = static_cast<Pixel>(
+  //     Clip3(RightShiftWithRounding(res, inter_post_round_bits), 0,
+  //           (1 << kBitdepth8) - 1));
+  return RightShiftWithRounding_S16(res, 4);
+}
+
+inline __m128i PackPixels(const __m256i& result) {
+  return _mm_packus_epi16(_mm256_castsi256_si128(result),
+                          _mm256_extracti128_si256(result, 1));
+}
+
+inline void Store4x4(uint8_t* LIBGAV1_RESTRICT dst, const ptrdiff_t dst_stride,
+                     const __m128i& result) {
+  Store4(dst, result);
+  const int result_1 = _mm_extract_epi32(result, 1);
+  memcpy(dst + dst_stride, &result_1, sizeof(result_1));
+  const int result_2 = _mm_extract_epi32(result, 2);
+  memcpy(dst + 2 * dst_stride, &result_2, sizeof(result_2));
+  const int result_3 = _mm_extract_epi32(result, 3);
+  memcpy(dst + 3 * dst_stride, &result_3, sizeof(result_3));
+}
+
+template <int subsampling_x, int subsampling_y>
+void MaskBlend_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                    const void* LIBGAV1_RESTRICT prediction_1,
+                    const ptrdiff_t /*prediction_stride_1*/,
+                    const uint8_t* LIBGAV1_RESTRICT const mask_ptr,
+                    const ptrdiff_t mask_stride, const int width,
+                    const int height, void* LIBGAV1_RESTRICT dest,
+                    const ptrdiff_t dst_stride) {
+  auto* dst = static_cast<uint8_t*>(dest);
+  const auto* pred_0 = static_cast<const int16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const int16_t*>(prediction_1);
+  const uint8_t* mask = mask_ptr;
+  int y = height;
+
+  if (width == 4) {
+    assert(subsampling_x == 1);
+    constexpr ptrdiff_t mask_stride4 = 4 << subsampling_x;
+    do {
+      const __m256i pred_mask_0 =
+          GetMask4x4<subsampling_x, subsampling_y>(mask, mask_stride4);
+      const __m256i result = MaskBlend16(
+          LoadUnaligned32(pred_0), LoadUnaligned32(pred_1), pred_mask_0);
+      Store4x4(dst, dst_stride, PackPixels(result));
+      pred_0 += 4 << 2;
+      pred_1 += 4 << 2;
+      mask += mask_stride4 << (2 + subsampling_y);
+      dst += dst_stride << 2;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    do {
+      const __m256i pred_mask_0 =
+          GetMask8x2<subsampling_x, subsampling_y>(mask, mask_stride);
+      const __m128i result = PackPixels(MaskBlend16(
+          LoadUnaligned32(pred_0), LoadUnaligned32(pred_1), pred_mask_0));
+      StoreLo8(dst, result);
+      StoreHi8(dst + dst_stride, result);
+      pred_0 += 8 << 1;
+      pred_1 += 8 << 1;
+      mask += mask_stride << (1 + subsampling_y);
+      dst += dst_stride << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      const __m256i pred_mask_0 = GetMask16<subsampling_x, subsampling_y>(
+          mask + (x << subsampling_x), mask_stride);
+      const __m256i result =
+          MaskBlend16(LoadUnaligned32(pred_0 + x),
+                      LoadUnaligned32(pred_1 + x), pred_mask_0);
+      StoreUnaligned16(dst + x, PackPixels(result));
+      x += 16;
+    } while (x < width);
+    dst += dst_stride;
+    pred_0 += width;
+    pred_1 += width;
+    mask += mask_stride << subsampling_y;
+  } while (--y != 0);
+}
+
+// Returns 16 blended pixels. |pred_mask_1| holds the 16-bit mask values.
+inline __m128i InterIntraMaskBlend16(const __m128i& pred_val_0,
+                                     const __m128i& pred_val_1,
+                                     const __m256i& pred_mask_1) {
+  // 64 - mask
+  const __m256i pred_mask_0 =
+      _mm256_sub_epi16(_mm256_set1_epi16(kMaskInverse), pred_mask_1);
+  const __m256i pred_mask =
+      _mm256_or_si256(pred_mask_0, _mm256_slli_epi16(pred_mask_1, 8));
+  const __m256i pred =
+      _mm256_or_si256(_mm256_cvtepu8_epi16(pred_val_0),
+                      _mm256_slli_epi16(_mm256_cvtepu8_epi16(pred_val_1), 8));
+  // int res = (mask_value * prediction_1[x] +
+  //      (64 - mask_value) * prediction_0[x]) >> 6;
+  const __m256i compound_pred = _mm256_maddubs_epi16(pred, pred_mask);
+  return PackPixels(RightShiftWithRounding_S16(compound_pred, 6));
+}
+
+template <int subsampling_x, int subsampling_y>
+void InterIntraMaskBlend8bpp_AVX2(
+    const uint8_t* LIBGAV1_RESTRICT prediction_0,
+    uint8_t* LIBGAV1_RESTRICT prediction_1, const ptrdiff_t prediction_stride_1,
+    const uint8_t* LIBGAV1_RESTRICT const mask_ptr, const ptrdiff_t mask_stride,
+    const int width, const int height) {
+  const uint8_t* mask = mask_ptr;
+  int y = height;
+
+  if (width == 4) {
+    do {
+      const __m256i pred_mask_1 =
+          GetMask4x4<subsampling_x, subsampling_y>(mask, mask_stride);
+      const __m128i pred_val_01 = _mm_unpacklo_epi32(
+          Load4(prediction_1), Load4(prediction_1 + prediction_stride_1));
+      const __m128i pred_val_23 =
+          _mm_unpacklo_epi32(Load4(prediction_1 + 2 * prediction_stride_1),
+                             Load4(prediction_1 + 3 * prediction_stride_1));
+      const __m128i pred_val_1 = _mm_unpacklo_epi64(pred_val_01, pred_val_23);
+      const __m128i result = InterIntraMaskBlend16(
+          LoadUnaligned16(prediction_0), pred_val_1, pred_mask_1);
+      Store4x4(prediction_1, prediction_stride_1, result);
+      prediction_0 += 4 << 2;
+      prediction_1 += prediction_stride_1 << 2;
+      mask += mask_stride << (2 + subsampling_y);
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    do {
+      const __m256i pred_mask_1 =
+          GetMask8x2<subsampling_x, subsampling_y>(mask, mask_stride);
+      const __m128i pred_val_1 =
+          LoadHi8(LoadLo8(prediction_1), prediction_1 + prediction_stride_1);
+      const __m128i result = InterIntraMaskBlend16(
+          LoadUnaligned16(prediction_0), pred_val_1, pred_mask_1);
+      StoreLo8(prediction_1, result);
+      StoreHi8(prediction_1 + prediction_stride_1, result);
+      prediction_0 += 8 << 1;
+      prediction_1 += prediction_stride_1 << 1;
+      mask += mask_stride << (1 + subsampling_y);
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      const __m256i pred_mask_1 = GetMask16<subsampling_x, subsampling_y>(
+          mask + (x << subsampling_x), mask_stride);
+      const __m128i result =
+          InterIntraMaskBlend16(LoadUnaligned16(prediction_0 + x),
+                                LoadUnaligned16(prediction_1 + x), pred_mask_1);
+      StoreUnaligned16(prediction_1 + x, result);
+      x += 16;
+    } while (x < width);
+    prediction_0 += width;
+    prediction_1 += prediction_stride_1;
+    mask += mask_stride << subsampling_y;
+  } while (--y != 0);
+}
+
+void Init8bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_8BPP_AVX2(MaskBlend444)
+  dsp->mask_blend[0][0] = MaskBlend_AVX2<0, 0>;
+#endif
+#if DSP_ENABLED_8BPP_AVX2(MaskBlend422)
+  dsp->mask_blend[1][0] = MaskBlend_AVX2<1, 0>;
+#endif
+#if DSP_ENABLED_8BPP_AVX2(MaskBlend420)
+  dsp->mask_blend[2][0] = MaskBlend_AVX2<1, 1>;
+#endif
+  // The is_inter_intra index of mask_blend[][] is replaced by
+  // inter_intra_mask_blend_8bpp[] in 8-bit.
+#if DSP_ENABLED_8BPP_AVX2(InterIntraMaskBlend8bpp444)
+  dsp->inter_intra_mask_blend_8bpp[0] = InterIntraMaskBlend8bpp_AVX2<0, 0>;
+#endif
+#if DSP_ENABLED_8BPP_AVX2(InterIntraMaskBlend8bpp422)
+  dsp->inter_intra_mask_blend_8bpp[1] = InterIntraMaskBlend8bpp_AVX2<1, 0>;
+#endif
+#if DSP_ENABLED_8BPP_AVX2(InterIntraMaskBlend8bpp420)
+  dsp->inter_intra_mask_blend_8bpp[2] = InterIntraMaskBlend8bpp_AVX2<1, 1>;
+#endif
+}
+
+}  // namespace
+}  // namespace low_bitdepth
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+namespace high_bitdepth {
+namespace {
+
+constexpr int kMax10bppSample = (1 << 10) - 1;
+constexpr int kRoundBitsMaskBlend = 4;
+
+// Returns 16 blended pixels.
+template <bool is_inter_intra>
+inline __m256i MaskBlend16(const __m256i& pred_val_0,
+                           const __m256i& pred_val_1,
+                           const __m256i& pred_mask_0) {
+  // 64 - mask
+  const __m256i pred_mask_1 =
+      _mm256_sub_epi16(_mm256_set1_epi16(kMaskInverse), pred_mask_0);
+  if (is_inter_intra) {
+    // dst[x] = static_cast<Pixel>(RightShiftWithRounding(
+    //     mask_value * pred_1[x] + (64 - mask_value) * pred_0[x], 6));
+    const __m256i mask_0 = _mm256_unpacklo_epi16(pred_mask_1, pred_mask_0);
+    const __m256i mask_1 = _mm256_unpackhi_epi16(pred_mask_1, pred_mask_0);
+    const __m256i pred_0 = _mm256_unpacklo_epi16(pred_val_0, pred_val_1);
+    const __m256i pred_1 = _mm256_unpackhi_epi16(pred_val_0, pred_val_1);
+    const __m256i compound_pred_0 = _mm256_madd_epi16(pred_0, mask_0);
+    const __m256i compound_pred_1 = _mm256_madd_epi16(pred_1, mask_1);
+    return _mm256_packus_epi32(RightShiftWithRounding_S32(compound_pred_0, 6),
+                               RightShiftWithRounding_S32(compound_pred_1, 6));
+  }
+  // int res = (mask_value * pred_0[x] + (64 - mask_value) * pred_1[x]) >> 6;
+  const __m256i compound_pred_lo_0 =
+      _mm256_mullo_epi16(pred_val_0, pred_mask_0);
+  const __m256i compound_pred_hi_0 =
+      _mm256_mulhi_epu16(pred_val_0, pred_mask_0);
+  const __m256i compound_pred_lo_1 =
+      _mm256_mullo_epi16(pred_val_1, pred_mask_1);
+  const __m256i compound_pred_hi_1 =
+      _mm256_mulhi_epu16(pred_val_1, pred_mask_1);
+  const __m256i pack0_lo =
+      _mm256_unpacklo_epi16(compound_pred_lo_0, compound_pred_hi_0);
+  const __m256i pack0_hi =
+      _mm256_unpackhi_epi16(compound_pred_lo_0, compound_pred_hi_0);
+  const __m256i pack1_lo =
+      _mm256_unpacklo_epi16(compound_pred_lo_1, compound_pred_hi_1);
+  const __m256i pack1_hi =
+      _mm256_unpackhi_epi16(compound_pred_lo_1, compound_pred_hi_1);
+  const __m256i compound_pred_lo = _mm256_add_epi32(pack0_lo, pack1_lo);
+  const __m256i compound_pred_hi = _mm256_add_epi32(pack0_hi, pack1_hi);
+  // res -= (bitdepth == 8) ? 0 : kCompoundOffset;
+  const __m256i offset = _mm256_set1_epi32(kCompoundOffset);
+  const __m256i sub_0 =
+      _mm256_sub_epi32(_mm256_srli_epi32(compound_pred_lo, 6), offset);
+  const __m256i sub_1 =
+      _mm256_sub_epi32(_mm256_srli_epi32(compound_pred_hi, 6), offset);
+  // dst[x] = static_cast<Pixel>(
+  //     Clip3(RightShiftWithRounding(res, inter_post_round_bits), 0,
+  //           (1 << kBitdepth10) - 1));
+  const __m256i shift_0 =
+      RightShiftWithRounding_S32(sub_0, kRoundBitsMaskBlend);
+  const __m256i shift_1 =
+      RightShiftWithRounding_S32(sub_1, kRoundBitsMaskBlend);
+  return _mm256_min_epi16(_mm256_packus_epi32(shift_0, shift_1),
+                          _mm256_set1_epi16(kMax10bppSample));
+}
+
+template <bool is_inter_intra, int subsampling_x, int subsampling_y>
+void MaskBlend10bpp_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                         const void* LIBGAV1_RESTRICT prediction_1,
+                         const ptrdiff_t prediction_stride_1,
+                         const uint8_t* LIBGAV1_RESTRICT const mask_ptr,
+                         const ptrdiff_t mask_stride, const int width,
+                         const int height, void* LIBGAV1_RESTRICT dest,
+                         const ptrdiff_t dest_stride) {
+  auto* dst = static_cast<uint16_t*>(dest);
+  const ptrdiff_t dst_stride = dest_stride / sizeof(dst[0]);
+  const auto* pred_0 = static_cast<const uint16_t*>(prediction_0);
+  const auto* pred_1 = static_cast<const uint16_t*>(prediction_1);
+  const ptrdiff_t pred_stride_1 = prediction_stride_1;
+  const uint8_t* mask = mask_ptr;
+  int y = height;
+
+  if (width == 4) {
+    do {
+      const __m256i pred_mask_0 =
+          GetMask4x4<subsampling_x, subsampling_y>(mask, mask_stride);
+      const __m256i pred_val_1 = SetrM128i(
+          LoadHi8(LoadLo8(pred_1), pred_1 + pred_stride_1),
+          LoadHi8(LoadLo8(pred_1 + 2 * pred_stride_1),
+                  pred_1 + 3 * pred_stride_1));
+      const __m256i result = MaskBlend16<is_inter_intra>(
+          LoadUnaligned32(pred_0), pred_val_1, pred_mask_0);
+      const __m128i result_01 = _mm256_castsi256_si128(result);
+      const __m128i result_23 = _mm256_extracti128_si256(result, 1);
+      StoreLo8(dst, result_01);
+      StoreHi8(dst + dst_stride, result_01);
+      StoreLo8(dst + 2 * dst_stride, result_23);
+      StoreHi8(dst + 3 * dst_stride, result_23);
+      pred_0 += 4 << 2;
+      pred_1 += pred_stride_1 << 2;
+      mask += mask_stride << (2 + subsampling_y);
+      dst += dst_stride << 2;
+      y -= 4;
+    } while (y != 0);
+    return;
+  }
+
+  if (width == 8) {
+    do {
+      const __m256i pred_mask_0 =
+          GetMask8x2<subsampling_x, subsampling_y>(mask, mask_stride);
+      const __m256i pred_val_1 = SetrM128i(
+          LoadUnaligned16(pred_1), LoadUnaligned16(pred_1 + pred_stride_1));
+      const __m256i result = MaskBlend16<is_inter_intra>(
+          LoadUnaligned32(pred_0), pred_val_1, pred_mask_0);
+      StoreUnaligned16(dst, _mm256_castsi256_si128(result));
+      StoreUnaligned16(dst + dst_stride, _mm256_extracti128_si256(result, 1));
+      pred_0 += 8 << 1;
+      pred_1 += pred_stride_1 << 1;
+      mask += mask_stride << (1 + subsampling_y);
+      dst += dst_stride << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      const __m256i pred_mask_0 = GetMask16<subsampling_x, subsampling_y>(
+          mask + (x << subsampling_x), mask_stride);
+      StoreUnaligned32(dst + x, MaskBlend16<is_inter_intra>(
+                                    LoadUnaligned32(pred_0 + x),
+                                    LoadUnaligned32(pred_1 + x), pred_mask_0));
+      x += 16;
+    } while (x < width);
+    dst += dst_stride;
+    pred_0 += width;
+    pred_1 += pred_stride_1;
+    mask += mask_stride << subsampling_y;
+  } while (--y != 0);
+}
+
+void Init10bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_10BPP_AVX2(MaskBlend444)
+  dsp->mask_blend[0][0] = MaskBlend10bpp_AVX2<false, 0, 0>;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(MaskBlend422)
+  dsp->mask_blend[1][0] = MaskBlend10bpp_AVX2<false, 1, 0>;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(MaskBlend420)
+  dsp->mask_blend[2][0] = MaskBlend10bpp_AVX2<false, 1, 1>;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(MaskBlendInterIntra444)
+  dsp->mask_blend[0][1] = MaskBlend10bpp_AVX2<true, 0, 0>;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(MaskBlendInterIntra422)
+  dsp->mask_blend[1][1] = MaskBlend10bpp_AVX2<true, 1, 0>;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(MaskBlendInterIntra420)
+  dsp->mask_blend[2][1] = MaskBlend10bpp_AVX2<true, 1, 1>;
+#endif
+}
+
+}  // namespace
+}  // namespace high_bitdepth
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+void MaskBlendInit_AVX2() {
+  low_bitdepth::Init8bpp();
+#if LIBGAV1_MAX_BITDEPTH >= 10
+  high_bitdepth::Init10bpp();
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+
+namespace libgav1 {
+namespace dsp {
+
+void MaskBlendInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
@@ -0,0 +1,308 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/motion_field_projection.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+#include "src/utils/constants.h"
+#include "src/utils/types.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace {
+
+inline __m256i MvProjection(const __m256i mv, const __m256i denominator,
+                            const __m256i numerator) {
+  const __m256i m0 = _mm256_madd_epi16(mv, denominator);
+  const __m256i m = _mm256_mullo_epi32(m0, numerator);
+  // Add the sign (0 or -1) to round towards zero.
+  const __m256i sign = _mm256_srai_epi32(m, 31);
+  const __m256i add_sign = _mm256_add_epi32(m, sign);
+  const __m256i sum = _mm256_add_epi32(add_sign, _mm256_set1_epi32(1 << 13));
+  return _mm256_srai_epi32(sum, 14);
+}
+
+inline __m256i MvProjectionClip(const __m256i mv, const __m256i denominator,
+                                const __m256i numerator) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i mv0 = _mm256_unpacklo_epi16(mv, zero);
+  const __m256i mv1 = _mm256_unpackhi_epi16(mv, zero);
+  const __m256i denorm0 = _mm256_unpacklo_epi16(denominator, zero);
+  const __m256i denorm1 = _mm256_unpackhi_epi16(denominator, zero);
+  const __m256i s0 = MvProjection(mv0, denorm0, numerator);
+  const __m256i s1 = MvProjection(mv1, denorm1, numerator);
+  const __m256i projection = _mm256_packs_epi32(s0, s1);
+  const __m256i projection_mv_clamp = _mm256_set1_epi16(kProjectionMvClamp);
+  const __m256i projection_mv_clamp_negative =
+      _mm256_set1_epi16(-kProjectionMvClamp);
+  const __m256i clamp = _mm256_min_epi16(projection, projection_mv_clamp);
+  return _mm256_max_epi16(clamp, projection_mv_clamp_negative);
+}
+
+inline __m256i Project_AVX2(const __m256i delta, const __m256i dst_sign) {
+  // Add 63 to negative delta so that it shifts towards zero.
+  const __m256i delta_sign = _mm256_srai_epi16(delta, 15);
+  const __m256i delta_sign_63 = _mm256_srli_epi16(delta_sign, 10);
+  const __m256i delta_adjust = _mm256_add_epi16(delta, delta_sign_63);
+  const __m256i offset0 = _mm256_srai_epi16(delta_adjust, 6);
+  const __m256i offset1 = _mm256_xor_si256(offset0, dst_sign);
+  return _mm256_sub_epi16(offset1, dst_sign);
+}
+
+// Projects the |width| (8 or 16) entries of the current row starting at |x8|,
+// which is a multiple of 8. Entries 0-7 and 8-15 belong to different 8x8
+// column groups and so have different horizontal limits.
+template <int width>
+inline void ProjectColumns(
+    const __m256i division_table, const MotionVector* const mv,
+    const __m256i numerator, const int x8_start, const int x8_end,
+    const int x8, const __m128i r_offsets, const __m128i skip_reference,
+    const ReferenceFrameType* const source_reference_types,
+    const __m128i y8_floor8, const __m128i y8_ceiling8, const __m256i d_sign,
+    const ptrdiff_t stride, int8_t* const dst_reference_offset,
+    MotionVector* const dst_mv) {
+  static_assert(width == 8 || width == 16, "");
+  constexpr int kValidMask = (1 << width) - 1;
+  const __m128i source_reference_type16 =
+      (width == 16) ? LoadUnaligned16(source_reference_types + x8)
+                    : LoadLo8(source_reference_types + x8);
+  const __m128i skip_r =
+      _mm_shuffle_epi8(skip_reference, source_reference_type16);
+  // Early termination #1 if all are skips.
+  if ((_mm_movemask_epi8(skip_r) & kValidMask) == kValidMask) return;
+
+  // Deinterlace x and y components, leaving entries 0-7 in the low 128-bit
+  // lane and entries 8-15 in the high lane.
+  const __m256i kShuffle = _mm256_setr_epi8(
+      0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9,
+      12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  const __m256i mvs0 = LoadUnaligned32(mv + x8);
+  const __m256i mvs1 =
+      (width == 16) ? LoadUnaligned32(mv + x8 + 8) : _mm256_setzero_si256();
+  const __m256i mv0 = _mm256_permute4x64_epi64(
+      _mm256_shuffle_epi8(mvs0, kShuffle), 0xd8);  // y0-7 | x0-7
+  const __m256i mv1 = _mm256_permute4x64_epi64(
+      _mm256_shuffle_epi8(mvs1, kShuffle), 0xd8);  // y8-15 | x8-15
+  const __m256i mv_y = _mm256_permute2x128_si256(mv0, mv1, 0x20);
+  const __m256i mv_x = _mm256_permute2x128_si256(mv0, mv1, 0x31);
+
+  // Each 16-bit index is (2 * type) | ((2 * type + 1) << 8).
+  const __m256i type = _mm256_cvtepu8_epi16(source_reference_type16);
+  const __m256i idx =
+      _mm256_add_epi16(_mm256_mullo_epi16(type, _mm256_set1_epi16(0x0202)),
+                       _mm256_set1_epi16(0x0100));
+  const __m256i denorm = _mm256_shuffle_epi8(division_table, idx);
+  // numerator could be 0.
+  const __m256i projection_y = MvProjectionClip(mv_y, denorm, numerator);
+  const __m256i projection_x = MvProjectionClip(mv_x, denorm, numerator);
+  // Do not update the motion vector if the block position is not valid or
+  // if position_x8 is outside the current range of x8_start and x8_end.
+  // Note that position_y8 will always be within the range of y8_start and
+  // y8_end.
+  // After subtracting the base, valid projections are within 8-bit. Values
+  // which saturate or wrap around are all outside the limits below.
+  const __m256i position_y = Project_AVX2(projection_y, d_sign);
+  const __m256i position_x = Project_AVX2(projection_x, d_sign);
+  const __m256i positions = _mm256_packs_epi16(position_x, position_y);
+  const __m256i k0to15 =
+      _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 0, 0, 0, 0, 0, 0, 0, 0, 8, 9,
+                       10, 11, 12, 13, 14, 15, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i position_xy = _mm256_add_epi8(positions, k0to15);
+  const int x8_floor0 =
+      std::max(x8_start - x8, -kProjectionMvMaxHorizontalOffset);  // [-8, 8]
+  const int x8_floor1 =
+      std::max(x8_start - x8, 8 - kProjectionMvMaxHorizontalOffset);
+  const int x8_ceiling0 =
+      std::min(x8_end - x8, 8 + kProjectionMvMaxHorizontalOffset) - 1;
+  const int x8_ceiling1 =
+      std::min(x8_end - x8, 16 + kProjectionMvMaxHorizontalOffset) - 1;
+  const __m256i floor_xy =
+      SetrM128i(_mm_unpacklo_epi64(_mm_set1_epi8(x8_floor0), y8_floor8),
+                _mm_unpacklo_epi64(_mm_set1_epi8(x8_floor1), y8_floor8));
+  const __m256i ceiling_xy =
+      SetrM128i(_mm_unpacklo_epi64(_mm_set1_epi8(x8_ceiling0), y8_ceiling8),
+                _mm_unpacklo_epi64(_mm_set1_epi8(x8_ceiling1), y8_ceiling8));
+  const __m256i underflow = _mm256_cmpgt_epi8(floor_xy, position_xy);
+  const __m256i overflow = _mm256_cmpgt_epi8(position_xy, ceiling_xy);
+  const __m256i out = _mm256_or_si256(underflow, overflow);
+  const __m256i out_xy = _mm256_or_si256(out, _mm256_srli_si256(out, 8));
+  const __m128i skip = _mm_or_si128(
+      skip_r, _mm_unpacklo_epi64(_mm256_castsi256_si128(out_xy),
+                                 _mm256_extracti128_si256(out_xy, 1)));
+  uint32_t store_mask = ~_mm_movemask_epi8(skip) & kValidMask;
+  // Early termination #2 if all are skips.
+  if (store_mask == 0) return;
+
+  const __m128i position_xy_lo = _mm256_castsi256_si128(position_xy);
+  const __m128i position_xy_hi = _mm256_extracti128_si256(position_xy, 1);
+  const __m256i p_x =
+      _mm256_cvtepi8_epi16(_mm_unpacklo_epi64(position_xy_lo, position_xy_hi));
+  const __m256i p_y =
+      _mm256_cvtepi8_epi16(_mm_unpackhi_epi64(position_xy_lo, position_xy_hi));
+  const __m256i p_y_offset =
+      _mm256_mullo_epi16(p_y, _mm256_set1_epi16(stride));
+  const __m256i pos = _mm256_add_epi16(p_y_offset, p_x);
+  const __m256i position = _mm256_add_epi16(pos, _mm256_set1_epi16(x8));
+  alignas(32) int16_t position16[16];
+  alignas(16) int8_t r16[16];
+  StoreAligned32(position16, position);
+  StoreAligned16(r16, _mm_shuffle_epi8(r_offsets, source_reference_type16));
+  // Store in increasing column order, which keeps the result the same when
+  // several entries project to the same position.
+  do {
+    const int i = CountTrailingZeros(store_mask);
+    dst_mv[position16[i]] = mv[x8 + i];
+    dst_reference_offset[position16[i]] = r16[i];
+    store_mask &= store_mask - 1;
+  } while (store_mask != 0);
+}
+
+// 7.9.2.
+void MotionFieldProjectionKernel_AVX2(
+    const ReferenceInfo& reference_info,
+    const int reference_to_current_with_sign, const int dst_sign,
+    const int y8_start, const int y8_end, const int x8_start, const int x8_end,
+    TemporalMotionField* const motion_field) {
+  const ptrdiff_t stride = motion_field->mv.columns();
+  // The column range has to be offset by kProjectionMvMaxHorizontalOffset since
+  // coordinates in that range could end up being position_x8 because of
+  // projection.
+  const int adjusted_x8_start =
+      std::max(x8_start - kProjectionMvMaxHorizontalOffset, 0);
+  const int adjusted_x8_end = std::min(
+      x8_end + kProjectionMvMaxHorizontalOffset, static_cast<int>(stride));
+  const int adjusted_x8_end8 = adjusted_x8_end & ~7;
+  const int8_t* const reference_offsets =
+      reference_info.relative_distance_to.data();
+  const bool* const skip_references = reference_info.skip_references.data();
+  const int16_t* const projection_divisions =
+      reference_info.projection_divisions.data();
+  const ReferenceFrameType* source_reference_types =
+      &reference_info.motion_field_reference_frame[y8_start][0];
+  const MotionVector* mv = &reference_info.motion_field_mv[y8_start][0];
+  int8_t* dst_reference_offset = motion_field->reference_offset[y8_start];
+  MotionVector* dst_mv = motion_field->mv[y8_start];
+  const __m256i d_sign = _mm256_set1_epi16(dst_sign);
+  const __m256i numerator = _mm256_set1_epi32(reference_to_current_with_sign);
+
+  static_assert(sizeof(int8_t) == sizeof(bool), "");
+  static_assert(sizeof(int8_t) == sizeof(ReferenceFrameType), "");
+  static_assert(sizeof(int32_t) == sizeof(MotionVector), "");
+  assert(dst_sign == 0 || dst_sign == -1);
+  assert(stride == motion_field->reference_offset.columns());
+  assert((y8_start & 7) == 0);
+  assert((adjusted_x8_start & 7) == 0);
+  // The final position calculation is represented with int16_t. Valid
+  // position_y8 from its base is at most 7. After considering the horizontal
+  // offset which is at most |stride - 1|, we have the following assertion,
+  // which means this optimization works for frame width up to 32K (each
+  // position is a 8x8 block).
+  assert(8 * stride <= 32768);
+  // Widen the bools to 0 and -1 so that _mm_movemask_epi8() picks them up.
+  const __m128i skip_reference =
+      _mm_cmpgt_epi8(LoadLo8(skip_references), _mm_setzero_si128());
+  const __m128i r_offsets = LoadLo8(reference_offsets);
+  const __m256i division_table =
+      _mm256_broadcastsi128_si256(LoadUnaligned16(projection_divisions));
+
+  int y8 = y8_start;
+  do {
+    const int y8_floor = (y8 & ~7) - y8;                             // [-7, 0]
+    const int y8_ceiling = std::min(y8_end - y8, y8_floor + 8) - 1;  // [0, 7]
+    const __m128i y8_floor8 = _mm_set1_epi8(y8_floor);
+    const __m128i y8_ceiling8 = _mm_set1_epi8(y8_ceiling);
+    int x8;
+
+    for (x8 = adjusted_x8_start; x8 + 16 <= adjusted_x8_end8; x8 += 16) {
+      ProjectColumns<16>(division_table, mv, numerator, x8_start, x8_end, x8,
+                         r_offsets, skip_reference, source_reference_types,
+                         y8_floor8, y8_ceiling8, d_sign, stride,
+                         dst_reference_offset, dst_mv);
+    }
+    if (x8 < adjusted_x8_end8) {
+      ProjectColumns<8>(division_table, mv, numerator, x8_start, x8_end, x8,
+                        r_offsets, skip_reference, source_reference_types,
+                        y8_floor8, y8_ceiling8, d_sign, stride,
+                        dst_reference_offset, dst_mv);
+      x8 += 8;
+    }
+
+    // The following leftover processing cannot be moved out of the do...while
+    // loop. Doing so may change the result storing orders of the same position.
+    for (; x8 < adjusted_x8_end; ++x8) {
+      const int source_reference_type = source_reference_types[x8];
+      if (skip_references[source_reference_type]) continue;
+      MotionVector projection_mv;
+      // reference_to_current_with_sign could be 0.
+      GetMvProjection(mv[x8], reference_to_current_with_sign,
+                      projection_divisions[source_reference_type],
+                      &projection_mv);
+      // Do not update the motion vector if the block position is not valid
+      // or if position_x8 is outside the current range of x8_start and
+      // x8_end. Note that position_y8 will always be within the range of
+      // y8_start and y8_end.
+      const int position_y8 = Project(0, projection_mv.mv[0], dst_sign);
+      if (position_y8 < y8_floor || position_y8 > y8_ceiling) continue;
+      const int x8_base = x8 & ~7;
+      const int x8_floor =
+          std::max(x8_start, x8_base - kProjectionMvMaxHorizontalOffset);
+      const int x8_ceiling =
+          std::min(x8_end, x8_base + 8 + kProjectionMvMaxHorizontalOffset);
+      const int position_x8 = Project(x8, projection_mv.mv[1], dst_sign);
+      if (position_x8 < x8_floor || position_x8 >= x8_ceiling) continue;
+      dst_mv[position_y8 * stride + position_x8] = mv[x8];
+      dst_reference_offset[position_y8 * stride + position_x8] =
+          reference_offsets[source_reference_type];
+    }
+
+    source_reference_types += stride;
+    mv += stride;
+    dst_reference_offset += stride;
+    dst_mv += stride;
+  } while (++y8 < y8_end);
+}
+
+}  // namespace
+
+void MotionFieldProjectionInit_AVX2() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+  dsp->motion_field_projection_kernel = MotionFieldProjectionKernel_AVX2;
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+namespace libgav1 {
+namespace dsp {
+
+void MotionFieldProjectionInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
@@ -0,0 +1,151 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/motion_vector_search.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+#include "src/utils/constants.h"
+#include "src/utils/types.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace {
+
+constexpr int kProjectionMvDivisionLookup_32bit[kMaxFrameDistance + 1] = {
+    0,    16384, 8192, 5461, 4096, 3276, 2730, 2340, 2048, 1820, 1638,
+    1489, 1365,  1260, 1170, 1092, 1024, 963,  910,  862,  819,  780,
+    744,  712,   682,  655,  630,  606,  585,  564,  546,  528};
+
+inline __m256i MvProjection(const __m256i mv, const __m256i denominator,
+                            const __m256i numerator) {
+  const __m256i m0 = _mm256_madd_epi16(mv, denominator);
+  const __m256i m = _mm256_mullo_epi32(m0, numerator);
+  // Add the sign (0 or -1) to round towards zero.
+  const __m256i sign = _mm256_srai_epi32(m, 31);
+  const __m256i add_sign = _mm256_add_epi32(m, sign);
+  const __m256i sum = _mm256_add_epi32(add_sign, _mm256_set1_epi32(1 << 13));
+  return _mm256_srai_epi32(sum, 14);
+}
+
+// Projects the 8 motion vectors in |temporal_mv|. The 32-bit lanes of
+// |offsets| hold the matching temporal reference offsets.
+inline __m256i MvProjectionSingleClip(const __m256i temporal_mv,
+                                      const __m256i offsets,
+                                      const __m256i numerator) {
+  const __m256i lookup =
+      _mm256_i32gather_epi32(kProjectionMvDivisionLookup_32bit, offsets, 4);
+  // All the unpacks and the pack work within 128-bit lanes, so the output
+  // order matches |temporal_mv|.
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i mv0 = _mm256_unpacklo_epi16(temporal_mv, zero);
+  const __m256i mv1 = _mm256_unpackhi_epi16(temporal_mv, zero);
+  const __m256i denominator0 = _mm256_unpacklo_epi32(lookup, lookup);
+  const __m256i denominator1 = _mm256_unpackhi_epi32(lookup, lookup);
+  const __m256i s0 = MvProjection(mv0, denominator0, numerator);
+  const __m256i s1 = MvProjection(mv1, denominator1, numerator);
+  const __m256i mv = _mm256_packs_epi32(s0, s1);
+  const __m256i projection_mv_clamp = _mm256_set1_epi16(kProjectionMvClamp);
+  const __m256i projection_mv_clamp_negative =
+      _mm256_set1_epi16(-kProjectionMvClamp);
+  const __m256i clamp = _mm256_min_epi16(mv, projection_mv_clamp);
+  return _mm256_max_epi16(clamp, projection_mv_clamp_negative);
+}
+
+inline __m256i LowPrecision(const __m256i mv) {
+  const __m256i kRoundDownMask = _mm256_set1_epi16(~1);
+  const __m256i sign = _mm256_srai_epi16(mv, 15);
+  const __m256i sub_sign = _mm256_sub_epi16(mv, sign);
+  return _mm256_and_si256(sub_sign, kRoundDownMask);
+}
+
+inline __m256i ForceInteger(const __m256i mv) {
+  const __m256i kRoundDownMask = _mm256_set1_epi16(~7);
+  const __m256i sign = _mm256_srai_epi16(mv, 15);
+  const __m256i mv1 = _mm256_add_epi16(mv, _mm256_set1_epi16(3));
+  const __m256i mv2 = _mm256_sub_epi16(mv1, sign);
+  return _mm256_and_si256(mv2, kRoundDownMask);
+}
+
+// |precision| is the index into Dsp::mv_projection_single, i.e. 0 for low
+// precision, 1 for force integer and 2 for high precision.
+template <int precision>
+inline __m256i Round(const __m256i mv) {
+  if (precision == 0) return LowPrecision(mv);
+  if (precision == 1) return ForceInteger(mv);
+  return mv;
+}
+
+template <int precision>
+void MvProjectionSingle_AVX2(
+    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
+    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
+    const int reference_offset, const int count,
+    MotionVector* LIBGAV1_RESTRICT candidate_mvs) {
+  const __m256i numerator = _mm256_set1_epi32(reference_offset);
+  // The callers only allow up to three more elements to be calculated, so
+  // process 8 elements at a time only when more than 4 are left.
+  int i = 0;
+  for (; count - i > 4; i += 8) {
+    const __m256i temporal_mv = LoadUnaligned32(temporal_mvs + i);
+    const __m256i offsets =
+        _mm256_cvtepi8_epi32(LoadLo8(temporal_reference_offsets + i));
+    const __m256i mv = Round<precision>(
+        MvProjectionSingleClip(temporal_mv, offsets, numerator));
+    StoreUnaligned32(candidate_mvs + i, mv);
+  }
+  if (i < count) {
+    const __m256i temporal_mv =
+        SetrM128i(LoadUnaligned16(temporal_mvs + i), _mm_setzero_si128());
+    const __m256i offsets =
+        _mm256_cvtepi8_epi32(Load4(temporal_reference_offsets + i));
+    const __m256i mv = Round<precision>(
+        MvProjectionSingleClip(temporal_mv, offsets, numerator));
+    StoreUnaligned16(candidate_mvs + i, _mm256_castsi256_si128(mv));
+  }
+}
+
+}  // namespace
+
+void MotionVectorSearchInit_AVX2() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+  dsp->mv_projection_single[0] = MvProjectionSingle_AVX2<0>;
+  dsp->mv_projection_single[1] = MvProjectionSingle_AVX2<1>;
+  dsp->mv_projection_single[2] = MvProjectionSingle_AVX2<2>;
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+namespace libgav1 {
+namespace dsp {
+
+void MotionVectorSearchInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
@@ -63,25 +63,6 @@ inline __m128i MvProjectionClip(const __m128i mvs[2],
   return _mm_max_epi16(clamp, projection_mv_clamp_negative);
 }
 
-inline __m128i MvProjectionCompoundClip(
-    const MotionVector* LIBGAV1_RESTRICT const temporal_mvs,
-    const int8_t temporal_reference_offsets[2],
-    const int reference_offsets[2]) {
-  const auto* const tmvs = reinterpret_cast<const int32_t*>(temporal_mvs);
-  const __m128i temporal_mv = LoadLo8(tmvs);
-  const __m128i temporal_mv_0 = _mm_cvtepu16_epi32(temporal_mv);
-  __m128i mvs[2], denominators[2];
-  mvs[0] = _mm_unpacklo_epi64(temporal_mv_0, temporal_mv_0);
-  mvs[1] = _mm_unpackhi_epi64(temporal_mv_0, temporal_mv_0);
-  denominators[0] = _mm_set1_epi32(
-      kProjectionMvDivisionLookup[temporal_reference_offsets[0]]);
-  denominators[1] = _mm_set1_epi32(
-      kProjectionMvDivisionLookup[temporal_reference_offsets[1]]);
-  const __m128i offsets = LoadLo8(reference_offsets);
-  const __m128i numerator = _mm_unpacklo_epi32(offsets, offsets);
-  return MvProjectionClip(mvs, denominators, numerator);
-}
-
 inline __m128i MvProjectionSingleClip(
     const MotionVector* LIBGAV1_RESTRICT const temporal_mvs,
     const int8_t* LIBGAV1_RESTRICT const temporal_reference_offsets,
@@ -125,60 +106,6 @@ inline void ForceInteger(const __m128i mv, void* const candidate_mvs) {
   StoreAligned16(candidate_mvs, mv3);
 }
 
-void MvProjectionCompoundLowPrecision_SSE4_1(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int i = 0;
-  do {
-    const __m128i mv = MvProjectionCompoundClip(
-        temporal_mvs + i, temporal_reference_offsets + i, offsets);
-    LowPrecision(mv, candidate_mvs + i);
-    i += 2;
-  } while (i < count);
-}
-
-void MvProjectionCompoundForceInteger_SSE4_1(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int i = 0;
-  do {
-    const __m128i mv = MvProjectionCompoundClip(
-        temporal_mvs + i, temporal_reference_offsets + i, offsets);
-    ForceInteger(mv, candidate_mvs + i);
-    i += 2;
-  } while (i < count);
-}
-
-void MvProjectionCompoundHighPrecision_SSE4_1(
-    const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
-    const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
-    const int reference_offsets[2], const int count,
-    CompoundMotionVector* LIBGAV1_RESTRICT candidate_mvs) {
-  // |reference_offsets| non-zero check usually equals true and is ignored.
-  // To facilitate the compilers, make a local copy of |reference_offsets|.
-  const int offsets[2] = {reference_offsets[0], reference_offsets[1]};
-  // One more element could be calculated.
-  int i = 0;
-  do {
-    const __m128i mv = MvProjectionCompoundClip(
-        temporal_mvs + i, temporal_reference_offsets + i, offsets);
-    StoreAligned16(candidate_mvs + i, mv);
-    i += 2;
-  } while (i < count);
-}
-
 void MvProjectionSingleLowPrecision_SSE4_1(
     const MotionVector* LIBGAV1_RESTRICT temporal_mvs,
     const int8_t* LIBGAV1_RESTRICT temporal_reference_offsets,
@@ -229,9 +156,6 @@ void MvProjectionSingleHighPrecision_SSE4_1(
 void MotionVectorSearchInit_SSE4_1() {
   Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
   assert(dsp != nullptr);
-  dsp->mv_projection_compound[0] = MvProjectionCompoundLowPrecision_SSE4_1;
-  dsp->mv_projection_compound[1] = MvProjectionCompoundForceInteger_SSE4_1;
-  dsp->mv_projection_compound[2] = MvProjectionCompoundHighPrecision_SSE4_1;
   dsp->mv_projection_single[0] = MvProjectionSingleLowPrecision_SSE4_1;
   dsp->mv_projection_single[1] = MvProjectionSingleForceInteger_SSE4_1;
   dsp->mv_projection_single[2] = MvProjectionSingleHighPrecision_SSE4_1;
@@ -0,0 +1,392 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/obmc.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+#include "src/utils/constants.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace low_bitdepth {
+namespace {
+
+#include "src/dsp/obmc.inc"
+#include "src/dsp/x86/obmc_sse4.inc"
+
+// Returns the interleaved (mask, 64 - mask) byte pairs of each mask value in
+// |mask_val|, in the order used by Blend32().
+inline void GetMasks(const __m256i& mask_val, __m256i* const masks_lo,
+                     __m256i* const masks_hi) {
+  // 64 - mask
+  const __m256i obmc_mask_val =
+      _mm256_sub_epi8(_mm256_set1_epi8(64), mask_val);
+  *masks_lo = _mm256_unpacklo_epi8(mask_val, obmc_mask_val);
+  *masks_hi = _mm256_unpackhi_epi8(mask_val, obmc_mask_val);
+}
+
+// Returns the (mask, 64 - mask) byte pair of |mask| repeated over 128 bits.
+inline __m128i GetRowMasks(const uint8_t mask) {
+  return _mm_set1_epi16(static_cast<int16_t>(mask | ((64 - mask) << 8)));
+}
+
+// Blends 32 pixels. The unpacks and the pack both work within 128-bit lanes,
+// so the order is preserved.
+inline __m256i Blend32(const __m256i& pred_val, const __m256i& obmc_pred_val,
+                       const __m256i& masks_lo, const __m256i& masks_hi) {
+  const __m256i terms_lo = _mm256_unpacklo_epi8(pred_val, obmc_pred_val);
+  const __m256i result_lo = RightShiftWithRounding_S16(
+      _mm256_maddubs_epi16(terms_lo, masks_lo), kRoundBitsObmcBlend);
+  const __m256i terms_hi = _mm256_unpackhi_epi8(pred_val, obmc_pred_val);
+  const __m256i result_hi = RightShiftWithRounding_S16(
+      _mm256_maddubs_epi16(terms_hi, masks_hi), kRoundBitsObmcBlend);
+  return _mm256_packus_epi16(result_lo, result_hi);
+}
+
+void OverlapBlendFromLeft_AVX2(
+    void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
+    const int width, const int height,
+    const void* LIBGAV1_RESTRICT const obmc_prediction,
+    const ptrdiff_t obmc_prediction_stride) {
+  auto* pred = static_cast<uint8_t*>(prediction);
+  const auto* obmc_pred = static_cast<const uint8_t*>(obmc_prediction);
+  assert(width >= 2);
+  assert(width <= 32);
+  assert(height >= 4);
+
+  if (width == 2) {
+    OverlapBlendFromLeft2xH_SSE4_1(pred, prediction_stride, height, obmc_pred);
+    return;
+  }
+  if (width == 4) {
+    OverlapBlendFromLeft4xH_SSE4_1(pred, prediction_stride, height, obmc_pred);
+    return;
+  }
+  if (width == 8) {
+    OverlapBlendFromLeft8xH_SSE4_1(pred, prediction_stride, height, obmc_pred);
+    return;
+  }
+  __m256i masks_lo, masks_hi;
+  int y = height;
+  if (width == 16) {
+    GetMasks(_mm256_broadcastsi128_si256(LoadUnaligned16(kObmcMask + 14)),
+             &masks_lo, &masks_hi);
+    do {
+      const __m256i pred_val = SetrM128i(
+          LoadUnaligned16(pred), LoadUnaligned16(pred + prediction_stride));
+      const __m256i obmc_pred_val =
+          SetrM128i(LoadUnaligned16(obmc_pred),
+                    LoadUnaligned16(obmc_pred + obmc_prediction_stride));
+      const __m256i result =
+          Blend32(pred_val, obmc_pred_val, masks_lo, masks_hi);
+      StoreUnaligned16(pred, _mm256_castsi256_si128(result));
+      StoreUnaligned16(pred + prediction_stride,
+                       _mm256_extracti128_si256(result, 1));
+      pred += prediction_stride << 1;
+      obmc_pred += obmc_prediction_stride << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  GetMasks(LoadUnaligned32(kObmcMask + 30), &masks_lo, &masks_hi);
+  do {
+    StoreUnaligned32(pred, Blend32(LoadUnaligned32(pred),
+                                   LoadUnaligned32(obmc_pred), masks_lo,
+                                   masks_hi));
+    pred += prediction_stride;
+    obmc_pred += obmc_prediction_stride;
+  } while (--y != 0);
+}
+
+void OverlapBlendFromTop_AVX2(
+    void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
+    const int width, const int height,
+    const void* LIBGAV1_RESTRICT const obmc_prediction,
+    const ptrdiff_t obmc_prediction_stride) {
+  auto* pred = static_cast<uint8_t*>(prediction);
+  const auto* obmc_pred = static_cast<const uint8_t*>(obmc_prediction);
+  assert(width >= 4);
+  assert(height >= 2);
+
+  if (width == 4) {
+    OverlapBlendFromTop4xH_SSE4_1(pred, prediction_stride, height, obmc_pred);
+    return;
+  }
+  if (width == 8) {
+    OverlapBlendFromTop8xH_SSE4_1(pred, prediction_stride, height, obmc_pred);
+    return;
+  }
+
+  // Stop when mask value becomes 64.
+  const int compute_height = height - (height >> 2);
+  const uint8_t* mask = kObmcMask + height - 2;
+  int y = 0;
+  if (width == 16) {
+    // Only |height| == 4 gives an odd |compute_height|. Its last row has a mask
+    // value of 64, so blending it leaves the prediction unchanged.
+    do {
+      const __m256i masks =
+          SetrM128i(GetRowMasks(mask[y]), GetRowMasks(mask[y + 1]));
+      const __m256i pred_val = SetrM128i(
+          LoadUnaligned16(pred), LoadUnaligned16(pred + prediction_stride));
+      const __m256i obmc_pred_val =
+          SetrM128i(LoadUnaligned16(obmc_pred),
+                    LoadUnaligned16(obmc_pred + obmc_prediction_stride));
+      const __m256i result = Blend32(pred_val, obmc_pred_val, masks, masks);
+      StoreUnaligned16(pred, _mm256_castsi256_si128(result));
+      StoreUnaligned16(pred + prediction_stride,
+                       _mm256_extracti128_si256(result, 1));
+      pred += prediction_stride << 1;
+      obmc_pred += obmc_prediction_stride << 1;
+      y += 2;
+    } while (y < compute_height);
+    return;
+  }
+
+  do {
+    const __m256i masks = _mm256_broadcastsi128_si256(GetRowMasks(mask[y]));
+    int x = 0;
+    do {
+      StoreUnaligned32(pred + x, Blend32(LoadUnaligned32(pred + x),
+                                         LoadUnaligned32(obmc_pred + x), masks,
+                                         masks));
+      x += 32;
+    } while (x < width);
+    pred += prediction_stride;
+    obmc_pred += obmc_prediction_stride;
+  } while (++y < compute_height);
+}
+
+void Init8bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_8BPP_AVX2(ObmcVertical)
+  dsp->obmc_blend[kObmcDirectionVertical] = OverlapBlendFromTop_AVX2;
+#endif
+#if DSP_ENABLED_8BPP_AVX2(ObmcHorizontal)
+  dsp->obmc_blend[kObmcDirectionHorizontal] = OverlapBlendFromLeft_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace low_bitdepth
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+namespace high_bitdepth {
+namespace {
+
+#include "src/dsp/obmc.inc"
+#include "src/dsp/x86/obmc_sse4.inc"
+
+// Returns the interleaved (mask, 64 - mask) 16-bit pairs of the 16 mask values
+// in |mask_val|, in the order used by Blend16().
+inline void GetMasks(const __m256i& mask_val, __m256i* const masks_lo,
+                     __m256i* const masks_hi) {
+  // 64 - mask
+  const __m256i obmc_mask_val =
+      _mm256_sub_epi16(_mm256_set1_epi16(64), mask_val);
+  *masks_lo = _mm256_unpacklo_epi16(mask_val, obmc_mask_val);
+  *masks_hi = _mm256_unpackhi_epi16(mask_val, obmc_mask_val);
+}
+
+// Returns the (mask, 64 - mask) 16-bit pair of |mask| repeated over 128 bits.
+inline __m128i GetRowMasks(const uint8_t mask) {
+  return _mm_set1_epi32(mask | ((64 - mask) << 16));
+}
+
+// Blends 16 pixels. The unpacks and the pack both work within 128-bit lanes,
+// so the order is preserved.
+inline __m256i Blend16(const __m256i& pred_val, const __m256i& obmc_pred_val,
+                       const __m256i& masks_lo, const __m256i& masks_hi) {
+  const __m256i terms_lo = _mm256_unpacklo_epi16(pred_val, obmc_pred_val);
+  const __m256i result_lo = RightShiftWithRounding_S32(
+      _mm256_madd_epi16(terms_lo, masks_lo), kRoundBitsObmcBlend);
+  const __m256i terms_hi = _mm256_unpackhi_epi16(pred_val, obmc_pred_val);
+  const __m256i result_hi = RightShiftWithRounding_S32(
+      _mm256_madd_epi16(terms_hi, masks_hi), kRoundBitsObmcBlend);
+  return _mm256_packus_epi32(result_lo, result_hi);
+}
+
+void OverlapBlendFromLeft10bpp_AVX2(
+    void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
+    const int width, const int height,
+    const void* LIBGAV1_RESTRICT const obmc_prediction,
+    const ptrdiff_t obmc_prediction_stride) {
+  auto* pred = static_cast<uint16_t*>(prediction);
+  const auto* obmc_pred = static_cast<const uint16_t*>(obmc_prediction);
+  const ptrdiff_t pred_stride = prediction_stride / sizeof(pred[0]);
+  const ptrdiff_t obmc_pred_stride =
+      obmc_prediction_stride / sizeof(obmc_pred[0]);
+  assert(width >= 2);
+  assert(width <= 32);
+  assert(height >= 4);
+
+  if (width == 2) {
+    OverlapBlendFromLeft2xH_SSE4_1(pred, pred_stride, height, obmc_pred);
+    return;
+  }
+  if (width == 4) {
+    OverlapBlendFromLeft4xH_SSE4_1(pred, pred_stride, height, obmc_pred);
+    return;
+  }
+  __m256i masks_lo, masks_hi;
+  int y = height;
+  if (width == 8) {
+    GetMasks(_mm256_broadcastsi128_si256(
+                 _mm_cvtepu8_epi16(LoadLo8(kObmcMask + 6))),
+             &masks_lo, &masks_hi);
+    do {
+      const __m256i pred_val = SetrM128i(LoadUnaligned16(pred),
+                                         LoadUnaligned16(pred + pred_stride));
+      const __m256i obmc_pred_val =
+          SetrM128i(LoadUnaligned16(obmc_pred),
+                    LoadUnaligned16(obmc_pred + obmc_pred_stride));
+      const __m256i result =
+          Blend16(pred_val, obmc_pred_val, masks_lo, masks_hi);
+      StoreUnaligned16(pred, _mm256_castsi256_si128(result));
+      StoreUnaligned16(pred + pred_stride,
+                       _mm256_extracti128_si256(result, 1));
+      pred += pred_stride << 1;
+      obmc_pred += obmc_pred_stride << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  const uint8_t* mask = kObmcMask + width - 2;
+  int x = 0;
+  do {
+    pred = static_cast<uint16_t*>(prediction) + x;
+    obmc_pred = static_cast<const uint16_t*>(obmc_prediction) + x;
+    GetMasks(_mm256_cvtepu8_epi16(LoadUnaligned16(mask + x)), &masks_lo,
+             &masks_hi);
+    y = height;
+    do {
+      StoreUnaligned32(pred, Blend16(LoadUnaligned32(pred),
+                                     LoadUnaligned32(obmc_pred), masks_lo,
+                                     masks_hi));
+      pred += pred_stride;
+      obmc_pred += obmc_pred_stride;
+    } while (--y != 0);
+    x += 16;
+  } while (x < width);
+}
+
+void OverlapBlendFromTop10bpp_AVX2(
+    void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
+    const int width, const int height,
+    const void* LIBGAV1_RESTRICT const obmc_prediction,
+    const ptrdiff_t obmc_prediction_stride) {
+  auto* pred = static_cast<uint16_t*>(prediction);
+  const auto* obmc_pred = static_cast<const uint16_t*>(obmc_prediction);
+  const ptrdiff_t pred_stride = prediction_stride / sizeof(pred[0]);
+  const ptrdiff_t obmc_pred_stride =
+      obmc_prediction_stride / sizeof(obmc_pred[0]);
+  assert(width >= 4);
+  assert(height >= 2);
+
+  if (width == 4) {
+    OverlapBlendFromTop4xH_SSE4_1(pred, pred_stride, height, obmc_pred);
+    return;
+  }
+
+  // Stop when mask value becomes 64.
+  const int compute_height = height - (height >> 2);
+  const uint8_t* mask = kObmcMask + height - 2;
+  int y = 0;
+  if (width == 8) {
+    // Only |height| == 4 gives an odd |compute_height|. Its last row has a mask
+    // value of 64, so blending it leaves the prediction unchanged.
+    do {
+      const __m256i masks =
+          SetrM128i(GetRowMasks(mask[y]), GetRowMasks(mask[y + 1]));
+      const __m256i pred_val = SetrM128i(LoadUnaligned16(pred),
+                                         LoadUnaligned16(pred + pred_stride));
+      const __m256i obmc_pred_val =
+          SetrM128i(LoadUnaligned16(obmc_pred),
+                    LoadUnaligned16(obmc_pred + obmc_pred_stride));
+      const __m256i result = Blend16(pred_val, obmc_pred_val, masks, masks);
+      StoreUnaligned16(pred, _mm256_castsi256_si128(result));
+      StoreUnaligned16(pred + pred_stride,
+                       _mm256_extracti128_si256(result, 1));
+      pred += pred_stride << 1;
+      obmc_pred += obmc_pred_stride << 1;
+      y += 2;
+    } while (y < compute_height);
+    return;
+  }
+
+  do {
+    const __m256i masks = _mm256_broadcastsi128_si256(GetRowMasks(mask[y]));
+    int x = 0;
+    do {
+      StoreUnaligned32(pred + x, Blend16(LoadUnaligned32(pred + x),
+                                         LoadUnaligned32(obmc_pred + x), masks,
+                                         masks));
+      x += 16;
+    } while (x < width);
+    pred += pred_stride;
+    obmc_pred += obmc_pred_stride;
+  } while (++y < compute_height);
+}
+
+void Init10bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_10BPP_AVX2(ObmcVertical)
+  dsp->obmc_blend[kObmcDirectionVertical] = OverlapBlendFromTop10bpp_AVX2;
+#endif
+#if DSP_ENABLED_10BPP_AVX2(ObmcHorizontal)
+  dsp->obmc_blend[kObmcDirectionHorizontal] = OverlapBlendFromLeft10bpp_AVX2;
+#endif
+}
+
+}  // namespace
+}  // namespace high_bitdepth
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+void ObmcInit_AVX2() {
+  low_bitdepth::Init8bpp();
+#if LIBGAV1_MAX_BITDEPTH >= 10
+  high_bitdepth::Init10bpp();
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+
+namespace libgav1 {
+namespace dsp {
+
+void ObmcInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
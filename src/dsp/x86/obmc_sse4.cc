@@ -35,108 +35,7 @@ namespace low_bitdepth {
 namespace {
 
 #include "src/dsp/obmc.inc"
-
-inline void OverlapBlendFromLeft2xH_SSE4_1(
-    uint8_t* LIBGAV1_RESTRICT const prediction,
-    const ptrdiff_t prediction_stride, const int height,
-    const uint8_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_prediction_stride = 2;
-  uint8_t* pred = prediction;
-  const uint8_t* obmc_pred = obmc_prediction;
-  const __m128i mask_inverter = _mm_cvtsi32_si128(0x40404040);
-  const __m128i mask_val = _mm_shufflelo_epi16(Load4(kObmcMask), 0);
-  // 64 - mask
-  const __m128i obmc_mask_val = _mm_sub_epi8(mask_inverter, mask_val);
-  const __m128i masks = _mm_unpacklo_epi8(mask_val, obmc_mask_val);
-  int y = height;
-  do {
-    const __m128i pred_val = Load2x2(pred, pred + prediction_stride);
-    const __m128i obmc_pred_val = Load4(obmc_pred);
-
-    const __m128i terms = _mm_unpacklo_epi8(pred_val, obmc_pred_val);
-    const __m128i result =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms, masks), 6);
-    const __m128i packed_result = _mm_packus_epi16(result, result);
-    Store2(pred, packed_result);
-    pred += prediction_stride;
-    const int16_t second_row_result = _mm_extract_epi16(packed_result, 1);
-    memcpy(pred, &second_row_result, sizeof(second_row_result));
-    pred += prediction_stride;
-    obmc_pred += obmc_prediction_stride << 1;
-    y -= 2;
-  } while (y != 0);
-}
-
-inline void OverlapBlendFromLeft4xH_SSE4_1(
-    uint8_t* LIBGAV1_RESTRICT const prediction,
-    const ptrdiff_t prediction_stride, const int height,
-    const uint8_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_prediction_stride = 4;
-  uint8_t* pred = prediction;
-  const uint8_t* obmc_pred = obmc_prediction;
-  const __m128i mask_inverter = _mm_cvtsi32_si128(0x40404040);
-  const __m128i mask_val = Load4(kObmcMask + 2);
-  // 64 - mask
-  const __m128i obmc_mask_val = _mm_sub_epi8(mask_inverter, mask_val);
-  // Duplicate first half of vector.
-  const __m128i masks =
-      _mm_shuffle_epi32(_mm_unpacklo_epi8(mask_val, obmc_mask_val), 0x44);
-  int y = height;
-  do {
-    const __m128i pred_val0 = Load4(pred);
-    pred += prediction_stride;
-
-    // Place the second row of each source in the second four bytes.
-    const __m128i pred_val =
-        _mm_alignr_epi8(Load4(pred), _mm_slli_si128(pred_val0, 12), 12);
-    const __m128i obmc_pred_val = LoadLo8(obmc_pred);
-    const __m128i terms = _mm_unpacklo_epi8(pred_val, obmc_pred_val);
-    const __m128i result =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms, masks), 6);
-    const __m128i packed_result = _mm_packus_epi16(result, result);
-    Store4(pred - prediction_stride, packed_result);
-    const int second_row_result = _mm_extract_epi32(packed_result, 1);
-    memcpy(pred, &second_row_result, sizeof(second_row_result));
-    pred += prediction_stride;
-    obmc_pred += obmc_prediction_stride << 1;
-    y -= 2;
-  } while (y != 0);
-}
-
-inline void OverlapBlendFromLeft8xH_SSE4_1(
-    uint8_t* LIBGAV1_RESTRICT const prediction,
-    const ptrdiff_t prediction_stride, const int height,
-    const uint8_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_prediction_stride = 8;
-  uint8_t* pred = prediction;
-  const uint8_t* obmc_pred = obmc_prediction;
-  const __m128i mask_inverter = _mm_set1_epi8(64);
-  const __m128i mask_val = LoadLo8(kObmcMask + 6);
-  // 64 - mask
-  const __m128i obmc_mask_val = _mm_sub_epi8(mask_inverter, mask_val);
-  const __m128i masks = _mm_unpacklo_epi8(mask_val, obmc_mask_val);
-  int y = height;
-  do {
-    const __m128i pred_val = LoadHi8(LoadLo8(pred), pred + prediction_stride);
-    const __m128i obmc_pred_val = LoadUnaligned16(obmc_pred);
-
-    const __m128i terms_lo = _mm_unpacklo_epi8(pred_val, obmc_pred_val);
-    const __m128i result_lo =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms_lo, masks), 6);
-
-    const __m128i terms_hi = _mm_unpackhi_epi8(pred_val, obmc_pred_val);
-    const __m128i result_hi =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms_hi, masks), 6);
-
-    const __m128i result = _mm_packus_epi16(result_lo, result_hi);
-    StoreLo8(pred, result);
-    pred += prediction_stride;
-    StoreHi8(pred, result);
-    pred += prediction_stride;
-    obmc_pred += obmc_prediction_stride << 1;
-    y -= 2;
-  } while (y != 0);
-}
+#include "src/dsp/x86/obmc_sse4.inc"
 
 void OverlapBlendFromLeft_SSE4_1(
     void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
@@ -191,89 +90,6 @@ void OverlapBlendFromLeft_SSE4_1(
   } while (x < width);
 }
 
-inline void OverlapBlendFromTop4xH_SSE4_1(
-    uint8_t* LIBGAV1_RESTRICT const prediction,
-    const ptrdiff_t prediction_stride, const int height,
-    const uint8_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_prediction_stride = 4;
-  uint8_t* pred = prediction;
-  const uint8_t* obmc_pred = obmc_prediction;
-  const __m128i mask_inverter = _mm_set1_epi16(64);
-  const __m128i mask_shuffler = _mm_set_epi32(0x01010101, 0x01010101, 0, 0);
-  const __m128i mask_preinverter = _mm_set1_epi16(-256 | 1);
-
-  const uint8_t* mask = kObmcMask + height - 2;
-  const int compute_height = height - (height >> 2);
-  int y = 0;
-  do {
-    // First mask in the first half, second mask in the second half.
-    const __m128i mask_val = _mm_shuffle_epi8(
-        _mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(mask + y)),
-        mask_shuffler);
-    const __m128i masks =
-        _mm_sub_epi8(mask_inverter, _mm_sign_epi8(mask_val, mask_preinverter));
-    const __m128i pred_val0 = Load4(pred);
-
-    const __m128i obmc_pred_val = LoadLo8(obmc_pred);
-    pred += prediction_stride;
-    const __m128i pred_val =
-        _mm_alignr_epi8(Load4(pred), _mm_slli_si128(pred_val0, 12), 12);
-    const __m128i terms = _mm_unpacklo_epi8(obmc_pred_val, pred_val);
-    const __m128i result =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms, masks), 6);
-
-    const __m128i packed_result = _mm_packus_epi16(result, result);
-    Store4(pred - prediction_stride, packed_result);
-    Store4(pred, _mm_srli_si128(packed_result, 4));
-    pred += prediction_stride;
-    obmc_pred += obmc_prediction_stride << 1;
-    y += 2;
-  } while (y < compute_height);
-}
-
-inline void OverlapBlendFromTop8xH_SSE4_1(
-    uint8_t* LIBGAV1_RESTRICT const prediction,
-    const ptrdiff_t prediction_stride, const int height,
-    const uint8_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_prediction_stride = 8;
-  uint8_t* pred = prediction;
-  const uint8_t* obmc_pred = obmc_prediction;
-  const uint8_t* mask = kObmcMask + height - 2;
-  const __m128i mask_inverter = _mm_set1_epi8(64);
-  const int compute_height = height - (height >> 2);
-  int y = compute_height;
-  do {
-    const __m128i mask_val0 = _mm_set1_epi8(mask[compute_height - y]);
-    // 64 - mask
-    const __m128i obmc_mask_val0 = _mm_sub_epi8(mask_inverter, mask_val0);
-    const __m128i masks0 = _mm_unpacklo_epi8(mask_val0, obmc_mask_val0);
-
-    const __m128i pred_val = LoadHi8(LoadLo8(pred), pred + prediction_stride);
-    const __m128i obmc_pred_val = LoadUnaligned16(obmc_pred);
-
-    const __m128i terms_lo = _mm_unpacklo_epi8(pred_val, obmc_pred_val);
-    const __m128i result_lo =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms_lo, masks0), 6);
-
-    --y;
-    const __m128i mask_val1 = _mm_set1_epi8(mask[compute_height - y]);
-    // 64 - mask
-    const __m128i obmc_mask_val1 = _mm_sub_epi8(mask_inverter, mask_val1);
-    const __m128i masks1 = _mm_unpacklo_epi8(mask_val1, obmc_mask_val1);
-
-    const __m128i terms_hi = _mm_unpackhi_epi8(pred_val, obmc_pred_val);
-    const __m128i result_hi =
-        RightShiftWithRounding_U16(_mm_maddubs_epi16(terms_hi, masks1), 6);
-
-    const __m128i result = _mm_packus_epi16(result_lo, result_hi);
-    StoreLo8(pred, result);
-    pred += prediction_stride;
-    StoreHi8(pred, result);
-    pred += prediction_stride;
-    obmc_pred += obmc_prediction_stride << 1;
-  } while (--y > 0);
-}
-
 void OverlapBlendFromTop_SSE4_1(
     void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
     const int width, const int height,
@@ -340,71 +156,7 @@ namespace high_bitdepth {
 namespace {
 
 #include "src/dsp/obmc.inc"
-
-constexpr int kRoundBitsObmcBlend = 6;
-
-inline void OverlapBlendFromLeft2xH_SSE4_1(
-    uint16_t* LIBGAV1_RESTRICT const prediction, const ptrdiff_t pred_stride,
-    const int height, const uint16_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_pred_stride = 2;
-  uint16_t* pred = prediction;
-  const uint16_t* obmc_pred = obmc_prediction;
-  const ptrdiff_t pred_stride2 = pred_stride << 1;
-  const ptrdiff_t obmc_pred_stride2 = obmc_pred_stride << 1;
-  const __m128i mask_inverter = _mm_cvtsi32_si128(0x40404040);
-  const __m128i mask_val = _mm_shufflelo_epi16(Load2(kObmcMask), 0x00);
-  // 64 - mask.
-  const __m128i obmc_mask_val = _mm_sub_epi8(mask_inverter, mask_val);
-  const __m128i masks =
-      _mm_cvtepi8_epi16(_mm_unpacklo_epi8(mask_val, obmc_mask_val));
-  int y = height;
-  do {
-    const __m128i pred_val = Load4x2(pred, pred + pred_stride);
-    const __m128i obmc_pred_val = LoadLo8(obmc_pred);
-    const __m128i terms = _mm_unpacklo_epi16(pred_val, obmc_pred_val);
-    const __m128i result = RightShiftWithRounding_U32(
-        _mm_madd_epi16(terms, masks), kRoundBitsObmcBlend);
-    const __m128i packed_result = _mm_packus_epi32(result, result);
-    Store4(pred, packed_result);
-    Store4(pred + pred_stride, _mm_srli_si128(packed_result, 4));
-    pred += pred_stride2;
-    obmc_pred += obmc_pred_stride2;
-    y -= 2;
-  } while (y != 0);
-}
-
-inline void OverlapBlendFromLeft4xH_SSE4_1(
-    uint16_t* LIBGAV1_RESTRICT const prediction, const ptrdiff_t pred_stride,
-    const int height, const uint16_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_pred_stride = 4;
-  uint16_t* pred = prediction;
-  const uint16_t* obmc_pred = obmc_prediction;
-  const ptrdiff_t pred_stride2 = pred_stride << 1;
-  const ptrdiff_t obmc_pred_stride2 = obmc_pred_stride << 1;
-  const __m128i mask_inverter = _mm_cvtsi32_si128(0x40404040);
-  const __m128i mask_val = Load4(kObmcMask + 2);
-  // 64 - mask.
-  const __m128i obmc_mask_val = _mm_sub_epi8(mask_inverter, mask_val);
-  const __m128i masks =
-      _mm_cvtepi8_epi16(_mm_unpacklo_epi8(mask_val, obmc_mask_val));
-  int y = height;
-  do {
-    const __m128i pred_val = LoadHi8(LoadLo8(pred), pred + pred_stride);
-    const __m128i obmc_pred_val = LoadUnaligned16(obmc_pred);
-    const __m128i terms_lo = _mm_unpacklo_epi16(pred_val, obmc_pred_val);
-    const __m128i terms_hi = _mm_unpackhi_epi16(pred_val, obmc_pred_val);
-    const __m128i result_lo = RightShiftWithRounding_U32(
-        _mm_madd_epi16(terms_lo, masks), kRoundBitsObmcBlend);
-    const __m128i result_hi = RightShiftWithRounding_U32(
-        _mm_madd_epi16(terms_hi, masks), kRoundBitsObmcBlend);
-    const __m128i packed_result = _mm_packus_epi32(result_lo, result_hi);
-    StoreLo8(pred, packed_result);
-    StoreHi8(pred + pred_stride, packed_result);
-    pred += pred_stride2;
-    obmc_pred += obmc_pred_stride2;
-    y -= 2;
-  } while (y != 0);
-}
+#include "src/dsp/x86/obmc_sse4.inc"
 
 void OverlapBlendFromLeft10bpp_SSE4_1(
     void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
@@ -458,46 +210,6 @@ void OverlapBlendFromLeft10bpp_SSE4_1(
   } while (x < width);
 }
 
-inline void OverlapBlendFromTop4xH_SSE4_1(
-    uint16_t* LIBGAV1_RESTRICT const prediction, const ptrdiff_t pred_stride,
-    const int height, const uint16_t* LIBGAV1_RESTRICT const obmc_prediction) {
-  constexpr int obmc_pred_stride = 4;
-  uint16_t* pred = prediction;
-  const uint16_t* obmc_pred = obmc_prediction;
-  const __m128i mask_inverter = _mm_set1_epi16(64);
-  const __m128i mask_shuffler = _mm_set_epi32(0x01010101, 0x01010101, 0, 0);
-  const __m128i mask_preinverter = _mm_set1_epi16(-256 | 1);
-  const uint8_t* mask = kObmcMask + height - 2;
-  const int compute_height = height - (height >> 2);
-  const ptrdiff_t pred_stride2 = pred_stride << 1;
-  const ptrdiff_t obmc_pred_stride2 = obmc_pred_stride << 1;
-  int y = 0;
-  do {
-    // First mask in the first half, second mask in the second half.
-    const __m128i mask_val = _mm_shuffle_epi8(Load4(mask + y), mask_shuffler);
-    const __m128i masks =
-        _mm_sub_epi8(mask_inverter, _mm_sign_epi8(mask_val, mask_preinverter));
-    const __m128i masks_lo = _mm_cvtepi8_epi16(masks);
-    const __m128i masks_hi = _mm_cvtepi8_epi16(_mm_srli_si128(masks, 8));
-
-    const __m128i pred_val = LoadHi8(LoadLo8(pred), pred + pred_stride);
-    const __m128i obmc_pred_val = LoadUnaligned16(obmc_pred);
-    const __m128i terms_lo = _mm_unpacklo_epi16(obmc_pred_val, pred_val);
-    const __m128i terms_hi = _mm_unpackhi_epi16(obmc_pred_val, pred_val);
-    const __m128i result_lo = RightShiftWithRounding_U32(
-        _mm_madd_epi16(terms_lo, masks_lo), kRoundBitsObmcBlend);
-    const __m128i result_hi = RightShiftWithRounding_U32(
-        _mm_madd_epi16(terms_hi, masks_hi), kRoundBitsObmcBlend);
-    const __m128i packed_result = _mm_packus_epi32(result_lo, result_hi);
-
-    StoreLo8(pred, packed_result);
-    StoreHi8(pred + pred_stride, packed_result);
-    pred += pred_stride2;
-    obmc_pred += obmc_pred_stride2;
-    y += 2;
-  } while (y < compute_height);
-}
-
 void OverlapBlendFromTop10bpp_SSE4_1(
     void* LIBGAV1_RESTRICT const prediction, const ptrdiff_t prediction_stride,
     const int width, const int height,
@@ -0,0 +1,304 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/dsp/weight_mask.h"
+#include "src/utils/cpu.h"
+
+#if LIBGAV1_TARGETING_AVX2
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "src/dsp/constants.h"
+#include "src/dsp/dsp.h"
+#include "src/dsp/x86/common_avx2.h"
+#include "src/utils/common.h"
+
+namespace libgav1 {
+namespace dsp {
+namespace {
+
+constexpr int kDifferenceOffset = 38;
+constexpr int kMaskCeiling = 64;
+
+// Converts 32 scaled differences, held as 16-bit values, to mask values.
+template <bool mask_is_inverse>
+inline __m256i GetMask32(const __m256i& scaled_difference_0,
+                         const __m256i& scaled_difference_1) {
+  // _mm256_packus_epi16() works within 128-bit lanes, restore the order.
+  const __m256i scaled_difference = _mm256_permute4x64_epi64(
+      _mm256_packus_epi16(scaled_difference_0, scaled_difference_1), 0xd8);
+  const __m256i mask_ceiling = _mm256_set1_epi8(kMaskCeiling);
+  const __m256i mask_value = _mm256_min_epu8(
+      _mm256_adds_epu8(scaled_difference,
+                       _mm256_set1_epi8(kDifferenceOffset)),
+      mask_ceiling);
+  return mask_is_inverse ? _mm256_sub_epi8(mask_ceiling, mask_value)
+                         : mask_value;
+}
+
+// Computes the mask of a block whose width is at least 16. |WeightMask32|
+// returns the mask values of 32 consecutive prediction values. A block of
+// width 16 is processed two rows at a time; the predictions are contiguous.
+template <int width, int height, typename Pixel,
+          __m256i (*WeightMask32)(const Pixel*, const Pixel*)>
+inline void WeightMaskWxH(const void* LIBGAV1_RESTRICT prediction_0,
+                          const void* LIBGAV1_RESTRICT prediction_1,
+                          uint8_t* LIBGAV1_RESTRICT mask,
+                          const ptrdiff_t mask_stride) {
+  static_assert(width >= 16, "");
+  const auto* pred_0 = static_cast<const Pixel*>(prediction_0);
+  const auto* pred_1 = static_cast<const Pixel*>(prediction_1);
+  int y = height;
+
+  if (width == 16) {
+    do {
+      const __m256i mask_value = WeightMask32(pred_0, pred_1);
+      StoreUnaligned16(mask, _mm256_castsi256_si128(mask_value));
+      StoreUnaligned16(mask + mask_stride,
+                       _mm256_extracti128_si256(mask_value, 1));
+      pred_0 += 16 << 1;
+      pred_1 += 16 << 1;
+      mask += mask_stride << 1;
+      y -= 2;
+    } while (y != 0);
+    return;
+  }
+
+  do {
+    int x = 0;
+    do {
+      StoreUnaligned32(mask + x, WeightMask32(pred_0 + x, pred_1 + x));
+      x += 32;
+    } while (x < width);
+    pred_0 += width;
+    pred_1 += width;
+    mask += mask_stride;
+  } while (--y != 0);
+}
+
+}  // namespace
+
+namespace low_bitdepth {
+namespace {
+
+constexpr int kRoundingBits8bpp = 4;
+constexpr int kScaledDiffShift = 4;
+
+inline __m256i ScaledDifference16(const int16_t* LIBGAV1_RESTRICT pred_0,
+                                  const int16_t* LIBGAV1_RESTRICT pred_1) {
+  const __m256i difference = _mm256_abs_epi16(
+      _mm256_sub_epi16(LoadUnaligned32(pred_0), LoadUnaligned32(pred_1)));
+  // The rounding and the scaling shifts are combined; the absolute difference
+  // is treated as unsigned.
+  const __m256i rounding = _mm256_set1_epi16((1 << kRoundingBits8bpp) >> 1);
+  return _mm256_srli_epi16(_mm256_add_epi16(difference, rounding),
+                           kRoundingBits8bpp + kScaledDiffShift);
+}
+
+template <bool mask_is_inverse>
+inline __m256i WeightMask32(const int16_t* LIBGAV1_RESTRICT pred_0,
+                            const int16_t* LIBGAV1_RESTRICT pred_1) {
+  return GetMask32<mask_is_inverse>(
+      ScaledDifference16(pred_0, pred_1),
+      ScaledDifference16(pred_0 + 16, pred_1 + 16));
+}
+
+template <int width, int height, bool mask_is_inverse>
+void WeightMask_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                     const void* LIBGAV1_RESTRICT prediction_1,
+                     uint8_t* LIBGAV1_RESTRICT mask,
+                     const ptrdiff_t mask_stride) {
+  WeightMaskWxH<width, height, int16_t, WeightMask32<mask_is_inverse>>(
+      prediction_0, prediction_1, mask, mask_stride);
+}
+
+#define INIT_WEIGHT_MASK(width, height, w_index, h_index)                   \
+  dsp->weight_mask[w_index][h_index][0] = WeightMask_AVX2<width, height, 0>; \
+  dsp->weight_mask[w_index][h_index][1] = WeightMask_AVX2<width, height, 1>
+void Init8bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth8);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_16x8)
+  INIT_WEIGHT_MASK(16, 8, 1, 0);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_16x16)
+  INIT_WEIGHT_MASK(16, 16, 1, 1);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_16x32)
+  INIT_WEIGHT_MASK(16, 32, 1, 2);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_16x64)
+  INIT_WEIGHT_MASK(16, 64, 1, 3);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_32x8)
+  INIT_WEIGHT_MASK(32, 8, 2, 0);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_32x16)
+  INIT_WEIGHT_MASK(32, 16, 2, 1);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_32x32)
+  INIT_WEIGHT_MASK(32, 32, 2, 2);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_32x64)
+  INIT_WEIGHT_MASK(32, 64, 2, 3);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_64x16)
+  INIT_WEIGHT_MASK(64, 16, 3, 1);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_64x32)
+  INIT_WEIGHT_MASK(64, 32, 3, 2);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_64x64)
+  INIT_WEIGHT_MASK(64, 64, 3, 3);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_64x128)
+  INIT_WEIGHT_MASK(64, 128, 3, 4);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_128x64)
+  INIT_WEIGHT_MASK(128, 64, 4, 3);
+#endif
+#if DSP_ENABLED_8BPP_AVX2(WeightMask_128x128)
+  INIT_WEIGHT_MASK(128, 128, 4, 4);
+#endif
+}
+#undef INIT_WEIGHT_MASK
+
+}  // namespace
+}  // namespace low_bitdepth
+
+#if LIBGAV1_MAX_BITDEPTH >= 10
+namespace high_bitdepth {
+namespace {
+
+constexpr int kRoundingBits10bpp = 6;
+constexpr int kScaledDiffShift = 4;
+
+inline __m256i ScaledDifference16(const uint16_t* LIBGAV1_RESTRICT pred_0,
+                                  const uint16_t* LIBGAV1_RESTRICT pred_1) {
+  const __m256i zero = _mm256_setzero_si256();
+  // Range of prediction: [3988, 61532].
+  const __m256i pred_00 = LoadUnaligned32(pred_0);
+  const __m256i pred_10 = LoadUnaligned32(pred_1);
+  const __m256i difference_lo = RightShiftWithRounding_S32(
+      _mm256_abs_epi32(_mm256_sub_epi32(_mm256_unpacklo_epi16(pred_00, zero),
+                                        _mm256_unpacklo_epi16(pred_10, zero))),
+      kRoundingBits10bpp);
+  const __m256i difference_hi = RightShiftWithRounding_S32(
+      _mm256_abs_epi32(_mm256_sub_epi32(_mm256_unpackhi_epi16(pred_00, zero),
+                                        _mm256_unpackhi_epi16(pred_10, zero))),
+      kRoundingBits10bpp);
+  // The unpacks and the pack both work within 128-bit lanes, so the order is
+  // preserved.
+  return _mm256_srli_epi16(_mm256_packus_epi32(difference_lo, difference_hi),
+                           kScaledDiffShift);
+}
+
+template <bool mask_is_inverse>
+inline __m256i WeightMask32(const uint16_t* LIBGAV1_RESTRICT pred_0,
+                            const uint16_t* LIBGAV1_RESTRICT pred_1) {
+  return GetMask32<mask_is_inverse>(
+      ScaledDifference16(pred_0, pred_1),
+      ScaledDifference16(pred_0 + 16, pred_1 + 16));
+}
+
+template <int width, int height, bool mask_is_inverse>
+void WeightMask10bpp_AVX2(const void* LIBGAV1_RESTRICT prediction_0,
+                          const void* LIBGAV1_RESTRICT prediction_1,
+                          uint8_t* LIBGAV1_RESTRICT mask,
+                          const ptrdiff_t mask_stride) {
+  WeightMaskWxH<width, height, uint16_t, WeightMask32<mask_is_inverse>>(
+      prediction_0, prediction_1, mask, mask_stride);
+}
+
+#define INIT_WEIGHT_MASK(width, height, w_index, h_index) \
+  dsp->weight_mask[w_index][h_index][0] =                 \
+      WeightMask10bpp_AVX2<width, height, 0>;             \
+  dsp->weight_mask[w_index][h_index][1] =                 \
+      WeightMask10bpp_AVX2<width, height, 1>
+void Init10bpp() {
+  Dsp* const dsp = dsp_internal::GetWritableDspTable(kBitdepth10);
+  assert(dsp != nullptr);
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_16x8)
+  INIT_WEIGHT_MASK(16, 8, 1, 0);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_16x16)
+  INIT_WEIGHT_MASK(16, 16, 1, 1);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_16x32)
+  INIT_WEIGHT_MASK(16, 32, 1, 2);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_16x64)
+  INIT_WEIGHT_MASK(16, 64, 1, 3);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_32x8)
+  INIT_WEIGHT_MASK(32, 8, 2, 0);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_32x16)
+  INIT_WEIGHT_MASK(32, 16, 2, 1);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_32x32)
+  INIT_WEIGHT_MASK(32, 32, 2, 2);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_32x64)
+  INIT_WEIGHT_MASK(32, 64, 2, 3);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_64x16)
+  INIT_WEIGHT_MASK(64, 16, 3, 1);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_64x32)
+  INIT_WEIGHT_MASK(64, 32, 3, 2);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_64x64)
+  INIT_WEIGHT_MASK(64, 64, 3, 3);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_64x128)
+  INIT_WEIGHT_MASK(64, 128, 3, 4);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_128x64)
+  INIT_WEIGHT_MASK(128, 64, 4, 3);
+#endif
+#if DSP_ENABLED_10BPP_AVX2(WeightMask_128x128)
+  INIT_WEIGHT_MASK(128, 128, 4, 4);
+#endif
+}
+#undef INIT_WEIGHT_MASK
+
+}  // namespace
+}  // namespace high_bitdepth
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+
+void WeightMaskInit_AVX2() {
+  low_bitdepth::Init8bpp();
+#if LIBGAV1_MAX_BITDEPTH >= 10
+  high_bitdepth::Init10bpp();
+#endif  // LIBGAV1_MAX_BITDEPTH >= 10
+}
+
+}  // namespace dsp
+}  // namespace libgav1
+
+#else   // !LIBGAV1_TARGETING_AVX2
+
+namespace libgav1 {
+namespace dsp {
+
+void WeightMaskInit_AVX2() {}
+
+}  // namespace dsp
+}  // namespace libgav1
+#endif  // LIBGAV1_TARGETING_AVX2
@@ -31,6 +31,7 @@
 #include "src/utils/compiler_attributes.h"
 #include "src/utils/constants.h"
 #include "src/utils/logging.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/threadpool.h"
 
 namespace libgav1 {
@@ -346,7 +347,7 @@ bool FilmGrain<bitdepth>::Init() {
       const size_t buffer_size =
           kScalingLutLength * (static_cast<int>(params_.num_u_points > 0) +
                                static_cast<int>(params_.num_v_points > 0));
-      scaling_lut_chroma_buffer_.reset(new (std::nothrow) int16_t[buffer_size]);
+      scaling_lut_chroma_buffer_ = MakeUniqueArray<int16_t>(buffer_size);
       if (scaling_lut_chroma_buffer_ == nullptr) return false;
 
       int16_t* buffer = scaling_lut_chroma_buffer_.get();
@@ -451,7 +452,7 @@ bool FilmGrain<bitdepth>::AllocateNoiseStripes() {
                          (kNoiseStripeHeight >> subsampling_y_) *
                          SubsampledValue(width_, subsampling_x_);
   }
-  noise_buffer_.reset(new (std::nothrow) GrainType[noise_buffer_size]);
+  noise_buffer_ = MakeUniqueArray<GrainType>(noise_buffer_size);
   if (noise_buffer_ == nullptr) return false;
   GrainType* noise_buffer = noise_buffer_.get();
   if (params_.num_y_points > 0) {
@@ -553,6 +554,7 @@ void FilmGrain<bitdepth>::BlendNoiseChromaWorker(
     ptrdiff_t source_stride_uv, uint8_t* dest_plane_u, uint8_t* dest_plane_v,
     ptrdiff_t dest_stride_uv) {
   assert(num_planes > 0);
+  const ScopedPerfStage perf_stage(kPerfStageFilmGrain);
   const int full_jobs_per_plane = height_ / kFrameChunkHeight;
   const int remainder_job_height = height_ & (kFrameChunkHeight - 1);
   const int total_full_jobs = full_jobs_per_plane * num_planes;
@@ -606,6 +608,7 @@ void FilmGrain<bitdepth>::BlendNoiseLumaWorker(
     const dsp::Dsp& dsp, std::atomic<int>* job_counter, int min_value,
     int max_luma, const uint8_t* source_plane_y, ptrdiff_t source_stride_y,
     uint8_t* dest_plane_y, ptrdiff_t dest_stride_y) {
+  const ScopedPerfStage perf_stage(kPerfStageFilmGrain);
   const int total_full_jobs = height_ / kFrameChunkHeight;
   const int remainder_job_height = height_ & (kFrameChunkHeight - 1);
   const int total_jobs =
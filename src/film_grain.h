@@ -29,6 +29,7 @@
 #include "src/utils/array_2d.h"
 #include "src/utils/constants.h"
 #include "src/utils/cpu.h"
+#include "src/utils/memory.h"
 #include "src/utils/threadpool.h"
 #include "src/utils/types.h"
 #include "src/utils/vector.h"
@@ -167,7 +168,7 @@ class FilmGrain {
   // If allocated, this buffer is 256 * 2 values long and scaling_lut_u_ and
   // scaling_lut_v_ point into this buffer. Otherwise, scaling_lut_u_ and
   // scaling_lut_v_ point to scaling_lut_y_.
-  std::unique_ptr<int16_t[]> scaling_lut_chroma_buffer_;
+  UniqueArrayPtr<int16_t> scaling_lut_chroma_buffer_;
 
   // A two-dimensional array of noise data for each plane. Generated for each 32
   // luma sample high stripe of the image. The first dimension is called
@@ -187,7 +188,7 @@ class FilmGrain {
   // chroma components.
   Array2DView<GrainType> noise_stripes_[kMaxPlanes];
   // Owns the memory that the elements of noise_stripes_ point to.
-  std::unique_ptr<GrainType[]> noise_buffer_;
+  UniqueArrayPtr<GrainType> noise_buffer_;
 
   Array2D<GrainType> noise_image_[kMaxPlanes];
   ThreadPool* const thread_pool_;
@@ -19,6 +19,7 @@
 
 #include <array>
 #include <condition_variable>  // NOLINT (unapproved c++11 header)
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>  // NOLINT (unapproved c++11 header)
@@ -38,15 +39,46 @@
 #include "src/utils/memory.h"
 #include "src/utils/stack.h"
 #include "src/utils/types.h"
+#include "src/utils/vector.h"
 #include "src/yuv_buffer.h"
 
 namespace libgav1 {
 
+class Tile;
+
 // Buffer used to store the unfiltered pixels that are necessary for decoding
 // the next superblock row (for the intra prediction process).
 using IntraPredictionBuffer =
     std::array<AlignedDynamicBuffer<uint8_t, kMaxAlignment>, kMaxPlanes>;
 
+// Compressed size and measured decoding time of a tile. Used to estimate the
+// cost of the tile at the same position in the next frame.
+struct TileCost {
+  size_t size;
+  int64_t microseconds;
+};
+
+// The memory of a Tile and of its buffers. It is kept in the
+// FrameScratchBuffer so that the tile with the same number in the next frame
+// reuses it instead of allocating it again. See Tile::Create().
+struct TileStorage {
+  // Tile::Create() constructs the Tile object in this buffer.
+  AlignedDynamicBuffer<uint8_t, kMaxAlignment> tile;
+  std::array<Array2D<uint8_t>, 2> coefficient_levels;
+  std::array<Array2D<int8_t>, 2> dc_categories;
+  AlignedDynamicBuffer<uint8_t, 32> residual_buffer;
+  std::unique_ptr<PredictionParameters> prediction_parameters;
+  DynamicBuffer<BlockCdfContext> top_context;
+};
+
+// Destroys a Tile that was constructed in a TileStorage and leaves its memory
+// to the TileStorage. Defined in tile.cc.
+struct TileDeleter {
+  void operator()(Tile* tile) const;
+};
+
+using TilePtr = std::unique_ptr<Tile, TileDeleter>;
+
 // Buffer to facilitate decoding a frame. This struct is used only within
 // DecoderImpl::DecodeTiles().
 // The alignment requirement is due to the SymbolDecoderContext member
@@ -68,6 +100,13 @@ struct FrameScratchBuffer : public MaxAlignedAllocable {
   // * For the 4x4 block at column4x4 the bit index is (column4x4 >> 1).
   Array2D<uint8_t> cdef_skip;
   Array2D<TransformSize> inter_transform_sizes;
+  // Deblocking filter edge information, indexed by loop filter type and plane.
+  // Each entry describes the edge on the left (vertical) or top (horizontal)
+  // border of a 4x4 block in the corresponding plane. The entries are filled
+  // in while the tiles are parsed. They are zeroed for each frame, and only the
+  // positions with an edge are written. See PostFilter::StoreDeblockEdges() for
+  // the encoding.
+  Array2D<uint8_t> deblock_edges[kNumLoopFilterTypes][kMaxPlanes];
   BlockParametersHolder block_parameters_holder;
   TemporalMotionField motion_field;
   SymbolDecoderContext symbol_decoder_context;
@@ -100,6 +139,20 @@ struct FrameScratchBuffer : public MaxAlignedAllocable {
   DynamicBuffer<std::condition_variable> superblock_row_progress_condvar;
   // Used to signal tile decoding failure in the combined multithreading mode.
   bool tile_decoding_failed LIBGAV1_GUARDED_BY(superblock_row_mutex);
+  // The size of these buffers is the number of tiles. |tile_order| contains
+  // the tile indices in the order in which the tiles are handed out to the
+  // threads. |tile_costs| contains the cost of each tile of the last frame that
+  // was decoded using this buffer (the first |tile_cost_count| entries are
+  // valid).
+  DynamicBuffer<int> tile_order;
+  DynamicBuffer<TileCost> tile_costs;
+  int tile_cost_count = 0;
+  // The size of this buffer is at least the number of tiles. It is indexed by
+  // the tile number.
+  DynamicBuffer<TileStorage> tile_storage;
+  // The tiles of the frame that is being decoded. It is empty outside of
+  // DecoderImpl::DecodeTiles(), which keeps its capacity for the next frame.
+  Vector<TilePtr> tiles;
 };
 
 class FrameScratchBufferPool {
@@ -120,6 +173,18 @@ class FrameScratchBufferPool {
     buffers_.Push(std::move(scratch_buffer));
   }
 
+  // Frees the buffers of the pool except for the |count| buffers at the top.
+  // None of the buffers may be in use.
+  void Shrink(int count) {
+    Stack<std::unique_ptr<FrameScratchBuffer>, kMaxThreads> kept_buffers;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < count && !buffers_.Empty(); ++i) {
+      kept_buffers.Push(buffers_.Pop());
+    }
+    while (!buffers_.Empty()) buffers_.Pop();
+    while (!kept_buffers.Empty()) buffers_.Push(kept_buffers.Pop());
+  }
+
  private:
   std::mutex mutex_;
   Stack<std::unique_ptr<FrameScratchBuffer>, kMaxThreads> buffers_
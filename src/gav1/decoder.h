@@ -31,6 +31,7 @@
 #include "gav1/decoder_buffer.h"
 #include "gav1/decoder_settings.h"
 #include "gav1/frame_buffer.h"
+#include "gav1/perf_counters.h"
 #include "gav1/status_code.h"
 #include "gav1/symbol_visibility.h"
 #include "gav1/version.h"
@@ -55,9 +56,23 @@ LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderEnqueueFrame(
 LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderDequeueFrame(
     Libgav1Decoder* decoder, const Libgav1DecoderBuffer** out_ptr);
 
+LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderFlush(Libgav1Decoder* decoder);
+
+LIBGAV1_PUBLIC Libgav1StatusCode
+Libgav1DecoderSetThreads(Libgav1Decoder* decoder, int threads);
+
+LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderHoldFrame(
+    Libgav1Decoder* decoder, const Libgav1DecoderBuffer** out_ptr);
+
+LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderReleaseFrame(
+    Libgav1Decoder* decoder, const Libgav1DecoderBuffer* buffer);
+
 LIBGAV1_PUBLIC Libgav1StatusCode
 Libgav1DecoderSignalEOS(Libgav1Decoder* decoder);
 
+LIBGAV1_PUBLIC Libgav1StatusCode Libgav1DecoderGetPerfCounters(
+    const Libgav1Decoder* decoder, Libgav1PerfCounters* perf_counters);
+
 LIBGAV1_PUBLIC int Libgav1DecoderGetMaxBitdepth(void);
 
 #if defined(__cplusplus)
@@ -122,6 +137,69 @@ class LIBGAV1_PUBLIC Decoder {
   // call will block until an enqueued frame has been decoded.
   StatusCode DequeueFrame(const DecoderBuffer** out_ptr);
 
+  // Discards all the enqueued frames and the frames that have not been
+  // dequeued yet, and clears the reference frames so that decoding can resume
+  // at a random access point (for example, after a seek). The sequence header
+  // that was last seen is retained.
+  //
+  // In frame parallel mode, the frames that are being decoded are aborted
+  // (they stop at the next superblock row) instead of being decoded to
+  // completion, so the latency of this call does not depend on the number of
+  // frames in flight. |settings_.release_input_buffer| is called for every
+  // discarded input buffer that has not been released yet.
+  //
+  // The frames held through |HoldFrame()| remain valid. The pointer obtained by
+  // the prior DequeueFrame call will no longer be valid.
+  //
+  // Returns kStatusOk on success, an error status if the decoder has already
+  // failed (in which case |SignalEOS()| must be used to reset it).
+  StatusCode Flush();
+
+  // Changes the number of threads used for decoding to |threads| without
+  // recreating the decoder. |threads| has the same meaning as
+  // |DecoderSettings::threads| and the new value is retained across
+  // |SignalEOS()|.
+  //
+  // In non-frame-parallel mode, the new value takes effect when the next frame
+  // is decoded. In frame parallel mode, this function waits for the frames in
+  // flight to finish decoding and then recomputes the number of frames that
+  // are decoded in parallel and the worker threads of each frame. The decoder
+  // stays in frame parallel mode, with a single frame in flight if |threads| is
+  // too small for decoding several frames in parallel.
+  //
+  // Note: In frame parallel mode this call blocks until all the frames that
+  // have been enqueued are decoded, i.e., it drains the decoding pipeline. The
+  // decoded frames can still be dequeued afterwards.
+  //
+  // Returns kStatusOk on success. Returns kStatusInvalidArgument if |threads|
+  // is not greater than 0 or if |threads| is more than 1 in the parse_only
+  // mode. Returns one of the other error statuses if there is an error. If the
+  // threads for the new value cannot be created, the decoder keeps decoding
+  // with the previous number of threads.
+  StatusCode SetThreads(int threads);
+
+  // Takes a reference to the frame returned by the most recent successful
+  // |DequeueFrame()| call. On success, sets |*out_ptr| to a DecoderBuffer that
+  // describes the same frame (including |user_private_data|) and that remains
+  // valid until it is passed to |ReleaseFrame()|. Subsequent |DequeueFrame()|
+  // calls do not invalidate it and the frame buffer is not reused by the
+  // decoder while it is held, so an application can keep several output frames
+  // alive without copying them.
+  //
+  // Returns kStatusOk on success. Returns kStatusNothingToDequeue if the most
+  // recent |DequeueFrame()| call did not return a frame. Returns one of the
+  // other error statuses if there is an error.
+  //
+  // NOTE: All the held frames are released by |SignalEOS()| and when the
+  // decoder is destroyed. The DecoderBuffers obtained from this function will
+  // no longer be valid after those calls.
+  StatusCode HoldFrame(const DecoderBuffer** out_ptr);
+
+  // Releases a frame obtained from |HoldFrame()|. |buffer| is no longer valid
+  // after this call. Returns kStatusInvalidArgument if |buffer| is not a
+  // currently held frame.
+  StatusCode ReleaseFrame(const DecoderBuffer* buffer);
+
   // Signals the end of stream.
   //
   // In non-frame-parallel mode, this function will release all the frames held
@@ -134,6 +212,18 @@ class LIBGAV1_PUBLIC Decoder {
   // and the decoder is ready to start decoding a new coded video sequence.
   StatusCode SignalEOS();
 
+  // Copies the hardware performance counter values accumulated per decoding
+  // stage since the decoder was initialized or since the last |SignalEOS()|
+  // call into |*perf_counters|. The counts of a frame are complete once it
+  // has been dequeued.
+  //
+  // Returns kStatusOk on success. Returns kStatusUnimplemented if
+  // |settings_.collect_perf_counters| is false, if the library was built
+  // without LIBGAV1_ENABLE_PERF_COUNTERS or if the counters cannot be opened
+  // (for example on a system other than Linux, or when access to them is
+  // restricted by /proc/sys/kernel/perf_event_paranoid).
+  StatusCode GetPerfCounters(PerfCounters* perf_counters) const;
+
   // Returns the maximum bitdepth that is supported by this decoder.
   static int GetMaxBitdepth();
 
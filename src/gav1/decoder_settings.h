@@ -18,8 +18,10 @@
 #define LIBGAV1_SRC_GAV1_DECODER_SETTINGS_H_
 
 #if defined(__cplusplus)
+#include <cstddef>
 #include <cstdint>
 #else
+#include <stddef.h>
 #include <stdint.h>
 #endif  // defined(__cplusplus)
 
@@ -40,6 +42,27 @@ extern "C" {
 typedef void (*Libgav1ReleaseInputBufferCallback)(void* callback_private_data,
                                                   void* buffer_private_data);
 
+// Memory allocation callbacks. If set, the decoder allocates its internal
+// memory, including the frame buffers unless the get_frame_buffer callback is
+// set, with these callbacks instead of the global heap.
+// |allocator_private_data| is the allocator_private_data field of the
+// settings.
+//
+// Returns a block of at least |size| bytes suitably aligned for any scalar type
+// (like malloc()), or NULL on failure.
+typedef void* (*Libgav1AllocateMemoryCallback)(void* allocator_private_data,
+                                               size_t size);
+// Returns a block of at least |size| bytes aligned to |alignment|, which is a
+// power of 2 greater than the alignment guaranteed by the allocate callback,
+// or NULL on failure.
+typedef void* (*Libgav1AllocateAlignedMemoryCallback)(
+    void* allocator_private_data, size_t alignment, size_t size);
+// Frees a block returned by either allocation callback. May be called on any
+// of the decoder's threads and, until the decoder is destroyed, from any of
+// its entry points.
+typedef void (*Libgav1FreeMemoryCallback)(void* allocator_private_data,
+                                          void* ptr);
+
 typedef struct Libgav1DecoderSettings {
   // Number of threads to use when decoding. Must be greater than 0. The library
   // will create at most |threads| new threads. Defaults to 1 (no new threads
@@ -86,6 +109,49 @@ typedef struct Libgav1DecoderSettings {
   // A boolean. If set to 1, the decoder will only parse the bitstream, i.e., no
   // decoding will take place.
   int parse_only;
+  // A boolean. If set to 1 and frame parallel decoding is not in use, the
+  // decoder throttles its thread count: it measures the time spent in each
+  // stage of decoding the recent frames and uses up to |threads| threads
+  // depending on how expensive they are. Frames that are too cheap to benefit
+  // from multi-threading are decoded in the calling thread. The split of the
+  // threads between the decoding stages is not changed. If |threads| is 1,
+  // this setting is ignored.
+  int adaptive_threading;
+  // Memory allocation callbacks. If |allocate_memory| is NULL (the default),
+  // the global heap is used. Otherwise |free_memory| must also be set.
+  // |allocate_aligned_memory| is optional; without it aligned blocks are
+  // carved out of larger blocks from |allocate_memory|.
+  Libgav1AllocateMemoryCallback allocate_memory;
+  Libgav1AllocateAlignedMemoryCallback allocate_aligned_memory;
+  Libgav1FreeMemoryCallback free_memory;
+  // Passed as the allocator_private_data argument to the memory allocation
+  // callbacks.
+  void* allocator_private_data;
+  // The largest frame size expected in the stream, including across sequence
+  // headers. This is a hint, larger frames are still decoded. If set, the
+  // decoder allocates its per-frame buffers, and the frame buffers unless
+  // get_frame_buffer is set, for this size up front, so that resolution
+  // switches within it do not reallocate memory. If both are 0 (the
+  // default), the buffers grow with the largest frame decoded so far.
+  int max_frame_width;
+  int max_frame_height;
+  // A boolean. If set to 1, the decoder counts the CPU cycles, instructions,
+  // last level cache misses and branch misses spent in each decoding stage
+  // using the Linux perf_event_open() interface. The counts are returned by
+  // Libgav1DecoderGetPerfCounters(). This requires the library to be built
+  // with LIBGAV1_ENABLE_PERF_COUNTERS and is ignored if the counters are not
+  // available.
+  int collect_perf_counters;
+  // Maximum number of frames that are decoded in parallel in frame parallel
+  // mode. This bounds the memory used for the frames in flight and the number
+  // of frames that can be enqueued before a frame has to be dequeued (i.e. the
+  // output latency). The threads that are not used for decoding separate
+  // frames are used within each frame. A value of 1 disables frame parallel
+  // decoding. 0 (the default) lets the decoder choose based on |threads| and
+  // the video stream.
+  //
+  // If frame_parallel is 0, this setting is ignored.
+  int max_frames_in_flight;
 } Libgav1DecoderSettings;
 
 LIBGAV1_PUBLIC void Libgav1DecoderSettingsInitDefault(
@@ -97,6 +163,9 @@ LIBGAV1_PUBLIC void Libgav1DecoderSettingsInitDefault(
 namespace libgav1 {
 
 using ReleaseInputBufferCallback = Libgav1ReleaseInputBufferCallback;
+using AllocateMemoryCallback = Libgav1AllocateMemoryCallback;
+using AllocateAlignedMemoryCallback = Libgav1AllocateAlignedMemoryCallback;
+using FreeMemoryCallback = Libgav1FreeMemoryCallback;
 
 // Applications must populate this structure before creating a decoder instance.
 struct DecoderSettings {
@@ -145,6 +214,49 @@ struct DecoderSettings {
   // If set to true, the decoder will only parse the bitstream, i.e., no
   // decoding will take place.
   bool parse_only = false;
+  // If set to true and frame parallel decoding is not in use, the decoder
+  // throttles its thread count: it measures the time spent in each stage of
+  // decoding the recent frames and uses up to |threads| threads depending on
+  // how expensive they are. Frames that are too cheap to benefit from
+  // multi-threading are decoded in the calling thread. The split of the
+  // threads between the decoding stages is not changed. If |threads| is 1,
+  // this setting is ignored.
+  bool adaptive_threading = false;
+  // Memory allocation callbacks. If |allocate_memory| is nullptr (the
+  // default), the global heap is used. Otherwise |free_memory| must also be
+  // set. |allocate_aligned_memory| is optional; without it aligned blocks are
+  // carved out of larger blocks from |allocate_memory|.
+  AllocateMemoryCallback allocate_memory = nullptr;
+  AllocateAlignedMemoryCallback allocate_aligned_memory = nullptr;
+  FreeMemoryCallback free_memory = nullptr;
+  // Passed as the allocator_private_data argument to the memory allocation
+  // callbacks.
+  void* allocator_private_data = nullptr;
+  // The largest frame size expected in the stream, including across sequence
+  // headers. This is a hint, larger frames are still decoded. If set, the
+  // decoder allocates its per-frame buffers, and the frame buffers unless
+  // get_frame_buffer is set, for this size up front, so that resolution
+  // switches within it do not reallocate memory. If both are 0 (the
+  // default), the buffers grow with the largest frame decoded so far.
+  int max_frame_width = 0;
+  int max_frame_height = 0;
+  // If set to true, the decoder counts the CPU cycles, instructions, last
+  // level cache misses and branch misses spent in each decoding stage using
+  // the Linux perf_event_open() interface. The counts are returned by
+  // Decoder::GetPerfCounters(). This requires the library to be built with
+  // LIBGAV1_ENABLE_PERF_COUNTERS and is ignored if the counters are not
+  // available.
+  bool collect_perf_counters = false;
+  // Maximum number of frames that are decoded in parallel in frame parallel
+  // mode. This bounds the memory used for the frames in flight and the number
+  // of frames that can be enqueued before a frame has to be dequeued (i.e. the
+  // output latency). The threads that are not used for decoding separate
+  // frames are used within each frame. A value of 1 disables frame parallel
+  // decoding. 0 (the default) lets the decoder choose based on |threads| and
+  // the video stream.
+  //
+  // If frame_parallel is false, this setting is ignored.
+  int max_frames_in_flight = 0;
 };
 
 }  // namespace libgav1
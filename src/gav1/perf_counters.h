@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 The libgav1 Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBGAV1_SRC_GAV1_PERF_COUNTERS_H_
+#define LIBGAV1_SRC_GAV1_PERF_COUNTERS_H_
+
+#if defined(__cplusplus)
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif  // defined(__cplusplus)
+
+// All the declarations in this file are part of the public ABI.
+
+// The decoder stages that hardware performance counters are attributed to
+// when DecoderSettings::collect_perf_counters is set. The work that is done
+// outside of these stages (for example frame setup, motion field projection
+// and border extension) is not counted.
+typedef enum Libgav1PerfStage {
+  // OBU and header parsing, and reading the mode info and the transform
+  // coefficients of the blocks.
+  kLibgav1PerfStageParse,
+  // Intra and inter prediction.
+  kLibgav1PerfStagePredict,
+  // Inverse transforms and the reconstruction of the residual.
+  kLibgav1PerfStageReconstruct,
+  kLibgav1PerfStageDeblock,
+  kLibgav1PerfStageCdef,
+  kLibgav1PerfStageSuperRes,
+  kLibgav1PerfStageLoopRestoration,
+  kLibgav1PerfStageFilmGrain,
+  kLibgav1NumPerfStages
+} Libgav1PerfStage;
+
+typedef enum Libgav1PerfCounter {
+  kLibgav1PerfCounterCycles,
+  kLibgav1PerfCounterInstructions,
+  kLibgav1PerfCounterLlcMisses,
+  kLibgav1PerfCounterBranchMisses,
+  kLibgav1NumPerfCounters
+} Libgav1PerfCounter;
+
+// The counts accumulated by all the threads of a decoder since it was created
+// or since the last SignalEOS() call. Only user space events are counted.
+typedef struct Libgav1PerfCounters {
+  // Bit i is set if counter i (a Libgav1PerfCounter) could be opened on at
+  // least one of the decoding threads. The counts of the other counters are 0.
+  int available_counters;
+  int64_t counts[kLibgav1NumPerfStages][kLibgav1NumPerfCounters];
+} Libgav1PerfCounters;
+
+#if defined(__cplusplus)
+namespace libgav1 {
+
+using PerfStage = Libgav1PerfStage;
+constexpr PerfStage kPerfStageParse = kLibgav1PerfStageParse;
+constexpr PerfStage kPerfStagePredict = kLibgav1PerfStagePredict;
+constexpr PerfStage kPerfStageReconstruct = kLibgav1PerfStageReconstruct;
+constexpr PerfStage kPerfStageDeblock = kLibgav1PerfStageDeblock;
+constexpr PerfStage kPerfStageCdef = kLibgav1PerfStageCdef;
+constexpr PerfStage kPerfStageSuperRes = kLibgav1PerfStageSuperRes;
+constexpr PerfStage kPerfStageLoopRestoration =
+    kLibgav1PerfStageLoopRestoration;
+constexpr PerfStage kPerfStageFilmGrain = kLibgav1PerfStageFilmGrain;
+constexpr int kNumPerfStages = kLibgav1NumPerfStages;
+
+using PerfCounter = Libgav1PerfCounter;
+constexpr PerfCounter kPerfCounterCycles = kLibgav1PerfCounterCycles;
+constexpr PerfCounter kPerfCounterInstructions =
+    kLibgav1PerfCounterInstructions;
+constexpr PerfCounter kPerfCounterLlcMisses = kLibgav1PerfCounterLlcMisses;
+constexpr PerfCounter kPerfCounterBranchMisses =
+    kLibgav1PerfCounterBranchMisses;
+constexpr int kNumPerfCounters = kLibgav1NumPerfCounters;
+
+using PerfCounters = Libgav1PerfCounters;
+
+}  // namespace libgav1
+#endif  // defined(__cplusplus)
+
+#endif  // LIBGAV1_SRC_GAV1_PERF_COUNTERS_H_
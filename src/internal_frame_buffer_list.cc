@@ -14,7 +14,9 @@
 
 #include "src/internal_frame_buffer_list.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <new>
@@ -57,9 +59,21 @@ void ReleaseInternalFrameBuffer(void* callback_private_data,
 }  // extern "C"
 
 StatusCode InternalFrameBufferList::OnFrameBufferSizeChanged(
-    int /*bitdepth*/, Libgav1ImageFormat /*image_format*/, int /*width*/,
-    int /*height*/, int /*left_border*/, int /*right_border*/,
-    int /*top_border*/, int /*bottom_border*/, int /*stride_alignment*/) {
+    int bitdepth, Libgav1ImageFormat image_format, int /*width*/,
+    int /*height*/, int left_border, int right_border, int top_border,
+    int bottom_border, int stride_alignment) {
+  reserved_size_ = 0;
+  if (max_frame_width_ == 0 || max_frame_height_ == 0) return kStatusOk;
+  FrameBufferInfo info;
+  const StatusCode status = ComputeFrameBufferInfo(
+      bitdepth, image_format, max_frame_width_, max_frame_height_, left_border,
+      right_border, top_border, bottom_border, stride_alignment, &info);
+  if (status != kStatusOk) return status;
+  if (info.uv_buffer_size > SIZE_MAX / 2 ||
+      info.y_buffer_size > SIZE_MAX - 2 * info.uv_buffer_size) {
+    return kStatusInvalidArgument;
+  }
+  reserved_size_ = info.y_buffer_size + 2 * info.uv_buffer_size;
   return kStatusOk;
 }
 
@@ -95,11 +109,12 @@ StatusCode InternalFrameBufferList::GetFrameBuffer(
   }
 
   if (buffer->size < min_size) {
-    std::unique_ptr<uint8_t[], MallocDeleter> new_data(
-        static_cast<uint8_t*>(malloc(min_size)));
+    const size_t size = std::max(min_size, reserved_size_);
+    AlignedUniquePtr<uint8_t> new_data =
+        MakeAlignedUniquePtr<uint8_t>(alignof(std::max_align_t), size);
     if (new_data == nullptr) return kStatusOutOfMemory;
     buffer->data = std::move(new_data);
-    buffer->size = min_size;
+    buffer->size = size;
   }
 
   uint8_t* const y_buffer = buffer->data.get();
@@ -50,6 +50,15 @@ class InternalFrameBufferList : public Allocable {
 
   ~InternalFrameBufferList() = default;
 
+  // Makes the frame buffers large enough for frames of up to |width| x
+  // |height| (in the format passed to the next OnFrameBufferSizeChanged()
+  // call), so that changing the frame size within this limit reuses them. A
+  // size of 0 x 0 (the default) sizes the buffers for the frames requested.
+  void SetMaxFrameSize(int width, int height) {
+    max_frame_width_ = width;
+    max_frame_height_ = height;
+  }
+
   Libgav1StatusCode OnFrameBufferSizeChanged(int bitdepth,
                                              Libgav1ImageFormat image_format,
                                              int width, int height,
@@ -68,12 +77,17 @@ class InternalFrameBufferList : public Allocable {
 
  private:
   struct Buffer : public Allocable {
-    std::unique_ptr<uint8_t[], MallocDeleter> data;
+    AlignedUniquePtr<uint8_t> data;
     size_t size = 0;
     bool in_use = false;
   };
 
   Vector<std::unique_ptr<Buffer>> buffers_;
+  int max_frame_width_ = 0;
+  int max_frame_height_ = 0;
+  // The minimum size of a frame buffer allocation. Derived from the maximum
+  // frame size in OnFrameBufferSizeChanged().
+  size_t reserved_size_ = 0;
 };
 
 }  // namespace libgav1
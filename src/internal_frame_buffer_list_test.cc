@@ -14,11 +14,14 @@
 
 #include "src/internal_frame_buffer_list.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 
 #include "gtest/gtest.h"
 #include "src/gav1/decoder_buffer.h"
 #include "src/gav1/frame_buffer.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 namespace {
@@ -154,5 +157,45 @@ TEST_F(InternalFrameBufferListTest, VaryingBufferSizes) {
   }
 }
 
+TEST(InternalFrameBufferListMaxFrameSizeTest, BuffersAreReused) {
+  const int bitdepth = 8;
+  const Libgav1ImageFormat image_format = kLibgav1ImageFormatYuv420;
+  const int border = 32;
+  const int stride_alignment = 16;
+  int allocations = 0;
+  Allocator allocator;
+  allocator.allocate = [](void* private_data, size_t size) {
+    ++*static_cast<int*>(private_data);
+    return malloc(size);
+  };
+  allocator.deallocate = [](void* /*private_data*/, void* ptr) { free(ptr); };
+  allocator.private_data = &allocations;
+  const ScopedAllocator scoped_allocator(allocator);
+
+  InternalFrameBufferList buffer_list;
+  buffer_list.SetMaxFrameSize(1280, 720);
+  EXPECT_EQ(OnInternalFrameBufferSizeChanged(
+                &buffer_list, bitdepth, image_format, 640, 360, border, border,
+                border, border, stride_alignment),
+            0);
+
+  // The first buffer is allocated for the maximum frame size, so the larger
+  // frames reuse it.
+  FrameBuffer frame_buffer;
+  int allocations_after_first_frame = 0;
+  for (const int width : {320, 640, 1280, 960}) {
+    const int height = width * 9 / 16;
+    EXPECT_EQ(GetInternalFrameBuffer(&buffer_list, bitdepth, image_format,
+                                     width, height, border, border, border,
+                                     border, stride_alignment, &frame_buffer),
+              0);
+    if (allocations_after_first_frame == 0) {
+      allocations_after_first_frame = allocations;
+    }
+    EXPECT_EQ(allocations, allocations_after_first_frame);
+    ReleaseInternalFrameBuffer(&buffer_list, frame_buffer.private_data);
+  }
+}
+
 }  // namespace
 }  // namespace libgav1
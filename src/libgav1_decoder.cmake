@@ -77,6 +77,7 @@ list(APPEND libgav1_api_includes "${libgav1_source}/gav1/decoder.h"
             "${libgav1_source}/gav1/decoder_buffer.h"
             "${libgav1_source}/gav1/decoder_settings.h"
             "${libgav1_source}/gav1/frame_buffer.h"
+            "${libgav1_source}/gav1/perf_counters.h"
             "${libgav1_source}/gav1/status_code.h"
             "${libgav1_source}/gav1/symbol_visibility.h"
             "${libgav1_source}/gav1/version.h")
@@ -271,23 +271,87 @@ void ScanPoint(const Tile::Block& block, int delta_row, int delta_column,
                           found_match, num_mv_found);
 }
 
+// Part of 7.10.2.6. Stores in |candidate_mvs| the projections towards
+// |reference_frame| of the |count| temporal motion vectors, where |cells|
+// holds the index of the 8x8 block of each of them within the current 64x64
+// block. Only the motion vectors that are not in the temporal motion vector
+// cache of the tile are projected; their projections are then cached.
+void GetTemporalProjections(const Tile& tile,
+                            const ReferenceFrameType reference_frame,
+                            const int reference_offset,
+                            const MotionVector* const temporal_mvs,
+                            const int8_t* const temporal_reference_offsets,
+                            const uint8_t* const cells, const int count,
+                            MotionVector* const candidate_mvs) {
+  assert(reference_frame > kReferenceFrameIntra);
+  TemporalMvCache& cache = tile.temporal_mv_cache();
+  uint64_t valid = cache.valid[reference_frame];
+  MotionVector* const cached_mvs = cache.mv[reference_frame];
+  alignas(kMaxAlignment)
+      MotionVector missing_mvs[kMaxTemporalMvCandidatesWithPadding];
+  int8_t missing_reference_offsets[kMaxTemporalMvCandidatesWithPadding];
+  uint8_t missing_cells[kMaxTemporalMvCandidates];
+  int num_missing = 0;
+  for (int i = 0; i < count; ++i) {
+    if (((valid >> cells[i]) & 1) != 0) continue;
+    missing_mvs[num_missing] = temporal_mvs[i];
+    missing_reference_offsets[num_missing] = temporal_reference_offsets[i];
+    missing_cells[num_missing++] = cells[i];
+  }
+  if (num_missing != 0) {
+    // Pad so that SIMD implementations won't read uninitialized memory.
+    for (int i = num_missing; i < ((num_missing + 3) & ~3); ++i) {
+      missing_mvs[i].mv32 = 0;
+      missing_reference_offsets[i] = 0;
+    }
+    const ObuFrameHeader& frame_header = tile.frame_header();
+    const int mv_projection_function_index =
+        frame_header.allow_high_precision_mv ? 2
+                                             : frame_header.force_integer_mv;
+    alignas(kMaxAlignment)
+        MotionVector projected_mvs[kMaxTemporalMvCandidatesWithPadding];
+    const dsp::Dsp& dsp = *dsp::GetDspTable(8);
+    dsp.mv_projection_single[mv_projection_function_index](
+        missing_mvs, missing_reference_offsets, reference_offset, num_missing,
+        projected_mvs);
+    for (int i = 0; i < num_missing; ++i) {
+      cached_mvs[missing_cells[i]] = projected_mvs[i];
+      valid |= uint64_t{1} << missing_cells[i];
+    }
+    cache.valid[reference_frame] = valid;
+  }
+  for (int i = 0; i < count; ++i) {
+    candidate_mvs[i] = cached_mvs[cells[i]];
+  }
+}
+
 // 7.10.2.6.
 void AddTemporalReferenceMvCandidate(
-    const ObuFrameHeader& frame_header, const int reference_offsets[2],
-    const MotionVector* const temporal_mvs,
-    const int8_t* const temporal_reference_offsets, int count, bool is_compound,
-    int* const zero_mv_context, int* const num_mv_found,
+    const Tile& tile, const ReferenceFrameType reference_frames[2],
+    const int reference_offsets[2], const MotionVector* const temporal_mvs,
+    const int8_t* const temporal_reference_offsets, const uint8_t* const cells,
+    int count, bool is_compound, int* const zero_mv_context,
+    int* const num_mv_found,
     PredictionParameters* const prediction_parameters) {
-  const int mv_projection_function_index =
-      frame_header.allow_high_precision_mv ? 2 : frame_header.force_integer_mv;
   const MotionVector* const global_mv = prediction_parameters->global_mv;
   if (is_compound) {
     alignas(kMaxAlignment)
         CompoundMotionVector candidate_mvs[kMaxTemporalMvCandidatesWithPadding];
-    const dsp::Dsp& dsp = *dsp::GetDspTable(8);
-    dsp.mv_projection_compound[mv_projection_function_index](
-        temporal_mvs, temporal_reference_offsets, reference_offsets, count,
-        candidate_mvs);
+    for (int i = 0; i < 2; ++i) {
+      alignas(kMaxAlignment)
+          MotionVector projected_mvs[kMaxTemporalMvCandidatesWithPadding];
+      if (reference_offsets[i] == 0) {
+        // The projection of any motion vector with a zero offset is zero.
+        for (int j = 0; j < count; ++j) projected_mvs[j].mv32 = 0;
+      } else {
+        GetTemporalProjections(tile, reference_frames[i], reference_offsets[i],
+                               temporal_mvs, temporal_reference_offsets, cells,
+                               count, projected_mvs);
+      }
+      for (int j = 0; j < count; ++j) {
+        candidate_mvs[j].mv[i] = projected_mvs[j];
+      }
+    }
     if (*zero_mv_context == -1) {
       int max_difference =
           std::max(std::abs(candidate_mvs[0].mv[0].mv[0] - global_mv[0].mv[0]),
@@ -351,10 +415,9 @@ void AddTemporalReferenceMvCandidate(
   }
   alignas(kMaxAlignment)
       MotionVector candidate_mvs[kMaxTemporalMvCandidatesWithPadding];
-  const dsp::Dsp& dsp = *dsp::GetDspTable(8);
-  dsp.mv_projection_single[mv_projection_function_index](
-      temporal_mvs, temporal_reference_offsets, reference_offsets[0], count,
-      candidate_mvs);
+  GetTemporalProjections(tile, reference_frames[0], reference_offsets[0],
+                         temporal_mvs, temporal_reference_offsets, cells, count,
+                         candidate_mvs);
   if (*zero_mv_context == -1) {
     const int max_difference =
         std::max(std::abs(candidate_mvs[0].mv[0] - global_mv[0].mv[0]),
@@ -415,9 +478,10 @@ void TemporalScan(const Tile::Block& block, bool is_compound,
   const MotionVector* motion_field_mv = motion_field.mv[0];
   const int8_t* motion_field_reference_offset =
       motion_field.reference_offset[0];
-  alignas(kMaxAlignment)
-      MotionVector temporal_mvs[kMaxTemporalMvCandidatesWithPadding];
-  int8_t temporal_reference_offsets[kMaxTemporalMvCandidatesWithPadding];
+  MotionVector temporal_mvs[kMaxTemporalMvCandidates];
+  int8_t temporal_reference_offsets[kMaxTemporalMvCandidates];
+  // The index of the 8x8 block of each candidate within the 64x64 block.
+  uint8_t cells[kMaxTemporalMvCandidates];
   int count = 0;
   int offset = stride * (row_start >> 1);
   int mv_row = row_start;
@@ -435,8 +499,9 @@ void TemporalScan(const Tile::Block& block, bool is_compound,
           }
         } else {
           temporal_mvs[count] = temporal_mv;
-          temporal_reference_offsets[count++] =
+          temporal_reference_offsets[count] =
               motion_field_reference_offset[offset + x8];
+          cells[count++] = ((mv_row >> 1) & 7) * 8 + (x8 & 7);
         }
       }
       mv_column += step_w;
@@ -470,8 +535,9 @@ void TemporalScan(const Tile::Block& block, bool is_compound,
           motion_field_mv[temporal_sample_offsets[i]];
       if (temporal_mv.mv[0] != kInvalidMvValue) {
         temporal_mvs[count] = temporal_mv;
-        temporal_reference_offsets[count++] =
+        temporal_reference_offsets[count] =
             motion_field_reference_offset[temporal_sample_offsets[i]];
+        cells[count++] = ((mv_row >> 1) & 7) * 8 + ((mv_column >> 1) & 7);
       }
     }
   }
@@ -483,27 +549,20 @@ void TemporalScan(const Tile::Block& block, bool is_compound,
                              ->relative_distance_to[bp->reference_frame[0]];
     reference_offsets[0] =
         Clip3(offset_0, -kMaxFrameDistance, kMaxFrameDistance);
+    ReferenceFrameType reference_frames[2] = {bp->reference_frame[0],
+                                              kReferenceFrameNone};
     if (is_compound) {
       const int offset_1 = tile.current_frame()
                                .reference_info()
                                ->relative_distance_to[bp->reference_frame[1]];
       reference_offsets[1] =
           Clip3(offset_1, -kMaxFrameDistance, kMaxFrameDistance);
-      // Pad so that SIMD implementations won't read uninitialized memory.
-      if ((count & 1) != 0) {
-        temporal_mvs[count].mv32 = 0;
-        temporal_reference_offsets[count] = 0;
-      }
-    } else {
-      // Pad so that SIMD implementations won't read uninitialized memory.
-      for (int i = count; i < ((count + 3) & ~3); ++i) {
-        temporal_mvs[i].mv32 = 0;
-        temporal_reference_offsets[i] = 0;
-      }
+      reference_frames[1] = bp->reference_frame[1];
     }
+    tile.temporal_mv_cache().Update(block.row4x4, block.column4x4);
     AddTemporalReferenceMvCandidate(
-        tile.frame_header(), reference_offsets, temporal_mvs,
-        temporal_reference_offsets, count, is_compound, zero_mv_context,
+        tile, reference_frames, reference_offsets, temporal_mvs,
+        temporal_reference_offsets, cells, count, is_compound, zero_mv_context,
         num_mv_found, &(*bp->prediction_parameters));
   }
 }
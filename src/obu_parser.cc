@@ -2661,6 +2661,10 @@ bool ObuParser::ParseHeader() {
 #undef OBU_LOG_AND_RETURN_FALSE
 
 bool ObuParser::InitBitReader(const uint8_t* const data, size_t size) {
+  if (bit_reader_ != nullptr) {
+    bit_reader_->Reset(data, size);
+    return true;
+  }
   bit_reader_.reset(new (std::nothrow) RawBitReader(data, size));
   return bit_reader_ != nullptr;
 }
@@ -2675,6 +2679,20 @@ bool ObuParser::EnsureCurrentFrameIsNotNull() {
   return true;
 }
 
+void ObuParser::Reset(const uint8_t* const data, size_t size) {
+  assert(current_frame_ == nullptr);
+  data_ = data;
+  size_ = size;
+  obu_headers_.clear();
+  sequence_header_ = {};
+  frame_header_ = {};
+  tile_buffers_.clear();
+  next_tile_group_start_ = 0;
+  has_sequence_header_ = false;
+  sequence_header_changed_ = false;
+  extension_disallowed_ = false;
+}
+
 bool ObuParser::HasData() const { return size_ > 0; }
 
 StatusCode ObuParser::ParseOneFrame(RefCountedBufferPtr* const current_frame) {
@@ -2765,6 +2783,22 @@ StatusCode ObuParser::ParseOneFrame(RefCountedBufferPtr* const current_frame) {
               sequence_header_.color_config.bitdepth, LIBGAV1_MAX_BITDEPTH);
           return kStatusUnimplemented;
         }
+#if LIBGAV1_SPECIALIZE_420
+        if (sequence_header_.color_config.is_monochrome ||
+            sequence_header_.color_config.subsampling_x != 1 ||
+            sequence_header_.color_config.subsampling_y != 1) {
+          LIBGAV1_DLOG(ERROR,
+                       "Only 4:2:0 streams are supported by this build.");
+          return kStatusUnimplemented;
+        }
+#endif
+#if LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK
+        if (sequence_header_.use_128x128_superblock) {
+          LIBGAV1_DLOG(ERROR,
+                       "128x128 superblocks are not supported by this build.");
+          return kStatusUnimplemented;
+        }
+#endif
         break;
       case kObuFrameHeader:
         if (seen_frame_header) {
@@ -233,6 +233,11 @@ class ObuParser : public Allocable {
   ObuParser(const ObuParser& rhs) = delete;
   ObuParser& operator=(const ObuParser& rhs) = delete;
 
+  // Makes the parser parse |data| as if it was constructed with |data| and
+  // |size|, but keeps the memory that it has allocated. This lets a decoder
+  // use one parser for all the temporal units.
+  void Reset(const uint8_t* data, size_t size);
+
   // Returns true if there is more data that needs to be parsed.
   bool HasData() const;
 
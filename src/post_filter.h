@@ -35,6 +35,7 @@
 #include "src/utils/common.h"
 #include "src/utils/constants.h"
 #include "src/utils/memory.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/threadpool.h"
 #include "src/yuv_buffer.h"
 
@@ -142,6 +143,19 @@ class PostFilter {
   int ApplyFilteringForOneSuperBlockRow(int row4x4, int sb4x4, bool is_last_row,
                                         bool do_deblock);
 
+  // Computes the deblocking filter edges of the block of size |block_size| at
+  // (|row4x4|, |column4x4|) and stores them in the deblock edge maps of the
+  // frame. |has_chroma| indicates whether the chroma edges of the block must
+  // also be stored. This must be called after the transform sizes of the block
+  // have been parsed. The edges on the left (top) border of the tile that
+  // starts at (|tile_row4x4_start|, |tile_column4x4_start|) depend on the
+  // neighboring tile, which may not have been parsed yet. Those are computed
+  // by the deblocking filter instead. The maps must be zeroed before the first
+  // block of the frame; the positions without an edge are not written.
+  void StoreDeblockEdges(int row4x4, int column4x4, BlockSize block_size,
+                         bool has_chroma, int tile_row4x4_start,
+                         int tile_column4x4_start);
+
   // Apply deblocking filter in one direction (specified by |loop_filter_type|)
   // for the superblock row starting at |row4x4_start| for columns starting from
   // |column4x4_start| in increments of 16 (or 8 for chroma with subsampling)
@@ -455,9 +469,15 @@ class PostFilter {
   const LoopRestoration& loop_restoration_;
   const dsp::Dsp& dsp_;
   const int8_t bitdepth_;
+#if LIBGAV1_SPECIALIZE_420
+  static constexpr int8_t subsampling_x_[kMaxPlanes] = {0, 1, 1};
+  static constexpr int8_t subsampling_y_[kMaxPlanes] = {0, 1, 1};
+  static constexpr int8_t planes_ = kMaxPlanes;
+#else
   const int8_t subsampling_x_[kMaxPlanes];
   const int8_t subsampling_y_[kMaxPlanes];
   const int8_t planes_;
+#endif
   const int pixel_size_log2_;
   const uint8_t* const inner_thresh_;
   const uint8_t* const outer_thresh_;
@@ -481,6 +501,8 @@ class PostFilter {
   const Array2D<int8_t>& cdef_index_;
   const Array2D<uint8_t>& cdef_skip_;
   const Array2D<TransformSize>& inter_transform_sizes_;
+  // Points to |FrameScratchBuffer::deblock_edges|.
+  Array2D<uint8_t> (*const deblock_edges_)[kMaxPlanes];
   LoopRestorationInfo* const restoration_info_;
   uint8_t* const superres_coefficients_[kNumPlaneTypes];
   // Line buffer used by multi-threaded ApplySuperRes().
@@ -531,6 +553,8 @@ class PostFilter {
 
   template <int bitdepth, typename Pixel>
   friend class PostFilterHelperFuncTest;
+
+  friend class PostFilterDeblockEdgesTest;
 };
 
 extern template void PostFilter::ExtendFrame<uint8_t>(uint8_t* frame_start,
@@ -338,6 +338,16 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
 
   const bool is_frame_right =
       MultiplyBy4(column4x4_start + block_width4x4) >= frame_header_.width;
+  // Without a thread pool, the output is written to |cdef_buffer_| which is
+  // shifted such that no pixel which is still needed as input gets
+  // overwritten. So the 8-bit units which do not touch the frame borders do
+  // not need any kCdefLargeValue padding and are filtered directly from the
+  // source frame instead of from a 16-bit copy in |cdef_block|.
+  const bool filter_unpadded =
+      sizeof(Pixel) == 1 && thread_pool_ == nullptr &&
+      dsp_.cdef_filters_unpadded[0][0] != nullptr && row4x4_start > 0 &&
+      column4x4_start > 0 && !is_frame_right &&
+      MultiplyBy4(row4x4_start + block_height4x4) < frame_header_.height;
   if (!is_frame_right && thread_pool_ != nullptr) {
     // Backup the last 2 columns for use in the next iteration.
     use_border_columns[border_columns_dst_index][0] = true;
@@ -352,12 +362,14 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
                MultiplyBy4(block_height4x4), sizeof(Pixel));
   }
 
-  PrepareCdefBlock<Pixel>(
-      block_width4x4, block_height4x4, row4x4_start, column4x4_start,
-      cdef_block, kCdefUnitSizeWithBorders, true,
-      (border_columns != nullptr) ? border_columns[border_columns_src_index]
-                                  : nullptr,
-      use_border_columns[border_columns_src_index][0]);
+  if (!filter_unpadded) {
+    PrepareCdefBlock<Pixel>(
+        block_width4x4, block_height4x4, row4x4_start, column4x4_start,
+        cdef_block, kCdefUnitSizeWithBorders, true,
+        (border_columns != nullptr) ? border_columns[border_columns_src_index]
+                                    : nullptr,
+        use_border_columns[border_columns_src_index][0]);
+  }
 
   // Stored direction used during the u/v pass.  If bit 3 is set, then block is
   // a skip.
@@ -378,6 +390,29 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
   const uint8_t* skip_row =
       &cdef_skip_[row4x4_start >> 1][column4x4_start >> 4];
   const int skip_stride = cdef_skip_.columns();
+
+  // The directions and variances of the non-skipped 8x8 blocks are computed
+  // for the whole unit with a single call. With a thread pool, the last row of
+  // 8x8 blocks is left to the loop below since its input may have to come from
+  // |cdef_border_|.
+  const int width8x8 = DivideBy2(block_width4x4);
+  int variance_y[8 * 8];
+  int num_direction_blocks = 0;
+  if (compute_direction_and_variance) {
+    const int height8x8 = DivideBy2(block_height4x4) -
+                          static_cast<int>(thread_pool_ != nullptr);
+    if (height8x8 > 0) {
+      uint8_t direction_mask[8];
+      for (int y = 0; y < height8x8; ++y) {
+        direction_mask[y] = skip_row[y * skip_stride] & ((1 << width8x8) - 1);
+      }
+      dsp_.cdef_directions(src_buffer_row_base[kPlaneY],
+                           frame_buffer_.stride(kPlaneY), width8x8, height8x8,
+                           direction_mask, direction_y, variance_y);
+      num_direction_blocks = width8x8 * height8x8;
+    }
+  }
+
   int row4x4 = row4x4_start;
   do {
     uint8_t* cdef_buffer_base = cdef_buffer_row_base[kPlaneY];
@@ -413,34 +448,30 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
                        block_width, block_height, sizeof(Pixel));
           }
         } else {
-          // Zero out residual skip flag.
-          direction_y[y_index] = 0;
-
           int variance = 0;
-          if (compute_direction_and_variance) {
-            if (thread_pool_ == nullptr ||
-                row4x4 + kStep4x4 < row4x4_start + block_height4x4) {
-              dsp_.cdef_direction(src_buffer, src_stride, &direction_y[y_index],
-                                  &variance);
-            } else if (sizeof(Pixel) == 2) {
-              dsp_.cdef_direction(cdef_src, kCdefUnitSizeWithBorders * 2,
-                                  &direction_y[y_index], &variance);
-            } else {
-              // If we are in the last row4x4 for this unit, then the last two
-              // input rows have to come from |cdef_border_|. Since we already
-              // have |cdef_src| populated correctly, use that as the input
-              // for the direction process.
-              uint8_t direction_src[8][8];
-              const uint16_t* cdef_src_line = cdef_src;
-              for (auto& direction_src_line : direction_src) {
-                for (int i = 0; i < 8; ++i) {
-                  direction_src_line[i] = cdef_src_line[i];
-                }
-                cdef_src_line += kCdefUnitSizeWithBorders;
+          if (!compute_direction_and_variance) {
+            // Zero out residual skip flag.
+            direction_y[y_index] = 0;
+          } else if (y_index < num_direction_blocks) {
+            variance = variance_y[y_index];
+          } else if (sizeof(Pixel) == 2) {
+            dsp_.cdef_direction(cdef_src, kCdefUnitSizeWithBorders * 2,
+                                &direction_y[y_index], &variance);
+          } else {
+            // If we are in the last row4x4 for this unit, then the last two
+            // input rows have to come from |cdef_border_|. Since we already
+            // have |cdef_src| populated correctly, use that as the input
+            // for the direction process.
+            uint8_t direction_src[8][8];
+            const uint16_t* cdef_src_line = cdef_src;
+            for (auto& direction_src_line : direction_src) {
+              for (int i = 0; i < 8; ++i) {
+                direction_src_line[i] = cdef_src_line[i];
               }
-              dsp_.cdef_direction(direction_src, 8, &direction_y[y_index],
-                                  &variance);
+              cdef_src_line += kCdefUnitSizeWithBorders;
             }
+            dsp_.cdef_direction(direction_src, 8, &direction_y[y_index],
+                                &variance);
           }
           const int direction =
               (y_primary_strength == 0) ? 0 : direction_y[y_index];
@@ -460,11 +491,18 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
             const int strength_index =
                 y_strength_index |
                 (static_cast<int>(primary_strength == 0) << 1);
-            dsp_.cdef_filters[1][strength_index](
-                cdef_src, kCdefUnitSizeWithBorders, block_height,
-                primary_strength, y_secondary_strength,
-                frame_header_.cdef.damping, direction, cdef_buffer,
-                cdef_stride);
+            if (filter_unpadded) {
+              dsp_.cdef_filters_unpadded[1][strength_index](
+                  src_buffer, src_stride, block_height, primary_strength,
+                  y_secondary_strength, frame_header_.cdef.damping, direction,
+                  cdef_buffer, cdef_stride);
+            } else {
+              dsp_.cdef_filters[1][strength_index](
+                  cdef_src, kCdefUnitSizeWithBorders, block_height,
+                  primary_strength, y_secondary_strength,
+                  frame_header_.cdef.damping, direction, cdef_buffer,
+                  cdef_stride);
+            }
           }
         }
         cdef_buffer_base += column_step[kPlaneY];
@@ -522,100 +560,133 @@ void PostFilter::ApplyCdefForOneUnit(uint16_t* cdef_block, const int index,
     }
   }
 
-  PrepareCdefBlock<Pixel>(
-      block_width4x4, block_height4x4, row4x4_start, column4x4_start,
-      cdef_block, kCdefUnitSizeWithBorders, false,
-      (border_columns != nullptr) ? border_columns[border_columns_src_index]
-                                  : nullptr,
-      use_border_columns[border_columns_src_index][1]);
+  if (!filter_unpadded) {
+    PrepareCdefBlock<Pixel>(
+        block_width4x4, block_height4x4, row4x4_start, column4x4_start,
+        cdef_block, kCdefUnitSizeWithBorders, false,
+        (border_columns != nullptr) ? border_columns[border_columns_src_index]
+                                    : nullptr,
+        use_border_columns[border_columns_src_index][1]);
+  }
 
   // uv_strength_index is 0 for both primary and secondary strengths being
   // non-zero, 1 for primary only, 2 for secondary only.
   const int uv_strength_index =
       (static_cast<int>(uv_primary_strength == 0) << 1) |
       static_cast<int>(uv_secondary_strength == 0);
-  for (int plane = kPlaneU; plane <= kPlaneV; ++plane) {
-    const int8_t subsampling_x = subsampling_x_[plane];
-    const int8_t subsampling_y = subsampling_y_[plane];
-    const int block_width = kStep >> subsampling_x;
-    const int block_height = kStep >> subsampling_y;
-    int row4x4 = row4x4_start;
-
-    y_index = 0;
+  // The U and V planes share the subsampling, the strengths and the directions,
+  // so the co-located blocks of both planes are filtered together.
+  const int8_t subsampling_x = subsampling_x_[kPlaneU];
+  const int8_t subsampling_y = subsampling_y_[kPlaneU];
+  const int block_width = kStep >> subsampling_x;
+  const int block_height = kStep >> subsampling_y;
+  const int stride_u = frame_buffer_.stride(kPlaneU);
+  const int stride_v = frame_buffer_.stride(kPlaneV);
+  row4x4 = row4x4_start;
+  y_index = 0;
+  do {
+    uint8_t* cdef_buffer_u = cdef_buffer_row_base[kPlaneU];
+    uint8_t* cdef_buffer_v = cdef_buffer_row_base[kPlaneV];
+    const uint8_t* src_buffer_u = src_buffer_row_base[kPlaneU];
+    const uint8_t* src_buffer_v = src_buffer_row_base[kPlaneV];
+    const uint16_t* cdef_src_u = cdef_src_row_base[kPlaneU];
+    const uint16_t* cdef_src_v = cdef_src_row_base[kPlaneV];
+    int column4x4 = column4x4_start;
     do {
-      uint8_t* cdef_buffer_base = cdef_buffer_row_base[plane];
-      const uint8_t* src_buffer_base = src_buffer_row_base[plane];
-      const uint16_t* cdef_src_base = cdef_src_row_base[plane];
-      int column4x4 = column4x4_start;
-      do {
-        const int cdef_stride = frame_buffer_.stride(plane);
-        uint8_t* const cdef_buffer = cdef_buffer_base;
-        const int src_stride = frame_buffer_.stride(plane);
-        const uint8_t* const src_buffer = src_buffer_base;
-        const uint16_t* const cdef_src = cdef_src_base;
-        const bool skip = (direction_y[y_index] & kCdefSkip) != 0;
-        int dual_cdef = 0;
+      const bool skip = (direction_y[y_index] & kCdefSkip) != 0;
+      int dual_cdef = 0;
+
+      if (skip) {  // No cdef filtering.
+        if (thread_pool_ == nullptr) {
+          CopyPixels(src_buffer_u, stride_u, cdef_buffer_u, stride_u,
+                     block_width, block_height, sizeof(Pixel));
+          CopyPixels(src_buffer_v, stride_v, cdef_buffer_v, stride_v,
+                     block_width, block_height, sizeof(Pixel));
+        }
+      } else {
+        // Make sure block pair is not out of bounds.
+        if (column4x4 + (kStep4x4 * 2) <= column4x4_start + block_width4x4) {
+          // Enable dual processing if subsampling_x is 1.
+          dual_cdef = subsampling_x;
+        }
 
-        if (skip) {  // No cdef filtering.
-          if (thread_pool_ == nullptr) {
-            CopyPixels(src_buffer, src_stride, cdef_buffer, cdef_stride,
-                       block_width, block_height, sizeof(Pixel));
-          }
-        } else {
-          // Make sure block pair is not out of bounds.
-          if (column4x4 + (kStep4x4 * 2) <= column4x4_start + block_width4x4) {
-            // Enable dual processing if subsampling_x is 1.
-            dual_cdef = subsampling_x;
+        int direction = (uv_primary_strength == 0)
+                            ? 0
+                            : kCdefUvDirection[subsampling_x][subsampling_y]
+                                              [direction_y[y_index]];
+
+        if (dual_cdef != 0) {
+          if (uv_primary_strength &&
+              direction_y[y_index] != direction_y[y_index + 1]) {
+            // Disable dual processing if the second block of the pair does
+            // not have the same direction.
+            dual_cdef = 0;
           }
 
-          int direction = (uv_primary_strength == 0)
-                              ? 0
-                              : kCdefUvDirection[subsampling_x][subsampling_y]
-                                                [direction_y[y_index]];
-
-          if (dual_cdef != 0) {
-            if (uv_primary_strength &&
-                direction_y[y_index] != direction_y[y_index + 1]) {
-              // Disable dual processing if the second block of the pair does
-              // not have the same direction.
-              dual_cdef = 0;
-            }
-
-            // Disable dual processing if the second block of the pair is a
-            // skip.
-            if (direction_y[y_index + 1] == kCdefSkip) {
-              dual_cdef = 0;
-            }
+          // Disable dual processing if the second block of the pair is a
+          // skip.
+          if (direction_y[y_index + 1] == kCdefSkip) {
+            dual_cdef = 0;
           }
+        }
 
-          // Block width is 8 if either dual_cdef is true or subsampling_x == 0.
-          const int width_index = dual_cdef | (subsampling_x ^ 1);
-          dsp_.cdef_filters[width_index][uv_strength_index](
-              cdef_src, kCdefUnitSizeWithBorders, block_height,
+        // Block width is 8 if either dual_cdef is true or subsampling_x == 0.
+        const int width_index = dual_cdef | (subsampling_x ^ 1);
+        if (filter_unpadded) {
+          const dsp::CdefFilteringUnpaddedFunc filter =
+              dsp_.cdef_filters_unpadded[width_index][uv_strength_index];
+          filter(src_buffer_u, stride_u, block_height, uv_primary_strength,
+                 uv_secondary_strength, frame_header_.cdef.damping - 1,
+                 direction, cdef_buffer_u, stride_u);
+          filter(src_buffer_v, stride_v, block_height, uv_primary_strength,
+                 uv_secondary_strength, frame_header_.cdef.damping - 1,
+                 direction, cdef_buffer_v, stride_v);
+        } else if (dsp_.cdef_filters_uv[width_index][uv_strength_index] !=
+                   nullptr) {
+          dsp_.cdef_filters_uv[width_index][uv_strength_index](
+              cdef_src_u, cdef_src_v, kCdefUnitSizeWithBorders, block_height,
               uv_primary_strength, uv_secondary_strength,
-              frame_header_.cdef.damping - 1, direction, cdef_buffer,
-              cdef_stride);
+              frame_header_.cdef.damping - 1, direction, cdef_buffer_u,
+              stride_u, cdef_buffer_v, stride_v);
+        } else {
+          const dsp::CdefFilteringFunc filter =
+              dsp_.cdef_filters[width_index][uv_strength_index];
+          filter(cdef_src_u, kCdefUnitSizeWithBorders, block_height,
+                 uv_primary_strength, uv_secondary_strength,
+                 frame_header_.cdef.damping - 1, direction, cdef_buffer_u,
+                 stride_u);
+          filter(cdef_src_v, kCdefUnitSizeWithBorders, block_height,
+                 uv_primary_strength, uv_secondary_strength,
+                 frame_header_.cdef.damping - 1, direction, cdef_buffer_v,
+                 stride_v);
         }
-        // When dual_cdef is set, the above cdef_filter() will process 2 blocks,
-        // so adjust the pointers and indexes for 2 blocks.
-        cdef_buffer_base += column_step[plane] << dual_cdef;
-        src_buffer_base += column_step[plane] << dual_cdef;
-        cdef_src_base += (column_step[plane] / sizeof(Pixel)) << dual_cdef;
-        column4x4 += kStep4x4 << dual_cdef;
-        y_index += 1 << dual_cdef;
-      } while (column4x4 < column4x4_start + block_width4x4);
+      }
+      // When dual_cdef is set, the above cdef_filter() will process 2 blocks,
+      // so adjust the pointers and indexes for 2 blocks.
+      const int column_step_uv = column_step[kPlaneU] << dual_cdef;
+      cdef_buffer_u += column_step_uv;
+      cdef_buffer_v += column_step_uv;
+      src_buffer_u += column_step_uv;
+      src_buffer_v += column_step_uv;
+      cdef_src_u += column_step_uv / sizeof(Pixel);
+      cdef_src_v += column_step_uv / sizeof(Pixel);
+      column4x4 += kStep4x4 << dual_cdef;
+      y_index += 1 << dual_cdef;
+    } while (column4x4 < column4x4_start + block_width4x4);
 
+    for (int plane = kPlaneU; plane <= kPlaneV; ++plane) {
       cdef_buffer_row_base[plane] += cdef_buffer_row_base_stride[plane];
       src_buffer_row_base[plane] += src_buffer_row_base_stride[plane];
       cdef_src_row_base[plane] += cdef_src_row_base_stride[plane];
-      row4x4 += kStep4x4;
-    } while (row4x4 < row4x4_start + block_height4x4);
-  }
+    }
+    row4x4 += kStep4x4;
+  } while (row4x4 < row4x4_start + block_height4x4);
 }
 
 void PostFilter::ApplyCdefForOneSuperBlockRowHelper(
     uint16_t* cdef_block, uint8_t border_columns[2][kMaxPlanes][256],
     int row4x4, int block_height4x4) {
+  const ScopedPerfStage perf_stage(kPerfStageCdef);
   bool use_border_columns[2][2] = {};
   const bool non_zero_index = frame_header_.cdef.bits > 0;
   const int8_t* cdef_index =
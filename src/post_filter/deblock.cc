@@ -45,6 +45,58 @@ constexpr dsp::LoopFilterSize GetLoopFilterSizeUV(int filter_length) {
   return static_cast<dsp::LoopFilterSize>(filter_length != 4);
 }
 
+// Encoding of the entries of the deblock edge maps: The lower 6 bits hold the
+// filter level and the upper 2 bits hold the dsp::LoopFilterSize. 0 means that
+// the edge is not filtered. kDeblockEdgeUnknown (which has a level of 0 and
+// hence is never a valid encoding) means that the edge information has to be
+// computed by the deblocking filter.
+constexpr int kDeblockEdgeSizeShift = 6;
+constexpr uint8_t kDeblockEdgeLevelMask = (1 << kDeblockEdgeSizeShift) - 1;
+constexpr uint8_t kDeblockEdgeUnknown = 3 << kDeblockEdgeSizeShift;
+static_assert(kMaxLoopFilterValue <= kDeblockEdgeLevelMask, "");
+
+constexpr uint8_t PackDeblockEdge(uint8_t level, dsp::LoopFilterSize size) {
+  return level | (size << kDeblockEdgeSizeShift);
+}
+
+constexpr uint8_t DeblockEdgeLevel(uint8_t edge) {
+  return edge & kDeblockEdgeLevelMask;
+}
+
+constexpr dsp::LoopFilterSize DeblockEdgeSize(uint8_t edge) {
+  return static_cast<dsp::LoopFilterSize>(edge >> kDeblockEdgeSizeShift);
+}
+
+// Returns the index of the first non-zero entry of |edges| in the range
+// [|start|, |end|) or |end| if there is none. Runs of edges that do not need
+// filtering are skipped 8 entries at a time.
+inline int NextDeblockEdge(const uint8_t* const edges, int start,
+                           const int end) {
+  for (; start + 8 <= end; start += 8) {
+    uint64_t value;
+    memcpy(&value, edges + start, sizeof(value));
+    if (value != 0) break;
+  }
+  while (start < end && edges[start] == 0) ++start;
+  return start;
+}
+
+// Same as above, but stops at the first entry that is non-zero in either
+// |edges_u| or |edges_v|.
+inline int NextDeblockEdge(const uint8_t* const edges_u,
+                           const uint8_t* const edges_v, int start,
+                           const int end) {
+  for (; start + 8 <= end; start += 8) {
+    uint64_t value_u;
+    uint64_t value_v;
+    memcpy(&value_u, edges_u + start, sizeof(value_u));
+    memcpy(&value_v, edges_v + start, sizeof(value_v));
+    if ((value_u | value_v) != 0) break;
+  }
+  while (start < end && (edges_u[start] | edges_v[start]) == 0) ++start;
+  return start;
+}
+
 bool NonBlockBorderNeedsFilter(const BlockParameters& bp, int filter_id,
                                uint8_t* const level) {
   if (bp.deblock_filter_level[filter_id] == 0 || (bp.skip && bp.is_inter)) {
@@ -295,84 +347,225 @@ void PostFilter::GetVerticalDeblockFilterEdgeInfoUV(
   *filter_length = std::min(*step, step_prev);
 }
 
+void PostFilter::StoreDeblockEdges(int row4x4, int column4x4,
+                                   BlockSize block_size, bool has_chroma,
+                                   int tile_row4x4_start,
+                                   int tile_column4x4_start) {
+  const int row4x4_end =
+      std::min(row4x4 + kNum4x4BlocksHigh[block_size], frame_header_.rows4x4);
+  const int column4x4_end = std::min(
+      column4x4 + kNum4x4BlocksWide[block_size], frame_header_.columns4x4);
+  Array2D<uint8_t>& vertical_edges =
+      deblock_edges_[kLoopFilterTypeVertical][kPlaneY];
+  Array2D<uint8_t>& horizontal_edges =
+      deblock_edges_[kLoopFilterTypeHorizontal][kPlaneY];
+  uint8_t level;
+  int step;
+  int filter_length;
+
+  // Only the positions where a transform block starts can have an edge. All
+  // the other positions keep the 0 written when the maps were allocated for
+  // the frame.
+  for (int row = row4x4; row < row4x4_end; ++row) {
+    BlockParameters* const* const bp_row = block_parameters_.Address(row, 0);
+    int column = column4x4;
+    do {
+      if (column != 0 && column == tile_column4x4_start) {
+        vertical_edges[row][column] = kDeblockEdgeUnknown;
+        step = kTransformWidth[inter_transform_sizes_[row][column]];
+      } else if (GetVerticalDeblockFilterEdgeInfo(row, column, bp_row + column,
+                                                  &level, &step,
+                                                  &filter_length)) {
+        vertical_edges[row][column] =
+            PackDeblockEdge(level, GetLoopFilterSizeY(filter_length));
+      }
+      column += DivideBy4(step);
+    } while (column < column4x4_end);
+  }
+  for (int column = column4x4; column < column4x4_end; ++column) {
+    int row = row4x4;
+    do {
+      if (row != 0 && row == tile_row4x4_start) {
+        horizontal_edges[row][column] = kDeblockEdgeUnknown;
+        step = kTransformHeight[inter_transform_sizes_[row][column]];
+      } else if (GetHorizontalDeblockFilterEdgeInfo(row, column, &level, &step,
+                                                    &filter_length)) {
+        horizontal_edges[row][column] =
+            PackDeblockEdge(level, GetLoopFilterSizeY(filter_length));
+      }
+      row += DivideBy4(step);
+    } while (row < row4x4_end);
+  }
+
+  if (!needs_chroma_deblock_ || !has_chroma) return;
+  // For the blocks that are smaller than 8x8 in a subsampled direction, the
+  // chroma block also covers the preceding luma blocks. The entries of the
+  // chroma maps are in units of chroma 4x4 blocks.
+  const int8_t subsampling_x = subsampling_x_[kPlaneU];
+  const int8_t subsampling_y = subsampling_y_[kPlaneU];
+  const int row4x4_uv_start = row4x4 >> subsampling_y;
+  const int row4x4_uv_end = SubsampledValue(row4x4_end, subsampling_y);
+  const int column4x4_uv_start = column4x4 >> subsampling_x;
+  const int column4x4_uv_end = SubsampledValue(column4x4_end, subsampling_x);
+  Array2D<uint8_t>* const vertical_edges_uv =
+      deblock_edges_[kLoopFilterTypeVertical];
+  Array2D<uint8_t>* const horizontal_edges_uv =
+      deblock_edges_[kLoopFilterTypeHorizontal];
+  uint8_t level_u;
+  uint8_t level_v;
+  for (int row = row4x4_uv_start; row < row4x4_uv_end; ++row) {
+    const int luma_row = row << subsampling_y;
+    int column = column4x4_uv_start;
+    do {
+      const int luma_column = column << subsampling_x;
+      BlockParameters* const* const bp = block_parameters_.Address(
+          GetDeblockPosition(luma_row, subsampling_y),
+          GetDeblockPosition(luma_column, subsampling_x));
+      if (luma_column != 0 && luma_column == tile_column4x4_start) {
+        vertical_edges_uv[kPlaneU][row][column] = kDeblockEdgeUnknown;
+        vertical_edges_uv[kPlaneV][row][column] = kDeblockEdgeUnknown;
+        step = kTransformWidth[(*bp)->uv_transform_size];
+      } else {
+        GetVerticalDeblockFilterEdgeInfoUV(luma_column, bp, &level_u, &level_v,
+                                           &step, &filter_length);
+        if (level_u != 0) {
+          vertical_edges_uv[kPlaneU][row][column] =
+              PackDeblockEdge(level_u, GetLoopFilterSizeUV(filter_length));
+        }
+        if (level_v != 0) {
+          vertical_edges_uv[kPlaneV][row][column] =
+              PackDeblockEdge(level_v, GetLoopFilterSizeUV(filter_length));
+        }
+      }
+      column += DivideBy4(step);
+    } while (column < column4x4_uv_end);
+  }
+  for (int column = column4x4_uv_start; column < column4x4_uv_end; ++column) {
+    const int luma_column = column << subsampling_x;
+    int row = row4x4_uv_start;
+    do {
+      const int luma_row = row << subsampling_y;
+      if (luma_row != 0 && luma_row == tile_row4x4_start) {
+        horizontal_edges_uv[kPlaneU][row][column] = kDeblockEdgeUnknown;
+        horizontal_edges_uv[kPlaneV][row][column] = kDeblockEdgeUnknown;
+        step = kTransformHeight[block_parameters_
+                                    .Find(GetDeblockPosition(luma_row,
+                                                             subsampling_y),
+                                          GetDeblockPosition(luma_column,
+                                                             subsampling_x))
+                                    ->uv_transform_size];
+      } else {
+        GetHorizontalDeblockFilterEdgeInfoUV(luma_row, luma_column, &level_u,
+                                             &level_v, &step, &filter_length);
+        if (level_u != 0) {
+          horizontal_edges_uv[kPlaneU][row][column] =
+              PackDeblockEdge(level_u, GetLoopFilterSizeUV(filter_length));
+        }
+        if (level_v != 0) {
+          horizontal_edges_uv[kPlaneV][row][column] =
+              PackDeblockEdge(level_v, GetLoopFilterSizeUV(filter_length));
+        }
+      }
+      row += DivideBy4(step);
+    } while (row < row4x4_uv_end);
+  }
+}
+
 void PostFilter::HorizontalDeblockFilter(int row4x4_start, int row4x4_end,
                                          int column4x4_start,
                                          int column4x4_end) {
-  const int height4x4 = row4x4_end - row4x4_start;
-  const int width4x4 = column4x4_end - column4x4_start;
-  if (height4x4 <= 0 || width4x4 <= 0) return;
+  row4x4_end = std::min(row4x4_end, DivideBy4(frame_header_.height + 3));
+  column4x4_end = std::min(column4x4_end, DivideBy4(frame_header_.width + 3));
+  if (row4x4_start >= row4x4_end || column4x4_start >= column4x4_end) return;
+  const ScopedPerfStage perf_stage(kPerfStageDeblock);
 
-  const int column_step = 1;
-  const int src_step = 4 << pixel_size_log2_;
+  const int src_step_shift = 2 + pixel_size_log2_;
   const ptrdiff_t src_stride = frame_buffer_.stride(kPlaneY);
+  const ptrdiff_t row_stride = MultiplyBy4(src_stride);
+  const Array2D<uint8_t>& edges_y =
+      deblock_edges_[kLoopFilterTypeHorizontal][kPlaneY];
   uint8_t* src = GetSourceBuffer(kPlaneY, row4x4_start, column4x4_start);
-  int row_step;
   uint8_t level;
+  int step;
   int filter_length;
 
-  const int width = frame_header_.width;
-  const int height = frame_header_.height;
-  for (int column4x4 = 0;
-       column4x4 < width4x4 && MultiplyBy4(column4x4_start + column4x4) < width;
-       column4x4 += column_step, src += src_step) {
-    uint8_t* src_row = src;
-    for (int row4x4 = 0;
-         row4x4 < height4x4 && MultiplyBy4(row4x4_start + row4x4) < height;
-         row4x4 += row_step) {
-      const bool need_filter = GetHorizontalDeblockFilterEdgeInfo(
-          row4x4_start + row4x4, column4x4_start + column4x4, &level, &row_step,
-          &filter_length);
-      if (need_filter) {
-        assert(level > 0 && level <= kMaxLoopFilterValue);
-        const dsp::LoopFilterSize size = GetLoopFilterSizeY(filter_length);
-        dsp_.loop_filters[size][kLoopFilterTypeHorizontal](
-            src_row, src_stride, outer_thresh_[level], inner_thresh_[level],
-            HevThresh(level));
+  for (int row4x4 = row4x4_start; row4x4 < row4x4_end;
+       ++row4x4, src += row_stride) {
+    const uint8_t* const edges = edges_y[row4x4];
+    for (int column4x4 = NextDeblockEdge(edges, column4x4_start, column4x4_end);
+         column4x4 < column4x4_end;
+         column4x4 = NextDeblockEdge(edges, column4x4 + 1, column4x4_end)) {
+      uint8_t edge = edges[column4x4];
+      if (edge == kDeblockEdgeUnknown) {
+        if (!GetHorizontalDeblockFilterEdgeInfo(row4x4, column4x4, &level,
+                                                &step, &filter_length)) {
+          continue;
+        }
+        edge = PackDeblockEdge(level, GetLoopFilterSizeY(filter_length));
       }
-      src_row += row_step * src_stride;
-      row_step = DivideBy4(row_step);
+      level = DeblockEdgeLevel(edge);
+      assert(level > 0 && level <= kMaxLoopFilterValue);
+      dsp_.loop_filters[DeblockEdgeSize(edge)][kLoopFilterTypeHorizontal](
+          src + ((column4x4 - column4x4_start) << src_step_shift), src_stride,
+          outer_thresh_[level], inner_thresh_[level], HevThresh(level));
     }
   }
 
   if (needs_chroma_deblock_) {
     const int8_t subsampling_x = subsampling_x_[kPlaneU];
     const int8_t subsampling_y = subsampling_y_[kPlaneU];
-    const int column_step = 1 << subsampling_x;
+    const int row4x4_uv_start = row4x4_start >> subsampling_y;
+    const int row4x4_uv_end = SubsampledValue(row4x4_end, subsampling_y);
+    const int column4x4_uv_start = column4x4_start >> subsampling_x;
+    const int column4x4_uv_end = SubsampledValue(column4x4_end, subsampling_x);
     const ptrdiff_t src_stride_u = frame_buffer_.stride(kPlaneU);
     const ptrdiff_t src_stride_v = frame_buffer_.stride(kPlaneV);
+    const ptrdiff_t row_stride_u = MultiplyBy4(src_stride_u);
+    const ptrdiff_t row_stride_v = MultiplyBy4(src_stride_v);
+    const Array2D<uint8_t>& edges_u =
+        deblock_edges_[kLoopFilterTypeHorizontal][kPlaneU];
+    const Array2D<uint8_t>& edges_v =
+        deblock_edges_[kLoopFilterTypeHorizontal][kPlaneV];
     uint8_t* src_u = GetSourceBuffer(kPlaneU, row4x4_start, column4x4_start);
     uint8_t* src_v = GetSourceBuffer(kPlaneV, row4x4_start, column4x4_start);
-    int row_step;
     uint8_t level_u;
     uint8_t level_v;
-    int filter_length;
-
-    for (int column4x4 = 0; column4x4 < width4x4 &&
-                            MultiplyBy4(column4x4_start + column4x4) < width;
-         column4x4 += column_step, src_u += src_step, src_v += src_step) {
-      uint8_t* src_row_u = src_u;
-      uint8_t* src_row_v = src_v;
-      for (int row4x4 = 0;
-           row4x4 < height4x4 && MultiplyBy4(row4x4_start + row4x4) < height;
-           row4x4 += row_step) {
-        GetHorizontalDeblockFilterEdgeInfoUV(
-            row4x4_start + row4x4, column4x4_start + column4x4, &level_u,
-            &level_v, &row_step, &filter_length);
-        if (level_u != 0) {
+
+    for (int row4x4 = row4x4_uv_start; row4x4 < row4x4_uv_end;
+         ++row4x4, src_u += row_stride_u, src_v += row_stride_v) {
+      const uint8_t* const edges_row_u = edges_u[row4x4];
+      const uint8_t* const edges_row_v = edges_v[row4x4];
+      for (int column4x4 = NextDeblockEdge(edges_row_u, edges_row_v,
+                                           column4x4_uv_start,
+                                           column4x4_uv_end);
+           column4x4 < column4x4_uv_end;
+           column4x4 = NextDeblockEdge(edges_row_u, edges_row_v, column4x4 + 1,
+                                       column4x4_uv_end)) {
+        uint8_t edge_u = edges_row_u[column4x4];
+        uint8_t edge_v = edges_row_v[column4x4];
+        if (edge_u == kDeblockEdgeUnknown) {
+          assert(edge_v == kDeblockEdgeUnknown);
+          GetHorizontalDeblockFilterEdgeInfoUV(
+              row4x4 << subsampling_y, column4x4 << subsampling_x, &level_u,
+              &level_v, &step, &filter_length);
           const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
-          dsp_.loop_filters[size][kLoopFilterTypeHorizontal](
-              src_row_u, src_stride_u, outer_thresh_[level_u],
+          edge_u = (level_u == 0) ? 0 : PackDeblockEdge(level_u, size);
+          edge_v = (level_v == 0) ? 0 : PackDeblockEdge(level_v, size);
+        }
+        const ptrdiff_t offset = (column4x4 - column4x4_uv_start)
+                                 << src_step_shift;
+        if (edge_u != 0) {
+          level_u = DeblockEdgeLevel(edge_u);
+          dsp_.loop_filters[DeblockEdgeSize(edge_u)][kLoopFilterTypeHorizontal](
+              src_u + offset, src_stride_u, outer_thresh_[level_u],
               inner_thresh_[level_u], HevThresh(level_u));
         }
-        if (level_v != 0) {
-          const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
-          dsp_.loop_filters[size][kLoopFilterTypeHorizontal](
-              src_row_v, src_stride_v, outer_thresh_[level_v],
+        if (edge_v != 0) {
+          level_v = DeblockEdgeLevel(edge_v);
+          dsp_.loop_filters[DeblockEdgeSize(edge_v)][kLoopFilterTypeHorizontal](
+              src_v + offset, src_stride_v, outer_thresh_[level_v],
               inner_thresh_[level_v], HevThresh(level_v));
         }
-        src_row_u += row_step * src_stride_u;
-        src_row_v += row_step * src_stride_v;
-        row_step = DivideBy4(row_step << subsampling_y);
       }
     }
   }
@@ -380,94 +573,103 @@ void PostFilter::HorizontalDeblockFilter(int row4x4_start, int row4x4_end,
 
 void PostFilter::VerticalDeblockFilter(int row4x4_start, int row4x4_end,
                                        int column4x4_start, int column4x4_end) {
-  const int height4x4 = row4x4_end - row4x4_start;
-  const int width4x4 = column4x4_end - column4x4_start;
-  if (height4x4 <= 0 || width4x4 <= 0) return;
+  row4x4_end = std::min(row4x4_end, DivideBy4(frame_header_.height + 3));
+  column4x4_end = std::min(column4x4_end, DivideBy4(frame_header_.width + 3));
+  if (row4x4_start >= row4x4_end || column4x4_start >= column4x4_end) return;
+  const ScopedPerfStage perf_stage(kPerfStageDeblock);
 
-  const ptrdiff_t row_stride = MultiplyBy4(frame_buffer_.stride(kPlaneY));
+  const int src_step_shift = 2 + pixel_size_log2_;
   const ptrdiff_t src_stride = frame_buffer_.stride(kPlaneY);
+  const ptrdiff_t row_stride = MultiplyBy4(src_stride);
+  const Array2D<uint8_t>& edges_y =
+      deblock_edges_[kLoopFilterTypeVertical][kPlaneY];
   uint8_t* src = GetSourceBuffer(kPlaneY, row4x4_start, column4x4_start);
-  int column_step;
   uint8_t level;
+  int step;
   int filter_length;
 
-  BlockParameters* const* bp_row_base =
-      block_parameters_.Address(row4x4_start, column4x4_start);
-  const int bp_stride = block_parameters_.columns4x4();
-  const int column_step_shift = pixel_size_log2_;
-  const int width = frame_header_.width;
-  const int height = frame_header_.height;
-  for (int row4x4 = 0;
-       row4x4 < height4x4 && MultiplyBy4(row4x4_start + row4x4) < height;
-       ++row4x4, src += row_stride, bp_row_base += bp_stride) {
-    uint8_t* src_row = src;
-    BlockParameters* const* bp = bp_row_base;
-    for (int column4x4 = 0; column4x4 < width4x4 &&
-                            MultiplyBy4(column4x4_start + column4x4) < width;
-         column4x4 += column_step, bp += column_step) {
-      const bool need_filter = GetVerticalDeblockFilterEdgeInfo(
-          row4x4_start + row4x4, column4x4_start + column4x4, bp, &level,
-          &column_step, &filter_length);
-      if (need_filter) {
-        assert(level > 0 && level <= kMaxLoopFilterValue);
-        const dsp::LoopFilterSize size = GetLoopFilterSizeY(filter_length);
-        dsp_.loop_filters[size][kLoopFilterTypeVertical](
-            src_row, src_stride, outer_thresh_[level], inner_thresh_[level],
-            HevThresh(level));
+  for (int row4x4 = row4x4_start; row4x4 < row4x4_end;
+       ++row4x4, src += row_stride) {
+    const uint8_t* const edges = edges_y[row4x4];
+    for (int column4x4 = NextDeblockEdge(edges, column4x4_start, column4x4_end);
+         column4x4 < column4x4_end;
+         column4x4 = NextDeblockEdge(edges, column4x4 + 1, column4x4_end)) {
+      uint8_t edge = edges[column4x4];
+      if (edge == kDeblockEdgeUnknown) {
+        if (!GetVerticalDeblockFilterEdgeInfo(
+                row4x4, column4x4, block_parameters_.Address(row4x4, column4x4),
+                &level, &step, &filter_length)) {
+          continue;
+        }
+        edge = PackDeblockEdge(level, GetLoopFilterSizeY(filter_length));
       }
-      src_row += column_step << column_step_shift;
-      column_step = DivideBy4(column_step);
+      level = DeblockEdgeLevel(edge);
+      assert(level > 0 && level <= kMaxLoopFilterValue);
+      dsp_.loop_filters[DeblockEdgeSize(edge)][kLoopFilterTypeVertical](
+          src + ((column4x4 - column4x4_start) << src_step_shift), src_stride,
+          outer_thresh_[level], inner_thresh_[level], HevThresh(level));
     }
   }
 
   if (needs_chroma_deblock_) {
     const int8_t subsampling_x = subsampling_x_[kPlaneU];
     const int8_t subsampling_y = subsampling_y_[kPlaneU];
-    const int row_step = 1 << subsampling_y;
-    uint8_t* src_u = GetSourceBuffer(kPlaneU, row4x4_start, column4x4_start);
-    uint8_t* src_v = GetSourceBuffer(kPlaneV, row4x4_start, column4x4_start);
+    const int row4x4_uv_start = row4x4_start >> subsampling_y;
+    const int row4x4_uv_end = SubsampledValue(row4x4_end, subsampling_y);
+    const int column4x4_uv_start = column4x4_start >> subsampling_x;
+    const int column4x4_uv_end = SubsampledValue(column4x4_end, subsampling_x);
     const ptrdiff_t src_stride_u = frame_buffer_.stride(kPlaneU);
     const ptrdiff_t src_stride_v = frame_buffer_.stride(kPlaneV);
-    const ptrdiff_t row_stride_u = MultiplyBy4(frame_buffer_.stride(kPlaneU));
-    const ptrdiff_t row_stride_v = MultiplyBy4(frame_buffer_.stride(kPlaneV));
-    const LoopFilterType type = kLoopFilterTypeVertical;
-    int column_step;
+    const ptrdiff_t row_stride_u = MultiplyBy4(src_stride_u);
+    const ptrdiff_t row_stride_v = MultiplyBy4(src_stride_v);
+    const Array2D<uint8_t>& edges_u =
+        deblock_edges_[kLoopFilterTypeVertical][kPlaneU];
+    const Array2D<uint8_t>& edges_v =
+        deblock_edges_[kLoopFilterTypeVertical][kPlaneV];
+    uint8_t* src_u = GetSourceBuffer(kPlaneU, row4x4_start, column4x4_start);
+    uint8_t* src_v = GetSourceBuffer(kPlaneV, row4x4_start, column4x4_start);
     uint8_t level_u;
     uint8_t level_v;
-    int filter_length;
-
-    BlockParameters* const* bp_row_base = block_parameters_.Address(
-        GetDeblockPosition(row4x4_start, subsampling_y),
-        GetDeblockPosition(column4x4_start, subsampling_x));
-    const int bp_stride = block_parameters_.columns4x4() << subsampling_y;
-    for (int row4x4 = 0;
-         row4x4 < height4x4 && MultiplyBy4(row4x4_start + row4x4) < height;
-         row4x4 += row_step, src_u += row_stride_u, src_v += row_stride_v,
-             bp_row_base += bp_stride) {
-      uint8_t* src_row_u = src_u;
-      uint8_t* src_row_v = src_v;
-      BlockParameters* const* bp = bp_row_base;
-      for (int column4x4 = 0; column4x4 < width4x4 &&
-                              MultiplyBy4(column4x4_start + column4x4) < width;
-           column4x4 += column_step, bp += column_step) {
-        GetVerticalDeblockFilterEdgeInfoUV(column4x4_start + column4x4, bp,
-                                           &level_u, &level_v, &column_step,
-                                           &filter_length);
-        if (level_u != 0) {
+
+    for (int row4x4 = row4x4_uv_start; row4x4 < row4x4_uv_end;
+         ++row4x4, src_u += row_stride_u, src_v += row_stride_v) {
+      const uint8_t* const edges_row_u = edges_u[row4x4];
+      const uint8_t* const edges_row_v = edges_v[row4x4];
+      for (int column4x4 = NextDeblockEdge(edges_row_u, edges_row_v,
+                                           column4x4_uv_start,
+                                           column4x4_uv_end);
+           column4x4 < column4x4_uv_end;
+           column4x4 = NextDeblockEdge(edges_row_u, edges_row_v, column4x4 + 1,
+                                       column4x4_uv_end)) {
+        uint8_t edge_u = edges_row_u[column4x4];
+        uint8_t edge_v = edges_row_v[column4x4];
+        if (edge_u == kDeblockEdgeUnknown) {
+          assert(edge_v == kDeblockEdgeUnknown);
+          const int luma_column = column4x4 << subsampling_x;
+          GetVerticalDeblockFilterEdgeInfoUV(
+              luma_column,
+              block_parameters_.Address(
+                  GetDeblockPosition(row4x4 << subsampling_y, subsampling_y),
+                  GetDeblockPosition(luma_column, subsampling_x)),
+              &level_u, &level_v, &step, &filter_length);
           const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
-          dsp_.loop_filters[size][type](
-              src_row_u, src_stride_u, outer_thresh_[level_u],
+          edge_u = (level_u == 0) ? 0 : PackDeblockEdge(level_u, size);
+          edge_v = (level_v == 0) ? 0 : PackDeblockEdge(level_v, size);
+        }
+        const ptrdiff_t offset = (column4x4 - column4x4_uv_start)
+                                 << src_step_shift;
+        if (edge_u != 0) {
+          level_u = DeblockEdgeLevel(edge_u);
+          dsp_.loop_filters[DeblockEdgeSize(edge_u)][kLoopFilterTypeVertical](
+              src_u + offset, src_stride_u, outer_thresh_[level_u],
               inner_thresh_[level_u], HevThresh(level_u));
         }
-        if (level_v != 0) {
-          const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
-          dsp_.loop_filters[size][type](
-              src_row_v, src_stride_v, outer_thresh_[level_v],
+        if (edge_v != 0) {
+          level_v = DeblockEdgeLevel(edge_v);
+          dsp_.loop_filters[DeblockEdgeSize(edge_v)][kLoopFilterTypeVertical](
+              src_v + offset, src_stride_v, outer_thresh_[level_v],
               inner_thresh_[level_v], HevThresh(level_v));
         }
-        src_row_u += column_step << column_step_shift;
-        src_row_v += column_step << column_step_shift;
-        column_step = DivideBy4(column_step << subsampling_x);
       }
     }
   }
@@ -106,6 +106,7 @@ void PostFilter::ApplyLoopRestorationForOneSuperBlockRow(const int row4x4_start,
                                                          const int sb4x4) {
   assert(row4x4_start >= 0);
   assert(DoRestoration());
+  const ScopedPerfStage perf_stage(kPerfStageLoopRestoration);
   int plane = kPlaneY;
   const int upscaled_width = frame_header_.upscaled_width;
   const int height = frame_header_.height;
@@ -44,6 +44,12 @@ constexpr int kLoopRestorationBorderRows[2] = {54, 26};
 
 }  // namespace
 
+#if LIBGAV1_SPECIALIZE_420
+constexpr int8_t PostFilter::subsampling_x_[kMaxPlanes];
+constexpr int8_t PostFilter::subsampling_y_[kMaxPlanes];
+constexpr int8_t PostFilter::planes_;
+#endif
+
 PostFilter::PostFilter(const ObuFrameHeader& frame_header,
                        const ObuSequenceHeader& sequence_header,
                        FrameScratchBuffer* const frame_scratch_buffer,
@@ -53,12 +59,14 @@ PostFilter::PostFilter(const ObuFrameHeader& frame_header,
       loop_restoration_(frame_header.loop_restoration),
       dsp_(*dsp),
       bitdepth_(sequence_header.color_config.bitdepth),
+#if !LIBGAV1_SPECIALIZE_420
       subsampling_x_{0, sequence_header.color_config.subsampling_x,
                      sequence_header.color_config.subsampling_x},
       subsampling_y_{0, sequence_header.color_config.subsampling_y,
                      sequence_header.color_config.subsampling_y},
       planes_(sequence_header.color_config.is_monochrome ? kMaxPlanesMonochrome
                                                          : kMaxPlanes),
+#endif
       pixel_size_log2_(static_cast<int>((bitdepth_ == 8) ? sizeof(uint8_t)
                                                          : sizeof(uint16_t)) -
                        1),
@@ -74,6 +82,7 @@ PostFilter::PostFilter(const ObuFrameHeader& frame_header,
       cdef_index_(frame_scratch_buffer->cdef_index),
       cdef_skip_(frame_scratch_buffer->cdef_skip),
       inter_transform_sizes_(frame_scratch_buffer->inter_transform_sizes),
+      deblock_edges_(frame_scratch_buffer->deblock_edges),
       restoration_info_(&frame_scratch_buffer->loop_restoration_info),
       superres_coefficients_{
           frame_scratch_buffer->superres_coefficients[kPlaneTypeY].get(),
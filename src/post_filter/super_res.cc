@@ -21,6 +21,7 @@ void PostFilter::ApplySuperRes(const std::array<uint8_t*, kMaxPlanes>& src,
                                const int line_buffer_row,
                                const std::array<uint8_t*, kMaxPlanes>& dst,
                                bool dst_is_loop_restoration_border /*=false*/) {
+  const ScopedPerfStage perf_stage(kPerfStageSuperRes);
   int plane = kPlaneY;
   do {
     const int plane_width =
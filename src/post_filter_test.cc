@@ -1077,4 +1077,623 @@ INSTANTIATE_TEST_SUITE_P(PostFilterApplyCdefTestInstance,
                          testing::ValuesIn(kTestParamApplyCdef));
 #endif  // LIBGAV1_MAX_BITDEPTH == 12
 
+namespace {
+
+// Matches the encoding of the deblock edge maps in
+// src/post_filter/deblock.cc.
+constexpr uint8_t kDeblockEdgeUnknown = 3 << 6;
+
+uint8_t PackDeblockEdge(uint8_t level, dsp::LoopFilterSize size) {
+  return level | (size << 6);
+}
+
+dsp::LoopFilterSize GetLoopFilterSizeY(int filter_length) {
+  if (filter_length == 4) return dsp::kLoopFilterSize4;
+  if (filter_length == 8) return dsp::kLoopFilterSize8;
+  return dsp::kLoopFilterSize14;
+}
+
+dsp::LoopFilterSize GetLoopFilterSizeUV(int filter_length) {
+  return (filter_length == 4) ? dsp::kLoopFilterSize4 : dsp::kLoopFilterSize6;
+}
+
+// Returns a random transform size that is at most |width| x |height| pixels
+// and has an aspect ratio of at most 4:1.
+TransformSize GetRandomTransformSize(libvpx_test::ACMRandom* rnd, int width,
+                                     int height) {
+  const int width_log2 = std::min(FloorLog2(width), 6);
+  const int height_log2 = std::min(FloorLog2(height), 6);
+  while (true) {
+    const int tx_width_log2 = 2 + rnd->Rand8() % (width_log2 - 1);
+    const int tx_height_log2 = 2 + rnd->Rand8() % (height_log2 - 1);
+    for (int tx_size = kTransformSize4x4; tx_size < kNumTransformSizes;
+         ++tx_size) {
+      if (kTransformWidthLog2[tx_size] == tx_width_log2 &&
+          kTransformHeightLog2[tx_size] == tx_height_log2) {
+        return static_cast<TransformSize>(tx_size);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Compares the deblock edge maps stored by PostFilter::StoreDeblockEdges() and
+// the deblocking filter that uses them against the per-edge computation that
+// was done by the deblocking filter before the maps were introduced.
+class PostFilterDeblockEdgesTest
+    : public testing::TestWithParam<FrameSizeParam>,
+      public test_utils::MaxAlignedAllocable {
+ public:
+  PostFilterDeblockEdgesTest() = default;
+  PostFilterDeblockEdgesTest(const PostFilterDeblockEdgesTest&) = delete;
+  PostFilterDeblockEdgesTest& operator=(const PostFilterDeblockEdgesTest&) =
+      delete;
+  ~PostFilterDeblockEdgesTest() override = default;
+
+ protected:
+  // The arguments of a StoreDeblockEdges() call.
+  struct BlockInfo {
+    int row4x4;
+    int column4x4;
+    BlockSize block_size;
+    bool has_chroma;
+    int tile_row4x4_start;
+    int tile_column4x4_start;
+  };
+
+  void SetUp() override {
+    dsp::DspInit();
+    dsp_ = dsp::GetDspTable(kBitdepth8);
+    ASSERT_NE(dsp_, nullptr);
+  }
+
+  // Sets the headers and allocates the frame scratch buffer and the frame
+  // buffers.
+  void SetInput(libvpx_test::ACMRandom* rnd);
+  // Fills both frame buffers with the same random pixels.
+  void SetInputBuffers(libvpx_test::ACMRandom* rnd);
+  // Clears the deblock edge maps as the decoder does at the start of a frame.
+  void ClearDeblockEdges() {
+    for (auto& deblock_edges : frame_scratch_buffer_.deblock_edges) {
+      for (Array2D<uint8_t>& edges : deblock_edges) {
+        memset(edges[0], 0, edges.size());
+      }
+    }
+  }
+  // Generates a random block layout and calls StoreDeblockEdges() for each
+  // block in decoding order.
+  void DecodeBlocks(libvpx_test::ACMRandom* rnd, PostFilter* post_filter);
+  void DecodePartition(libvpx_test::ACMRandom* rnd, PostFilter* post_filter,
+                       int row4x4, int column4x4, int size4x4_log2);
+  void DecodeBlock(libvpx_test::ACMRandom* rnd, PostFilter* post_filter,
+                   int row4x4, int column4x4, int width4x4, int height4x4);
+  static bool IsTileStart(const std::vector<bool>& tile_starts,
+                          int position4x4) {
+    return position4x4 != 0 && (position4x4 & 15) == 0 &&
+           tile_starts[DivideBy16(position4x4)];
+  }
+  // The deblocking filter as it was done before the deblock edge maps:
+  // Computes the edges while walking the frame and filters |post_filter|'s
+  // frame buffer. The computed edges are stored in |expected_edges_|.
+  void ReferenceVerticalDeblockFilter(PostFilter* post_filter);
+  void ReferenceHorizontalDeblockFilter(PostFilter* post_filter);
+  // Applies the deblocking filter that uses the deblock edge maps to the
+  // whole frame.
+  void DeblockFilter(PostFilter* post_filter) {
+    post_filter->VerticalDeblockFilter(0, frame_header_.rows4x4, 0,
+                                       frame_header_.columns4x4);
+    post_filter->HorizontalDeblockFilter(0, frame_header_.rows4x4, 0,
+                                         frame_header_.columns4x4);
+  }
+  void CompareEdges(PostFilter* post_filter);
+  void ComparePixels();
+
+  ObuSequenceHeader sequence_header_;
+  ObuFrameHeader frame_header_ = {};
+  FrameScratchBuffer frame_scratch_buffer_;
+  YuvBuffer yuv_buffer_;
+  YuvBuffer reference_yuv_buffer_;
+  Array2D<uint8_t> expected_edges_[kNumLoopFilterTypes][kMaxPlanes];
+  // Indexed by superblock row and column. True if a tile starts there.
+  std::vector<bool> tile_row_starts_;
+  std::vector<bool> tile_column_starts_;
+  std::vector<BlockInfo> blocks_;
+  const dsp::Dsp* dsp_;
+  const FrameSizeParam param_ = GetParam();
+  int tile_row4x4_start_ = 0;
+  int tile_column4x4_start_ = 0;
+};
+
+void PostFilterDeblockEdgesTest::SetInput(libvpx_test::ACMRandom* rnd) {
+  sequence_header_.color_config.bitdepth = kBitdepth8;
+  sequence_header_.color_config.subsampling_x = param_.subsampling_x;
+  sequence_header_.color_config.subsampling_y = param_.subsampling_y;
+  sequence_header_.color_config.is_monochrome = false;
+  sequence_header_.use_128x128_superblock = false;
+
+  frame_header_.width = param_.width;
+  frame_header_.upscaled_width = param_.width;
+  frame_header_.height = param_.height;
+  frame_header_.columns4x4 = DivideBy4(Align(frame_header_.width, 8));
+  frame_header_.rows4x4 = DivideBy4(Align(frame_header_.height, 8));
+  frame_header_.tile_info.tile_count = 1;
+  frame_header_.loop_filter.level[0] = 1 + rnd->Rand8() % kMaxLoopFilterValue;
+  frame_header_.loop_filter.level[1] = 1 + rnd->Rand8() % kMaxLoopFilterValue;
+  // At least one of the chroma planes is filtered.
+  do {
+    frame_header_.loop_filter.level[kPlaneU + 1] =
+        (rnd->Rand8() & 1) * (1 + rnd->Rand8() % kMaxLoopFilterValue);
+    frame_header_.loop_filter.level[kPlaneV + 1] =
+        (rnd->Rand8() & 1) * (1 + rnd->Rand8() % kMaxLoopFilterValue);
+  } while (frame_header_.loop_filter.level[kPlaneU + 1] == 0 &&
+           frame_header_.loop_filter.level[kPlaneV + 1] == 0);
+  frame_header_.loop_filter.sharpness = rnd->Rand8() & 7;
+
+  const int rows4x4 = frame_header_.rows4x4;
+  const int columns4x4 = frame_header_.columns4x4;
+  ASSERT_TRUE(frame_scratch_buffer_.block_parameters_holder.Reset(
+      rows4x4 + kMaxBlockHeight4x4, columns4x4 + kMaxBlockWidth4x4));
+  ASSERT_TRUE(frame_scratch_buffer_.inter_transform_sizes.Reset(
+      rows4x4 + kMaxBlockHeight4x4, columns4x4 + kMaxBlockWidth4x4,
+      /*zero_initialize=*/false));
+  for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+    const int8_t subsampling_x = (plane == kPlaneY) ? 0 : param_.subsampling_x;
+    const int8_t subsampling_y = (plane == kPlaneY) ? 0 : param_.subsampling_y;
+    for (int type = 0; type < kNumLoopFilterTypes; ++type) {
+      ASSERT_TRUE(frame_scratch_buffer_.deblock_edges[type][plane].Reset(
+          SubsampledValue(rows4x4, subsampling_y),
+          SubsampledValue(columns4x4, subsampling_x)));
+      ASSERT_TRUE(expected_edges_[type][plane].Reset(
+          SubsampledValue(rows4x4, subsampling_y),
+          SubsampledValue(columns4x4, subsampling_x)));
+    }
+  }
+
+  // Each superblock row and column starts a new tile with a probability of
+  // 1/4.
+  tile_row_starts_.resize(DivideBy16(rows4x4 + 15));
+  for (size_t i = 0; i < tile_row_starts_.size(); ++i) {
+    tile_row_starts_[i] = i == 0 || (rnd->Rand8() & 3) == 0;
+  }
+  tile_column_starts_.resize(DivideBy16(columns4x4 + 15));
+  for (size_t i = 0; i < tile_column_starts_.size(); ++i) {
+    tile_column_starts_[i] = i == 0 || (rnd->Rand8() & 3) == 0;
+  }
+
+  for (YuvBuffer* const buffer : {&yuv_buffer_, &reference_yuv_buffer_}) {
+    ASSERT_TRUE(buffer->Realloc(
+        kBitdepth8, /*is_monochrome=*/false, frame_header_.upscaled_width,
+        frame_header_.height, param_.subsampling_x, param_.subsampling_y,
+        kBorderPixels, kBorderPixels, kBorderPixels, kBorderPixels, nullptr,
+        nullptr, nullptr));
+  }
+}
+
+void PostFilterDeblockEdgesTest::SetInputBuffers(libvpx_test::ACMRandom* rnd) {
+  for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+    const int subsampling_x = (plane == kPlaneY) ? 0 : param_.subsampling_x;
+    const int subsampling_y = (plane == kPlaneY) ? 0 : param_.subsampling_y;
+    const int plane_width =
+        MultiplyBy4(frame_header_.columns4x4) >> subsampling_x;
+    const int plane_height =
+        MultiplyBy4(frame_header_.rows4x4) >> subsampling_y;
+    uint8_t* src = yuv_buffer_.data(plane);
+    uint8_t* reference = reference_yuv_buffer_.data(plane);
+    // Smooth content with some noise so that the filters are not always
+    // disabled by the thresholds.
+    const int base = rnd->Rand8();
+    for (int y = 0; y < plane_height; ++y) {
+      for (int x = 0; x < plane_width; ++x) {
+        src[x] = Clip3(base + ((x + y) & 63) + (rnd->Rand8() & 7) - 32, 0, 255);
+        reference[x] = src[x];
+      }
+      src += yuv_buffer_.stride(plane);
+      reference += reference_yuv_buffer_.stride(plane);
+    }
+  }
+}
+
+void PostFilterDeblockEdgesTest::DecodeBlocks(libvpx_test::ACMRandom* rnd,
+                                              PostFilter* post_filter) {
+  blocks_.clear();
+  for (int row4x4 = 0; row4x4 < frame_header_.rows4x4; row4x4 += 16) {
+    if (tile_row_starts_[DivideBy16(row4x4)]) tile_row4x4_start_ = row4x4;
+    for (int column4x4 = 0; column4x4 < frame_header_.columns4x4;
+         column4x4 += 16) {
+      if (tile_column_starts_[DivideBy16(column4x4)]) {
+        tile_column4x4_start_ = column4x4;
+      }
+      DecodePartition(rnd, post_filter, row4x4, column4x4,
+                      /*size4x4_log2=*/4);
+    }
+  }
+}
+
+// Follows the partition rules of the spec (5.11.4) for the blocks that cross
+// the bottom or the right edge of the frame.
+void PostFilterDeblockEdgesTest::DecodePartition(libvpx_test::ACMRandom* rnd,
+                                                 PostFilter* post_filter,
+                                                 int row4x4, int column4x4,
+                                                 int size4x4_log2) {
+  if (row4x4 >= frame_header_.rows4x4 ||
+      column4x4 >= frame_header_.columns4x4) {
+    return;
+  }
+  const int size4x4 = 1 << size4x4_log2;
+  if (size4x4 == 1) {
+    DecodeBlock(rnd, post_filter, row4x4, column4x4, 1, 1);
+    return;
+  }
+  const int half4x4 = size4x4 >> 1;
+  const bool has_rows = row4x4 + half4x4 < frame_header_.rows4x4;
+  const bool has_columns = column4x4 + half4x4 < frame_header_.columns4x4;
+  Partition partition;
+  if (has_rows && has_columns) {
+    partition = static_cast<Partition>(rnd->Rand8() & 3);
+  } else if (has_columns) {
+    partition =
+        ((rnd->Rand8() & 1) != 0) ? kPartitionHorizontal : kPartitionSplit;
+  } else if (has_rows) {
+    partition =
+        ((rnd->Rand8() & 1) != 0) ? kPartitionVertical : kPartitionSplit;
+  } else {
+    partition = kPartitionSplit;
+  }
+  switch (partition) {
+    case kPartitionNone:
+      DecodeBlock(rnd, post_filter, row4x4, column4x4, size4x4, size4x4);
+      break;
+    case kPartitionHorizontal:
+      DecodeBlock(rnd, post_filter, row4x4, column4x4, size4x4, half4x4);
+      if (has_rows) {
+        DecodeBlock(rnd, post_filter, row4x4 + half4x4, column4x4, size4x4,
+                    half4x4);
+      }
+      break;
+    case kPartitionVertical:
+      DecodeBlock(rnd, post_filter, row4x4, column4x4, half4x4, size4x4);
+      if (has_columns) {
+        DecodeBlock(rnd, post_filter, row4x4, column4x4 + half4x4, half4x4,
+                    size4x4);
+      }
+      break;
+    default:
+      assert(partition == kPartitionSplit);
+      DecodePartition(rnd, post_filter, row4x4, column4x4, size4x4_log2 - 1);
+      DecodePartition(rnd, post_filter, row4x4, column4x4 + half4x4,
+                      size4x4_log2 - 1);
+      DecodePartition(rnd, post_filter, row4x4 + half4x4, column4x4,
+                      size4x4_log2 - 1);
+      DecodePartition(rnd, post_filter, row4x4 + half4x4, column4x4 + half4x4,
+                      size4x4_log2 - 1);
+      break;
+  }
+}
+
+void PostFilterDeblockEdgesTest::DecodeBlock(libvpx_test::ACMRandom* rnd,
+                                             PostFilter* post_filter,
+                                             int row4x4, int column4x4,
+                                             int width4x4, int height4x4) {
+  int block_size = kBlock4x4;
+  while (kNum4x4BlocksWide[block_size] != width4x4 ||
+         kNum4x4BlocksHigh[block_size] != height4x4) {
+    ++block_size;
+  }
+  ASSERT_LT(block_size, kMaxBlockSizes);
+  BlockParameters* const bp = frame_scratch_buffer_.block_parameters_holder.Get(
+      row4x4, column4x4, static_cast<BlockSize>(block_size));
+  ASSERT_NE(bp, nullptr);
+  bp->is_inter = (rnd->Rand8() & 1) != 0;
+  bp->skip = (rnd->Rand8() & 1) != 0;
+  // A level of 0 disables the filtering on one side of an edge.
+  for (auto& level : bp->deblock_filter_level) {
+    level = ((rnd->Rand8() & 3) == 0) ? 0
+                                      : 1 + rnd->Rand8() % kMaxLoopFilterValue;
+  }
+
+  const int width = MultiplyBy4(width4x4);
+  const int height = MultiplyBy4(height4x4);
+  const TransformSize tx_size = GetRandomTransformSize(rnd, width, height);
+  for (int row = row4x4; row < row4x4 + height4x4; ++row) {
+    for (int column = column4x4; column < column4x4 + width4x4;
+         column += kTransformWidth4x4[tx_size]) {
+      for (int i = 0; i < kTransformWidth4x4[tx_size]; ++i) {
+        frame_scratch_buffer_.inter_transform_sizes[row][column + i] = tx_size;
+      }
+    }
+  }
+  // Blocks that are 4 pixels wide (high) in a subsampled direction share
+  // their chroma block with the preceding block.
+  const bool has_chroma =
+      !(((row4x4 & 1) == 0 && (param_.subsampling_y & height4x4) == 1) ||
+        ((column4x4 & 1) == 0 && (param_.subsampling_x & width4x4) == 1));
+  bp->uv_transform_size = GetRandomTransformSize(
+      rnd, std::max(4, width >> param_.subsampling_x),
+      std::max(4, height >> param_.subsampling_y));
+
+  const BlockInfo block = {row4x4,
+                           column4x4,
+                           static_cast<BlockSize>(block_size),
+                           has_chroma,
+                           tile_row4x4_start_,
+                           tile_column4x4_start_};
+  post_filter->StoreDeblockEdges(block.row4x4, block.column4x4,
+                                 block.block_size, block.has_chroma,
+                                 block.tile_row4x4_start,
+                                 block.tile_column4x4_start);
+  blocks_.push_back(block);
+}
+
+void PostFilterDeblockEdgesTest::ReferenceVerticalDeblockFilter(
+    PostFilter* post_filter) {
+  const int rows4x4 = DivideBy4(frame_header_.height + 3);
+  const int columns4x4 = DivideBy4(frame_header_.width + 3);
+  const BlockParametersHolder& block_parameters =
+      frame_scratch_buffer_.block_parameters_holder;
+  const dsp::LoopFilterFuncs& loop_filters = dsp_->loop_filters;
+  const uint8_t* const outer_thresh = post_filter->outer_thresh_;
+  const uint8_t* const inner_thresh = post_filter->inner_thresh_;
+  uint8_t level;
+  int step;
+  int filter_length;
+
+  uint8_t* const src_y = reference_yuv_buffer_.data(kPlaneY);
+  const ptrdiff_t stride_y = reference_yuv_buffer_.stride(kPlaneY);
+  for (int row4x4 = 0; row4x4 < rows4x4; ++row4x4) {
+    BlockParameters* const* const bp_row =
+        block_parameters.Address(row4x4, 0);
+    for (int column4x4 = 0; column4x4 < columns4x4;
+         column4x4 += DivideBy4(step)) {
+      if (post_filter->GetVerticalDeblockFilterEdgeInfo(
+              row4x4, column4x4, bp_row + column4x4, &level, &step,
+              &filter_length)) {
+        const dsp::LoopFilterSize size = GetLoopFilterSizeY(filter_length);
+        expected_edges_[kLoopFilterTypeVertical][kPlaneY][row4x4][column4x4] =
+            PackDeblockEdge(level, size);
+        loop_filters[size][kLoopFilterTypeVertical](
+            src_y + MultiplyBy4(row4x4) * stride_y + MultiplyBy4(column4x4),
+            stride_y, outer_thresh[level], inner_thresh[level],
+            DivideBy16(level));
+      }
+    }
+  }
+
+  const int8_t subsampling_x = param_.subsampling_x;
+  const int8_t subsampling_y = param_.subsampling_y;
+  uint8_t level_uv[2];
+  for (int row4x4 = 0; row4x4 < rows4x4; row4x4 += 1 << subsampling_y) {
+    for (int column4x4 = 0; column4x4 < columns4x4;
+         column4x4 += DivideBy4(step << subsampling_x)) {
+      post_filter->GetVerticalDeblockFilterEdgeInfoUV(
+          column4x4,
+          block_parameters.Address(GetDeblockPosition(row4x4, subsampling_y),
+                                   GetDeblockPosition(column4x4,
+                                                      subsampling_x)),
+          &level_uv[0], &level_uv[1], &step, &filter_length);
+      const int row = row4x4 >> subsampling_y;
+      const int column = column4x4 >> subsampling_x;
+      for (int plane = kPlaneU; plane <= kPlaneV; ++plane) {
+        level = level_uv[plane - kPlaneU];
+        if (level == 0) continue;
+        const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
+        expected_edges_[kLoopFilterTypeVertical][plane][row][column] =
+            PackDeblockEdge(level, size);
+        const ptrdiff_t stride = reference_yuv_buffer_.stride(plane);
+        loop_filters[size][kLoopFilterTypeVertical](
+            reference_yuv_buffer_.data(plane) + MultiplyBy4(row) * stride +
+                MultiplyBy4(column),
+            stride, outer_thresh[level], inner_thresh[level],
+            DivideBy16(level));
+      }
+    }
+  }
+}
+
+void PostFilterDeblockEdgesTest::ReferenceHorizontalDeblockFilter(
+    PostFilter* post_filter) {
+  const int rows4x4 = DivideBy4(frame_header_.height + 3);
+  const int columns4x4 = DivideBy4(frame_header_.width + 3);
+  const dsp::LoopFilterFuncs& loop_filters = dsp_->loop_filters;
+  const uint8_t* const outer_thresh = post_filter->outer_thresh_;
+  const uint8_t* const inner_thresh = post_filter->inner_thresh_;
+  uint8_t level;
+  int step;
+  int filter_length;
+
+  uint8_t* const src_y = reference_yuv_buffer_.data(kPlaneY);
+  const ptrdiff_t stride_y = reference_yuv_buffer_.stride(kPlaneY);
+  for (int column4x4 = 0; column4x4 < columns4x4; ++column4x4) {
+    for (int row4x4 = 0; row4x4 < rows4x4; row4x4 += DivideBy4(step)) {
+      if (post_filter->GetHorizontalDeblockFilterEdgeInfo(
+              row4x4, column4x4, &level, &step, &filter_length)) {
+        const dsp::LoopFilterSize size = GetLoopFilterSizeY(filter_length);
+        expected_edges_[kLoopFilterTypeHorizontal][kPlaneY][row4x4]
+                       [column4x4] = PackDeblockEdge(level, size);
+        loop_filters[size][kLoopFilterTypeHorizontal](
+            src_y + MultiplyBy4(row4x4) * stride_y + MultiplyBy4(column4x4),
+            stride_y, outer_thresh[level], inner_thresh[level],
+            DivideBy16(level));
+      }
+    }
+  }
+
+  const int8_t subsampling_x = param_.subsampling_x;
+  const int8_t subsampling_y = param_.subsampling_y;
+  uint8_t level_uv[2];
+  for (int column4x4 = 0; column4x4 < columns4x4;
+       column4x4 += 1 << subsampling_x) {
+    for (int row4x4 = 0; row4x4 < rows4x4;
+         row4x4 += DivideBy4(step << subsampling_y)) {
+      post_filter->GetHorizontalDeblockFilterEdgeInfoUV(
+          row4x4, column4x4, &level_uv[0], &level_uv[1], &step,
+          &filter_length);
+      const int row = row4x4 >> subsampling_y;
+      const int column = column4x4 >> subsampling_x;
+      for (int plane = kPlaneU; plane <= kPlaneV; ++plane) {
+        level = level_uv[plane - kPlaneU];
+        if (level == 0) continue;
+        const dsp::LoopFilterSize size = GetLoopFilterSizeUV(filter_length);
+        expected_edges_[kLoopFilterTypeHorizontal][plane][row][column] =
+            PackDeblockEdge(level, size);
+        const ptrdiff_t stride = reference_yuv_buffer_.stride(plane);
+        loop_filters[size][kLoopFilterTypeHorizontal](
+            reference_yuv_buffer_.data(plane) + MultiplyBy4(row) * stride +
+                MultiplyBy4(column),
+            stride, outer_thresh[level], inner_thresh[level],
+            DivideBy16(level));
+      }
+    }
+  }
+}
+
+void PostFilterDeblockEdgesTest::CompareEdges(PostFilter* post_filter) {
+  const int rows4x4 = DivideBy4(frame_header_.height + 3);
+  const int columns4x4 = DivideBy4(frame_header_.width + 3);
+  for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+    const int8_t subsampling_x = (plane == kPlaneY) ? 0 : param_.subsampling_x;
+    const int8_t subsampling_y = (plane == kPlaneY) ? 0 : param_.subsampling_y;
+    for (int type = 0; type < kNumLoopFilterTypes; ++type) {
+      const Array2D<uint8_t>& edges = post_filter->deblock_edges_[type][plane];
+      const Array2D<uint8_t>& expected_edges = expected_edges_[type][plane];
+      for (int row = 0; row < SubsampledValue(rows4x4, subsampling_y); ++row) {
+        for (int column = 0;
+             column < SubsampledValue(columns4x4, subsampling_x); ++column) {
+          // The edges on the tile borders are computed by the filter.
+          const bool tile_border =
+              (type == kLoopFilterTypeVertical)
+                  ? IsTileStart(tile_column_starts_, column << subsampling_x)
+                  : IsTileStart(tile_row_starts_, row << subsampling_y);
+          ASSERT_EQ(edges[row][column],
+                    tile_border ? kDeblockEdgeUnknown
+                                : expected_edges[row][column])
+              << "plane: " << plane << " type: " << type << " row: " << row
+              << " column: " << column;
+        }
+      }
+    }
+  }
+}
+
+void PostFilterDeblockEdgesTest::ComparePixels() {
+  for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+    const int subsampling_x = (plane == kPlaneY) ? 0 : param_.subsampling_x;
+    const int subsampling_y = (plane == kPlaneY) ? 0 : param_.subsampling_y;
+    const int plane_width =
+        MultiplyBy4(frame_header_.columns4x4) >> subsampling_x;
+    const int plane_height =
+        MultiplyBy4(frame_header_.rows4x4) >> subsampling_y;
+    const uint8_t* src = yuv_buffer_.data(plane);
+    const uint8_t* reference = reference_yuv_buffer_.data(plane);
+    for (int y = 0; y < plane_height; ++y) {
+      ASSERT_EQ(memcmp(src, reference, plane_width), 0)
+          << "plane: " << plane << " y: " << y;
+      src += yuv_buffer_.stride(plane);
+      reference += reference_yuv_buffer_.stride(plane);
+    }
+  }
+}
+
+TEST_P(PostFilterDeblockEdgesTest, StoredEdgesMatchPerEdgeComputation) {
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  for (int i = 0; i < 4; ++i) {
+    SetInput(&rnd);
+    SetInputBuffers(&rnd);
+    PostFilter post_filter(frame_header_, sequence_header_,
+                           &frame_scratch_buffer_, &yuv_buffer_, dsp_,
+                           /*do_post_filter_mask=*/0x01);
+    PostFilter reference_post_filter(frame_header_, sequence_header_,
+                                     &frame_scratch_buffer_,
+                                     &reference_yuv_buffer_, dsp_,
+                                     /*do_post_filter_mask=*/0x01);
+    DecodeBlocks(&rnd, &post_filter);
+    ASSERT_FALSE(HasFailure());
+
+    ReferenceVerticalDeblockFilter(&reference_post_filter);
+    ReferenceHorizontalDeblockFilter(&reference_post_filter);
+    CompareEdges(&post_filter);
+
+    DeblockFilter(&post_filter);
+    ComparePixels();
+  }
+}
+
+TEST_P(PostFilterDeblockEdgesTest, DISABLED_Speed) {
+  constexpr int kNumRuns = 100;
+  libvpx_test::ACMRandom rnd(libvpx_test::ACMRandom::DeterministicSeed());
+  SetInput(&rnd);
+  SetInputBuffers(&rnd);
+  PostFilter post_filter(frame_header_, sequence_header_,
+                         &frame_scratch_buffer_, &yuv_buffer_, dsp_,
+                         /*do_post_filter_mask=*/0x01);
+  PostFilter reference_post_filter(frame_header_, sequence_header_,
+                                   &frame_scratch_buffer_,
+                                   &reference_yuv_buffer_, dsp_,
+                                   /*do_post_filter_mask=*/0x01);
+  DecodeBlocks(&rnd, &post_filter);
+  ASSERT_FALSE(HasFailure());
+
+  // The edges are stored while the tiles are parsed, so the cost of the
+  // stored edges is the sum of the first two timings. The per-edge walk does
+  // all of its work in the deblocking filter.
+  absl::Duration elapsed_time;
+  absl::Time start = absl::Now();
+  for (int i = 0; i < kNumRuns; ++i) {
+    ClearDeblockEdges();
+    for (const BlockInfo& block : blocks_) {
+      post_filter.StoreDeblockEdges(block.row4x4, block.column4x4,
+                                    block.block_size, block.has_chroma,
+                                    block.tile_row4x4_start,
+                                    block.tile_column4x4_start);
+    }
+  }
+  const absl::Duration store_time = absl::Now() - start;
+  printf("Mode %s[%31s]: %5d us\n", "Deblock", "StoreDeblockEdges",
+         static_cast<int>(absl::ToInt64Microseconds(store_time)));
+
+  start = absl::Now();
+  for (int i = 0; i < kNumRuns; ++i) {
+    DeblockFilter(&post_filter);
+  }
+  elapsed_time = absl::Now() - start;
+  printf("Mode %s[%31s]: %5d us\n", "Deblock", "DeblockFilter",
+         static_cast<int>(absl::ToInt64Microseconds(elapsed_time)));
+  printf("Mode %s[%31s]: %5d us\n", "Deblock",
+         "StoreDeblockEdges+DeblockFilter",
+         static_cast<int>(
+             absl::ToInt64Microseconds(store_time + elapsed_time)));
+
+  start = absl::Now();
+  for (int i = 0; i < kNumRuns; ++i) {
+    ReferenceVerticalDeblockFilter(&reference_post_filter);
+    ReferenceHorizontalDeblockFilter(&reference_post_filter);
+  }
+  elapsed_time = absl::Now() - start;
+  printf("Mode %s[%31s]: %5d us\n", "Deblock", "PerEdge",
+         static_cast<int>(absl::ToInt64Microseconds(elapsed_time)));
+}
+
+const FrameSizeParam kTestParamDeblockEdges[] = {
+    FrameSizeParam(352, 352, 288, 0, 0),
+    FrameSizeParam(1920, 1920, 1080, 0, 0),
+    FrameSizeParam(251, 251, 187, 0, 0),
+    FrameSizeParam(36, 36, 20, 0, 0),
+    FrameSizeParam(352, 352, 288, 0, 1),
+    FrameSizeParam(1920, 1920, 1080, 0, 1),
+    FrameSizeParam(251, 251, 187, 0, 1),
+    FrameSizeParam(36, 36, 20, 0, 1),
+    FrameSizeParam(352, 352, 288, 1, 0),
+    FrameSizeParam(1920, 1920, 1080, 1, 0),
+    FrameSizeParam(251, 251, 187, 1, 0),
+    FrameSizeParam(36, 36, 20, 1, 0),
+    FrameSizeParam(352, 352, 288, 1, 1),
+    FrameSizeParam(1920, 1920, 1080, 1, 1),
+    FrameSizeParam(251, 251, 187, 1, 1),
+    FrameSizeParam(36, 36, 20, 1, 1),
+};
+
+INSTANTIATE_TEST_SUITE_P(PostFilterDeblockEdgesTestInstance,
+                         PostFilterDeblockEdgesTest,
+                         testing::ValuesIn(kTestParamDeblockEdges));
+
 }  // namespace libgav1
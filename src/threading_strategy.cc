@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <cassert>
 #include <memory>
+#include <numeric>
+#include <utility>
 
 #include "src/frame_scratch_buffer.h"
 #include "src/utils/constants.h"
@@ -41,6 +43,8 @@ constexpr int kFrameParallelThresholdMultiplier =
 //   * Otherwise, return the largest value of i which satisfies the following
 //     condition: i + i * tile_columns <= thread_count. This ensures that there
 //     are at least |tile_columns| worker threads for each frame thread.
+//   * If |max_frame_threads| is not 0, the value is limited to
+//     |max_frame_threads| (and 0 is returned if that is less than 2).
 //   * This function will never return 1 or a value > |thread_count|.
 //
 //  This heuristic is based on empirical performance data. The in-frame
@@ -56,16 +60,130 @@ constexpr int kFrameParallelThresholdMultiplier =
 //  |tile_count| because in most practical cases there aren't more than that
 //  many superblock rows and columns available to work on in parallel.
 int ComputeFrameThreadCount(int thread_count, int tile_count,
-                            int tile_columns) {
+                            int tile_columns, int max_frame_threads) {
   assert(thread_count > 0);
+  assert(max_frame_threads >= 0);
   if (thread_count == 1) return 0;
-  return (thread_count <= tile_count * kFrameParallelThresholdMultiplier)
-             ? 0
-             : std::max(2, thread_count / (1 + tile_columns));
+  if (thread_count <= tile_count * kFrameParallelThresholdMultiplier) return 0;
+  int frame_threads = std::max(2, thread_count / (1 + tile_columns));
+  if (max_frame_threads != 0) {
+    frame_threads = std::min(frame_threads, max_frame_threads);
+    if (frame_threads < 2) return 0;
+  }
+  return frame_threads;
 }
 
+// The estimates in DecodeStageCosts are exponential moving averages with a
+// weight of 1 / (1 << kStageCostAverageLog2) for the most recent frame.
+constexpr int kStageCostAverageLog2 = 2;
+
+// Number of frames that have to be measured with a thread count before
+// ComputeAdaptiveThreadCount() switches to another thread count.
+constexpr int kMinFramesForAdaptation = 4;
+
+// Minimum amount of work (in microseconds of single threaded decoding) per
+// thread for a frame to be worth multi-threading.
+#if !defined(LIBGAV1_MIN_THREADED_FRAME_COST_US)
+constexpr int kMinThreadedFrameCostUs = 250;
+#else
+constexpr int kMinThreadedFrameCostUs = LIBGAV1_MIN_THREADED_FRAME_COST_US;
+#endif
+
+// Upper bound of the speedup that is expected from multi-threading a frame in
+// non frame parallel mode. Used to estimate the single threaded cost from the
+// multi-threaded cost.
+constexpr int kMaxExpectedThreadedSpeedup = 4;
+
 }  // namespace
 
+void DecodeStageCosts::EndFrame(int thread_count) {
+  if (frames_ == 0 || thread_count != thread_count_) {
+    for (int i = 0; i < kNumStages; ++i) average_[i] = current_[i];
+    frames_ = 1;
+    thread_count_ = thread_count;
+  } else {
+    for (int i = 0; i < kNumStages; ++i) {
+      average_[i] += (current_[i] - average_[i]) / (1 << kStageCostAverageLog2);
+    }
+    ++frames_;
+  }
+  for (auto& cost : current_) cost = 0;
+}
+
+void DecodeStageCosts::Reset() {
+  for (int i = 0; i < kNumStages; ++i) {
+    current_[i] = 0;
+    average_[i] = 0;
+  }
+  frames_ = 0;
+  thread_count_ = 0;
+}
+
+int ComputeAdaptiveThreadCount(int thread_count,
+                               const DecodeStageCosts& costs) {
+  assert(thread_count > 0);
+  if (thread_count == 1 || costs.frames() == 0) return thread_count;
+  const int current_thread_count = std::min(costs.thread_count(), thread_count);
+  if (costs.frames() < kMinFramesForAdaptation) {
+    // Keep the current thread count until there are enough measurements.
+    return current_thread_count;
+  }
+  const int64_t single_threaded_cost =
+      costs.frame_cost() *
+      std::min(current_thread_count, kMaxExpectedThreadedSpeedup);
+  // Every thread should get at least kMinThreadedFrameCostUs worth of work.
+  // The current thread count is kept as long as the work per thread is less
+  // than twice that, so that small changes of the estimate do not recreate
+  // the thread pool.
+  const int64_t min_cost = kMinThreadedFrameCostUs;
+  if (single_threaded_cost >= min_cost * current_thread_count &&
+      single_threaded_cost < 2 * min_cost * current_thread_count) {
+    return current_thread_count;
+  }
+  return static_cast<int>(std::max<int64_t>(
+      std::min<int64_t>(single_threaded_cost / min_cost, thread_count), 1));
+}
+
+bool ComputeTileOrder(const Vector<TileBuffer>& tile_buffers,
+                      FrameScratchBuffer* const frame_scratch_buffer) {
+  const int tile_count = static_cast<int>(tile_buffers.size());
+  if (!frame_scratch_buffer->tile_order.Resize(tile_count) ||
+      !frame_scratch_buffer->tile_costs.Resize(tile_count)) {
+    frame_scratch_buffer->tile_cost_count = 0;
+    return false;
+  }
+  int* const tile_order = frame_scratch_buffer->tile_order.get();
+  TileCost* const tile_costs = frame_scratch_buffer->tile_costs.get();
+  bool use_measured_costs =
+      frame_scratch_buffer->tile_cost_count == tile_count;
+  for (int i = 0; use_measured_costs && i < tile_count; ++i) {
+    use_measured_costs =
+        tile_costs[i].size != 0 && tile_costs[i].microseconds > 0;
+  }
+  // The estimates are stored in |tile_costs[i].microseconds| for sorting.
+  for (int i = 0; i < tile_count; ++i) {
+    const auto size = static_cast<int64_t>(tile_buffers[i].size);
+    tile_costs[i].microseconds =
+        use_measured_costs
+            ? size * tile_costs[i].microseconds /
+                  static_cast<int64_t>(tile_costs[i].size)
+            : size;
+  }
+  std::iota(tile_order, tile_order + tile_count, 0);
+  std::stable_sort(tile_order, tile_order + tile_count,
+                   [tile_costs](int a, int b) {
+                     return tile_costs[a].microseconds >
+                            tile_costs[b].microseconds;
+                   });
+  // The decoding times are filled in by the threads that process the tiles.
+  for (int i = 0; i < tile_count; ++i) {
+    tile_costs[i].size = tile_buffers[i].size;
+    tile_costs[i].microseconds = 0;
+  }
+  frame_scratch_buffer->tile_cost_count = tile_count;
+  return true;
+}
+
 bool ThreadingStrategy::Reset(const ObuFrameHeader& frame_header,
                               int thread_count) {
   assert(thread_count > 0);
@@ -150,7 +268,7 @@ bool ThreadingStrategy::Reset(const ObuFrameHeader& frame_header,
 }
 
 bool ThreadingStrategy::Reset(int thread_count) {
-  assert(thread_count > 0);
+  assert(thread_count >= 0);
   frame_parallel_ = true;
 
   // In frame parallel mode, we simply access the underlying |thread_pool_|
@@ -160,6 +278,10 @@ bool ThreadingStrategy::Reset(int thread_count) {
   tile_thread_count_ = 0;
   max_tile_index_for_row_threads_ = 0;
 
+  if (thread_count == 0) {
+    thread_pool_.reset(nullptr);
+    return true;
+  }
   if (thread_pool_ == nullptr || thread_pool_->num_threads() != thread_count) {
     thread_pool_ = ThreadPool::Create("libgav1-fp", thread_count);
     if (thread_pool_ == nullptr) {
@@ -171,14 +293,21 @@ bool ThreadingStrategy::Reset(int thread_count) {
   return true;
 }
 
+void ThreadingStrategy::Reset(std::unique_ptr<ThreadPool> thread_pool) {
+  frame_parallel_ = true;
+  tile_thread_count_ = 0;
+  max_tile_index_for_row_threads_ = 0;
+  thread_pool_ = std::move(thread_pool);
+}
+
 bool InitializeThreadPoolsForFrameParallel(
-    int thread_count, int tile_count, int tile_columns,
+    int thread_count, int tile_count, int tile_columns, int max_frame_threads,
     std::unique_ptr<ThreadPool>* const frame_thread_pool,
     FrameScratchBufferPool* const frame_scratch_buffer_pool) {
   assert(*frame_thread_pool == nullptr);
   thread_count = std::min(thread_count, static_cast<int>(kMaxThreads));
-  const int frame_threads =
-      ComputeFrameThreadCount(thread_count, tile_count, tile_columns);
+  const int frame_threads = ComputeFrameThreadCount(
+      thread_count, tile_count, tile_columns, max_frame_threads);
   if (frame_threads == 0) return true;
   *frame_thread_pool = ThreadPool::Create(frame_threads);
   if (*frame_thread_pool == nullptr) {
@@ -186,30 +315,73 @@ bool InitializeThreadPoolsForFrameParallel(
                  frame_threads);
     return false;
   }
-  int remaining_threads = thread_count - frame_threads;
-  if (remaining_threads == 0) return true;
-  int threads_per_frame = remaining_threads / frame_threads;
+  if (thread_count == frame_threads) return true;
+  return ResetThreadPoolsForFrameParallel(thread_count, frame_threads,
+                                          frame_scratch_buffer_pool);
+}
+
+bool ResetThreadPoolsForFrameParallel(
+    int thread_count, int frame_threads,
+    FrameScratchBufferPool* const frame_scratch_buffer_pool) {
+  assert(frame_threads > 0);
+  thread_count = std::min(thread_count, static_cast<int>(kMaxThreads));
+  int remaining_threads = std::max(thread_count - frame_threads, 0);
+  const int threads_per_frame = remaining_threads / frame_threads;
   const int extra_threads = remaining_threads % frame_threads;
   Vector<std::unique_ptr<FrameScratchBuffer>> frame_scratch_buffers;
-  if (!frame_scratch_buffers.reserve(frame_threads)) return false;
-  // Create the tile thread pools.
-  for (int i = 0; i < frame_threads && remaining_threads > 0; ++i) {
+  Vector<std::unique_ptr<ThreadPool>> thread_pools;
+  if (!frame_scratch_buffers.reserve(frame_threads) ||
+      !thread_pools.reserve(frame_threads)) {
+    return false;
+  }
+  // Create the tile thread pools whose size changes. Nothing is replaced until
+  // all of them have been created so that the existing thread pools are kept
+  // on failure.
+  bool ok = true;
+  for (int i = 0; i < frame_threads; ++i) {
     std::unique_ptr<FrameScratchBuffer> frame_scratch_buffer =
         frame_scratch_buffer_pool->Get();
     if (frame_scratch_buffer == nullptr) {
-      return false;
+      ok = false;
+      break;
     }
     // If the number of tile threads cannot be divided equally amongst all the
     // frame threads, assign one extra thread to the first |extra_threads| frame
     // threads.
     const int current_frame_thread_count =
         threads_per_frame + static_cast<int>(i < extra_threads);
-    if (!frame_scratch_buffer->threading_strategy.Reset(
-            current_frame_thread_count)) {
-      return false;
-    }
     remaining_threads -= current_frame_thread_count;
+    const ThreadPool* const thread_pool =
+        frame_scratch_buffer->threading_strategy.thread_pool();
+    std::unique_ptr<ThreadPool> new_thread_pool;
+    if (current_frame_thread_count != 0 &&
+        (thread_pool == nullptr ||
+         thread_pool->num_threads() != current_frame_thread_count)) {
+      new_thread_pool =
+          ThreadPool::Create("libgav1-fp", current_frame_thread_count);
+      if (new_thread_pool == nullptr) {
+        LIBGAV1_DLOG(ERROR, "Failed to create a thread pool with %d threads.",
+                     current_frame_thread_count);
+        ok = false;
+      }
+    }
     frame_scratch_buffers.push_back_unchecked(std::move(frame_scratch_buffer));
+    thread_pools.push_back_unchecked(std::move(new_thread_pool));
+    if (!ok) break;
+  }
+  assert(!ok || remaining_threads == 0);
+  if (ok) {
+    // Every buffer that may be used by a frame thread is visited so that the
+    // buffers that no longer get any worker threads release their thread
+    // pools.
+    for (int i = 0; i < frame_threads; ++i) {
+      ThreadingStrategy& threading_strategy =
+          frame_scratch_buffers[i]->threading_strategy;
+      if (thread_pools[i] != nullptr ||
+          threads_per_frame + static_cast<int>(i < extra_threads) == 0) {
+        threading_strategy.Reset(std::move(thread_pools[i]));
+      }
+    }
   }
   // We release the frame scratch buffers in reverse order so that the extra
   // threads are allocated to buffers in the top of the stack.
@@ -217,6 +389,42 @@ bool InitializeThreadPoolsForFrameParallel(
        --i) {
     frame_scratch_buffer_pool->Release(std::move(frame_scratch_buffers[i]));
   }
+  return ok;
+}
+
+int ComputeFrameThreadCountForResize(int thread_count, int tile_count,
+                                     int tile_columns, int max_frame_threads) {
+  thread_count = std::min(thread_count, static_cast<int>(kMaxThreads));
+  return std::max(ComputeFrameThreadCount(thread_count, tile_count,
+                                          tile_columns, max_frame_threads),
+                  1);
+}
+
+bool ResizeThreadPoolsForFrameParallel(
+    int thread_count, int tile_count, int tile_columns, int max_frame_threads,
+    std::unique_ptr<ThreadPool>* const frame_thread_pool,
+    FrameScratchBufferPool* const frame_scratch_buffer_pool) {
+  assert(*frame_thread_pool != nullptr);
+  const int frame_threads = ComputeFrameThreadCountForResize(
+      thread_count, tile_count, tile_columns, max_frame_threads);
+  std::unique_ptr<ThreadPool> new_frame_thread_pool;
+  if ((*frame_thread_pool)->num_threads() != frame_threads) {
+    new_frame_thread_pool = ThreadPool::Create(frame_threads);
+    if (new_frame_thread_pool == nullptr) {
+      LIBGAV1_DLOG(ERROR, "Failed to create frame thread pool with %d threads.",
+                   frame_threads);
+      return false;
+    }
+  }
+  if (!ResetThreadPoolsForFrameParallel(thread_count, frame_threads,
+                                        frame_scratch_buffer_pool)) {
+    return false;
+  }
+  if (new_frame_thread_pool != nullptr) {
+    // This joins the old (idle) frame threads.
+    *frame_thread_pool = std::move(new_frame_thread_pool);
+  }
+  frame_scratch_buffer_pool->Shrink(frame_threads);
   return true;
 }
 
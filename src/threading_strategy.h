@@ -17,14 +17,17 @@
 #ifndef LIBGAV1_SRC_THREADING_STRATEGY_H_
 #define LIBGAV1_SRC_THREADING_STRATEGY_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "src/obu_parser.h"
 #include "src/utils/compiler_attributes.h"
 #include "src/utils/threadpool.h"
+#include "src/utils/vector.h"
 
 namespace libgav1 {
 
+struct FrameScratchBuffer;
 class FrameScratchBufferPool;
 
 // This class allocates and manages the worker threads among thread pools used
@@ -55,11 +58,19 @@ class ThreadingStrategy {
   // Creates or re-allocates a thread pool with |thread_count| threads. This
   // function is used only in frame parallel mode. This function is idempotent
   // if the |thread_count| doesn't change between calls (it will only create new
-  // threads on the first call and do nothing on the subsequent calls).
+  // threads on the first call and do nothing on the subsequent calls). If
+  // |thread_count| is 0, the thread pool is released.
   // Note: During the lifetime of a ThreadingStrategy object, only one of the
   // Reset() variants will be used.
   LIBGAV1_MUST_USE_RESULT bool Reset(int thread_count);
 
+  // Same as Reset(int) with the number of threads of |thread_pool|, but uses
+  // |thread_pool| instead of creating a new thread pool. If |thread_pool| is
+  // nullptr, the thread pool is released. This function is used only in frame
+  // parallel mode, to create the thread pools of all the frame threads before
+  // any of them is replaced.
+  void Reset(std::unique_ptr<ThreadPool> thread_pool);
+
   // Returns a pointer to the ThreadPool that is to be used for Tile
   // multi-threading.
   ThreadPool* tile_thread_pool() const {
@@ -100,12 +111,95 @@ class ThreadingStrategy {
   bool frame_parallel_ = false;
 };
 
+// Running estimates of the wall clock time spent in each stage of decoding a
+// frame in non frame parallel mode. The decoder adds the measurements of every
+// frame and ComputeAdaptiveThreadCount() uses them to decide how many threads
+// to use for the next frame.
+class DecodeStageCosts {
+ public:
+  enum Stage {
+    // Parsing and reconstruction of all the tiles. When the post filters are
+    // applied in the decode loop (single threaded decoding), their cost is
+    // included in this stage.
+    kStageTiles,
+    // Post filters applied after all the tiles have been decoded.
+    kStagePostFilter,
+    // Film grain synthesis and blending.
+    kStageFilmGrain,
+    kNumStages
+  };
+
+  DecodeStageCosts() = default;
+
+  // Adds the cost (in microseconds) of |stage| of the frame that is currently
+  // being measured.
+  void AddStageCost(Stage stage, int64_t microseconds) {
+    current_[stage] += microseconds;
+  }
+
+  // Folds the stage costs of the current frame into the running estimates.
+  // |thread_count| is the number of threads (including the current thread)
+  // that the frame was decoded with. The estimates are restarted whenever
+  // |thread_count| changes so that they always describe the thread count that
+  // is currently in use.
+  void EndFrame(int thread_count);
+
+  // Discards all the estimates. Called when the measurements no longer apply,
+  // e.g. after a flush or a change of the number of threads.
+  void Reset();
+
+  // Number of frames that were measured since the estimates were last
+  // restarted.
+  int frames() const { return frames_; }
+  int thread_count() const { return thread_count_; }
+  int64_t stage_cost(Stage stage) const { return average_[stage]; }
+  int64_t frame_cost() const {
+    return average_[kStageTiles] + average_[kStagePostFilter] +
+           average_[kStageFilmGrain];
+  }
+
+ private:
+  int64_t current_[kNumStages] = {};
+  // Exponential moving averages over recent frames.
+  int64_t average_[kNumStages] = {};
+  int frames_ = 0;
+  int thread_count_ = 0;
+};
+
+// Returns the number of threads (at most |thread_count|) that should be used
+// to decode the next frame in non frame parallel mode, based on the measured
+// |costs| of the recent frames. Handing work to the worker threads and applying
+// the post filters in a separate pass has a fixed cost per frame, so a thread
+// only pays off if it gets enough work. The thread count is scaled with the
+// estimated single threaded cost of a frame such that every thread gets at
+// least LIBGAV1_MIN_THREADED_FRAME_COST_US microseconds of work. For cheap
+// frames (small frames or simple content) this returns 1 so that the frame is
+// decoded in the current thread with the post filters applied in the decode
+// loop. Only the thread count is throttled; the threads are split between the
+// tile, row and post filter work as they are with a fixed thread count.
+int ComputeAdaptiveThreadCount(int thread_count, const DecodeStageCosts& costs);
+
+// Fills |frame_scratch_buffer->tile_order| with the tile indices sorted by
+// decreasing estimated cost so that the threads start with the most expensive
+// tiles and the frame is not held up by a large tile that is picked up last.
+// The cost of a tile is estimated from its compressed size. If the previous
+// frame that was decoded using |frame_scratch_buffer| had the same number of
+// tiles, the size is scaled by the decoding time per byte that was measured
+// for the tile at the same position in that frame.
+// Returns false if the memory for the tile order cannot be allocated.
+bool ComputeTileOrder(const Vector<TileBuffer>& tile_buffers,
+                      FrameScratchBuffer* frame_scratch_buffer);
+
 // Initializes the |frame_thread_pool| and the necessary worker threadpools (the
 // threading_strategy objects in each of the frame scratch buffer in
 // |frame_scratch_buffer_pool|) as follows:
 //  * frame_threads = ComputeFrameThreadCount();
 //  * For more details on how frame_threads is computed, see the function
-//    comment in ComputeFrameThreadCount().
+//    comment in ComputeFrameThreadCount(). If |max_frame_threads| is not 0,
+//    frame_threads is at most |max_frame_threads|. Since every frame thread
+//    decodes one frame, this bounds the number of frames in flight (and hence
+//    the number of frame scratch buffers and the output latency). The threads
+//    that are not used as frame threads become worker threads of the frames.
 //  * |frame_thread_pool| is created with |frame_threads| threads.
 //  * divide the remaining number of threads into each frame thread and
 //    initialize a frame_scratch_buffer.threading_strategy for each frame
@@ -122,7 +216,44 @@ class ThreadingStrategy {
 //      modified. This means that frame threading will not be used and the
 //      decoder will continue to operate normally in non frame parallel mode.
 LIBGAV1_MUST_USE_RESULT bool InitializeThreadPoolsForFrameParallel(
-    int thread_count, int tile_count, int tile_columns,
+    int thread_count, int tile_count, int tile_columns, int max_frame_threads,
+    std::unique_ptr<ThreadPool>* frame_thread_pool,
+    FrameScratchBufferPool* frame_scratch_buffer_pool);
+
+// Divides |thread_count| - |frame_threads| worker threads among the
+// threading_strategy objects of the |frame_threads| frame scratch buffers at
+// the top of |frame_scratch_buffer_pool| using the same policy as
+// InitializeThreadPoolsForFrameParallel(). The thread pools are grown or
+// shrunk as necessary (and released if a frame thread gets no worker threads).
+// Used to change the thread count of a decoder that is already running in
+// frame parallel mode. None of the frame scratch buffers may be in use when
+// this function is called. Returns true on success. On failure, the thread
+// pools of the frame scratch buffers are not changed.
+LIBGAV1_MUST_USE_RESULT bool ResetThreadPoolsForFrameParallel(
+    int thread_count, int frame_threads,
+    FrameScratchBufferPool* frame_scratch_buffer_pool);
+
+// Returns the number of frame threads that ResizeThreadPoolsForFrameParallel()
+// uses for the given arguments. This is ComputeFrameThreadCount(), but at least
+// 1 since the decoder cannot leave frame parallel mode.
+int ComputeFrameThreadCountForResize(int thread_count, int tile_count,
+                                     int tile_columns, int max_frame_threads);
+
+// Changes the thread count of a decoder that is already running in frame
+// parallel mode to |thread_count|. The number of frame threads is recomputed
+// with ComputeFrameThreadCountForResize() for the tile layout that
+// InitializeThreadPoolsForFrameParallel() was called with, and
+// |frame_thread_pool| is recreated if it changes. A single frame thread is
+// used if the heuristic prefers in-frame threading. The frame scratch buffers
+// beyond the number of frame threads are freed along with their thread pools,
+// and the remaining threads are divided as in
+// ResetThreadPoolsForFrameParallel(). None of the frame scratch buffers may be
+// in use and |frame_thread_pool| must be idle when this function is called.
+// Returns true on success. All the new thread pools are created before any of
+// the existing ones is replaced, so on failure the thread pools are not
+// changed and the decoder can keep using them.
+LIBGAV1_MUST_USE_RESULT bool ResizeThreadPoolsForFrameParallel(
+    int thread_count, int tile_count, int tile_columns, int max_frame_threads,
     std::unique_ptr<ThreadPool>* frame_thread_pool,
     FrameScratchBufferPool* frame_scratch_buffer_pool);
 
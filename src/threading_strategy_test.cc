@@ -14,7 +14,10 @@
 
 #include "src/threading_strategy.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <utility>
 #include <vector>
 
@@ -191,41 +194,56 @@ TEST_F(ThreadingStrategyTest, MultipleCalls2) {
   EXPECT_NE(strategy_.post_filter_thread_pool(), nullptr);
 }
 
+// Verifies that the |expected_tile_threads.size()| frame scratch buffers at the
+// top of |frame_scratch_buffer_pool| have the expected number of tile threads
+// and returns the total number of tile threads.
+int VerifyTileThreads(FrameScratchBufferPool* frame_scratch_buffer_pool,
+                      const std::vector<int>& expected_tile_threads) {
+  std::vector<std::unique_ptr<FrameScratchBuffer>> frame_scratch_buffers;
+  int actual_thread_count = 0;
+  for (size_t i = 0; i < expected_tile_threads.size(); ++i) {
+    SCOPED_TRACE(absl::StrCat("i: ", i));
+    frame_scratch_buffers.push_back(frame_scratch_buffer_pool->Get());
+    ThreadPool* const thread_pool =
+        frame_scratch_buffers.back()->threading_strategy.thread_pool();
+    if (expected_tile_threads[i] > 0) {
+      EXPECT_NE(thread_pool, nullptr);
+      if (thread_pool == nullptr) continue;
+      EXPECT_EQ(thread_pool->num_threads(), expected_tile_threads[i]);
+      actual_thread_count += thread_pool->num_threads();
+    } else {
+      EXPECT_EQ(thread_pool, nullptr);
+    }
+  }
+  // Release the buffers in reverse order to restore the order of the stack.
+  while (!frame_scratch_buffers.empty()) {
+    frame_scratch_buffer_pool->Release(std::move(frame_scratch_buffers.back()));
+    frame_scratch_buffers.pop_back();
+  }
+  return actual_thread_count;
+}
+
 void VerifyFrameParallel(int thread_count, int tile_count, int tile_columns,
                          int expected_frame_threads,
-                         const std::vector<int>& expected_tile_threads) {
+                         const std::vector<int>& expected_tile_threads,
+                         int max_frame_threads = 0) {
   ASSERT_EQ(expected_frame_threads, expected_tile_threads.size());
   ASSERT_GT(thread_count, 1);
   std::unique_ptr<ThreadPool> frame_thread_pool;
   FrameScratchBufferPool frame_scratch_buffer_pool;
   ASSERT_TRUE(InitializeThreadPoolsForFrameParallel(
-      thread_count, tile_count, tile_columns, &frame_thread_pool,
-      &frame_scratch_buffer_pool));
+      thread_count, tile_count, tile_columns, max_frame_threads,
+      &frame_thread_pool, &frame_scratch_buffer_pool));
   if (expected_frame_threads == 0) {
     EXPECT_EQ(frame_thread_pool, nullptr);
     return;
   }
   EXPECT_NE(frame_thread_pool.get(), nullptr);
   EXPECT_EQ(frame_thread_pool->num_threads(), expected_frame_threads);
-  std::vector<std::unique_ptr<FrameScratchBuffer>> frame_scratch_buffers;
-  int actual_thread_count = frame_thread_pool->num_threads();
-  for (int i = 0; i < expected_frame_threads; ++i) {
-    SCOPED_TRACE(absl::StrCat("i: ", i));
-    frame_scratch_buffers.push_back(frame_scratch_buffer_pool.Get());
-    ThreadPool* const thread_pool =
-        frame_scratch_buffers.back()->threading_strategy.thread_pool();
-    if (expected_tile_threads[i] > 0) {
-      EXPECT_NE(thread_pool, nullptr);
-      EXPECT_EQ(thread_pool->num_threads(), expected_tile_threads[i]);
-      actual_thread_count += thread_pool->num_threads();
-    } else {
-      EXPECT_EQ(thread_pool, nullptr);
-    }
-  }
+  const int actual_thread_count =
+      frame_thread_pool->num_threads() +
+      VerifyTileThreads(&frame_scratch_buffer_pool, expected_tile_threads);
   EXPECT_EQ(thread_count, actual_thread_count);
-  for (auto& frame_scratch_buffer : frame_scratch_buffers) {
-    frame_scratch_buffer_pool.Release(std::move(frame_scratch_buffer));
-  }
 }
 
 TEST(FrameParallelStrategyTest, FrameParallel) {
@@ -271,12 +289,40 @@ TEST(FrameParallelStrategyTest, FrameParallel) {
       /*expected_frame_threads=*/4, /*expected_tile_threads=*/{4, 3, 3, 3});
 }
 
+TEST(FrameParallelStrategyTest, MaxFrameThreads) {
+  // Without the limit, there would be 4 frame threads with 1 tile thread each.
+  VerifyFrameParallel(
+      /*thread_count=*/8, /*tile_count=*/1, /*tile_columns=*/1,
+      /*expected_frame_threads=*/4, /*expected_tile_threads=*/{1, 1, 1, 1},
+      /*max_frame_threads=*/4);
+  VerifyFrameParallel(
+      /*thread_count=*/8, /*tile_count=*/1, /*tile_columns=*/1,
+      /*expected_frame_threads=*/3, /*expected_tile_threads=*/{2, 2, 1},
+      /*max_frame_threads=*/3);
+  VerifyFrameParallel(
+      /*thread_count=*/8, /*tile_count=*/1, /*tile_columns=*/1,
+      /*expected_frame_threads=*/2, /*expected_tile_threads=*/{3, 3},
+      /*max_frame_threads=*/2);
+  // A limit of 1 disables frame parallel mode.
+  VerifyFrameParallel(
+      /*thread_count=*/8, /*tile_count=*/1, /*tile_columns=*/1,
+      /*expected_frame_threads=*/0, /*expected_tile_threads=*/{},
+      /*max_frame_threads=*/1);
+  // The limit does not enable frame parallel mode when it would not be used
+  // otherwise.
+  VerifyFrameParallel(
+      /*thread_count=*/4, /*tile_count=*/2, /*tile_columns=*/2,
+      /*expected_frame_threads=*/0, /*expected_tile_threads=*/{},
+      /*max_frame_threads=*/2);
+}
+
 TEST(FrameParallelStrategyTest, ThreadCountDoesNotExceedkMaxThreads) {
   std::unique_ptr<ThreadPool> frame_thread_pool;
   FrameScratchBufferPool frame_scratch_buffer_pool;
   ASSERT_TRUE(InitializeThreadPoolsForFrameParallel(
       /*thread_count=*/kMaxThreads + 10, /*tile_count=*/2, /*tile_columns=*/2,
-      &frame_thread_pool, &frame_scratch_buffer_pool));
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
   EXPECT_NE(frame_thread_pool.get(), nullptr);
   std::vector<std::unique_ptr<FrameScratchBuffer>> frame_scratch_buffers;
   int actual_thread_count = frame_thread_pool->num_threads();
@@ -298,5 +344,243 @@ TEST(FrameParallelStrategyTest, ThreadCountDoesNotExceedkMaxThreads) {
   }
 }
 
+TEST(FrameParallelStrategyTest, ResetThreadPoolsForFrameParallel) {
+  std::unique_ptr<ThreadPool> frame_thread_pool;
+  FrameScratchBufferPool frame_scratch_buffer_pool;
+  ASSERT_TRUE(InitializeThreadPoolsForFrameParallel(
+      /*thread_count=*/14, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  const int frame_threads = frame_thread_pool->num_threads();
+  ASSERT_EQ(frame_threads, 4);
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {3, 3, 2, 2}), 10);
+
+  // Shrink the tile thread pools.
+  ASSERT_TRUE(ResetThreadPoolsForFrameParallel(
+      /*thread_count=*/9, frame_threads, &frame_scratch_buffer_pool));
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {2, 1, 1, 1}), 5);
+
+  // Only the frame threads remain.
+  ASSERT_TRUE(ResetThreadPoolsForFrameParallel(
+      /*thread_count=*/2, frame_threads, &frame_scratch_buffer_pool));
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {0, 0, 0, 0}), 0);
+
+  // Grow the tile thread pools again.
+  ASSERT_TRUE(ResetThreadPoolsForFrameParallel(
+      /*thread_count=*/18, frame_threads, &frame_scratch_buffer_pool));
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {4, 4, 3, 3}), 14);
+}
+
+TEST(FrameParallelStrategyTest, ResizeThreadPoolsForFrameParallel) {
+  std::unique_ptr<ThreadPool> frame_thread_pool;
+  FrameScratchBufferPool frame_scratch_buffer_pool;
+  ASSERT_TRUE(InitializeThreadPoolsForFrameParallel(
+      /*thread_count=*/14, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  ASSERT_EQ(frame_thread_pool->num_threads(), 4);
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {3, 3, 2, 2}), 10);
+
+  // Fewer frame threads. The buffer of the fourth frame thread is freed, so a
+  // new buffer without a thread pool is returned after the first three.
+  ASSERT_TRUE(ResizeThreadPoolsForFrameParallel(
+      /*thread_count=*/9, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  EXPECT_EQ(frame_thread_pool->num_threads(), 3);
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {2, 2, 2, 0}), 6);
+
+  // Too few threads for frame parallelism. A single frame thread gets all the
+  // other threads.
+  ASSERT_TRUE(ResizeThreadPoolsForFrameParallel(
+      /*thread_count=*/3, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  EXPECT_EQ(frame_thread_pool->num_threads(), 1);
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {2, 0}), 2);
+
+  // The limit on the number of frame threads still applies.
+  ASSERT_TRUE(ResizeThreadPoolsForFrameParallel(
+      /*thread_count=*/14, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/2, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  EXPECT_EQ(frame_thread_pool->num_threads(), 2);
+  EXPECT_EQ(VerifyTileThreads(&frame_scratch_buffer_pool, {6, 6}), 12);
+
+  // More frame threads.
+  ASSERT_TRUE(ResizeThreadPoolsForFrameParallel(
+      /*thread_count=*/18, /*tile_count=*/2, /*tile_columns=*/2,
+      /*max_frame_threads=*/0, &frame_thread_pool,
+      &frame_scratch_buffer_pool));
+  ASSERT_NE(frame_thread_pool.get(), nullptr);
+  EXPECT_EQ(frame_thread_pool->num_threads(), 6);
+  EXPECT_EQ(
+      VerifyTileThreads(&frame_scratch_buffer_pool, {2, 2, 2, 2, 2, 2}), 12);
+}
+
+TEST(DecodeStageCostsTest, AdaptiveThreadCount) {
+  DecodeStageCosts costs;
+  // No measurements yet.
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 8);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(1, costs), 1);
+
+  // Cheap multi-threaded frames. The decoder switches to single threaded
+  // decoding only after a few frames have been measured.
+  for (int i = 0; i < 3; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 20);
+    costs.AddStageCost(DecodeStageCosts::kStagePostFilter, 10);
+    costs.EndFrame(/*thread_count=*/8);
+    EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 8);
+  }
+  costs.AddStageCost(DecodeStageCosts::kStageTiles, 20);
+  costs.EndFrame(/*thread_count=*/8);
+  EXPECT_EQ(costs.frames(), 4);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 1);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(1, costs), 1);
+
+  // Changing the thread count restarts the estimates. Single threaded frames
+  // that cost less than twice the minimum work per thread stay single
+  // threaded.
+  costs.AddStageCost(DecodeStageCosts::kStageTiles, 400);
+  costs.EndFrame(/*thread_count=*/1);
+  EXPECT_EQ(costs.frames(), 1);
+  EXPECT_EQ(costs.thread_count(), 1);
+  EXPECT_EQ(costs.frame_cost(), 400);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 1);
+  for (int i = 0; i < 3; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 400);
+    costs.EndFrame(/*thread_count=*/1);
+  }
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 1);
+
+  // The thread count scales with the cost. The running estimate moves from
+  // 400us towards 1000us, which is enough work for 3 threads.
+  for (int i = 0; i < 4; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 900);
+    costs.AddStageCost(DecodeStageCosts::kStageFilmGrain, 100);
+    costs.EndFrame(/*thread_count=*/1);
+  }
+  EXPECT_EQ(costs.frames(), 8);
+  EXPECT_GT(costs.frame_cost(), 750);
+  EXPECT_LT(costs.frame_cost(), 1000);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 3);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(2, costs), 2);
+
+  // The estimated single threaded cost of 3 * 400us keeps 3 threads busy
+  // enough without justifying more threads.
+  for (int i = 0; i < 8; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 300);
+    costs.AddStageCost(DecodeStageCosts::kStagePostFilter, 100);
+    costs.EndFrame(/*thread_count=*/3);
+    EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 3);
+  }
+  EXPECT_EQ(costs.stage_cost(DecodeStageCosts::kStageTiles), 300);
+  EXPECT_EQ(costs.stage_cost(DecodeStageCosts::kStageFilmGrain), 0);
+
+  // More expensive frames use all the threads.
+  for (int i = 0; i < 4; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 30000);
+    costs.EndFrame(/*thread_count=*/3);
+  }
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 8);
+
+  // Cheaper frames reduce the thread count gradually.
+  for (int i = 0; i < 4; ++i) {
+    costs.AddStageCost(DecodeStageCosts::kStageTiles, 150);
+    costs.EndFrame(/*thread_count=*/8);
+  }
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 2);
+
+  costs.Reset();
+  EXPECT_EQ(costs.frames(), 0);
+  EXPECT_EQ(ComputeAdaptiveThreadCount(8, costs), 8);
+}
+
+// Sets the compressed sizes of |tile_buffers| to |sizes|.
+void SetTileSizes(const std::vector<size_t>& sizes,
+                  Vector<TileBuffer>* const tile_buffers) {
+  tile_buffers->clear();
+  ASSERT_TRUE(tile_buffers->reserve(sizes.size()));
+  for (const size_t size : sizes) {
+    tile_buffers->push_back_unchecked(TileBuffer{nullptr, size});
+  }
+}
+
+// Records |microseconds| as the decoding times of the tiles, as done by the
+// threads that decode them.
+void SetTileTimes(const std::vector<int64_t>& microseconds,
+                  FrameScratchBuffer* const frame_scratch_buffer) {
+  for (size_t i = 0; i < microseconds.size(); ++i) {
+    frame_scratch_buffer->tile_costs.get()[i].microseconds = microseconds[i];
+  }
+}
+
+std::vector<int> GetTileOrder(const FrameScratchBuffer& frame_scratch_buffer,
+                              int tile_count) {
+  return std::vector<int>(frame_scratch_buffer.tile_order.get(),
+                          frame_scratch_buffer.tile_order.get() + tile_count);
+}
+
+TEST(ComputeTileOrderTest, SizesAndMeasuredCosts) {
+  std::unique_ptr<FrameScratchBuffer> frame_scratch_buffer(
+      new (std::nothrow) FrameScratchBuffer);
+  ASSERT_NE(frame_scratch_buffer, nullptr);
+  Vector<TileBuffer> tile_buffers;
+
+  // Without measurements the tiles are ordered by size. Ties keep the tile
+  // order.
+  SetTileSizes({100, 300, 200, 300}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 4),
+            (std::vector<int>{1, 3, 2, 0}));
+  EXPECT_EQ(frame_scratch_buffer->tile_cost_count, 4);
+  EXPECT_EQ(frame_scratch_buffer->tile_costs.get()[1].size, 300u);
+  EXPECT_EQ(frame_scratch_buffer->tile_costs.get()[1].microseconds, 0);
+
+  // The measured time per byte of each tile scales the size of the tile at
+  // the same position in the next frame: the estimates are 1000, 300, 200
+  // and 600.
+  SetTileTimes({1000, 300, 200, 600}, frame_scratch_buffer.get());
+  SetTileSizes({100, 300, 200, 300}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 4),
+            (std::vector<int>{0, 3, 1, 2}));
+
+  // The sizes change as well: the estimates are 500, 400, 400 and 400. The
+  // ties keep the tile order.
+  SetTileTimes({1000, 200, 200, 600}, frame_scratch_buffer.get());
+  SetTileSizes({50, 600, 400, 200}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 4),
+            (std::vector<int>{0, 1, 2, 3}));
+
+  // A tile without a measurement falls back to the sizes for all the tiles.
+  SetTileTimes({100, 0, 100, 4000}, frame_scratch_buffer.get());
+  SetTileSizes({50, 600, 400, 200}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 4),
+            (std::vector<int>{1, 2, 3, 0}));
+
+  // So does a change of the number of tiles.
+  SetTileTimes({100, 100, 100, 4000}, frame_scratch_buffer.get());
+  SetTileSizes({10, 20, 30, 20, 10, 30}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 6),
+            (std::vector<int>{2, 5, 1, 3, 0, 4}));
+  EXPECT_EQ(frame_scratch_buffer->tile_cost_count, 6);
+
+  // Equal costs keep the tile order.
+  SetTileTimes({10, 20, 30, 20, 10, 30}, frame_scratch_buffer.get());
+  SetTileSizes({7, 7, 7, 7, 7, 7}, &tile_buffers);
+  ASSERT_TRUE(ComputeTileOrder(tile_buffers, frame_scratch_buffer.get()));
+  EXPECT_EQ(GetTileOrder(*frame_scratch_buffer, 6),
+            (std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
 }  // namespace
 }  // namespace libgav1
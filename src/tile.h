@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <condition_variable>  // NOLINT (unapproved c++11 header)
@@ -26,6 +27,7 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>  // NOLINT (unapproved c++11 header)
+#include <new>
 
 #include "src/buffer_pool.h"
 #include "src/decoder_state.h"
@@ -69,7 +71,10 @@ enum ProcessingMode {
 // symbol_decoder_context_.
 class Tile : public MaxAlignedAllocable {
  public:
-  static std::unique_ptr<Tile> Create(
+  // Constructs the tile in |frame_scratch_buffer->tile_storage| at index
+  // |tile_number|, which must already exist. The tile reuses the buffers of
+  // the tile with the same number in the previous frames.
+  static TilePtr Create(
       int tile_number, const uint8_t* const data, size_t size,
       const ObuSequenceHeader& sequence_header,
       const ObuFrameHeader& frame_header, RefCountedBuffer* const current_frame,
@@ -81,13 +86,18 @@ class Tile : public MaxAlignedAllocable {
       const dsp::Dsp* const dsp, ThreadPool* const thread_pool,
       BlockingCounterWithStatus* const pending_tiles, bool frame_parallel,
       bool use_intra_prediction_buffer, bool parse_only) {
-    std::unique_ptr<Tile> tile(new (std::nothrow) Tile(
+    assert(static_cast<size_t>(tile_number) <
+           frame_scratch_buffer->tile_storage.size());
+    TileStorage* const storage =
+        &frame_scratch_buffer->tile_storage.get()[tile_number];
+    if (!storage->tile.Resize(sizeof(Tile))) return nullptr;
+    TilePtr tile(::new (storage->tile.get()) Tile(
         tile_number, data, size, sequence_header, frame_header, current_frame,
         state, frame_scratch_buffer, wedge_masks, quantizer_matrix,
         saved_symbol_decoder_context, prev_segment_ids, post_filter, dsp,
         thread_pool, pending_tiles, frame_parallel, use_intra_prediction_buffer,
-        parse_only));
-    return (tile != nullptr && tile->Init()) ? std::move(tile) : nullptr;
+        parse_only, storage));
+    return tile->Init() ? std::move(tile) : nullptr;
   }
 
   // Move only.
@@ -121,6 +131,9 @@ class Tile : public MaxAlignedAllocable {
   const ObuFrameHeader& frame_header() const { return frame_header_; }
   const RefCountedBuffer& current_frame() const { return current_frame_; }
   const TemporalMotionField& motion_field() const { return motion_field_; }
+  // The cache is only used while parsing, which is done by one thread at a
+  // time for a tile.
+  TemporalMvCache& temporal_mv_cache() const { return temporal_mv_cache_; }
   const std::array<bool, kNumReferenceFrameTypes>& reference_frame_sign_bias()
       const {
     return reference_frame_sign_bias_;
@@ -230,6 +243,10 @@ class Tile : public MaxAlignedAllocable {
     bool abort LIBGAV1_GUARDED_BY(mutex) = false;
     int pending_jobs LIBGAV1_GUARDED_BY(mutex) = 0;
     std::condition_variable pending_jobs_zero_condvar;
+    // Number of superblocks that have been parsed, in raster order within the
+    // tile. Written by the parsing thread and read without |mutex| by the
+    // decoding jobs to find the superblocks they can prefetch for.
+    std::atomic<int> parsed_superblocks{0};
   };
 
   // The residual pointer is used to traverse the |residual_buffer_|. It is
@@ -256,7 +273,8 @@ class Tile : public MaxAlignedAllocable {
        const SegmentationMap* prev_segment_ids, PostFilter* post_filter,
        const dsp::Dsp* dsp, ThreadPool* thread_pool,
        BlockingCounterWithStatus* pending_tiles, bool frame_parallel,
-       bool use_intra_prediction_buffer, bool parse_only);
+       bool use_intra_prediction_buffer, bool parse_only,
+       TileStorage* storage);
 
   // Performs member initializations that may fail. Helper function used by
   // Create().
@@ -465,6 +483,14 @@ class Tile : public MaxAlignedAllocable {
                        int candidate_row, int candidate_column,
                        bool* is_local_valid,
                        GlobalMotion* local_warp_params);  // 7.11.3.1.
+  // Predicts the |block_width|x|block_height| chroma area of a block smaller
+  // than 8x8 in luma from the up to four luma blocks which cover it. This is
+  // the InterPrediction() loop of 7.11.3.1 when someUseIntra is false.
+  bool ChromaSub8x8InterPrediction(const Block& block, Plane plane, int base_x,
+                                   int base_y, int block_width,
+                                   int block_height, int prediction_width,
+                                   int prediction_height, int candidate_row,
+                                   int candidate_column);
   void ScaleMotionVector(const MotionVector& mv, Plane plane,
                          int reference_frame_index, int x, int y, int* start_x,
                          int* start_y, int* step_x, int* step_y);  // 7.11.3.3.
@@ -488,13 +514,29 @@ class Tile : public MaxAlignedAllocable {
                           uint8_t* block_buffer,
                           ptrdiff_t convolve_buffer_stride,
                           ptrdiff_t block_extended_width);
+  // Issues software prefetches for the reference blocks of the inter blocks in
+  // the superblock at (|sb_row_index|, |sb_column_index|). The superblock must
+  // have been parsed and not yet decoded. At most |*prefetch_budget| cache
+  // lines are prefetched and |*prefetch_budget| is decremented accordingly.
+  void PrefetchReferenceBlocks(int sb_row_index, int sb_column_index,
+                               int* prefetch_budget);
+  // Prefetches the reference blocks of the superblocks that will be decoded
+  // after the superblock at (|sb_row_index|, |sb_column_index|) in the decode
+  // only pass. In non frame parallel mode only the superblocks that the
+  // parsing thread has finished are considered.
+  void PrefetchReferenceBlocksAhead(int sb_row_index, int sb_column_index);
+  // 7.11.3.4. If |average_blended| is not nullptr, |prediction| is the second
+  // prediction of a kCompoundPredictionTypeAverage block and the first one is
+  // already in |block.scratch_buffer|. When the second prediction can be
+  // convolved and blended with the first one in a single pass, the blended
+  // pixels are written to |dest| and |*average_blended| is set to true.
   bool BlockInterPrediction(const Block& block, Plane plane,
                             int reference_frame_index, const MotionVector& mv,
                             int x, int y, int width, int height,
                             int candidate_row, int candidate_column,
                             uint16_t* prediction, bool is_compound,
                             bool is_inter_intra, uint8_t* dest,
-                            ptrdiff_t dest_stride);  // 7.11.3.4.
+                            ptrdiff_t dest_stride, bool* average_blended);
   bool BlockWarpProcess(const Block& block, Plane plane, int index,
                         int block_start_x, int block_start_y, int width,
                         int height, GlobalMotion* warp_params, bool is_compound,
@@ -592,14 +634,14 @@ class Tile : public MaxAlignedAllocable {
   // relative to the start of this tile.
   int SuperBlockRowIndex(int row4x4) const {
     return (row4x4 - row4x4_start_) >>
-           (sequence_header_.use_128x128_superblock ? 5 : 4);
+           (Use128x128Superblock() ? 5 : 4);
   }
 
   // Returns the zero-based index of the super block that contains |column4x4|
   // relative to the start of this tile.
   int SuperBlockColumnIndex(int column4x4) const {
     return (column4x4 - column4x4_start_) >>
-           (sequence_header_.use_128x128_superblock ? 5 : 4);
+           (Use128x128Superblock() ? 5 : 4);
   }
 
   // Returns the zero-based index of the block that starts at row4x4 or
@@ -609,16 +651,26 @@ class Tile : public MaxAlignedAllocable {
   int CdfContextIndex(int row_or_column4x4) const {
     return row_or_column4x4 -
            (row_or_column4x4 &
-            (sequence_header_.use_128x128_superblock ? ~31 : ~15));
+            (Use128x128Superblock() ? ~31 : ~15));
   }
 
+  bool Use128x128Superblock() const {
+#if LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK
+    return false;
+#else
+    return sequence_header_.use_128x128_superblock;
+#endif
+  }
   BlockSize SuperBlockSize() const {
-    return sequence_header_.use_128x128_superblock ? kBlock128x128
-                                                   : kBlock64x64;
+    return Use128x128Superblock() ? kBlock128x128 : kBlock64x64;
   }
   int PlaneCount() const {
+#if LIBGAV1_SPECIALIZE_420
+    return kMaxPlanes;
+#else
     return sequence_header_.color_config.is_monochrome ? kMaxPlanesMonochrome
                                                        : kMaxPlanes;
+#endif
   }
 
   const int number_;
@@ -633,8 +685,13 @@ class Tile : public MaxAlignedAllocable {
   int superblock_rows_;
   int superblock_columns_;
   bool read_deltas_;
+#if LIBGAV1_SPECIALIZE_420
+  static constexpr int8_t subsampling_x_[kMaxPlanes] = {0, 1, 1};
+  static constexpr int8_t subsampling_y_[kMaxPlanes] = {0, 1, 1};
+#else
   const int8_t subsampling_x_[kMaxPlanes];
   const int8_t subsampling_y_[kMaxPlanes];
+#endif
 
   // The dimensions (in order) are: segment_id, level_index (based on plane and
   // direction), reference_frame and mode_id.
@@ -661,7 +718,7 @@ class Tile : public MaxAlignedAllocable {
   // GetTransformAllZeroContext. In that function, we only care about the
   // following values: 0, 1, 2, 3 and >= 4. So instead of clamping to 63, we
   // clamp to 4 (i.e.) all the values greater than 4 are stored as 4.
-  std::array<Array2D<uint8_t>, 2> coefficient_levels_;
+  std::array<Array2D<uint8_t>, 2>& coefficient_levels_;
   // This is equivalent to the LeftDcContext and AboveDcContext arrays in the
   // spec. In the spec, it can store 3 possible values: 0, 1 and 2 (where 1
   // means the value is < 0, 2 means the value is > 0 and 0 means the value is
@@ -679,13 +736,14 @@ class Tile : public MaxAlignedAllocable {
   //
   // The usage on GetTransformAllZeroContext is unaffected since there we
   // only care about whether it is 0 or not.
-  std::array<Array2D<int8_t>, 2> dc_categories_;
+  std::array<Array2D<int8_t>, 2>& dc_categories_;
   const ObuSequenceHeader& sequence_header_;
   const ObuFrameHeader& frame_header_;
   const std::array<bool, kNumReferenceFrameTypes>& reference_frame_sign_bias_;
   const std::array<RefCountedBufferPtr, kNumReferenceFrameTypes>&
       reference_frames_;
   TemporalMotionField& motion_field_;
+  mutable TemporalMvCache temporal_mv_cache_;
   const std::array<uint8_t, kNumReferenceFrameTypes>& reference_order_hint_;
   const WedgeMaskArray& wedge_masks_;
   const QuantizerMatrix& quantizer_matrix_;
@@ -717,10 +775,11 @@ class Tile : public MaxAlignedAllocable {
   //        |residual_size_|. Where 4096 = 64x64 which is the maximum transform
   //        size, and 32 * |kResidualPaddingVertical| is the padding to avoid
   //        bottom boundary checks when parsing quantized coefficients. This
-  //        memory is allocated and owned by the Tile class.
+  //        memory is allocated by the Tile class and owned by its
+  //        TileStorage.
   //    For |residual_buffer_threaded_|: See the comment below. This memory is
   //        not allocated or owned by the Tile class.
-  AlignedUniquePtr<uint8_t> residual_buffer_;
+  AlignedDynamicBuffer<uint8_t, 32>& residual_buffer_;
   // This is a 2d array of pointers of size |superblock_rows_| by
   // |superblock_columns_| where each pointer points to a ResidualBuffer for a
   // single super block. The array is populated when the parsing process begins
@@ -767,7 +826,7 @@ class Tile : public MaxAlignedAllocable {
   BlockingCounterWithStatus* const pending_tiles_;
   bool split_parse_and_decode_;
   // This is used only when |split_parse_and_decode_| is false.
-  std::unique_ptr<PredictionParameters> prediction_parameters_ = nullptr;
+  std::unique_ptr<PredictionParameters>& prediction_parameters_;
   // Stores the |transform_type| for the super block being decoded at a 4x4
   // granularity. The spec uses absolute indices for this array but it is
   // sufficient to use indices relative to the super block being decoded.
@@ -793,9 +852,11 @@ class Tile : public MaxAlignedAllocable {
   // buffer is the number of superblock columns in this tile. For each block,
   // the access index will be the corresponding SuperBlockColumnIndex()'th
   // entry.
-  DynamicBuffer<BlockCdfContext> top_context_;
+  DynamicBuffer<BlockCdfContext>& top_context_;
   // Whether the tile should only be parsed and not decoded.
   const bool parse_only_;
+
+  friend class TileTest;
 };
 
 struct Tile::Block {
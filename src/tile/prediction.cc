@@ -47,6 +47,8 @@ namespace {
 
 // Precision bits when scaling reference frames.
 constexpr int kReferenceScaleShift = 14;
+// Prefetches are issued at this granularity (in bytes).
+constexpr int kPrefetchStride = 64;
 constexpr int kAngleStep = 3;
 constexpr int kPredictionModeToAngle[kIntraPredictionModesUV] = {
     0, 90, 180, 45, 135, 113, 157, 203, 67, 0, 0, 0, 0};
@@ -286,11 +288,11 @@ void Tile::IntraPrediction(const Block& block, Plane plane, int x, int y,
     // Superblock index of block.row4x4. block.row4x4 is always in luma
     // dimension (no subsampling).
     const int current_superblock_index =
-        block.row4x4 >> (sequence_header_.use_128x128_superblock ? 5 : 4);
+        block.row4x4 >> (Use128x128Superblock() ? 5 : 4);
     // Superblock index of y - 1. y is in the plane dimension (chroma planes
     // could be subsampled).
-    const int plane_shift = (sequence_header_.use_128x128_superblock ? 7 : 6) -
-                            subsampling_y_[plane];
+    const int plane_shift =
+        (Use128x128Superblock() ? 7 : 6) - subsampling_y_[plane];
     const int top_row_superblock_index = (y - 1) >> plane_shift;
     // If the superblock index of y - 1 is not that of the current superblock,
     // then we will have to retrieve the top row from the
@@ -708,6 +710,7 @@ bool Tile::InterPrediction(const Block& block, const Plane plane, const int x,
       *block.bp->prediction_parameters;
   uint8_t* const dest = GetStartPoint(buffer_, plane, x, y, bitdepth);
   const ptrdiff_t dest_stride = buffer_[plane].columns();  // In bytes.
+  bool average_blended = false;
   for (int index = 0; index < 1 + static_cast<int>(is_compound); ++index) {
     const ReferenceFrameType reference_type =
         bp_reference.reference_frame[index];
@@ -729,11 +732,15 @@ bool Tile::InterPrediction(const Block& block, const Plane plane, const int x,
               ? -1
               : frame_header_.reference_frame_index[reference_type -
                                                     kReferenceFrameLast];
+      const bool try_average_blend =
+          index == 1 && prediction_parameters.compound_prediction_type ==
+                            kCompoundPredictionTypeAverage;
       if (!BlockInterPrediction(
               block, plane, reference_index, bp_reference.mv.mv[index], x, y,
               prediction_width, prediction_height, candidate_row,
               candidate_column, block.scratch_buffer->prediction_buffer[index],
-              is_compound, is_inter_intra, dest, dest_stride)) {
+              is_compound, is_inter_intra, dest, dest_stride,
+              try_average_blend ? &average_blended : nullptr)) {
         return false;
       }
     }
@@ -778,6 +785,7 @@ bool Tile::InterPrediction(const Block& block, const Plane plane, const int x,
   }
 
   if (is_compound) {
+    if (average_blended) return true;
     CompoundInterPrediction(block, prediction_mask, prediction_mask_stride,
                             prediction_width, prediction_height, subsampling_x,
                             subsampling_y, candidate_row, candidate_column,
@@ -795,6 +803,85 @@ bool Tile::InterPrediction(const Block& block, const Plane plane, const int x,
   return true;
 }
 
+bool Tile::ChromaSub8x8InterPrediction(
+    const Block& block, const Plane plane, const int base_x, const int base_y,
+    const int block_width, const int block_height, const int prediction_width,
+    const int prediction_height, const int candidate_row,
+    const int candidate_column) {
+  const int bitdepth = sequence_header_.color_config.bitdepth;
+  const int rows = block_height / prediction_height;
+  const int columns = block_width / prediction_width;
+  assert(rows <= 2 && columns <= 2 && rows * columns > 1);
+  assert(!block.bp->prediction_parameters->use_intra_block_copy);
+  const BlockParameters* bp_candidates[4];
+  bool same_motion = true;
+  int num_candidates = 0;
+  int r = 0;
+  do {
+    int c = 0;
+    do {
+      const BlockParameters* const bp = block_parameters_holder_.Find(
+          candidate_row + r, candidate_column + c);
+      // The candidates lie in the 8x8 luma area of a block with a dimension
+      // smaller than 8, so none of them can use compound prediction or
+      // warping.
+      assert(bp->reference_frame[0] > kReferenceFrameIntra);
+      assert(bp->reference_frame[1] <= kReferenceFrameIntra);
+      if (num_candidates != 0) {
+        const BlockParameters& bp_first = *bp_candidates[0];
+        same_motion &=
+            bp->reference_frame[0] == bp_first.reference_frame[0] &&
+            bp->mv.mv[0].mv32 == bp_first.mv.mv[0].mv32 &&
+            bp->interpolation_filter[0] == bp_first.interpolation_filter[0] &&
+            bp->interpolation_filter[1] == bp_first.interpolation_filter[1];
+      }
+      bp_candidates[num_candidates++] = bp;
+    } while (++c < columns);
+  } while (++r < rows);
+
+  const ptrdiff_t dest_stride = buffer_[plane].columns();  // In bytes.
+  // When all the candidates share their motion, the prediction of the whole
+  // area in one call is identical to the prediction of each part: the sub-pixel
+  // phases are the same and the convolve filters only change at a width or a
+  // height of 4, which the combined area does not exceed in the split
+  // direction. This is not true of scaled references, whose positions are not
+  // linear in x and y.
+  if (same_motion && !IsScaled(bp_candidates[0]->reference_frame[0])) {
+    const BlockParameters& bp = *bp_candidates[0];
+    return BlockInterPrediction(
+        block, plane,
+        frame_header_.reference_frame_index[bp.reference_frame[0] -
+                                            kReferenceFrameLast],
+        bp.mv.mv[0], base_x, base_y, block_width, block_height, candidate_row,
+        candidate_column, block.scratch_buffer->prediction_buffer[0],
+        /*is_compound=*/false, /*is_inter_intra=*/false,
+        GetStartPoint(buffer_, plane, base_x, base_y, bitdepth), dest_stride,
+        /*average_blended=*/nullptr);
+  }
+
+  int index = 0;
+  for (r = 0; r < rows; ++r) {
+    const int y = base_y + r * prediction_height;
+    for (int c = 0; c < columns; ++c) {
+      const int x = base_x + c * prediction_width;
+      const BlockParameters& bp = *bp_candidates[index++];
+      if (!BlockInterPrediction(
+              block, plane,
+              frame_header_.reference_frame_index[bp.reference_frame[0] -
+                                                  kReferenceFrameLast],
+              bp.mv.mv[0], x, y, prediction_width, prediction_height,
+              candidate_row + r, candidate_column + c,
+              block.scratch_buffer->prediction_buffer[0],
+              /*is_compound=*/false, /*is_inter_intra=*/false,
+              GetStartPoint(buffer_, plane, x, y, bitdepth), dest_stride,
+              /*average_blended=*/nullptr)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool Tile::ObmcBlockPrediction(const Block& block, const MotionVector& mv,
                                const Plane plane,
                                const int reference_frame_index, const int width,
@@ -817,7 +904,7 @@ bool Tile::ObmcBlockPrediction(const Block& block, const MotionVector& mv,
   if (!BlockInterPrediction(block, plane, reference_frame_index, mv, x, y,
                             width, height, candidate_row, candidate_column,
                             nullptr, false, false, obmc_buffer,
-                            obmc_buffer_stride)) {
+                            obmc_buffer_stride, nullptr)) {
     return false;
   }
 
@@ -1092,13 +1179,82 @@ void Tile::BuildConvolveBlock(
   }
 }
 
+void Tile::PrefetchReferenceBlocks(int sb_row_index, int sb_column_index,
+                                   int* const prefetch_budget) {
+  Queue<PartitionTreeNode>& blocks =
+      *residual_buffer_threaded_[sb_row_index][sb_column_index]
+           ->partition_tree_order();
+  const int pixel_size =
+      (sequence_header_.color_config.bitdepth == 8) ? sizeof(uint8_t)
+                                                    : sizeof(uint16_t);
+  for (size_t i = 0; i < blocks.Size(); ++i) {
+    const PartitionTreeNode& block = blocks[i];
+    const BlockParameters& bp =
+        *block_parameters_holder_.Find(block.row4x4, block.column4x4);
+    if (!bp.is_inter) continue;
+    for (int index = 0; index < 2; ++index) {
+      const ReferenceFrameType type = bp.reference_frame[index];
+      // Scaled references are rare. Do not bother prefetching for them.
+      if (type <= kReferenceFrameIntra || IsScaled(type)) continue;
+      const int reference_frame_index =
+          frame_header_.reference_frame_index[type - kReferenceFrameLast];
+      RefCountedBuffer& reference_frame =
+          *reference_frames_[reference_frame_index];
+      const YuvBuffer& reference_buffer = *reference_frame.buffer();
+      const MotionVector& mv = bp.mv.mv[index];
+      for (int plane = kPlaneY; plane < PlaneCount(); ++plane) {
+        const int subsampling_x = subsampling_x_[plane];
+        const int subsampling_y = subsampling_y_[plane];
+        const int last_x =
+            SubsampledValue(reference_frame.upscaled_width(), subsampling_x) -
+            1;
+        int last_y =
+            SubsampledValue(reference_frame.frame_height(), subsampling_y) - 1;
+        if (frame_parallel_) {
+          // Only prefetch the rows that are known to have been decoded.
+          last_y = std::min(
+              last_y,
+              reference_frame_progress_cache_[reference_frame_index] >>
+                  subsampling_y);
+          if (last_y < 0) continue;
+        }
+        // The motion vectors are in units of 1/8 luma samples. Include the
+        // rows and columns that are needed by the interpolation filters.
+        const int x = (MultiplyBy4(block.column4x4) >> subsampling_x) +
+                      (mv.mv[1] >> (3 + subsampling_x));
+        const int y = (MultiplyBy4(block.row4x4) >> subsampling_y) +
+                      (mv.mv[0] >> (3 + subsampling_y));
+        const int width = kBlockWidthPixels[block.block_size] >> subsampling_x;
+        const int height =
+            kBlockHeightPixels[block.block_size] >> subsampling_y;
+        const int x_start = Clip3(x - kSubPixelTaps / 2 + 1, 0, last_x);
+        const int x_end = Clip3(x + width + kSubPixelTaps / 2, 0, last_x);
+        const int y_start = Clip3(y - kSubPixelTaps / 2 + 1, 0, last_y);
+        const int y_end = Clip3(y + height + kSubPixelTaps / 2, 0, last_y);
+        const ptrdiff_t stride = reference_buffer.stride(plane);
+        const int row_size = (x_end - x_start) * pixel_size;
+        const uint8_t* row = reference_buffer.data(plane) + y_start * stride +
+                             x_start * pixel_size;
+        for (int row_y = y_start; row_y <= y_end; ++row_y, row += stride) {
+          for (int offset = 0; offset < row_size; offset += kPrefetchStride) {
+            LIBGAV1_PREFETCH(row + offset);
+          }
+          LIBGAV1_PREFETCH(row + row_size);
+          *prefetch_budget -= 1 + row_size / kPrefetchStride;
+          if (*prefetch_budget <= 0) return;
+        }
+      }
+    }
+  }
+}
+
 bool Tile::BlockInterPrediction(
     const Block& block, const Plane plane, const int reference_frame_index,
     const MotionVector& mv, const int x, const int y, const int width,
     const int height, const int candidate_row, const int candidate_column,
     uint16_t* const prediction, const bool is_compound,
     const bool is_inter_intra, uint8_t* const dest,
-    const ptrdiff_t dest_stride) {
+    const ptrdiff_t dest_stride, bool* const average_blended) {
   const BlockParameters& bp =
       *block_parameters_holder_.Find(candidate_row, candidate_column);
   int start_x;
@@ -1244,6 +1400,20 @@ bool Tile::BlockInterPrediction(
     const int horizontal_filter_id = (start_x >> 6) & kSubPixelMask;
     const int vertical_filter_id = (start_y >> 6) & kSubPixelMask;
 
+    if (average_blended != nullptr && vertical_filter_id != 0 &&
+        horizontal_filter_id != 0 &&
+        dsp_.convolve_2d_average_blend != nullptr) {
+      assert(is_compound);
+      dsp_.convolve_2d_average_blend(
+          block_start, convolve_buffer_stride, horizontal_filter_index,
+          vertical_filter_index, horizontal_filter_id, vertical_filter_id,
+          width, height,
+          block.scratch_buffer->compound_prediction_buffer_8bpp[0], dest,
+          dest_stride);
+      *average_blended = true;
+      return true;
+    }
+
     dsp::ConvolveFunc convolve_func =
         dsp_.convolve[reference_frame_index == -1][is_compound]
                      [vertical_filter_id != 0][horizontal_filter_id != 0];
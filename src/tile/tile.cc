@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <cstdlib>
@@ -33,6 +34,7 @@
 #include "src/utils/common.h"
 #include "src/utils/constants.h"
 #include "src/utils/logging.h"
+#include "src/utils/perf_counters.h"
 #include "src/utils/segmentation.h"
 #include "src/utils/stack.h"
 
@@ -87,6 +89,20 @@ constexpr uint8_t kAllZeroContextsByTopLeft[5][5] = {{1, 2, 2, 2, 3},
 //                                 stack.
 constexpr int kDfsStackSize = 16;
 
+// Number of superblocks to look ahead when prefetching the reference blocks in
+// the decode only pass. A value of 0 disables the prefetching. It is disabled
+// by default as it has not shown a measurable gain.
+#if !defined(LIBGAV1_REFERENCE_PREFETCH_DISTANCE)
+constexpr int kReferencePrefetchDistance = 0;
+#else
+constexpr int kReferencePrefetchDistance = LIBGAV1_REFERENCE_PREFETCH_DISTANCE;
+#endif
+
+// Upper bound on the number of cache lines prefetched per superblock. Keeps
+// the prefetches from evicting the data that is in use when the motion is
+// large or incoherent.
+constexpr int kMaxPrefetchLinesPerSuperBlock = 512;
+
 // Mask indicating whether the transform sets contain a particular transform
 // type. If |tx_type| is present in |tx_set|, then the |tx_type|th LSB is set.
 constexpr BitMaskSet kTransformTypeInSetMask[kNumTransformSets] = {
@@ -413,6 +429,13 @@ int GetCoeffBaseRangeContextEob(int adjusted_tx_width_log2, int pos,
 
 }  // namespace
 
+#if LIBGAV1_SPECIALIZE_420
+constexpr int8_t Tile::subsampling_x_[kMaxPlanes];
+constexpr int8_t Tile::subsampling_y_[kMaxPlanes];
+#endif
+
+void TileDeleter::operator()(Tile* const tile) const { tile->~Tile(); }
+
 Tile::Tile(int tile_number, const uint8_t* const data, size_t size,
            const ObuSequenceHeader& sequence_header,
            const ObuFrameHeader& frame_header,
@@ -425,18 +448,23 @@ Tile::Tile(int tile_number, const uint8_t* const data, size_t size,
            PostFilter* const post_filter, const dsp::Dsp* const dsp,
            ThreadPool* const thread_pool,
            BlockingCounterWithStatus* const pending_tiles, bool frame_parallel,
-           bool use_intra_prediction_buffer, bool parse_only)
+           bool use_intra_prediction_buffer, bool parse_only,
+           TileStorage* const storage)
     : number_(tile_number),
       row_(number_ / frame_header.tile_info.tile_columns),
       column_(number_ % frame_header.tile_info.tile_columns),
       data_(data),
       size_(size),
       read_deltas_(false),
+#if !LIBGAV1_SPECIALIZE_420
       subsampling_x_{0, sequence_header.color_config.subsampling_x,
                      sequence_header.color_config.subsampling_x},
       subsampling_y_{0, sequence_header.color_config.subsampling_y,
                      sequence_header.color_config.subsampling_y},
+#endif
       current_quantizer_index_(frame_header.quantizer.base_index),
+      coefficient_levels_(storage->coefficient_levels),
+      dc_categories_(storage->dc_categories),
       sequence_header_(sequence_header),
       frame_header_(frame_header),
       reference_frame_sign_bias_(state.reference_frame_sign_bias),
@@ -454,6 +482,7 @@ Tile::Tile(int tile_number, const uint8_t* const data, size_t size,
       block_parameters_holder_(frame_scratch_buffer->block_parameters_holder),
       quantizer_(sequence_header_.color_config.bitdepth,
                  &frame_header_.quantizer),
+      residual_buffer_(storage->residual_buffer),
       residual_size_((sequence_header_.color_config.bitdepth == 8)
                          ? sizeof(int16_t)
                          : sizeof(int32_t)),
@@ -470,12 +499,14 @@ Tile::Tile(int tile_number, const uint8_t* const data, size_t size,
       tile_scratch_buffer_pool_(
           &frame_scratch_buffer->tile_scratch_buffer_pool),
       pending_tiles_(pending_tiles),
+      prediction_parameters_(storage->prediction_parameters),
       frame_parallel_(frame_parallel),
       use_intra_prediction_buffer_(use_intra_prediction_buffer),
       intra_prediction_buffer_(
           use_intra_prediction_buffer_
               ? &frame_scratch_buffer->intra_prediction_buffers.get()[row_]
               : nullptr),
+      top_context_(storage->top_context),
       parse_only_(parse_only) {
   row4x4_start_ = frame_header.tile_info.tile_row_start[row_];
   row4x4_end_ = frame_header.tile_info.tile_row_start[row_ + 1];
@@ -572,16 +603,19 @@ bool Tile::Init() {
   } else {
     // Add 32 * |kResidualPaddingVertical| padding to avoid bottom boundary
     // checks when parsing quantized coefficients.
-    residual_buffer_ = MakeAlignedUniquePtr<uint8_t>(
-        32, (4096 + 32 * kResidualPaddingVertical) * residual_size_);
-    if (residual_buffer_ == nullptr) {
+    if (!residual_buffer_.Resize((4096 + 32 * kResidualPaddingVertical) *
+                                 residual_size_)) {
       LIBGAV1_DLOG(ERROR, "Allocation of residual_buffer_ failed.");
       return false;
     }
-    prediction_parameters_.reset(new (std::nothrow) PredictionParameters());
+    // |prediction_parameters_| is null the first time or if the block that
+    // was using it failed to decode.
     if (prediction_parameters_ == nullptr) {
-      LIBGAV1_DLOG(ERROR, "Allocation of prediction_parameters_ failed.");
-      return false;
+      prediction_parameters_.reset(new (std::nothrow) PredictionParameters());
+      if (prediction_parameters_ == nullptr) {
+        LIBGAV1_DLOG(ERROR, "Allocation of prediction_parameters_ failed.");
+        return false;
+      }
     }
   }
   if (frame_header_.use_ref_frame_mvs) {
@@ -603,6 +637,9 @@ bool Tile::ProcessSuperBlockRow(int row4x4,
                                 TileScratchBuffer* const scratch_buffer) {
   if (row4x4 < row4x4_start_ || row4x4 >= row4x4_end_) return true;
   assert(scratch_buffer != nullptr);
+  // The frame is aborted when the decoder is flushed or has failed. Stop
+  // working on it as early as possible.
+  if (current_frame_.aborted()) return false;
   const int block_width4x4 = kNum4x4BlocksWide[SuperBlockSize()];
   for (int column4x4 = column4x4_start_; column4x4 < column4x4_end_;
        column4x4 += block_width4x4) {
@@ -688,9 +725,8 @@ bool Tile::Parse() {
 bool Tile::Decode(
     std::mutex* const mutex, int* const superblock_row_progress,
     std::condition_variable* const superblock_row_progress_condvar) {
-  const int block_width4x4 = sequence_header_.use_128x128_superblock ? 32 : 16;
-  const int block_width4x4_log2 =
-      sequence_header_.use_128x128_superblock ? 5 : 4;
+  const int block_width4x4 = Use128x128Superblock() ? 32 : 16;
+  const int block_width4x4_log2 = Use128x128Superblock() ? 5 : 4;
   std::unique_ptr<TileScratchBuffer> scratch_buffer =
       tile_scratch_buffer_pool_->Get();
   if (scratch_buffer == nullptr) {
@@ -754,6 +790,7 @@ bool Tile::ThreadedParseAndDecode() {
     // Account for the parsing job.
     ++threading_.pending_jobs;
   }
+  threading_.parsed_superblocks.store(0, std::memory_order_relaxed);
 
   const int block_width4x4 = kNum4x4BlocksWide[SuperBlockSize()];
 
@@ -776,6 +813,9 @@ bool Tile::ThreadedParseAndDecode() {
         threading_.abort = true;
         break;
       }
+      threading_.parsed_superblocks.store(
+          row_index * superblock_columns_ + column_index + 1,
+          std::memory_order_release);
       std::unique_lock<std::mutex> lock(threading_.mutex);
       if (threading_.abort) break;
       threading_.sb_state[row_index][column_index] = kSuperBlockStateParsed;
@@ -1580,7 +1620,7 @@ bool Tile::TransformBlock(const Block& block, Plane plane, int base_x,
   if (start_x >= max_x || start_y >= max_y) return true;
   const int row = DivideBy4(start_y << subsampling_y);
   const int column = DivideBy4(start_x << subsampling_x);
-  const int mask = sequence_header_.use_128x128_superblock ? 31 : 15;
+  const int mask = Use128x128Superblock() ? 31 : 15;
   const int sub_block_row4x4 = row & mask;
   const int sub_block_column4x4 = column & mask;
   const int step_x = kTransformWidth4x4[tx_size];
@@ -1588,6 +1628,7 @@ bool Tile::TransformBlock(const Block& block, Plane plane, int base_x,
   const bool do_decode = mode == kProcessingModeDecodeOnly ||
                          mode == kProcessingModeParseAndDecode;
   if (do_decode && !bp.is_inter) {
+    const ScopedPerfStage perf_stage(kPerfStagePredict);
     if (bp.prediction_parameters->palette_mode_info.size[GetPlaneType(plane)] >
         0) {
       CALL_BITDEPTH_FUNCTION(PalettePrediction, block, plane, start_x, start_y,
@@ -1736,6 +1777,7 @@ void Tile::ReconstructBlock(const Block& block, Plane plane, int start_x,
   // Reconstruction process. Steps 2 and 3 of Section 7.12.3 in the spec.
   assert(non_zero_coeff_count >= 0);
   if (non_zero_coeff_count == 0) return;
+  const ScopedPerfStage perf_stage(kPerfStageReconstruct);
 #if LIBGAV1_MAX_BITDEPTH >= 10
   if (sequence_header_.color_config.bitdepth > 8) {
     Array2DView<uint16_t> buffer(
@@ -1860,8 +1902,7 @@ bool Tile::IsMvValid(const Block& block, bool is_compound) const {
     return false;
   }
   // sb_height_log2 = use_128x128_superblock ? log2(128) : log2(64)
-  const int sb_height_log2 =
-      6 + static_cast<int>(sequence_header_.use_128x128_superblock);
+  const int sb_height_log2 = 6 + static_cast<int>(Use128x128Superblock());
   const int active_sb_row = MultiplyBy4(block.row4x4) >> sb_height_log2;
   const int active_64x64_block_column = MultiplyBy4(block.column4x4) >> 6;
   const int src_sb_row = (src_bottom_edge - 1) >> sb_height_log2;
@@ -1878,9 +1919,8 @@ bool Tile::IsMvValid(const Block& block, bool is_compound) const {
 
   // Wavefront constraint: use only top left area of frame for reference.
   if (src_sb_row > active_sb_row) return false;
-  const int gradient =
-      1 + kIntraBlockCopyDelay64x64Blocks +
-      static_cast<int>(sequence_header_.use_128x128_superblock);
+  const int gradient = 1 + kIntraBlockCopyDelay64x64Blocks +
+                       static_cast<int>(Use128x128Superblock());
   const int wavefront_offset = gradient * (active_sb_row - src_sb_row);
   return src_64x64_block_column < active_64x64_block_column -
                                       kIntraBlockCopyDelay64x64Blocks +
@@ -2007,9 +2047,8 @@ void Tile::ResetEntropyContext(const Block& block) {
 bool Tile::ComputePrediction(const Block& block) {
   const BlockParameters& bp = *block.bp;
   if (!bp.is_inter) return true;
-  const int mask =
-      (1 << (4 + static_cast<int>(sequence_header_.use_128x128_superblock))) -
-      1;
+  const ScopedPerfStage perf_stage(kPerfStagePredict);
+  const int mask = (1 << (4 + static_cast<int>(Use128x128Superblock()))) - 1;
   const int sub_block_row4x4 = block.row4x4 & mask;
   const int sub_block_column4x4 = block.column4x4 & mask;
   const int plane_count = block.HasChroma() ? PlaneCount() : 1;
@@ -2088,6 +2127,15 @@ bool Tile::ComputePrediction(const Block& block) {
     } else {
       prediction_width = block.width >> subsampling_x;
       prediction_height = block.height >> subsampling_y;
+      if (prediction_width < block_width || prediction_height < block_height) {
+        if (!ChromaSub8x8InterPrediction(
+                block, static_cast<Plane>(plane), base_x, base_y, block_width,
+                block_height, prediction_width, prediction_height,
+                candidate_row, candidate_column)) {
+          return false;
+        }
+        continue;
+      }
     }
     int r = 0;
     int y = 0;
@@ -2220,6 +2268,11 @@ bool Tile::ProcessBlock(int row4x4, int column4x4, BlockSize block_size,
       frame_header_.segmentation.lossless[bp.prediction_parameters->segment_id]
           ? kTransformSize4x4
           : kUVTransformSize[block.residual_size[kPlaneU]];
+  if (!parse_only_ && post_filter_.DoDeblock()) {
+    post_filter_.StoreDeblockEdges(row4x4, column4x4, block_size,
+                                   block.HasChroma(), row4x4_start_,
+                                   column4x4_start_);
+  }
   if (bp.skip) ResetEntropyContext(block);
   PopulateCdefSkip(block);
   if (split_parse_and_decode_) {
@@ -2441,7 +2494,7 @@ void Tile::ResetCdef(const int row4x4, const int column4x4) {
   const int row = DivideBy16(row4x4);
   const int column = DivideBy16(column4x4);
   cdef_index_[row][column] = -1;
-  if (sequence_header_.use_128x128_superblock) {
+  if (Use128x128Superblock()) {
     const int cdef_size4x4 = kNum4x4BlocksWide[kBlock64x64];
     const int border_row = DivideBy16(row4x4 + cdef_size4x4);
     const int border_column = DivideBy16(column4x4 + cdef_size4x4);
@@ -2457,7 +2510,7 @@ void Tile::ClearBlockDecoded(TileScratchBuffer* const scratch_buffer,
   memset(scratch_buffer->block_decoded, 0,
          sizeof(scratch_buffer->block_decoded));
   // Set specific edge cases to true.
-  const int sb_size4 = sequence_header_.use_128x128_superblock ? 32 : 16;
+  const int sb_size4 = Use128x128Superblock() ? 32 : 16;
   for (int plane = kPlaneY; plane < PlaneCount(); ++plane) {
     const int subsampling_x = subsampling_x_[plane];
     const int subsampling_y = subsampling_y_[plane];
@@ -2493,6 +2546,11 @@ bool Tile::ProcessSuperBlock(int row4x4, int column4x4,
       mode == kProcessingModeParseOnly || mode == kProcessingModeParseAndDecode;
   const bool decoding = mode == kProcessingModeDecodeOnly ||
                         mode == kProcessingModeParseAndDecode;
+  // The prediction and the reconstruction have their own scopes, so the rest
+  // of the work is parsing, or the bookkeeping of the reconstruction when
+  // only decoding.
+  const ScopedPerfStage perf_stage(parsing ? kPerfStageParse
+                                           : kPerfStageReconstruct);
   if (parsing) {
     read_deltas_ = frame_header_.delta_q.present;
     ResetCdef(row4x4, column4x4);
@@ -2536,6 +2594,10 @@ bool Tile::ProcessSuperBlock(int row4x4, int column4x4,
           std::move(residual_buffer_threaded_[sb_row_index][sb_column_index]));
     }
   } else {
+    if (kReferencePrefetchDistance > 0 &&
+        !IsIntraFrame(frame_header_.frame_type)) {
+      PrefetchReferenceBlocksAhead(sb_row_index, sb_column_index);
+    }
     if (!DecodeSuperBlock(sb_row_index, sb_column_index, scratch_buffer)) {
       LIBGAV1_DLOG(ERROR, "Error decoding superblock row: %d column: %d",
                    row4x4, column4x4);
@@ -2547,6 +2609,47 @@ bool Tile::ProcessSuperBlock(int row4x4, int column4x4,
   return true;
 }
 
+void Tile::PrefetchReferenceBlocksAhead(int sb_row_index, int sb_column_index) {
+  // Prefetch the reference blocks of the superblock that is
+  // |kReferencePrefetchDistance| superblocks ahead in this row so that the
+  // loads overlap with the reconstruction of the superblocks in between.
+  const int sb_column_start = SuperBlockColumnIndex(column4x4_start_);
+  const int sb_column_end = SuperBlockColumnIndex(column4x4_end_ - 1) + 1;
+  int prefetch_budget = kMaxPrefetchLinesPerSuperBlock;
+  if (!frame_parallel_) {
+    // The tile is parsed concurrently by ThreadedParseAndDecode(), so only
+    // the superblocks that have been parsed can be looked at. Fall back to
+    // the farthest one of them. A superblock to the right of the current one
+    // cannot be scheduled for decoding before the current one is decoded, so
+    // its parsed data does not change while it is being read.
+    const int parsed_columns =
+        threading_.parsed_superblocks.load(std::memory_order_acquire) -
+        sb_row_index * superblock_columns_;
+    const int column =
+        std::min({sb_column_index + kReferencePrefetchDistance,
+                  sb_column_end - 1, parsed_columns - 1});
+    if (column > sb_column_index) {
+      PrefetchReferenceBlocks(sb_row_index, column, &prefetch_budget);
+    }
+    return;
+  }
+  // In frame parallel mode all the superblocks in the tile have been parsed
+  // before decoding starts. At the start of a row, prefetch for the
+  // superblocks that will not be reached by the look ahead.
+  if (sb_column_index == sb_column_start) {
+    const int end = std::min(sb_column_start + kReferencePrefetchDistance,
+                             sb_column_end);
+    for (int column = sb_column_start; column < end; ++column) {
+      PrefetchReferenceBlocks(sb_row_index, column, &prefetch_budget);
+      if (prefetch_budget <= 0) return;
+    }
+  }
+  const int column = sb_column_index + kReferencePrefetchDistance;
+  if (column < sb_column_end) {
+    PrefetchReferenceBlocks(sb_row_index, column, &prefetch_budget);
+  }
+}
+
 bool Tile::DecodeSuperBlock(int sb_row_index, int sb_column_index,
                             TileScratchBuffer* const scratch_buffer) {
   uint8_t* residual_buffer =
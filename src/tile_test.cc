@@ -0,0 +1,556 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/tile.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/buffer_pool.h"
+#include "src/decoder_state.h"
+#include "src/dsp/dsp.h"
+#include "src/frame_scratch_buffer.h"
+#include "src/motion_vector.h"
+#include "src/obu_parser.h"
+#include "src/post_filter.h"
+#include "src/prediction_mask.h"
+#include "src/quantizer.h"
+#include "src/tile_scratch_buffer.h"
+#include "src/utils/common.h"
+#include "src/utils/constants.h"
+#include "src/utils/types.h"
+#include "src/yuv_buffer.h"
+#include "tests/third_party/libvpx/acm_random.h"
+#include "tests/utils.h"
+
+namespace libgav1 {
+
+constexpr int kMaxBlockWidth4x4 = 32;
+constexpr int kMaxBlockHeight4x4 = 32;
+constexpr int kFrameWidth = 64;
+constexpr int kFrameHeight = 64;
+// The size of the scaled reference frame. A reference frame can be at most
+// twice as large as the current frame in each direction.
+constexpr int kScaledReferenceWidth = 96;
+constexpr int kScaledReferenceHeight = 80;
+// Index of the reference frame of the same size as the current frame and of
+// the scaled reference frame in DecoderState::reference_frame.
+constexpr int kReferenceIndex = 0;
+constexpr int kScaledReferenceIndex = 1;
+
+// Sets up an 8-bit 4:2:0 frame with a single tile. This class accesses private
+// members of Tile. To be declared a friend of Tile it must not have internal
+// linkage (it must be outside the anonymous namespace).
+class TileTest : public testing::Test,
+                 public test_utils::MaxAlignedAllocable {
+ public:
+  TileTest()
+      : buffer_pool_(nullptr, nullptr, nullptr, nullptr),
+        rnd_(libvpx_test::ACMRandom::DeterministicSeed()) {}
+  TileTest(const TileTest&) = delete;
+  TileTest& operator=(const TileTest&) = delete;
+  ~TileTest() override = default;
+
+ protected:
+  void SetUp() override;
+
+  // Sets the BlockParameters of the |block_size| block at |row4x4| and
+  // |column4x4| to a single reference prediction from the reference frame at
+  // |reference_index| with |mv| and |filter|.
+  BlockParameters* SetBlock(int row4x4, int column4x4, BlockSize block_size,
+                            int reference_index, const MotionVector& mv,
+                            InterpolationFilter filter);
+  MotionVector RandomMv();
+  InterpolationFilter RandomFilter() {
+    return static_cast<InterpolationFilter>(rnd_.Rand8() % 3);
+  }
+
+  // Predicts the chroma planes of the |block_size| block at |row4x4| and
+  // |column4x4|, which is the last of the blocks that share its chroma block,
+  // with ChromaSub8x8InterPrediction() and with one InterPrediction() call for
+  // each of the luma blocks that cover the chroma block, as done in 7.11.3.1,
+  // and checks that the two predictions are identical.
+  void TestChromaSub8x8InterPrediction(int row4x4, int column4x4,
+                                       BlockSize block_size);
+
+  // Partitions the frame randomly into inter blocks with random parameters
+  // and fills the motion field with random temporal motion vectors. Then finds
+  // the motion vector stack of each block in decoding order twice: once with
+  // the temporal motion vector cache shared between the blocks of the 64x64
+  // block, as in the decoder, and once with the cache cleared before each
+  // block. Checks that both give the same candidates and contexts.
+  void TestTemporalMvCache();
+
+  struct TestBlock {
+    int row4x4;
+    int column4x4;
+    BlockSize size;
+  };
+
+  // Appends to |blocks| in decoding order the blocks of a random partition of
+  // the square block of 1 << |size4x4_log2| 4x4 blocks at |row4x4| and
+  // |column4x4|.
+  void AddRandomPartition(int row4x4, int column4x4, int size4x4_log2,
+                          std::vector<TestBlock>* blocks);
+  void AddRandomInterBlock(int row4x4, int column4x4, int width4x4,
+                           int height4x4, std::vector<TestBlock>* blocks);
+
+  BufferPool buffer_pool_;
+  RefCountedBufferPtr current_frame_;
+  DecoderState state_;
+  ObuSequenceHeader sequence_header_ = {};
+  ObuFrameHeader frame_header_ = {};
+  FrameScratchBuffer frame_scratch_buffer_;
+  WedgeMaskArray wedge_masks_;
+  QuantizerMatrix quantizer_matrix_;
+  std::unique_ptr<PostFilter> post_filter_;
+  TilePtr tile_;
+  std::unique_ptr<TileScratchBuffer> scratch_buffer_;
+  const uint8_t tile_data_[8] = {};
+  libvpx_test::ACMRandom rnd_;
+};
+
+void TileTest::SetUp() {
+  dsp::DspInit();
+  const dsp::Dsp* const dsp = dsp::GetDspTable(kBitdepth8);
+  ASSERT_NE(dsp, nullptr);
+
+  sequence_header_.color_config.bitdepth = kBitdepth8;
+  sequence_header_.color_config.subsampling_x = 1;
+  sequence_header_.color_config.subsampling_y = 1;
+  frame_header_.width = kFrameWidth;
+  frame_header_.upscaled_width = kFrameWidth;
+  frame_header_.height = kFrameHeight;
+  frame_header_.render_width = kFrameWidth;
+  frame_header_.render_height = kFrameHeight;
+  frame_header_.columns4x4 = DivideBy4(kFrameWidth);
+  frame_header_.rows4x4 = DivideBy4(kFrameHeight);
+  frame_header_.frame_type = kFrameInter;
+  frame_header_.tile_info.tile_count = 1;
+  frame_header_.tile_info.tile_columns = 1;
+  frame_header_.tile_info.tile_rows = 1;
+  frame_header_.tile_info.tile_column_start[1] = frame_header_.columns4x4;
+  frame_header_.tile_info.tile_row_start[1] = frame_header_.rows4x4;
+  for (int i = 0; i < kNumInterReferenceFrameTypes; ++i) {
+    frame_header_.reference_frame_index[i] = i;
+  }
+
+  // The reference frames, filled with random pixels including their borders.
+  const int reference_sizes[2][2] = {
+      {kFrameWidth, kFrameHeight},
+      {kScaledReferenceWidth, kScaledReferenceHeight}};
+  for (int index = 0; index < 2; ++index) {
+    RefCountedBufferPtr reference = buffer_pool_.GetFreeBuffer();
+    ASSERT_NE(reference, nullptr);
+    ASSERT_TRUE(reference->Realloc(kBitdepth8, /*is_monochrome=*/false,
+                                   reference_sizes[index][0],
+                                   reference_sizes[index][1],
+                                   /*subsampling_x=*/1, /*subsampling_y=*/1,
+                                   kBorderPixels, kBorderPixels, kBorderPixels,
+                                   kBorderPixels));
+    ObuFrameHeader reference_header = frame_header_;
+    reference_header.width = reference_sizes[index][0];
+    reference_header.upscaled_width = reference_sizes[index][0];
+    reference_header.height = reference_sizes[index][1];
+    ASSERT_TRUE(reference->SetFrameDimensions(reference_header));
+    YuvBuffer* const buffer = reference->buffer();
+    for (int plane = kPlaneY; plane < kMaxPlanes; ++plane) {
+      const ptrdiff_t stride = buffer->stride(plane);
+      uint8_t* row = buffer->data(plane) - buffer->top_border(plane) * stride -
+                     buffer->left_border(plane);
+      const int rows = buffer->top_border(plane) + buffer->height(plane) +
+                       buffer->bottom_border(plane);
+      for (int y = 0; y < rows; ++y, row += stride) {
+        for (ptrdiff_t x = 0; x < stride; ++x) row[x] = rnd_.Rand8();
+      }
+    }
+    state_.reference_frame[index] = reference;
+  }
+
+  current_frame_ = buffer_pool_.GetFreeBuffer();
+  ASSERT_NE(current_frame_, nullptr);
+  ASSERT_TRUE(current_frame_->Realloc(
+      kBitdepth8, /*is_monochrome=*/false, kFrameWidth, kFrameHeight,
+      /*subsampling_x=*/1, /*subsampling_y=*/1, kBorderPixels, kBorderPixels,
+      kBorderPixels, kBorderPixels));
+  ASSERT_TRUE(current_frame_->SetFrameDimensions(frame_header_));
+
+  ASSERT_TRUE(frame_scratch_buffer_.block_parameters_holder.Reset(
+      frame_header_.rows4x4 + kMaxBlockHeight4x4,
+      frame_header_.columns4x4 + kMaxBlockWidth4x4));
+  ASSERT_TRUE(frame_scratch_buffer_.tile_storage.Resize(1));
+  frame_scratch_buffer_.tile_scratch_buffer_pool.Reset(kBitdepth8);
+  scratch_buffer_ = frame_scratch_buffer_.tile_scratch_buffer_pool.Get();
+  ASSERT_NE(scratch_buffer_, nullptr);
+
+  post_filter_.reset(new (std::nothrow) PostFilter(
+      frame_header_, sequence_header_, &frame_scratch_buffer_,
+      current_frame_->buffer(), dsp, /*do_post_filter_mask=*/0));
+  ASSERT_NE(post_filter_, nullptr);
+  tile_ = Tile::Create(
+      /*tile_number=*/0, tile_data_, sizeof(tile_data_), sequence_header_,
+      frame_header_, current_frame_.get(), state_, &frame_scratch_buffer_,
+      wedge_masks_, quantizer_matrix_,
+      /*saved_symbol_decoder_context=*/nullptr, /*prev_segment_ids=*/nullptr,
+      post_filter_.get(), dsp, /*thread_pool=*/nullptr,
+      /*pending_tiles=*/nullptr, /*frame_parallel=*/false,
+      /*use_intra_prediction_buffer=*/false, /*parse_only=*/false);
+  ASSERT_NE(tile_, nullptr);
+}
+
+BlockParameters* TileTest::SetBlock(int row4x4, int column4x4,
+                                    BlockSize block_size, int reference_index,
+                                    const MotionVector& mv,
+                                    InterpolationFilter filter) {
+  BlockParameters* const bp =
+      frame_scratch_buffer_.block_parameters_holder.Get(row4x4, column4x4,
+                                                        block_size);
+  if (bp == nullptr) return nullptr;
+  bp->is_inter = true;
+  bp->reference_frame[0] =
+      static_cast<ReferenceFrameType>(kReferenceFrameLast + reference_index);
+  bp->reference_frame[1] = kReferenceFrameNone;
+  bp->mv.mv[0] = mv;
+  bp->mv.mv[1] = {};
+  bp->interpolation_filter[0] = filter;
+  bp->interpolation_filter[1] = filter;
+  return bp;
+}
+
+MotionVector TileTest::RandomMv() {
+  // Up to 8 pixels in each direction in units of 1/8 pixel.
+  MotionVector mv;
+  mv.mv[0] = rnd_.Rand8() % 129 - 64;
+  mv.mv[1] = rnd_.Rand8() % 129 - 64;
+  return mv;
+}
+
+void TileTest::TestChromaSub8x8InterPrediction(int row4x4, int column4x4,
+                                               BlockSize block_size) {
+  BlockParameters* const bp =
+      *frame_scratch_buffer_.block_parameters_holder.Address(row4x4,
+                                                             column4x4);
+  ASSERT_NE(bp, nullptr);
+  bp->prediction_parameters.reset(new (std::nothrow) PredictionParameters());
+  ASSERT_NE(bp->prediction_parameters, nullptr);
+  bp->prediction_parameters->use_intra_block_copy = false;
+  bp->prediction_parameters->motion_mode = kMotionModeSimple;
+  bp->prediction_parameters->compound_prediction_type =
+      kCompoundPredictionTypeAverage;
+  const Tile::Block block(tile_.get(), block_size, row4x4, column4x4,
+                          scratch_buffer_.get(), /*residual=*/nullptr);
+  ASSERT_TRUE(block.HasChroma());
+
+  for (int plane = kPlaneU; plane < kMaxPlanes; ++plane) {
+    // Same as in Tile::ComputePrediction().
+    const BlockSize plane_size = block.residual_size[plane];
+    const int block_width = MultiplyBy4(kNum4x4BlocksWide[plane_size]);
+    const int block_height = MultiplyBy4(kNum4x4BlocksHigh[plane_size]);
+    const int base_x = MultiplyBy4(column4x4 >> 1);
+    const int base_y = MultiplyBy4(row4x4 >> 1);
+    const int candidate_row = (row4x4 >> 1) << 1;
+    const int candidate_column = (column4x4 >> 1) << 1;
+    const int prediction_width = block.width >> 1;
+    const int prediction_height = block.height >> 1;
+    ASSERT_TRUE(prediction_width < block_width ||
+                prediction_height < block_height);
+    Array2DView<uint8_t>& dest = tile_->buffer_[plane];
+
+    for (int y = 0; y < block_height; ++y) {
+      memset(&dest[base_y + y][base_x], 0, block_width);
+    }
+    ASSERT_TRUE(tile_->ChromaSub8x8InterPrediction(
+        block, static_cast<Plane>(plane), base_x, base_y, block_width,
+        block_height, prediction_width, prediction_height, candidate_row,
+        candidate_column));
+    uint8_t prediction[8][8];
+    ASSERT_LE(block_height, 8);
+    ASSERT_LE(block_width, 8);
+    for (int y = 0; y < block_height; ++y) {
+      memcpy(prediction[y], &dest[base_y + y][base_x], block_width);
+    }
+
+    for (int y = 0; y < block_height; ++y) {
+      memset(&dest[base_y + y][base_x], 0xff, block_width);
+    }
+    bool is_local_valid = false;
+    GlobalMotion local_warp_params;
+    for (int r = 0, y = 0; y < block_height; ++r, y += prediction_height) {
+      for (int c = 0, x = 0; x < block_width; ++c, x += prediction_width) {
+        ASSERT_TRUE(tile_->InterPrediction(
+            block, static_cast<Plane>(plane), base_x + x, base_y + y,
+            prediction_width, prediction_height, candidate_row + r,
+            candidate_column + c, &is_local_valid, &local_warp_params));
+      }
+    }
+    for (int y = 0; y < block_height; ++y) {
+      for (int x = 0; x < block_width; ++x) {
+        ASSERT_EQ(prediction[y][x], dest[base_y + y][base_x + x])
+            << "plane: " << plane << " y: " << y << " x: " << x;
+      }
+    }
+  }
+}
+
+void TileTest::TestTemporalMvCache() {
+  frame_header_.use_ref_frame_mvs = true;
+  TemporalMotionField& motion_field = frame_scratch_buffer_.motion_field;
+  const int rows8x8 = DivideBy2(frame_header_.rows4x4);
+  const int columns8x8 = DivideBy2(frame_header_.columns4x4);
+  ASSERT_TRUE(motion_field.mv.Reset(rows8x8, columns8x8,
+                                    /*zero_initialize=*/false));
+  ASSERT_TRUE(motion_field.reference_offset.Reset(rows8x8, columns8x8,
+                                                  /*zero_initialize=*/false));
+  for (int y = 0; y < rows8x8; ++y) {
+    for (int x = 0; x < columns8x8; ++x) {
+      MotionVector& mv = motion_field.mv[y][x];
+      if ((rnd_.Rand8() & 3) == 0) {
+        mv.mv[0] = kInvalidMvValue;
+        mv.mv[1] = 0;
+      } else {
+        mv.mv[0] = rnd_.Rand13Signed();
+        mv.mv[1] = rnd_.Rand13Signed();
+      }
+      motion_field.reference_offset[y][x] =
+          1 + rnd_.Rand8() % kMaxFrameDistance;
+    }
+  }
+  ReferenceInfo* const reference_info = current_frame_->reference_info();
+  for (int reference = kReferenceFrameLast;
+       reference <= kReferenceFrameAlternate; ++reference) {
+    reference_info->relative_distance_to[reference] =
+        rnd_.Rand8() % (2 * kMaxFrameDistance + 1) - kMaxFrameDistance;
+  }
+
+  ASSERT_TRUE(frame_scratch_buffer_.block_parameters_holder.Reset(
+      frame_header_.rows4x4 + kMaxBlockHeight4x4,
+      frame_header_.columns4x4 + kMaxBlockWidth4x4));
+  std::vector<TestBlock> blocks;
+  AddRandomPartition(0, 0, 4, &blocks);
+  if (HasFatalFailure()) return;
+
+  struct Result {
+    MvContexts contexts;
+    int nearest_mv_count;
+    int ref_mv_count;
+    int16_t weight_index_stack[kMaxRefMvStackSize];
+    CompoundMotionVector mvs[kMaxRefMvStackSize];
+  };
+  std::vector<Result> results[2];
+  TemporalMvCache& cache = tile_->temporal_mv_cache();
+  for (int pass = 0; pass < 2; ++pass) {
+    cache.row64 = -1;
+    cache.column64 = -1;
+    cache.valid = {};
+    for (const TestBlock& test_block : blocks) {
+      if (pass == 1) cache.valid = {};
+      const Tile::Block block(tile_.get(), test_block.size, test_block.row4x4,
+                              test_block.column4x4, scratch_buffer_.get(),
+                              /*residual=*/nullptr);
+      const bool is_compound =
+          block.bp->reference_frame[1] > kReferenceFrameIntra;
+      Result result = {};
+      FindMvStack(block, is_compound, &result.contexts);
+      const PredictionParameters& prediction_parameters =
+          *block.bp->prediction_parameters;
+      result.nearest_mv_count = prediction_parameters.nearest_mv_count;
+      result.ref_mv_count = prediction_parameters.ref_mv_count;
+      for (int i = 0; i < prediction_parameters.ref_mv_count; ++i) {
+        result.weight_index_stack[i] =
+            prediction_parameters.weight_index_stack[i];
+        if (is_compound) {
+          result.mvs[i].mv[0] = prediction_parameters.reference_mv(i, 0);
+          result.mvs[i].mv[1] = prediction_parameters.reference_mv(i, 1);
+        } else {
+          result.mvs[i].mv[0] = prediction_parameters.reference_mv(i);
+        }
+      }
+      results[pass].push_back(result);
+    }
+  }
+
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const Result& shared = results[0][i];
+    const Result& per_block = results[1][i];
+    SCOPED_TRACE(testing::Message()
+                 << "block: " << i << " row4x4: " << blocks[i].row4x4
+                 << " column4x4: " << blocks[i].column4x4
+                 << " size: " << blocks[i].size);
+    EXPECT_EQ(shared.contexts.zero_mv, per_block.contexts.zero_mv);
+    EXPECT_EQ(shared.contexts.reference_mv, per_block.contexts.reference_mv);
+    EXPECT_EQ(shared.contexts.new_mv, per_block.contexts.new_mv);
+    EXPECT_EQ(shared.nearest_mv_count, per_block.nearest_mv_count);
+    ASSERT_EQ(shared.ref_mv_count, per_block.ref_mv_count);
+    for (int j = 0; j < shared.ref_mv_count; ++j) {
+      EXPECT_EQ(shared.weight_index_stack[j], per_block.weight_index_stack[j])
+          << "index: " << j;
+      EXPECT_EQ(shared.mvs[j].mv64, per_block.mvs[j].mv64) << "index: " << j;
+    }
+  }
+}
+
+void TileTest::AddRandomPartition(int row4x4, int column4x4, int size4x4_log2,
+                                  std::vector<TestBlock>* const blocks) {
+  const int size4x4 = 1 << size4x4_log2;
+  const int half4x4 = size4x4 >> 1;
+  const Partition partition =
+      (size4x4 == 1) ? kPartitionNone
+                     : static_cast<Partition>(rnd_.Rand8() & 3);
+  switch (partition) {
+    case kPartitionNone:
+      AddRandomInterBlock(row4x4, column4x4, size4x4, size4x4, blocks);
+      break;
+    case kPartitionHorizontal:
+      AddRandomInterBlock(row4x4, column4x4, size4x4, half4x4, blocks);
+      AddRandomInterBlock(row4x4 + half4x4, column4x4, size4x4, half4x4,
+                          blocks);
+      break;
+    case kPartitionVertical:
+      AddRandomInterBlock(row4x4, column4x4, half4x4, size4x4, blocks);
+      AddRandomInterBlock(row4x4, column4x4 + half4x4, half4x4, size4x4,
+                          blocks);
+      break;
+    default:
+      assert(partition == kPartitionSplit);
+      AddRandomPartition(row4x4, column4x4, size4x4_log2 - 1, blocks);
+      AddRandomPartition(row4x4, column4x4 + half4x4, size4x4_log2 - 1,
+                         blocks);
+      AddRandomPartition(row4x4 + half4x4, column4x4, size4x4_log2 - 1,
+                         blocks);
+      AddRandomPartition(row4x4 + half4x4, column4x4 + half4x4,
+                         size4x4_log2 - 1, blocks);
+      break;
+  }
+}
+
+void TileTest::AddRandomInterBlock(int row4x4, int column4x4, int width4x4,
+                                   int height4x4,
+                                   std::vector<TestBlock>* const blocks) {
+  int block_size = kBlock4x4;
+  while (kNum4x4BlocksWide[block_size] != width4x4 ||
+         kNum4x4BlocksHigh[block_size] != height4x4) {
+    ++block_size;
+  }
+  BlockParameters* const bp = frame_scratch_buffer_.block_parameters_holder.Get(
+      row4x4, column4x4, static_cast<BlockSize>(block_size));
+  ASSERT_NE(bp, nullptr);
+  bp->prediction_parameters.reset(new (std::nothrow) PredictionParameters());
+  ASSERT_NE(bp->prediction_parameters, nullptr);
+  bp->size = static_cast<BlockSize>(block_size);
+  bp->is_inter = true;
+  bp->y_mode = ((rnd_.Rand8() & 1) != 0) ? kPredictionModeNewMv
+                                          : kPredictionModeNearestMv;
+  bp->reference_frame[0] = static_cast<ReferenceFrameType>(
+      kReferenceFrameLast + rnd_.Rand8() % kNumInterReferenceFrameTypes);
+  bp->reference_frame[1] = kReferenceFrameNone;
+  // Compound prediction is only allowed for blocks of at least 8x8.
+  if (width4x4 > 1 && height4x4 > 1 && (rnd_.Rand8() & 1) != 0) {
+    do {
+      bp->reference_frame[1] = static_cast<ReferenceFrameType>(
+          kReferenceFrameLast + rnd_.Rand8() % kNumInterReferenceFrameTypes);
+    } while (bp->reference_frame[1] == bp->reference_frame[0]);
+  }
+  bp->mv.mv[0] = RandomMv();
+  bp->mv.mv[1] = RandomMv();
+  blocks->push_back({row4x4, column4x4, static_cast<BlockSize>(block_size)});
+}
+
+namespace {
+
+// The blocks that are smaller than 8x8 in luma. The 4:2:0 chroma block of each
+// of them is predicted from the luma blocks of the same size that cover it.
+constexpr BlockSize kSub8x8BlockSizes[] = {kBlock4x4, kBlock4x8, kBlock8x4,
+                                           kBlock4x16, kBlock16x4};
+
+TEST_F(TileTest, ChromaSub8x8InterPredictionSameMotion) {
+  for (const int reference_index : {kReferenceIndex, kScaledReferenceIndex}) {
+    for (const BlockSize block_size : kSub8x8BlockSizes) {
+      for (int i = 0; i < 16; ++i) {
+        const int width4x4 = kNum4x4BlocksWide[block_size];
+        const int height4x4 = kNum4x4BlocksHigh[block_size];
+        // An 8x8 (or 4x16 or 16x4) area inside the frame.
+        const int row4x4 = 2 + 2 * (rnd_.Rand8() % 4);
+        const int column4x4 = 2 + 2 * (rnd_.Rand8() % 4);
+        const int last_row4x4 = row4x4 + ((height4x4 == 1) ? 1 : 0);
+        const int last_column4x4 = column4x4 + ((width4x4 == 1) ? 1 : 0);
+        const MotionVector mv = RandomMv();
+        const InterpolationFilter filter = RandomFilter();
+        for (int row = row4x4; row <= last_row4x4; ++row) {
+          for (int column = column4x4; column <= last_column4x4; ++column) {
+            ASSERT_NE(SetBlock(row, column, block_size, reference_index, mv,
+                               filter),
+                      nullptr);
+          }
+        }
+        TestChromaSub8x8InterPrediction(last_row4x4, last_column4x4,
+                                        block_size);
+        if (HasFatalFailure()) return;
+      }
+    }
+  }
+}
+
+TEST_F(TileTest, ChromaSub8x8InterPredictionMixedMotion) {
+  for (const bool use_scaled_reference : {false, true}) {
+    for (const BlockSize block_size : kSub8x8BlockSizes) {
+      for (int i = 0; i < 16; ++i) {
+        const int width4x4 = kNum4x4BlocksWide[block_size];
+        const int height4x4 = kNum4x4BlocksHigh[block_size];
+        const int row4x4 = 2 + 2 * (rnd_.Rand8() % 4);
+        const int column4x4 = 2 + 2 * (rnd_.Rand8() % 4);
+        const int last_row4x4 = row4x4 + ((height4x4 == 1) ? 1 : 0);
+        const int last_column4x4 = column4x4 + ((width4x4 == 1) ? 1 : 0);
+        // Each candidate has its own motion. Only some of them use the scaled
+        // reference frame.
+        for (int row = row4x4; row <= last_row4x4; ++row) {
+          for (int column = column4x4; column <= last_column4x4; ++column) {
+            const int reference_index =
+                (use_scaled_reference && (rnd_.Rand8() & 1) != 0)
+                    ? kScaledReferenceIndex
+                    : kReferenceIndex;
+            ASSERT_NE(SetBlock(row, column, block_size, reference_index,
+                               RandomMv(), RandomFilter()),
+                      nullptr);
+          }
+        }
+        TestChromaSub8x8InterPrediction(last_row4x4, last_column4x4,
+                                        block_size);
+        if (HasFatalFailure()) return;
+      }
+    }
+  }
+}
+
+TEST_F(TileTest, TemporalMvCacheMatchesPerBlockProjection) {
+  // Covers the three motion vector projection functions.
+  const bool kAllowHighPrecisionMv[3] = {false, false, true};
+  const int8_t kForceIntegerMv[3] = {0, 1, 0};
+  for (int i = 0; i < 3; ++i) {
+    frame_header_.allow_high_precision_mv = kAllowHighPrecisionMv[i];
+    frame_header_.force_integer_mv = kForceIntegerMv[i];
+    for (int j = 0; j < 8; ++j) {
+      TestTemporalMvCache();
+      if (HasFatalFailure()) return;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace libgav1
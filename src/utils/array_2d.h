@@ -25,6 +25,7 @@
 #include <type_traits>
 
 #include "src/utils/compiler_attributes.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 
@@ -83,17 +84,7 @@ class Array2D {
     // If T is not a trivial type, we should always reallocate the data_
     // buffer, so that the destructors of any existing objects are invoked.
     if (!std::is_trivial<T>::value || allocated_size_ < size_) {
-      // Note: This invokes the global operator new if T is a non-class type,
-      // such as integer or enum types, or a class type that is not derived
-      // from libgav1::Allocable, such as std::unique_ptr. If we enforce a
-      // maximum allocation size or keep track of our own heap memory
-      // consumption, we will need to handle the allocations here that use the
-      // global operator new.
-      if (zero_initialize) {
-        data_.reset(new (std::nothrow) T[size_]());
-      } else {
-        data_.reset(new (std::nothrow) T[size_]);
-      }
+      data_ = MakeUniqueArray<T>(size_, /*value_initialize=*/zero_initialize);
       if (data_ == nullptr) {
         allocated_size_ = 0;
         return false;
@@ -109,6 +100,25 @@ class Array2D {
     return true;
   }
 
+  // Allocates memory for at least |size| elements so that a later Reset() to a
+  // size that fits does not allocate. The array becomes empty, so Reset() must
+  // be called before it is used again. Only trivial types are supported since
+  // Reset() always reallocates the others.
+  LIBGAV1_MUST_USE_RESULT bool Reserve(size_t size) {
+    static_assert(std::is_trivial<T>::value,
+                  "Reserve() requires a trivial type.");
+    if (allocated_size_ >= size) return true;
+    size_ = 0;
+    data_view_.Reset(0, 0, nullptr);
+    data_ = MakeUniqueArray<T>(size);
+    if (data_ == nullptr) {
+      allocated_size_ = 0;
+      return false;
+    }
+    allocated_size_ = size;
+    return true;
+  }
+
   int rows() const { return data_view_.rows(); }
   int columns() const { return data_view_.columns(); }
   size_t size() const { return size_; }
@@ -120,7 +130,7 @@ class Array2D {
   const T* operator[](int row) const { return data_view_[row]; }
 
  private:
-  std::unique_ptr<T[]> data_;
+  UniqueArrayPtr<T> data_;
   size_t allocated_size_ = 0;
   size_t size_ = 0;
   Array2DView<T> data_view_;
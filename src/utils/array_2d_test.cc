@@ -244,5 +244,24 @@ TEST(Array2dTest, TestStructInit) {
 #endif
 }
 
+TEST(Array2dTest, TestReserve) {
+  Array2D<int16_t> data2d;
+  ASSERT_TRUE(data2d.Reserve(16 * 16));
+  EXPECT_EQ(data2d.size(), 0);
+  ASSERT_TRUE(data2d.Reset(8, 8, false));
+  const int16_t* const data = data2d.data();
+  // Resets that fit in the reserved memory reuse it, in either direction.
+  ASSERT_TRUE(data2d.Reset(16, 16, true));
+  EXPECT_EQ(data2d.data(), data);
+  EXPECT_EQ(data2d[15][15], 0);
+  ASSERT_TRUE(data2d.Reset(4, 4, false));
+  EXPECT_EQ(data2d.data(), data);
+  // Reserving less than what is allocated keeps the memory and the contents.
+  data2d[3][3] = 1;
+  ASSERT_TRUE(data2d.Reserve(8 * 8));
+  EXPECT_EQ(data2d.data(), data);
+  EXPECT_EQ(data2d[3][3], 1);
+}
+
 }  // namespace
 }  // namespace libgav1
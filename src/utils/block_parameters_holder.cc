@@ -15,6 +15,7 @@
 #include "src/utils/block_parameters_holder.h"
 
 #include <algorithm>
+#include <cstddef>
 
 #include "src/utils/common.h"
 #include "src/utils/constants.h"
@@ -31,6 +32,12 @@ bool BlockParametersHolder::Reset(int rows4x4, int columns4x4) {
          block_parameters_.Resize(rows4x4_ * columns4x4_);
 }
 
+bool BlockParametersHolder::Reserve(int rows4x4, int columns4x4) {
+  const size_t size = static_cast<size_t>(rows4x4) * columns4x4;
+  return block_parameters_cache_.Reserve(size) &&
+         block_parameters_.Resize(size);
+}
+
 BlockParameters* BlockParametersHolder::Get(int row4x4, int column4x4,
                                             BlockSize block_size) {
   const size_t index = index_.fetch_add(1, std::memory_order_relaxed);
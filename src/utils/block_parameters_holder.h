@@ -39,6 +39,11 @@ class BlockParametersHolder {
 
   LIBGAV1_MUST_USE_RESULT bool Reset(int rows4x4, int columns4x4);
 
+  // Allocates the memory needed by Reset() for frames of up to |rows4x4| x
+  // |columns4x4| 4x4 blocks ahead of time. Reset() must be called before the
+  // holder is used again.
+  LIBGAV1_MUST_USE_RESULT bool Reserve(int rows4x4, int columns4x4);
+
   // Returns a pointer to a BlockParameters object that can be used safely until
   // the next call to Reset(). Returns nullptr on memory allocation failure. It
   // also fills the cache matrix for the block starting at |row4x4|, |column4x4|
@@ -78,6 +78,20 @@
 #define ASAN_UNPOISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
 #endif
 
+//------------------------------------------------------------------------------
+// Prefetch.
+
+// LIBGAV1_PREFETCH
+//
+// Hints the processor to bring the cache line containing |addr| into the cache
+// for reading. This is only a hint: it never faults, even if |addr| is not a
+// valid address.
+#if defined(__GNUC__)
+#define LIBGAV1_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define LIBGAV1_PREFETCH(addr) static_cast<void>(addr)
+#endif
+
 //------------------------------------------------------------------------------
 // Function attributes.
 // GCC: https://gcc.gnu.org/onlinedocs/gcc/Function-Attributes.html
@@ -143,6 +157,29 @@
 #define LIBGAV1_PRINTF_ATTRIBUTE(string_index, first_to_check)
 #endif
 
+// LIBGAV1_X86_64_V3_CLONES
+//
+// Compiles the annotated function for baseline x86-64 and for x86-64-v3 (BMI1,
+// BMI2, LZCNT, MOVBE and AVX2). The version matching the CPU is selected once
+// when the library is loaded through an ifunc; calls then go through the GOT
+// without any per-call dispatch code. This is meant for the scalar hot paths
+// outside of the dsp table, such as the entropy decoder. Define
+// LIBGAV1_ENABLE_X86_64_V3_CLONES to 1 to enable it. It is only supported by
+// gcc 11 and later on x86-64 Linux and is ignored otherwise. gcc cannot
+// multiversion virtual functions.
+#if !defined(LIBGAV1_ENABLE_X86_64_V3_CLONES)
+#define LIBGAV1_ENABLE_X86_64_V3_CLONES 0
+#endif
+
+#if LIBGAV1_ENABLE_X86_64_V3_CLONES && defined(__x86_64__) &&           \
+    defined(__linux__) && !defined(__ANDROID__) && !defined(__clang__) && \
+    defined(__GNUC__) && __GNUC__ >= 11
+#define LIBGAV1_X86_64_V3_CLONES \
+  __attribute__((target_clones("arch=x86-64-v3", "default")))
+#else
+#define LIBGAV1_X86_64_V3_CLONES
+#endif
+
 //------------------------------------------------------------------------------
 // Thread annotations.
 
@@ -22,6 +22,19 @@
 
 #include "src/utils/bit_mask_set.h"
 
+// LIBGAV1_SPECIALIZE_420: define to 1 to build a decoder that only accepts
+// 4:2:0 streams with three planes. The plane count and subsampling then become
+// compile-time constants in the tile decoder and the post filter.
+#if !defined(LIBGAV1_SPECIALIZE_420)
+#define LIBGAV1_SPECIALIZE_420 0
+#endif
+
+// LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK: define to 1 to build a decoder that only
+// accepts streams with 64x64 superblocks.
+#if !defined(LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK)
+#define LIBGAV1_SPECIALIZE_64X64_SUPERBLOCK 0
+#endif
+
 namespace libgav1 {
 
 // Returns the number of elements between begin (inclusive) and end (inclusive).
@@ -38,7 +38,7 @@ class DynamicBuffer {
   // to get() will return nullptr.
   bool Resize(size_t size) {
     if (size <= size_) return true;
-    buffer_.reset(new (std::nothrow) T[size]);
+    buffer_ = MakeUniqueArray<T>(size);
     if (buffer_ == nullptr) {
       size_ = 0;
       return false;
@@ -50,7 +50,7 @@ class DynamicBuffer {
   size_t size() const { return size_; }
 
  private:
-  std::unique_ptr<T[]> buffer_;
+  UniqueArrayPtr<T> buffer_;
   size_t size_ = 0;
 };
 
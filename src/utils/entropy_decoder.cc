@@ -644,8 +644,8 @@ int64_t EntropyDecoder::ReadLiteral(int num_bits) {
   return literal;
 }
 
-int EntropyDecoder::ReadSymbol(uint16_t* LIBGAV1_RESTRICT const cdf,
-                               int symbol_count) {
+LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol(
+    uint16_t* LIBGAV1_RESTRICT const cdf, int symbol_count) {
   const int symbol = ReadSymbolImpl(cdf, symbol_count);
   if (allow_update_cdf_) {
     UpdateCdf(cdf, symbol_count, symbol);
@@ -653,7 +653,8 @@ int EntropyDecoder::ReadSymbol(uint16_t* LIBGAV1_RESTRICT const cdf,
   return symbol;
 }
 
-bool EntropyDecoder::ReadSymbol(uint16_t* LIBGAV1_RESTRICT cdf) {
+LIBGAV1_X86_64_V3_CLONES bool EntropyDecoder::ReadSymbol(
+    uint16_t* LIBGAV1_RESTRICT cdf) {
   assert(cdf[1] == 0);
   const bool symbol = ReadSymbolImpl(cdf[0]) != 0;
   if (allow_update_cdf_) {
@@ -683,12 +684,14 @@ bool EntropyDecoder::ReadSymbol(uint16_t* LIBGAV1_RESTRICT cdf) {
   return symbol;
 }
 
-bool EntropyDecoder::ReadSymbolWithoutCdfUpdate(uint16_t cdf) {
+LIBGAV1_X86_64_V3_CLONES bool EntropyDecoder::ReadSymbolWithoutCdfUpdate(
+    uint16_t cdf) {
   return ReadSymbolImpl(cdf) != 0;
 }
 
 template <int symbol_count>
-int EntropyDecoder::ReadSymbol(uint16_t* LIBGAV1_RESTRICT const cdf) {
+LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol(
+    uint16_t* LIBGAV1_RESTRICT const cdf) {
   static_assert(symbol_count >= 3 && symbol_count <= 16, "");
   if (symbol_count == 3 || symbol_count == 4) {
     return ReadSymbol3Or4(cdf, symbol_count);
@@ -1102,19 +1105,34 @@ void EntropyDecoder::NormalizeRange() {
   if (bits_ < 0) PopulateBits();
 }
 
-// Explicit instantiations.
-template int EntropyDecoder::ReadSymbol<3>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<4>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<5>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<6>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<7>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<8>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<9>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<10>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<11>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<12>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<13>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<14>(uint16_t* cdf);
-template int EntropyDecoder::ReadSymbol<16>(uint16_t* cdf);
+// Explicit instantiations. gcc drops the attribute of the template definition
+// because of the extern template declarations in the header, so it is repeated
+// here.
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<3>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<4>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<5>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<6>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<7>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<8>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<9>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<10>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<11>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<12>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<13>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<14>(
+    uint16_t* cdf);
+template LIBGAV1_X86_64_V3_CLONES int EntropyDecoder::ReadSymbol<16>(
+    uint16_t* cdf);
 
 }  // namespace libgav1
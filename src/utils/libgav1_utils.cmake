@@ -38,7 +38,10 @@ list(APPEND libgav1_utils_sources
             "${libgav1_source}/utils/executor.h"
             "${libgav1_source}/utils/logging.cc"
             "${libgav1_source}/utils/logging.h"
+            "${libgav1_source}/utils/memory.cc"
             "${libgav1_source}/utils/memory.h"
+            "${libgav1_source}/utils/perf_counters.cc"
+            "${libgav1_source}/utils/perf_counters.h"
             "${libgav1_source}/utils/queue.h"
             "${libgav1_source}/utils/raw_bit_reader.cc"
             "${libgav1_source}/utils/raw_bit_reader.h"
@@ -0,0 +1,299 @@
+// Copyright 2019 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/utils/memory.h"
+
+#if defined(__ANDROID__) || defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>  // NOLINT (unapproved c++11 header)
+
+#if defined(__linux__)
+#include <link.h>
+#endif
+#endif  // LIBGAV1_ENABLE_ALLOCATION_TRACING
+
+namespace libgav1 {
+namespace {
+
+// Stored immediately before each pointer returned by AlignedAlloc(). The
+// deallocation function is recorded with the memory rather than looked up
+// when it is freed, so that AlignedFree() works on any thread and after the
+// allocator is no longer installed.
+struct AllocationHeader {
+  void (*deallocate)(void* private_data, void* ptr);
+  void* private_data;
+  // The pointer returned by the allocation function.
+  void* base;
+};
+
+// The allocator installed by the innermost ScopedAllocator on this thread, or
+// nullptr for the system allocator.
+thread_local const Allocator* current_allocator = nullptr;
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+
+void* SystemAlignedAlloc(size_t alignment, size_t size) {
+  return _aligned_malloc(size, alignment);
+}
+
+void SystemFree(void* /*private_data*/, void* ptr) { _aligned_free(ptr); }
+
+#else  // !(defined(_MSC_VER) || defined(__MINGW32__))
+
+// |alignment| is at least alignof(AllocationHeader), i.e. sizeof(void*).
+void* SystemAlignedAlloc(size_t alignment, size_t size) {
+#if defined(__ANDROID__)
+  // Although posix_memalign() was introduced in Android API level 17, it is
+  // more convenient to use memalign(). Unlike glibc, Android does not consider
+  // memalign() an obsolete function.
+  return memalign(alignment, size);
+#else   // !defined(__ANDROID__)
+  if (alignment <= alignof(std::max_align_t)) return malloc(size);
+  void* ptr = nullptr;
+  const int error = posix_memalign(&ptr, alignment, size);
+  if (error != 0) {
+    errno = error;
+    return nullptr;
+  }
+  return ptr;
+#endif  // defined(__ANDROID__)
+}
+
+void SystemFree(void* /*private_data*/, void* ptr) { free(ptr); }
+
+#endif  // defined(_MSC_VER) || defined(__MINGW32__)
+
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+
+struct AllocationSite {
+  const void* address;
+  int64_t count;
+  int64_t bytes;
+};
+
+#if defined(__linux__)
+struct ModuleLookup {
+  uintptr_t address;
+  const char* name;
+  uintptr_t offset;
+};
+
+int FindModule(dl_phdr_info* info, size_t /*size*/, void* data) {
+  auto* const lookup = static_cast<ModuleLookup*>(data);
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& header = info->dlpi_phdr[i];
+    if (header.p_type != PT_LOAD) continue;
+    const uintptr_t start = info->dlpi_addr + header.p_vaddr;
+    if (lookup->address >= start && lookup->address - start < header.p_memsz) {
+      // The main program has an empty name.
+      lookup->name = (info->dlpi_name[0] != '\0') ? info->dlpi_name
+                                                  : "/proc/self/exe";
+      lookup->offset = lookup->address - info->dlpi_addr;
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif  // defined(__linux__)
+
+void PrintAllocationSite(const AllocationSite& site) {
+  fprintf(stderr, "  %" PRId64 " allocation(s), %" PRId64 " bytes at ",
+          site.count, site.bytes);
+  if (site.address == nullptr) {
+    fprintf(stderr, "other call sites\n");
+    return;
+  }
+  // The return address is in the instruction after the call. Look up the call
+  // itself.
+  const uintptr_t address = reinterpret_cast<uintptr_t>(site.address) - 1;
+#if defined(__linux__)
+  ModuleLookup lookup = {address, nullptr, 0};
+  if (dl_iterate_phdr(FindModule, &lookup) != 0) {
+    fprintf(stderr, "%s+0x%" PRIxPTR "\n", lookup.name, lookup.offset);
+    return;
+  }
+#endif
+  fprintf(stderr, "0x%" PRIxPTR "\n", address);
+}
+
+class AllocationTracer {
+ public:
+  void Record(const void* address, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++total_count_;
+    int i = 0;
+    while (i < num_sites_ && sites_[i].address != address) ++i;
+    if (i == num_sites_) {
+      if (num_sites_ == kMaxSites) {
+        // Count the call sites that do not fit in the last entry.
+        i = kMaxSites - 1;
+        sites_[i].address = nullptr;
+      } else {
+        sites_[num_sites_++] = {address, 0, 0};
+      }
+    }
+    ++sites_[i].count;
+    sites_[i].bytes += static_cast<int64_t>(size);
+  }
+
+  int64_t total_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_count_;
+  }
+
+  void Report() {
+    AllocationSite sites[kMaxSites];
+    int num_sites;
+    int period;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_sites = num_sites_;
+      std::copy(sites_, sites_ + num_sites_, sites);
+      num_sites_ = 0;
+      period = period_++;
+    }
+    if (num_sites == 0) return;
+    std::sort(sites, sites + num_sites,
+              [](const AllocationSite& a, const AllocationSite& b) {
+                return a.count > b.count;
+              });
+    int64_t count = 0;
+    int64_t bytes = 0;
+    for (int i = 0; i < num_sites; ++i) {
+      count += sites[i].count;
+      bytes += sites[i].bytes;
+    }
+    fprintf(stderr,
+            "libgav1: %" PRId64 " allocation(s), %" PRId64
+            " bytes before output frame %d:\n",
+            count, bytes, period);
+    for (int i = 0; i < num_sites; ++i) PrintAllocationSite(sites[i]);
+  }
+
+ private:
+  static constexpr int kMaxSites = 256;
+
+  std::mutex mutex_;
+  AllocationSite sites_[kMaxSites];
+  int num_sites_ = 0;
+  int64_t total_count_ = 0;
+  int period_ = 0;
+};
+
+AllocationTracer& GetAllocationTracer() {
+  static AllocationTracer tracer;
+  return tracer;
+}
+
+#endif  // LIBGAV1_ENABLE_ALLOCATION_TRACING
+
+}  // namespace
+
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+int64_t GetTracedAllocationCount() {
+  return GetAllocationTracer().total_count();
+}
+
+void ReportTracedAllocations() { GetAllocationTracer().Report(); }
+#endif
+
+Allocator GetCurrentAllocator() {
+  return (current_allocator != nullptr) ? *current_allocator : Allocator();
+}
+
+ScopedAllocator::ScopedAllocator(const Allocator& allocator)
+    : allocator_(allocator), previous_(current_allocator) {
+  current_allocator = &allocator_;
+}
+
+ScopedAllocator::~ScopedAllocator() {
+  assert(current_allocator == &allocator_);
+  current_allocator = previous_;
+}
+
+void* AlignedAlloc(size_t alignment, size_t size) {
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  if (alignment < alignof(AllocationHeader)) {
+    alignment = alignof(AllocationHeader);
+  }
+  // The returned pointer is |offset| bytes past an |alignment| aligned base
+  // address, which leaves room for the header and keeps the alignment.
+  const size_t offset =
+      (sizeof(AllocationHeader) + alignment - 1) & ~(alignment - 1);
+  if (size > std::numeric_limits<size_t>::max() - offset - alignment) {
+    return nullptr;
+  }
+  const Allocator* const allocator = current_allocator;
+  AllocationHeader header;
+  uint8_t* ptr;
+  if (allocator == nullptr || allocator->allocate == nullptr) {
+    header.deallocate = SystemFree;
+    header.private_data = nullptr;
+    header.base = SystemAlignedAlloc(alignment, offset + size);
+    if (header.base == nullptr) return nullptr;
+    ptr = static_cast<uint8_t*>(header.base) + offset;
+  } else {
+    header.deallocate = allocator->deallocate;
+    header.private_data = allocator->private_data;
+    if (alignment <= alignof(std::max_align_t)) {
+      header.base = allocator->allocate(allocator->private_data, offset + size);
+      if (header.base == nullptr) return nullptr;
+      ptr = static_cast<uint8_t*>(header.base) + offset;
+    } else if (allocator->allocate_aligned != nullptr) {
+      header.base = allocator->allocate_aligned(allocator->private_data,
+                                                alignment, offset + size);
+      if (header.base == nullptr) return nullptr;
+      ptr = static_cast<uint8_t*>(header.base) + offset;
+    } else {
+      // Over-allocate and align the pointer here.
+      header.base = allocator->allocate(allocator->private_data,
+                                        offset + size + alignment);
+      if (header.base == nullptr) return nullptr;
+      const auto address = reinterpret_cast<uintptr_t>(header.base) + offset;
+      ptr = reinterpret_cast<uint8_t*>((address + alignment - 1) &
+                                       ~static_cast<uintptr_t>(alignment - 1));
+    }
+  }
+  reinterpret_cast<AllocationHeader*>(ptr)[-1] = header;
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+#if defined(__GNUC__)
+  GetAllocationTracer().Record(__builtin_return_address(0), size);
+#else
+  GetAllocationTracer().Record(nullptr, size);
+#endif
+#endif
+  return ptr;
+}
+
+void AlignedFree(void* aligned_memory) {
+  if (aligned_memory == nullptr) return;
+  const AllocationHeader& header =
+      static_cast<const AllocationHeader*>(aligned_memory)[-1];
+  header.deallocate(header.private_data, header.base);
+}
+
+}  // namespace libgav1
@@ -17,17 +17,14 @@
 #ifndef LIBGAV1_SRC_UTILS_MEMORY_H_
 #define LIBGAV1_SRC_UTILS_MEMORY_H_
 
-#if defined(__ANDROID__) || defined(_MSC_VER) || defined(__MINGW32__)
-#include <malloc.h>
-#endif
-
-#include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <new>
+#include <type_traits>
 
 namespace libgav1 {
 
@@ -42,10 +39,68 @@ enum {
 #endif
 };
 
+// The memory allocation functions used by AlignedAlloc(). See the
+// allocate_memory, allocate_aligned_memory and free_memory fields of
+// DecoderSettings for their contracts. If |allocate| is nullptr, the system
+// allocator is used.
+struct Allocator {
+  void* (*allocate)(void* private_data, size_t size) = nullptr;
+  void* (*allocate_aligned)(void* private_data, size_t alignment,
+                            size_t size) = nullptr;
+  void (*deallocate)(void* private_data, void* ptr) = nullptr;
+  void* private_data = nullptr;
+};
+
+// Returns the allocator installed on the current thread by the innermost
+// ScopedAllocator, or a default (system) Allocator if there is none.
+Allocator GetCurrentAllocator();
+
+// Makes AlignedAlloc() (and everything built on it) use |allocator| on the
+// current thread for the lifetime of this object. The previously installed
+// allocator is restored on destruction.
+class ScopedAllocator {
+ public:
+  explicit ScopedAllocator(const Allocator& allocator);
+  ~ScopedAllocator();
+
+  // Not copyable or movable.
+  ScopedAllocator(const ScopedAllocator&) = delete;
+  ScopedAllocator& operator=(const ScopedAllocator&) = delete;
+
+ private:
+  const Allocator allocator_;
+  const Allocator* const previous_;
+};
+
+// Allocation tracing
+//
+// Define LIBGAV1_ENABLE_ALLOCATION_TRACING to 1 to record the call site of
+// every AlignedAlloc() call, i.e. of every allocation made through Allocable,
+// MaxAlignedAllocable, MakeUniqueArray(), MakeAlignedUniquePtr() and the
+// buffers built on them, such as DynamicBuffer. The call site is the return
+// address of AlignedAlloc(), which is in the function that the allocation
+// helper was inlined into. This is meant for finding the allocations made
+// while decoding each frame; it serializes the allocations on a mutex.
+#if !defined(LIBGAV1_ENABLE_ALLOCATION_TRACING)
+#define LIBGAV1_ENABLE_ALLOCATION_TRACING 0
+#endif
+
+#if LIBGAV1_ENABLE_ALLOCATION_TRACING
+// Returns the number of allocations traced since the process started.
+int64_t GetTracedAllocationCount();
+
+// Writes the allocations traced since the previous call to stderr, grouped by
+// call site, and starts a new period. Does nothing if there were none. The
+// call sites are printed as an offset into the module that contains them, for
+// use with addr2line. Called by the decoder for every frame that it outputs.
+void ReportTracedAllocations();
+#endif
+
 // AlignedAlloc, AlignedFree
 //
 // void* AlignedAlloc(size_t alignment, size_t size);
-//   Allocate aligned memory.
+//   Allocate aligned memory from the current thread's allocator (see
+//   ScopedAllocator).
 //   |alignment| must be a power of 2.
 //   Unlike posix_memalign(), |alignment| may be smaller than sizeof(void*).
 //   Unlike aligned_alloc(), |size| does not need to be a multiple of
@@ -53,43 +108,10 @@ enum {
 //   The returned pointer should be freed by AlignedFree().
 //
 // void AlignedFree(void* aligned_memory);
-//   Free aligned memory.
-
-#if defined(_MSC_VER) || defined(__MINGW32__)
-
-inline void* AlignedAlloc(size_t alignment, size_t size) {
-  return _aligned_malloc(size, alignment);
-}
-
-inline void AlignedFree(void* aligned_memory) { _aligned_free(aligned_memory); }
-
-#else  // !(defined(_MSC_VER) || defined(__MINGW32__))
-
-inline void* AlignedAlloc(size_t alignment, size_t size) {
-#if defined(__ANDROID__)
-  // Although posix_memalign() was introduced in Android API level 17, it is
-  // more convenient to use memalign(). Unlike glibc, Android does not consider
-  // memalign() an obsolete function.
-  return memalign(alignment, size);
-#else   // !defined(__ANDROID__)
-  void* ptr = nullptr;
-  // posix_memalign requires that the requested alignment be at least
-  // sizeof(void*). In this case, fall back on malloc which should return
-  // memory aligned to at least the size of a pointer.
-  const size_t required_alignment = sizeof(void*);
-  if (alignment < required_alignment) return malloc(size);
-  const int error = posix_memalign(&ptr, alignment, size);
-  if (error != 0) {
-    errno = error;
-    return nullptr;
-  }
-  return ptr;
-#endif  // defined(__ANDROID__)
-}
-
-inline void AlignedFree(void* aligned_memory) { free(aligned_memory); }
-
-#endif  // defined(_MSC_VER) || defined(__MINGW32__)
+//   Free aligned memory. The memory is returned to the allocator it came
+//   from, so this may be called on any thread.
+void* AlignedAlloc(size_t alignment, size_t size);
+void AlignedFree(void* aligned_memory);
 
 inline void Memset(uint8_t* const dst, int value, size_t count) {
   memset(dst, value, count);
@@ -126,6 +148,51 @@ inline AlignedUniquePtr<T> MakeAlignedUniquePtr(size_t alignment,
       static_cast<T*>(AlignedAlloc(alignment, count * sizeof(T))));
 }
 
+// Destroys the elements of an array allocated by MakeUniqueArray() and frees
+// it.
+template <typename T>
+class ArrayDeleter {
+ public:
+  ArrayDeleter() = default;
+  explicit ArrayDeleter(size_t count) : count_(count) {}
+
+  void operator()(T* array) const {
+    if (!std::is_trivially_destructible<T>::value) {
+      for (size_t i = 0; i < count_; ++i) array[i].~T();
+    }
+    AlignedFree(array);
+  }
+
+ private:
+  size_t count_ = 0;
+};
+
+template <typename T>
+using UniqueArrayPtr = std::unique_ptr<T[], ArrayDeleter<T>>;
+
+// Allocates an array of |count| elements of type T with AlignedAlloc(), so
+// that, unlike new T[], it comes from the current allocator even if T is not
+// derived from Allocable. The elements are value-initialized if
+// |value_initialize| is true and default-initialized otherwise. Returns
+// nullptr on failure.
+template <typename T>
+inline UniqueArrayPtr<T> MakeUniqueArray(size_t count,
+                                         bool value_initialize = false) {
+  if (count > std::numeric_limits<size_t>::max() / sizeof(T)) return nullptr;
+  constexpr size_t kAlignment = (alignof(T) > alignof(std::max_align_t))
+                                    ? alignof(T)
+                                    : alignof(std::max_align_t);
+  T* const array =
+      static_cast<T*>(AlignedAlloc(kAlignment, count * sizeof(T)));
+  if (array == nullptr) return nullptr;
+  if (value_initialize) {
+    for (size_t i = 0; i < count; ++i) ::new (&array[i]) T();
+  } else {
+    for (size_t i = 0; i < count; ++i) ::new (&array[i]) T;
+  }
+  return UniqueArrayPtr<T>(array, ArrayDeleter<T>(count));
+}
+
 // A base class with custom new and delete operators. The exception-throwing
 // new operators are deleted. The "new (std::nothrow)" form must be used.
 //
@@ -133,6 +200,8 @@ inline AlignedUniquePtr<T> MakeAlignedUniquePtr(size_t alignment,
 // 0x40000000 bytes (1 GB). TODO(wtc): Make the maximum allocable memory size
 // a compile-time configuration macro.
 //
+// The memory comes from AlignedAlloc(), i.e. from the current allocator.
+//
 // See https://en.cppreference.com/w/cpp/memory/new/operator_new and
 // https://en.cppreference.com/w/cpp/memory/new/operator_delete.
 //
@@ -145,36 +214,37 @@ struct Allocable {
 
   // Class-specific non-throwing allocation functions
   static void* operator new(size_t size, const std::nothrow_t& tag) noexcept {
+    static_cast<void>(tag);
     if (size > 0x40000000) return nullptr;
-    return ::operator new(size, tag);
+    return AlignedAlloc(alignof(std::max_align_t), size);
   }
   static void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    static_cast<void>(tag);
     if (size > 0x40000000) return nullptr;
-    return ::operator new[](size, tag);
+    return AlignedAlloc(alignof(std::max_align_t), size);
   }
 
   // Class-specific deallocation functions.
-  static void operator delete(void* ptr) noexcept { ::operator delete(ptr); }
-  static void operator delete[](void* ptr) noexcept {
-    ::operator delete[](ptr);
-  }
+  static void operator delete(void* ptr) noexcept { AlignedFree(ptr); }
+  static void operator delete[](void* ptr) noexcept { AlignedFree(ptr); }
 
   // Only called if new (std::nothrow) is used and the constructor throws an
   // exception.
   static void operator delete(void* ptr, const std::nothrow_t& tag) noexcept {
-    ::operator delete(ptr, tag);
+    static_cast<void>(tag);
+    AlignedFree(ptr);
   }
   // Only called if new[] (std::nothrow) is used and the constructor throws an
   // exception.
   static void operator delete[](void* ptr, const std::nothrow_t& tag) noexcept {
-    ::operator delete[](ptr, tag);
+    static_cast<void>(tag);
+    AlignedFree(ptr);
   }
 };
 
 // A variant of Allocable that forces allocations to be aligned to
 // kMaxAlignment bytes. This is intended for use with classes that use
-// alignas() with this value. C++17 aligned new/delete are used if available,
-// otherwise we use AlignedAlloc/Free.
+// alignas() with this value.
 struct MaxAlignedAllocable {
   // Class-specific allocation functions.
   static void* operator new(size_t size) = delete;
@@ -182,59 +252,31 @@ struct MaxAlignedAllocable {
 
   // Class-specific non-throwing allocation functions
   static void* operator new(size_t size, const std::nothrow_t& tag) noexcept {
-    if (size > 0x40000000) return nullptr;
-#ifdef __cpp_aligned_new
-    return ::operator new(size, std::align_val_t(kMaxAlignment), tag);
-#else
     static_cast<void>(tag);
+    if (size > 0x40000000) return nullptr;
     return AlignedAlloc(kMaxAlignment, size);
-#endif
   }
   static void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
-    if (size > 0x40000000) return nullptr;
-#ifdef __cpp_aligned_new
-    return ::operator new[](size, std::align_val_t(kMaxAlignment), tag);
-#else
     static_cast<void>(tag);
+    if (size > 0x40000000) return nullptr;
     return AlignedAlloc(kMaxAlignment, size);
-#endif
   }
 
   // Class-specific deallocation functions.
-  static void operator delete(void* ptr) noexcept {
-#ifdef __cpp_aligned_new
-    ::operator delete(ptr, std::align_val_t(kMaxAlignment));
-#else
-    AlignedFree(ptr);
-#endif
-  }
-  static void operator delete[](void* ptr) noexcept {
-#ifdef __cpp_aligned_new
-    ::operator delete[](ptr, std::align_val_t(kMaxAlignment));
-#else
-    AlignedFree(ptr);
-#endif
-  }
+  static void operator delete(void* ptr) noexcept { AlignedFree(ptr); }
+  static void operator delete[](void* ptr) noexcept { AlignedFree(ptr); }
 
   // Only called if new (std::nothrow) is used and the constructor throws an
   // exception.
   static void operator delete(void* ptr, const std::nothrow_t& tag) noexcept {
-#ifdef __cpp_aligned_new
-    ::operator delete(ptr, std::align_val_t(kMaxAlignment), tag);
-#else
     static_cast<void>(tag);
     AlignedFree(ptr);
-#endif
   }
   // Only called if new[] (std::nothrow) is used and the constructor throws an
   // exception.
   static void operator delete[](void* ptr, const std::nothrow_t& tag) noexcept {
-#ifdef __cpp_aligned_new
-    ::operator delete[](ptr, std::align_val_t(kMaxAlignment), tag);
-#else
     static_cast<void>(tag);
     AlignedFree(ptr);
-#endif
   }
 };
 
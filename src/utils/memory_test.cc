@@ -180,5 +180,102 @@ TEST(MemoryTest, TestMaxAlignedAllocable) {
 #endif  // ABSL_HAVE_EXCEPTIONS
 }
 
+// Counts the calls and forwards them to the system allocator.
+struct CountingAllocator {
+  int allocations = 0;
+  int aligned_allocations = 0;
+  int frees = 0;
+};
+
+void* CountingAllocate(void* private_data, size_t size) {
+  ++static_cast<CountingAllocator*>(private_data)->allocations;
+  const ScopedAllocator system_allocator{Allocator()};
+  return AlignedAlloc(alignof(std::max_align_t), size);
+}
+
+void* CountingAllocateAligned(void* private_data, size_t alignment,
+                              size_t size) {
+  ++static_cast<CountingAllocator*>(private_data)->aligned_allocations;
+  const ScopedAllocator system_allocator{Allocator()};
+  return AlignedAlloc(alignment, size);
+}
+
+void CountingFree(void* private_data, void* ptr) {
+  ++static_cast<CountingAllocator*>(private_data)->frees;
+  AlignedFree(ptr);
+}
+
+Allocator MakeCountingAllocator(CountingAllocator* counts,
+                                bool with_aligned_allocate) {
+  Allocator allocator;
+  allocator.allocate = CountingAllocate;
+  if (with_aligned_allocate) {
+    allocator.allocate_aligned = CountingAllocateAligned;
+  }
+  allocator.deallocate = CountingFree;
+  allocator.private_data = counts;
+  return allocator;
+}
+
+TEST(MemoryTest, TestScopedAllocator) {
+  for (const bool with_aligned_allocate : {false, true}) {
+    SCOPED_TRACE(with_aligned_allocate);
+    CountingAllocator counts;
+    void* small;
+    void* aligned;
+    std::unique_ptr<Small> object;
+    {
+      const ScopedAllocator scoped_allocator(
+          MakeCountingAllocator(&counts, with_aligned_allocate));
+      EXPECT_EQ(GetCurrentAllocator().private_data, &counts);
+      small = AlignedAlloc(1, 1);
+      ASSERT_NE(small, nullptr);
+      aligned = AlignedAlloc(1 << 10, 100);
+      ASSERT_NE(aligned, nullptr);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % (1 << 10), 0);
+      object.reset(new (std::nothrow) Small);
+      ASSERT_NE(object, nullptr);
+      {
+        // A nested scope with the system allocator.
+        const ScopedAllocator system_allocator{Allocator()};
+        void* const p = AlignedAlloc(16, 1);
+        ASSERT_NE(p, nullptr);
+        AlignedFree(p);
+      }
+      EXPECT_EQ(GetCurrentAllocator().private_data, &counts);
+    }
+    EXPECT_EQ(GetCurrentAllocator().allocate, nullptr);
+    EXPECT_EQ(counts.allocations + counts.aligned_allocations, 3);
+    EXPECT_EQ(counts.aligned_allocations, with_aligned_allocate ? 1 : 0);
+    // The memory goes back to the allocator it came from even though the
+    // allocator is no longer installed.
+    AlignedFree(small);
+    AlignedFree(aligned);
+    object = nullptr;
+    EXPECT_EQ(counts.frees, 3);
+  }
+}
+
+TEST(MemoryTest, TestMakeUniqueArray) {
+  CountingAllocator counts;
+  {
+    const ScopedAllocator scoped_allocator(
+        MakeCountingAllocator(&counts, /*with_aligned_allocate=*/false));
+    UniqueArrayPtr<int> zeros =
+        MakeUniqueArray<int>(100, /*value_initialize=*/true);
+    ASSERT_NE(zeros, nullptr);
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(zeros[i], 0);
+    UniqueArrayPtr<std::unique_ptr<int>> pointers =
+        MakeUniqueArray<std::unique_ptr<int>>(10);
+    ASSERT_NE(pointers, nullptr);
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(pointers[i], nullptr);
+    // The destructors of the elements are invoked.
+    pointers[3].reset(new (std::nothrow) int(3));
+    EXPECT_EQ(MakeUniqueArray<uint64_t>(SIZE_MAX / 4), nullptr);
+  }
+  EXPECT_EQ(counts.allocations, 2);
+  EXPECT_EQ(counts.frees, 2);
+}
+
 }  // namespace
 }  // namespace libgav1
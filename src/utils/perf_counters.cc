@@ -0,0 +1,270 @@
+// Copyright 2021 The libgav1 Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/utils/perf_counters.h"
+
+#include <cassert>
+#include <cstdint>
+
+#if LIBGAV1_PERF_COUNTERS_SUPPORTED
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "src/utils/logging.h"
+#endif  // LIBGAV1_PERF_COUNTERS_SUPPORTED
+
+namespace libgav1 {
+
+PerfCounterTotals::PerfCounterTotals() : available_counters_(0) {
+  for (auto& stage_counts : counts_) {
+    for (auto& count : stage_counts) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void PerfCounterTotals::Add(
+    int available_counters,
+    const int64_t counts[kNumPerfStages][kNumPerfCounters]) {
+  available_counters_.fetch_or(available_counters, std::memory_order_relaxed);
+  for (int stage = 0; stage < kNumPerfStages; ++stage) {
+    for (int counter = 0; counter < kNumPerfCounters; ++counter) {
+      if (counts[stage][counter] == 0) continue;
+      counts_[stage][counter].fetch_add(counts[stage][counter],
+                                        std::memory_order_relaxed);
+    }
+  }
+}
+
+void PerfCounterTotals::Get(PerfCounters* const perf_counters) const {
+  perf_counters->available_counters =
+      available_counters_.load(std::memory_order_relaxed);
+  for (int stage = 0; stage < kNumPerfStages; ++stage) {
+    for (int counter = 0; counter < kNumPerfCounters; ++counter) {
+      perf_counters->counts[stage][counter] =
+          counts_[stage][counter].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+#if LIBGAV1_PERF_COUNTERS_SUPPORTED
+namespace {
+
+// The counters of one thread. Each counter is a separate event that counts
+// the user space work of the thread on any cpu.
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      fds_[i] = -1;
+      pages_[i] = nullptr;
+    }
+  }
+
+  ~ThreadCounters() {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      if (pages_[i] != nullptr) {
+        munmap(const_cast<perf_event_mmap_page*>(pages_[i]), page_size_);
+      }
+      if (fds_[i] >= 0) close(fds_[i]);
+    }
+  }
+
+  // Not copyable or movable.
+  ThreadCounters(const ThreadCounters&) = delete;
+  ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+  // Opens the counters the first time it is called. Returns the bitmask of
+  // the counters that are available.
+  int Open();
+
+  // Stores the current value of each counter in |values|. The values of the
+  // counters that are not available are left unchanged.
+  void Read(uint64_t values[kNumPerfCounters]) const;
+
+ private:
+  static uint64_t ReadCounter(int fd,
+                              const volatile perf_event_mmap_page* page);
+
+  bool open_attempted_ = false;
+  int available_ = 0;
+  size_t page_size_ = 0;
+  int fds_[kNumPerfCounters];
+  // The user page of each counter, through which it can be read with the
+  // rdpmc instruction instead of a system call. nullptr if it could not be
+  // mapped.
+  const volatile perf_event_mmap_page* pages_[kNumPerfCounters];
+};
+
+int ThreadCounters::Open() {
+  if (open_attempted_) return available_;
+  open_attempted_ = true;
+  // Indexed by PerfCounter. The generic cache miss event counts the last level
+  // cache misses on most cpus.
+  static constexpr uint64_t kConfigs[kNumPerfCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kConfigs[i];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid 0 and cpu -1 count the calling thread on any cpu.
+    const long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+                            PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+      LIBGAV1_DLOG(WARNING, "perf_event_open() failed for counter %d: %s", i,
+                   strerror(errno));
+      continue;
+    }
+    fds_[i] = static_cast<int>(fd);
+    available_ |= 1 << i;
+    void* const page =
+        mmap(nullptr, page_size_, PROT_READ, MAP_SHARED, fds_[i], 0);
+    if (page != MAP_FAILED) {
+      pages_[i] = static_cast<const volatile perf_event_mmap_page*>(page);
+    }
+  }
+  return available_;
+}
+
+// Uses the sequence lock protocol documented in linux/perf_event.h to read the
+// counter with rdpmc while the event is scheduled on the current cpu. Falls
+// back to read() otherwise.
+uint64_t ThreadCounters::ReadCounter(
+    int fd, const volatile perf_event_mmap_page* const page) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (page != nullptr) {
+    uint32_t sequence;
+    uint64_t count;
+    bool rdpmc_usable;
+    do {
+      sequence = page->lock;
+      std::atomic_signal_fence(std::memory_order_acquire);
+      const uint32_t index = page->index;
+      rdpmc_usable = page->cap_user_rdpmc != 0 && index != 0;
+      if (!rdpmc_usable) break;
+      count = page->offset;
+      // The counter is |pmc_width| bits wide. Sign extend it before adding it
+      // to the offset.
+      const int shift = 64 - page->pmc_width;
+      const uint64_t pmc = static_cast<uint64_t>(__rdpmc(index - 1)) << shift;
+      count += static_cast<uint64_t>(static_cast<int64_t>(pmc) >> shift);
+      std::atomic_signal_fence(std::memory_order_acquire);
+    } while (page->lock != sequence);
+    if (rdpmc_usable) return count;
+  }
+#else
+  static_cast<void>(page);
+#endif
+  uint64_t count;
+  if (read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+  return count;
+}
+
+void ThreadCounters::Read(uint64_t values[kNumPerfCounters]) const {
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    if (fds_[i] >= 0) values[i] = ReadCounter(fds_[i], pages_[i]);
+  }
+}
+
+struct ThreadState {
+  ThreadCounters counters;
+  // Non-null while the thread is collecting.
+  PerfCounterTotals* totals = nullptr;
+  int available_counters = 0;
+  // The stage that the events are currently attributed to, or -1 if there is
+  // none.
+  int stage = -1;
+  // The counter values when |stage| was last changed.
+  uint64_t last[kNumPerfCounters] = {};
+  int64_t counts[kNumPerfStages][kNumPerfCounters] = {};
+};
+
+thread_local ThreadState thread_state;
+
+// Attributes the events counted since the last call to the current stage.
+void UpdateCounts(ThreadState* const state) {
+  uint64_t now[kNumPerfCounters];
+  memcpy(now, state->last, sizeof(now));
+  state->counters.Read(now);
+  if (state->stage >= 0) {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      state->counts[state->stage][i] +=
+          static_cast<int64_t>(now[i] - state->last[i]);
+    }
+  }
+  memcpy(state->last, now, sizeof(now));
+}
+
+}  // namespace
+
+bool PerfCountersAvailable() { return thread_state.counters.Open() != 0; }
+
+PerfCounterTotals* CurrentPerfCounterTotals() { return thread_state.totals; }
+
+ScopedPerfCounterCollection::ScopedPerfCounterCollection(
+    PerfCounterTotals* const totals)
+    : active_(false) {
+  ThreadState* const state = &thread_state;
+  if (totals == nullptr || state->totals != nullptr) return;
+  state->available_counters = state->counters.Open();
+  if (state->available_counters == 0) return;
+  active_ = true;
+  state->totals = totals;
+  state->stage = -1;
+  memset(state->counts, 0, sizeof(state->counts));
+}
+
+ScopedPerfCounterCollection::~ScopedPerfCounterCollection() {
+  if (!active_) return;
+  ThreadState* const state = &thread_state;
+  assert(state->stage == -1);
+  state->totals->Add(state->available_counters, state->counts);
+  state->totals = nullptr;
+}
+
+ScopedPerfStage::ScopedPerfStage(PerfStage stage)
+    : active_(false), previous_stage_(-1) {
+  ThreadState* const state = &thread_state;
+  if (state->totals == nullptr) return;
+  active_ = true;
+  UpdateCounts(state);
+  previous_stage_ = state->stage;
+  state->stage = stage;
+}
+
+ScopedPerfStage::~ScopedPerfStage() {
+  if (!active_) return;
+  ThreadState* const state = &thread_state;
+  UpdateCounts(state);
+  state->stage = previous_stage_;
+}
+
+#endif  // LIBGAV1_PERF_COUNTERS_SUPPORTED
+
+}  // namespace libgav1
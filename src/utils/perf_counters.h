@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 The libgav1 Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LIBGAV1_SRC_UTILS_PERF_COUNTERS_H_
+#define LIBGAV1_SRC_UTILS_PERF_COUNTERS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "src/gav1/perf_counters.h"
+#include "src/utils/memory.h"
+
+// Hardware performance counters per decoding stage. Define
+// LIBGAV1_ENABLE_PERF_COUNTERS to 1 to compile in the collection. It is only
+// supported on Linux (through perf_event_open()). Otherwise, or if it is 0, the
+// scopes below are empty and are optimized away.
+#if !defined(LIBGAV1_ENABLE_PERF_COUNTERS)
+#define LIBGAV1_ENABLE_PERF_COUNTERS 0
+#endif
+
+#if LIBGAV1_ENABLE_PERF_COUNTERS && defined(__linux__)
+#define LIBGAV1_PERF_COUNTERS_SUPPORTED 1
+#else
+#define LIBGAV1_PERF_COUNTERS_SUPPORTED 0
+#endif
+
+namespace libgav1 {
+
+// The counts of all the threads that decode for one decoder. The threads add
+// their counts when their outermost ScopedPerfCounterCollection ends.
+class PerfCounterTotals : public Allocable {
+ public:
+  PerfCounterTotals();
+
+  // Not copyable or movable.
+  PerfCounterTotals(const PerfCounterTotals&) = delete;
+  PerfCounterTotals& operator=(const PerfCounterTotals&) = delete;
+
+  void Add(int available_counters,
+           const int64_t counts[kNumPerfStages][kNumPerfCounters]);
+  void Get(PerfCounters* perf_counters) const;
+
+ private:
+  std::atomic<int> available_counters_;
+  std::atomic<int64_t> counts_[kNumPerfStages][kNumPerfCounters];
+};
+
+#if LIBGAV1_PERF_COUNTERS_SUPPORTED
+
+// Opens the counters of the calling thread if needed. Returns true if at least
+// one of them is available.
+bool PerfCountersAvailable();
+
+// Returns the totals that the calling thread is collecting for, or nullptr if
+// it is not collecting.
+PerfCounterTotals* CurrentPerfCounterTotals();
+
+// Makes the calling thread collect the counts of the ScopedPerfStages that it
+// runs into |totals| for the lifetime of this object. Nested collections on a
+// thread that is already collecting and a null |totals| do nothing.
+class ScopedPerfCounterCollection {
+ public:
+  explicit ScopedPerfCounterCollection(PerfCounterTotals* totals);
+  ~ScopedPerfCounterCollection();
+
+  // Not copyable or movable.
+  ScopedPerfCounterCollection(const ScopedPerfCounterCollection&) = delete;
+  ScopedPerfCounterCollection& operator=(const ScopedPerfCounterCollection&) =
+      delete;
+
+ private:
+  bool active_;
+};
+
+// Attributes the events counted on the calling thread to |stage| for the
+// lifetime of this object, unless a nested ScopedPerfStage attributes them to
+// another stage. Each scope reads the counters twice, so it should not be
+// placed around work that is much shorter than a block. Does nothing if the
+// thread is not collecting.
+class ScopedPerfStage {
+ public:
+  explicit ScopedPerfStage(PerfStage stage);
+  ~ScopedPerfStage();
+
+  // Not copyable or movable.
+  ScopedPerfStage(const ScopedPerfStage&) = delete;
+  ScopedPerfStage& operator=(const ScopedPerfStage&) = delete;
+
+ private:
+  bool active_;
+  int previous_stage_;
+};
+
+#else  // !LIBGAV1_PERF_COUNTERS_SUPPORTED
+
+inline bool PerfCountersAvailable() { return false; }
+
+inline PerfCounterTotals* CurrentPerfCounterTotals() { return nullptr; }
+
+class ScopedPerfCounterCollection {
+ public:
+  explicit ScopedPerfCounterCollection(PerfCounterTotals* /*totals*/) {}
+};
+
+class ScopedPerfStage {
+ public:
+  explicit ScopedPerfStage(PerfStage /*stage*/) {}
+};
+
+#endif  // LIBGAV1_PERF_COUNTERS_SUPPORTED
+
+}  // namespace libgav1
+
+#endif  // LIBGAV1_SRC_UTILS_PERF_COUNTERS_H_
@@ -24,6 +24,7 @@
 #include <utility>
 
 #include "src/utils/compiler_attributes.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 
@@ -34,7 +35,7 @@ template <typename T>
 class Queue {
  public:
   LIBGAV1_MUST_USE_RESULT bool Init(size_t capacity) {
-    elements_.reset(new (std::nothrow) T[capacity]);
+    elements_ = MakeUniqueArray<T>(capacity);
     if (elements_ == nullptr) return false;
     capacity_ = capacity;
     return true;
@@ -66,6 +67,15 @@ class Queue {
     return elements_[begin_];
   }
 
+  // Returns a reference to the element at position |index| counting from the
+  // front of the queue. It is an error to call this with |index| >= Size().
+  T& operator[](size_t index) {
+    assert(index < size_);
+    index += begin_;
+    if (index >= capacity_) index -= capacity_;
+    return elements_[index];
+  }
+
   // Returns a reference to the element at the back of the queue. It is an error
   // to call Back() when the queue is empty.
   T& Back() {
@@ -92,7 +102,7 @@ class Queue {
 
  private:
   // An array of |capacity| elements. Used as a circular array.
-  std::unique_ptr<T[]> elements_;
+  UniqueArrayPtr<T> elements_;
   size_t capacity_ = 0;
   // The index of the element to be removed by Pop().
   size_t begin_ = 0;
@@ -82,5 +82,26 @@ TEST(QueueTest, WrapAround) {
   }
 }
 
+TEST(QueueTest, Index) {
+  Queue<TestClass> queue;
+  ASSERT_TRUE(queue.Init(8));
+
+  // Move the front of the queue so that the elements wrap around.
+  for (int i = 0; i < 5; ++i) {
+    queue.Push(TestClass(i));
+    queue.Pop();
+  }
+  for (int i = 0; i < 8; ++i) {
+    queue.Push(TestClass(i));
+  }
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(queue[i].i, i);
+  }
+  queue.Pop();
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(queue[i].i, i + 1);
+  }
+}
+
 }  // namespace
 }  // namespace libgav1
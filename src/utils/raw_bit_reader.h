@@ -30,6 +30,10 @@ class RawBitReader final : public BitReader, public Allocable {
   RawBitReader(const uint8_t* data, size_t size);
   ~RawBitReader() override = default;
 
+  // Starts reading |data| from the beginning, as if the reader was constructed
+  // with |data| and |size|.
+  void Reset(const uint8_t* data, size_t size);
+
   int ReadBit() override;
   int64_t ReadLiteral(int num_bits) override;  // f(n) in the spec.
   bool ReadInverseSignedLiteral(int num_bits,
@@ -68,9 +72,9 @@ class RawBitReader final : public BitReader, public Allocable {
   bool CanReadLiteral(size_t num_bits) const;
   int ReadBitImpl();
 
-  const uint8_t* const data_;
+  const uint8_t* data_;
   size_t bit_offset_;
-  const size_t size_;
+  size_t size_;
 };
 
 }  // namespace libgav1
@@ -18,6 +18,7 @@
 #define LIBGAV1_SRC_UTILS_REFERENCE_INFO_H_
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 #include "src/utils/array_2d.h"
@@ -54,6 +55,15 @@ struct ReferenceInfo {
            );
   }
 
+  // Allocates the memory needed by Reset() for up to |rows| x |columns|
+  // entries ahead of time. Reset() must be called before the members are used
+  // again.
+  LIBGAV1_MUST_USE_RESULT bool Reserve(int rows, int columns) {
+    const size_t size = static_cast<size_t>(rows) * columns;
+    return motion_field_reference_frame.Reserve(size) &&
+           motion_field_mv.Reserve(size);
+  }
+
   // All members are used by inter frames only.
   // For intra frames, they are not initialized.
 
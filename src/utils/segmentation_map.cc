@@ -15,19 +15,31 @@
 #include "src/utils/segmentation_map.h"
 
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <new>
 
 namespace libgav1 {
 
-bool SegmentationMap::Allocate(int32_t rows4x4, int32_t columns4x4) {
-  if (rows4x4 * columns4x4 > rows4x4_ * columns4x4_) {
-    segment_id_buffer_.reset(new (std::nothrow) int8_t[rows4x4 * columns4x4]);
+bool SegmentationMap::Reserve(size_t size) {
+  if (size <= allocated_size_) return true;
+  segment_id_buffer_ = MakeUniqueArray<int8_t>(size);
+  if (segment_id_buffer_ == nullptr) {
+    allocated_size_ = 0;
+    return false;
   }
+  allocated_size_ = size;
+  return true;
+}
+
+bool SegmentationMap::Allocate(int32_t rows4x4, int32_t columns4x4) {
+  // Keep the buffer when the frame gets smaller so that switching back to a
+  // larger size (up to the largest one seen) does not allocate.
+  const bool reserved = Reserve(static_cast<size_t>(rows4x4) * columns4x4);
 
   rows4x4_ = rows4x4;
   columns4x4_ = columns4x4;
-  if (segment_id_buffer_ == nullptr) return false;
+  if (!reserved) return false;
   segment_id_.Reset(rows4x4_, columns4x4_, segment_id_buffer_.get());
   return true;
 }
@@ -17,11 +17,13 @@
 #ifndef LIBGAV1_SRC_UTILS_SEGMENTATION_MAP_H_
 #define LIBGAV1_SRC_UTILS_SEGMENTATION_MAP_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
 #include "src/utils/array_2d.h"
 #include "src/utils/compiler_attributes.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 
@@ -40,6 +42,11 @@ class SegmentationMap {
   // true on success, false on failure (for example, out of memory).
   LIBGAV1_MUST_USE_RESULT bool Allocate(int32_t rows4x4, int32_t columns4x4);
 
+  // Makes sure that the internal buffer can hold at least |size| segment ids,
+  // so that Allocate() does not need to allocate for maps that fit. The map
+  // must be allocated again before it is used.
+  LIBGAV1_MUST_USE_RESULT bool Reserve(size_t size);
+
   int8_t segment_id(int row4x4, int column4x4) const {
     return segment_id_[row4x4][column4x4];
   }
@@ -59,10 +66,11 @@ class SegmentationMap {
  private:
   int32_t rows4x4_ = 0;
   int32_t columns4x4_ = 0;
+  size_t allocated_size_ = 0;
 
   // segment_id_ is a rows4x4_ by columns4x4_ 2D array. The underlying data
   // buffer is dynamically allocated and owned by segment_id_buffer_.
-  std::unique_ptr<int8_t[]> segment_id_buffer_;
+  UniqueArrayPtr<int8_t> segment_id_buffer_;
   Array2DView<int8_t> segment_id_;
 };
 
@@ -14,9 +14,12 @@
 
 #include "src/utils/segmentation_map.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 
 #include "gtest/gtest.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 namespace {
@@ -116,5 +119,32 @@ TEST(SegmentationMapTest, CopyFrom) {
   }
 }
 
+TEST(SegmentationMapTest, ReuseBuffer) {
+  int allocations = 0;
+  Allocator allocator;
+  allocator.allocate = [](void* private_data, size_t size) {
+    ++*static_cast<int*>(private_data);
+    return malloc(size);
+  };
+  allocator.deallocate = [](void* /*private_data*/, void* ptr) { free(ptr); };
+  allocator.private_data = &allocations;
+  const ScopedAllocator scoped_allocator(allocator);
+
+  SegmentationMap segmentation_map;
+  ASSERT_TRUE(segmentation_map.Reserve(60 * 80));
+  EXPECT_EQ(allocations, 1);
+  // Switching between sizes that fit does not allocate.
+  for (const int32_t rows4x4 : {30, 60, 16, 60}) {
+    ASSERT_TRUE(segmentation_map.Allocate(rows4x4, 80));
+    segmentation_map.Clear();
+  }
+  EXPECT_EQ(allocations, 1);
+  // A larger size grows the buffer, which is then kept for smaller sizes.
+  ASSERT_TRUE(segmentation_map.Allocate(120, 80));
+  ASSERT_TRUE(segmentation_map.Allocate(60, 80));
+  ASSERT_TRUE(segmentation_map.Allocate(120, 80));
+  EXPECT_EQ(allocations, 2);
+}
+
 }  // namespace
 }  // namespace libgav1
@@ -38,6 +38,8 @@
 #include <chrono>  // NOLINT (unapproved c++11 header)
 #endif
 
+#include "src/utils/perf_counters.h"
+
 // Define the GetTid() function, a wrapper for the gettid() system call in
 // Linux.
 #if defined(__ANDROID__)
@@ -76,8 +78,8 @@ std::unique_ptr<ThreadPool> ThreadPool::Create(int num_threads) {
 std::unique_ptr<ThreadPool> ThreadPool::Create(const char name_prefix[],
                                                int num_threads) {
   if (name_prefix == nullptr || num_threads <= 0) return nullptr;
-  std::unique_ptr<WorkerThread*[]> threads(new (std::nothrow)
-                                               WorkerThread*[num_threads]);
+  UniqueArrayPtr<WorkerThread*> threads =
+      MakeUniqueArray<WorkerThread*>(num_threads);
   if (threads == nullptr) return nullptr;
   std::unique_ptr<ThreadPool> pool(new (std::nothrow) ThreadPool(
       name_prefix, std::move(threads), num_threads));
@@ -88,9 +90,11 @@ std::unique_ptr<ThreadPool> ThreadPool::Create(const char name_prefix[],
 }
 
 ThreadPool::ThreadPool(const char name_prefix[],
-                       std::unique_ptr<WorkerThread*[]> threads,
+                       UniqueArrayPtr<WorkerThread*> threads,
                        int num_threads)
-    : threads_(std::move(threads)), num_threads_(num_threads) {
+    : threads_(std::move(threads)),
+      allocator_(GetCurrentAllocator()),
+      num_threads_(num_threads) {
   threads_[0] = nullptr;
   assert(name_prefix != nullptr);
   const size_t name_prefix_len =
@@ -102,6 +106,19 @@ ThreadPool::ThreadPool(const char name_prefix[],
 ThreadPool::~ThreadPool() { Shutdown(); }
 
 void ThreadPool::Schedule(std::function<void()> closure) {
+#if LIBGAV1_PERF_COUNTERS_SUPPORTED
+  // Make the job collect into the same performance counter totals as the
+  // thread that schedules it.
+  PerfCounterTotals* const perf_counter_totals = CurrentPerfCounterTotals();
+  if (perf_counter_totals != nullptr) {
+    const std::function<void()> job = std::move(closure);
+    closure = [perf_counter_totals, job]() {
+      const ScopedPerfCounterCollection perf_counter_collection(
+          perf_counter_totals);
+      job();
+    };
+  }
+#endif
   LockMutex();
   if (!queue_.GrowIfNeeded()) {
     // queue_ is full and we can't grow it. Run |closure| directly.
@@ -235,6 +252,7 @@ void ThreadPool::WorkerThread::SetupName() {
 #endif  // defined(_MSC_VER)
 
 void ThreadPool::WorkerThread::Run() {
+  const ScopedAllocator scoped_allocator(pool_->allocator_);
   SetupName();
   pool_->WorkerFunction();
 }
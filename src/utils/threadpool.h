@@ -99,7 +99,7 @@ class ThreadPool : public Executor, public Allocable {
 
   // Creates the thread pool with the specified number of worker threads.
   // If num_threads is 1, the closures are run in FIFO order.
-  ThreadPool(const char name_prefix[], std::unique_ptr<WorkerThread*[]> threads,
+  ThreadPool(const char name_prefix[], UniqueArrayPtr<WorkerThread*> threads,
              int num_threads);
 
   // Starts the worker pool.
@@ -150,7 +150,10 @@ class ThreadPool : public Executor, public Allocable {
   UnboundedQueue<std::function<void()>> queue_ LIBGAV1_GUARDED_BY(queue_mutex_);
   // If not all the worker threads are created, the first entry after the
   // created worker threads is a null pointer.
-  const std::unique_ptr<WorkerThread*[]> threads_;
+  const UniqueArrayPtr<WorkerThread*> threads_;
+  // The allocator of the thread that created the pool. The worker threads
+  // allocate from it.
+  const Allocator allocator_;
 
   bool exit_threads_ LIBGAV1_GUARDED_BY(queue_mutex_) = false;
   const int num_threads_ = 0;
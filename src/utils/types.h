@@ -54,6 +54,33 @@ struct TemporalMotionField : public Allocable {
   Array2D<int8_t> reference_offset;
 };
 
+// Caches the projections (Section 7.9.3) of the temporal motion vectors of one
+// 64x64 block towards each reference frame. All the temporal candidates of a
+// block lie within the 64x64 block that contains it (Section 7.10.2.5), and
+// the candidates of neighboring blocks overlap, so the blocks of a 64x64 block
+// share the projections instead of each computing them.
+struct TemporalMvCache {
+  // Invalidates the cache unless the 4x4 block at (|row4x4|, |column4x4|) is
+  // within the cached 64x64 block.
+  void Update(int row4x4, int column4x4) {
+    const int row = row4x4 >> 4;
+    const int column = column4x4 >> 4;
+    if (row == row64 && column == column64) return;
+    row64 = row;
+    column64 = column;
+    valid = {};
+  }
+
+  // The position of the cached 64x64 block in units of 64x64 blocks.
+  int row64 = -1;
+  int column64 = -1;
+  // Bit i of valid[reference] is set if mv[reference][i] holds the projection
+  // towards |reference| of the motion field entry of the i-th 8x8 block (in
+  // raster order) of the 64x64 block.
+  std::array<uint64_t, kNumReferenceFrameTypes> valid = {};
+  MotionVector mv[kNumReferenceFrameTypes][64];
+};
+
 // MvContexts contains the contexts used to decode portions of an inter block
 // mode info to set the y_mode field in BlockParameters.
 //
@@ -21,7 +21,6 @@
 
 #include <cassert>
 #include <cstddef>
-#include <cstdlib>
 #include <cstring>
 #include <iterator>
 #include <new>
@@ -29,6 +28,7 @@
 #include <utility>
 
 #include "src/utils/compiler_attributes.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 namespace internal {
@@ -77,7 +77,7 @@ class VectorBase {
   VectorBase& operator=(VectorBase&& other) noexcept {
     if (this != &other) {
       clear();
-      free(items_);
+      AlignedFree(items_);
       items_ = other.items_;
       capacity_ = other.capacity_;
       num_items_ = other.num_items_;
@@ -89,13 +89,14 @@ class VectorBase {
   }
   ~VectorBase() {
     clear();
-    free(items_);
+    AlignedFree(items_);
   }
 
   // Reallocates just enough memory if needed so that 'new_cap' items can fit.
   LIBGAV1_MUST_USE_RESULT bool reserve(size_t new_cap) {
     if (capacity_ < new_cap) {
-      T* const new_items = static_cast<T*>(malloc(new_cap * sizeof(T)));
+      T* const new_items = static_cast<T*>(
+          AlignedAlloc(alignof(std::max_align_t), new_cap * sizeof(T)));
       if (new_items == nullptr) return false;
       if (num_items_ > 0) {
         if (std::is_trivial<T>::value) {
@@ -112,7 +113,7 @@ class VectorBase {
           }
         }
       }
-      free(items_);
+      AlignedFree(items_);
       items_ = new_items;
       capacity_ = new_cap;
     }
@@ -123,7 +124,7 @@ class VectorBase {
   bool shrink_to_fit() {
     if (capacity_ == num_items_) return true;
     if (num_items_ == 0) {
-      free(items_);
+      AlignedFree(items_);
       items_ = nullptr;
       capacity_ = 0;
       return true;
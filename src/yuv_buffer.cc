@@ -135,8 +135,8 @@ bool YuvBuffer::Realloc(int bitdepth, bool is_monochrome, int width, int height,
       // Allocation to hold larger frame, or first allocation.
       if (frame_size != static_cast<size_t>(frame_size)) return false;
 
-      buffer_alloc_.reset(new (std::nothrow)
-                              uint8_t[static_cast<size_t>(frame_size)]);
+      buffer_alloc_ =
+          MakeUniqueArray<uint8_t>(static_cast<size_t>(frame_size));
       if (buffer_alloc_ == nullptr) {
         buffer_alloc_size_ = 0;
         return false;
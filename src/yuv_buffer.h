@@ -26,6 +26,7 @@
 #include "src/gav1/frame_buffer.h"
 #include "src/utils/compiler_attributes.h"
 #include "src/utils/constants.h"
+#include "src/utils/memory.h"
 
 namespace libgav1 {
 
@@ -177,7 +178,7 @@ class YuvBuffer {
 
   // buffer_alloc_ and buffer_alloc_size_ are only used if the
   // get_frame_buffer callback is null and we allocate the buffer ourselves.
-  std::unique_ptr<uint8_t[]> buffer_alloc_;
+  UniqueArrayPtr<uint8_t> buffer_alloc_;
   size_t buffer_alloc_size_ = 0;
 
   int8_t subsampling_x_ = 0;  // 0 or 1.
@@ -107,6 +107,9 @@ list(APPEND libgav1_c_decoder_test_sources
             "${libgav1_source}/c_decoder_test.c"
             "${libgav1_source}/decoder_test_data.h")
 list(APPEND libgav1_c_version_test_sources "${libgav1_source}/c_version_test.c")
+list(APPEND libgav1_decoder_allocation_test_sources
+            "${libgav1_source}/decoder_allocation_test.cc"
+            "${libgav1_source}/decoder_test_data.h")
 list(APPEND libgav1_decoder_test_sources
             "${libgav1_source}/decoder_test.cc"
             "${libgav1_source}/decoder_test_data.h")
@@ -186,6 +189,7 @@ list(APPEND libgav1_threadpool_test_sources
             "${libgav1_source}/utils/threadpool_test.cc")
 list(APPEND libgav1_threading_strategy_test_sources
             "${libgav1_source}/threading_strategy_test.cc")
+list(APPEND libgav1_tile_test_sources "${libgav1_source}/tile_test.cc")
 list(APPEND libgav1_unbounded_queue_test_sources
             "${libgav1_source}/utils/unbounded_queue_test.cc")
 list(
@@ -445,8 +449,11 @@ macro(libgav1_add_tests_targets)
                          ${libgav1_defines}
                          INCLUDES
                          ${libgav1_test_include_paths}
+                         OBJLIB_DEPS
+                         libgav1_utils
                          LIB_DEPS
                          absl::base
+                         ${libgav1_common_test_absl_deps}
                          libgav1_gtest
                          libgav1_gtest_main)
 
@@ -746,6 +753,21 @@ macro(libgav1_add_tests_targets)
                          LIB_DEPS
                          ${libgav1_dependency})
 
+  libgav1_add_executable(TEST
+                         NAME
+                         decoder_allocation_test
+                         SOURCES
+                         ${libgav1_decoder_allocation_test_sources}
+                         DEFINES
+                         ${libgav1_defines}
+                         INCLUDES
+                         ${libgav1_test_include_paths}
+                         LIB_DEPS
+                         ${libgav1_dependency}
+                         ${libgav1_common_test_absl_deps}
+                         libgav1_gtest
+                         libgav1_gtest_main)
+
   libgav1_add_executable(TEST
                          NAME
                          decoder_test
@@ -755,8 +777,12 @@ macro(libgav1_add_tests_targets)
                          ${libgav1_defines}
                          INCLUDES
                          ${libgav1_test_include_paths}
+                         OBJLIB_DEPS
+                         libgav1_tests_utils
                          LIB_DEPS
                          ${libgav1_dependency}
+                         absl::strings
+                         absl::time
                          ${libgav1_common_test_absl_deps}
                          libgav1_gtest
                          libgav1_gtest_main)
@@ -1307,6 +1333,26 @@ macro(libgav1_add_tests_targets)
                          libgav1_gtest
                          libgav1_gtest_main)
 
+  libgav1_add_executable(TEST
+                         NAME
+                         tile_test
+                         SOURCES
+                         ${libgav1_tile_test_sources}
+                         DEFINES
+                         ${libgav1_defines}
+                         INCLUDES
+                         ${libgav1_test_include_paths}
+                         OBJLIB_DEPS
+                         libgav1_decoder
+                         libgav1_dsp
+                         libgav1_tests_utils
+                         libgav1_utils
+                         LIB_DEPS
+                         absl::time
+                         ${libgav1_common_test_absl_deps}
+                         libgav1_gtest
+                         libgav1_gtest_main)
+
   libgav1_add_executable(TEST
                          NAME
                          warp_test